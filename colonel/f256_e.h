@@ -185,6 +185,15 @@
 	#define FLAG_UART_MCR_LOOP			0b00010000		// Echo (loop back) test.  All characters sent will be echoed if set.	
 #define UART_LSR						(UART_BASE + 5)
 #define UART_MSR						(UART_BASE + 6)
+	#define FLAG_UART_MSR_DCTS			0b00000001		// CTS changed since MSR was last read
+	#define FLAG_UART_MSR_DDSR			0b00000010		// DSR changed since MSR was last read
+	#define FLAG_UART_MSR_TERI			0b00000100		// RI went from on to off since MSR was last read
+	#define FLAG_UART_MSR_DDCD			0b00001000		// DCD changed since MSR was last read
+	#define FLAG_UART_MSR_CTS			0b00010000		// Clear To Send
+	#define FLAG_UART_MSR_DSR			0b00100000		// Data Set Ready
+	#define FLAG_UART_MSR_RI			0b01000000		// Ring Indicator
+	#define FLAG_UART_MSR_DCD			0b10000000		// Data Carrier Detect
+	#define UART_MSR_DELTA_MASK			0b00001111		// any of the 'changed' bits
 #define UART_SCR						(UART_BASE + 7)
 
 #define UART_THR						(UART_BASE + 0)	// write register when DLAB=0
@@ -209,13 +218,28 @@
 #define UART_DATA_BITS			0b00000011	// 8 bits
 #define UART_STOP_BITS			0			// 1 stop bit
 #define UART_PARITY				0			// no parity
+#define UART_DATA_BITS_7		0b00000010	// 7 bits
+#define UART_DATA_BITS_8		0b00000011	// 8 bits
+#define UART_STOP_BITS_2		0b00000100	// 2 stop bits
+#define UART_PARITY_ODD			0b00001000	// parity enable, odd
+#define UART_PARITY_EVEN		0b00011000	// parity enable, even
+#define UART_LINE_FORMAT_MASK	0b00111111	// LCR bits for data bits, stop bits, and parity
 #define UART_BRK_SIG			0b01000000
 #define UART_NO_BRK_SIG			0b00000000
 #define UART_DLAB_MASK			0b10000000
 #define UART_THR_IS_EMPTY		0b00100000
 #define UART_THR_EMPTY_IDLE		0b01000000
 #define UART_DATA_AVAILABLE		0b00000001
-#define UART_ERROR_MASK			0b10011110
+#define UART_ERROR_MASK			0b00011110	// LSR: overrun, parity, framing, break. not bit 7, which only says a bad byte is somewhere in the FIFO
+#define UART_BYTE_ERROR_MASK	0b00011100	// LSR: parity, framing, break. these describe the byte at the top of the receive FIFO
+#define UART_OVERRUN_ERROR		0b00000010	// LSR: a byte arrived before the previous one was read
+#define UART_PARITY_ERROR		0b00000100	// LSR: byte arrived with the wrong parity
+#define UART_FRAMING_ERROR		0b00001000	// LSR: byte arrived without a valid stop bit
+#define UART_BREAK_INTERRUPT	0b00010000	// LSR: line held low longer than a byte (remote sent BREAK)
+#define UART_FIFO_ENABLE		0b00000001	// FCR: turn on the 16-byte receive and transmit FIFOs
+#define UART_FIFO_RX_RESET		0b00000010	// FCR: empty the receive FIFO
+#define UART_FIFO_TX_RESET		0b00000100	// FCR: empty the transmit FIFO
+#define UART_FIFO_SIZE			16			// bytes the transmit FIFO takes each time it empties
 
 
 
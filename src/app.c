@@ -18,10 +18,15 @@
 #include "app.h"
 #include "comm_buffer.h"
 #include "memory.h"
+#include "modem.h"
+#include "music.h"
+#include "rip.h"
 #include "screen.h"
 #include "serial.h"
 #include "startup.h"
 #include "strings.h"
+#include "trace.h"
+#include "transfer.h"
 
 // C includes
 #include <stdbool.h>
@@ -41,9 +46,9 @@
 /*****************************************************************************/
 
 #define CH_PROGRESS_BAR_FULL	CH_CHECKERBOARD
-#define PROGRESS_BAR_Y			(COMM_BUFFER_FIRST_ROW - 4)
+#define PROGRESS_BAR_Y			TERM_PROGRESS_BAR_START_Y	// in the title bar, between the app name and the connection state
 #define PROGRESS_BAR_START_X	TERM_PROGRESS_BAR_START_X
-#define PROGRESS_BAR_WIDTH		10	// number of characters in progress bar
+#define PROGRESS_BAR_WIDTH		TERM_PROGRESS_BAR_WIDTH	// number of characters in progress bar
 #define PROGRESS_BAR_DIVISOR	8	// number of slices in one char: divide % by this to get # of blocks to draw.
 #define COLOR_PROGRESS_BAR		COLOR_CYAN
 
@@ -54,8 +59,22 @@
 #define ACTION_SELECT_FONT_ANSI	(CH_LC_A + CH_ALT_OFFSET)	// alt-a
 #define ACTION_SELECT_FONT_IBM	(CH_LC_I + CH_ALT_OFFSET)	// alt-i
 #define ACTION_SET_TIME			(CH_LC_T + CH_ALT_OFFSET)	// alt-t
-//#define ACTION_RECEIVE_YMODEM	(CH_LC_Y + CH_ALT_OFFSET)	// alt-y
-//#define ACTION_ABORT_SESSION	(CH_ESC + CH_ALT_OFFSET)	// alt-ESC
+#define ACTION_TOGGLE_UTF8		(CH_LC_U + CH_ALT_OFFSET)	// alt-u
+#define ACTION_CYCLE_EMULATION	(CH_LC_E + CH_ALT_OFFSET)	// alt-e
+#define ACTION_TOGGLE_TELNET	(CH_LC_N + CH_ALT_OFFSET)	// alt-n
+#define ACTION_TOGGLE_CONNECT_BAUD	(CH_LC_B + CH_ALT_OFFSET)	// alt-b
+#define ACTION_DETECT_BAUD		(CH_LC_S + CH_ALT_OFFSET)	// alt-s
+#define ACTION_CYCLE_LINE_FORMAT	(CH_LC_L + CH_ALT_OFFSET)	// alt-l
+#define ACTION_SEND_BREAK		(CH_LC_K + CH_ALT_OFFSET)	// alt-k
+#define ACTION_RECEIVE_YMODEM	(CH_LC_Y + CH_ALT_OFFSET)	// alt-y
+#define ACTION_RECEIVE_YMODEM_G	(CH_LC_G + CH_ALT_OFFSET)	// alt-g
+#define ACTION_RECEIVE_ZMODEM	(CH_LC_Z + CH_ALT_OFFSET)	// alt-z
+#define ACTION_SEND_YMODEM		(CH_LC_P + CH_ALT_OFFSET)	// alt-p (put)
+#define ACTION_SEND_XMODEM		(CH_LC_X + CH_ALT_OFFSET)	// alt-x
+#define ACTION_RECEIVE_KERMIT	(CH_LC_M + CH_ALT_OFFSET)	// alt-m
+#define ACTION_SEND_KERMIT		(CH_LC_O + CH_ALT_OFFSET)	// alt-o
+#define ACTION_HANG_UP			(CH_LC_H + CH_ALT_OFFSET)	// alt-h
+#define ACTION_SET_ANSWERBACK	(CH_LC_W + CH_ALT_OFFSET)	// alt-w ("who are you")
 #define ACTION_SET_BAUD_300		(CH_1 + CH_ALT_OFFSET)	// alt-1
 #define ACTION_SET_BAUD_1200	(CH_2 + CH_ALT_OFFSET)	// alt-2
 #define ACTION_SET_BAUD_2400	(CH_3 + CH_ALT_OFFSET)	// alt-3
@@ -67,7 +86,17 @@
 #define ACTION_SET_BAUD_57600	(CH_9 + CH_ALT_OFFSET)	// alt-9
 #define ACTION_SET_BAUD_115200	(CH_0 + CH_ALT_OFFSET)	// alt-10
 
+#define NUM_BAUD_CONFIGS		10		// entries in app_baud_config[]
+
+#define AUTOBAUD_NOT_RUNNING	0xFF	// app_autobaud_step when no probe is running
+
+#define NUM_LINE_FORMATS		6		// entries in app_line_format_config[]
+#define BREAK_DURATION_TICKS	4		// hold BREAK for 250ms (4 RTC ticks)
+#define HANG_UP_DTR_TICKS		16		// hold DTR off for 1s (16 RTC ticks). modems need 50ms+ (S25) to notice.
+#define SERIAL_ERROR_MSG_TICKS	16		// report serial errors at most once a second (16 RTC ticks)
+
 #define ACTION_DEBUG_DUMP		(CH_LC_D + CH_ALT_OFFSET)	// alt-d
+#define ACTION_DUMP_TRACE		(CH_LC_R + CH_ALT_OFFSET)	// alt-r. only with TRANSFER_TRACE defined (see Makefile)
 
 #define UI_BYTE_SIZE_OF_APP_TITLEBAR	80	// 1 x 80 rows for the title at top
 
@@ -83,19 +112,61 @@ static uint8_t				app_active_panel_id;	// PANEL_ID_LEFT or PANEL_ID_RIGHT
 static uint8_t				app_connected_drive_count;
 
 uint8_t						app_current_baud_config;		// index to app_baud_config[]
+static bool					app_baud_follows_connect = false;	// if true, switch to the rate in the modem's CONNECT message
+static bool					app_was_online = false;			// connection state when the status line was last drawn
+
+static volatile uint16_t	app_ticks = 0;					// counts RTC periodic interrupts (16/sec). free-running, wraps.
+static uint8_t				app_autobaud_step = AUTOBAUD_NOT_RUNNING;	// index into app_autobaud_order[] being probed
+static uint8_t				app_autobaud_prev_config;		// baud config to go back to if the modem never answers
+static uint16_t				app_autobaud_start_tick;		// app_ticks when detection started
+
+// app_baud_config[] indexes, fastest first: the first rate the modem answers at is the highest that works
+const static uint8_t		app_autobaud_order[NUM_BAUD_CONFIGS] = {0, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+
+static uint8_t				app_current_line_format = 0;	// index to app_line_format_config[]
+static bool					app_break_active = false;		// BREAK is being sent
+static uint16_t				app_break_start_tick;			// app_ticks when BREAK started
+static bool					app_hang_up_active = false;		// DTR is off to make the modem hang up
+static uint16_t				app_hang_up_start_tick;			// app_ticks when DTR went off
+static uint16_t				app_error_msg_tick;				// app_ticks when serial errors were last reported
+
+// ALT-L cycles through these. 8N1 for BBSes; 7E1 and friends for mainframe gateways and packet-switched networks.
+const static line_format_config	app_line_format_config[NUM_LINE_FORMATS] = 
+{
+	{UART_DATA_BITS_8 | UART_PARITY | UART_STOP_BITS,			ID_STR_LINE_FORMAT_8N1},
+	{UART_DATA_BITS_7 | UART_PARITY_EVEN | UART_STOP_BITS,		ID_STR_LINE_FORMAT_7E1},
+	{UART_DATA_BITS_7 | UART_PARITY_ODD | UART_STOP_BITS,		ID_STR_LINE_FORMAT_7O1},
+	{UART_DATA_BITS_8 | UART_PARITY_EVEN | UART_STOP_BITS,		ID_STR_LINE_FORMAT_8E1},
+	{UART_DATA_BITS_8 | UART_PARITY_ODD | UART_STOP_BITS,		ID_STR_LINE_FORMAT_8O1},
+	{UART_DATA_BITS_8 | UART_PARITY | UART_STOP_BITS_2,			ID_STR_LINE_FORMAT_8N2},
+};
 
-const static baud_config	app_baud_config[10] = 
+// status line label for each modem_result, when not online
+const static uint8_t		app_modem_result_label_id[MODEM_RESULT_NO_ANSWER + 1] = 
 {
-	{ACTION_SET_BAUD_115200,	UART_BAUD_DIV_115200,	ID_STR_MSG_SET_BAUD_115200,	ID_STR_BAUD_115200},
-	{ACTION_SET_BAUD_300,		UART_BAUD_DIV_300,		ID_STR_MSG_SET_BAUD_300,	ID_STR_BAUD_300},
-	{ACTION_SET_BAUD_1200,		UART_BAUD_DIV_1200,		ID_STR_MSG_SET_BAUD_1200,	ID_STR_BAUD_1200},
-	{ACTION_SET_BAUD_2400,		UART_BAUD_DIV_2400,		ID_STR_MSG_SET_BAUD_2400,	ID_STR_BAUD_2400},
-	{ACTION_SET_BAUD_3600,		UART_BAUD_DIV_3600,		ID_STR_MSG_SET_BAUD_3600,	ID_STR_BAUD_3600},
-	{ACTION_SET_BAUD_4800,		UART_BAUD_DIV_4800, 	ID_STR_MSG_SET_BAUD_4800,	ID_STR_BAUD_4800},
-	{ACTION_SET_BAUD_9600,		UART_BAUD_DIV_9600,		ID_STR_MSG_SET_BAUD_9600,	ID_STR_BAUD_9600},
-	{ACTION_SET_BAUD_19200,		UART_BAUD_DIV_19200,	ID_STR_MSG_SET_BAUD_19200,	ID_STR_BAUD_19200},
-	{ACTION_SET_BAUD_38400,		UART_BAUD_DIV_38400,	ID_STR_MSG_SET_BAUD_38400,	ID_STR_BAUD_38400},
-	{ACTION_SET_BAUD_57600,		UART_BAUD_DIV_57600,	ID_STR_MSG_SET_BAUD_57600,	ID_STR_BAUD_57600},
+	ID_STR_CONN_OFFLINE,		// MODEM_RESULT_NONE
+	ID_STR_CONN_OFFLINE,		// MODEM_RESULT_OK
+	ID_STR_CONN_OFFLINE,		// MODEM_RESULT_CONNECT
+	ID_STR_CONN_RING,
+	ID_STR_CONN_NO_CARRIER,
+	ID_STR_CONN_ERROR,
+	ID_STR_CONN_NO_DIALTONE,
+	ID_STR_CONN_BUSY,
+	ID_STR_CONN_NO_ANSWER,
+};
+
+const static baud_config	app_baud_config[NUM_BAUD_CONFIGS] = 
+{
+	{ACTION_SET_BAUD_115200,	UART_BAUD_DIV_115200,	ID_STR_MSG_SET_BAUD_115200,	ID_STR_BAUD_115200,	115200},
+	{ACTION_SET_BAUD_300,		UART_BAUD_DIV_300,		ID_STR_MSG_SET_BAUD_300,	ID_STR_BAUD_300,	300},
+	{ACTION_SET_BAUD_1200,		UART_BAUD_DIV_1200,		ID_STR_MSG_SET_BAUD_1200,	ID_STR_BAUD_1200,	1200},
+	{ACTION_SET_BAUD_2400,		UART_BAUD_DIV_2400,		ID_STR_MSG_SET_BAUD_2400,	ID_STR_BAUD_2400,	2400},
+	{ACTION_SET_BAUD_3600,		UART_BAUD_DIV_3600,		ID_STR_MSG_SET_BAUD_3600,	ID_STR_BAUD_3600,	3600},
+	{ACTION_SET_BAUD_4800,		UART_BAUD_DIV_4800, 	ID_STR_MSG_SET_BAUD_4800,	ID_STR_BAUD_4800,	4800},
+	{ACTION_SET_BAUD_9600,		UART_BAUD_DIV_9600,		ID_STR_MSG_SET_BAUD_9600,	ID_STR_BAUD_9600,	9600},
+	{ACTION_SET_BAUD_19200,		UART_BAUD_DIV_19200,	ID_STR_MSG_SET_BAUD_19200,	ID_STR_BAUD_19200,	19200},
+	{ACTION_SET_BAUD_38400,		UART_BAUD_DIV_38400,	ID_STR_MSG_SET_BAUD_38400,	ID_STR_BAUD_38400,	38400},
+	{ACTION_SET_BAUD_57600,		UART_BAUD_DIV_57600,	ID_STR_MSG_SET_BAUD_57600,	ID_STR_BAUD_57600,	57600},
 };
 
 
@@ -111,6 +182,10 @@ static uint8_t				app_progress_bar_char[8] =
 	CH_PROGRESS_BAR_CHECKER_CH1+6,
 };
 
+// the part of the title bar the progress bar covers, so it can be put back when the bar is hidden
+static uint8_t				app_progress_bar_saved_char[PROGRESS_BAR_WIDTH];
+static uint8_t				app_progress_bar_saved_attr[PROGRESS_BAR_WIDTH];
+
 
 const static uint8_t			app_titlebar_glyphs[UI_BYTE_SIZE_OF_APP_TITLEBAR] = 
 {
@@ -140,12 +215,87 @@ const static char		app_font_ibm_ansi[] = {
 0x00,0x00,0x00,0x00, 0x00,0x00,0x00,0x00, 0x7E,0x81,0xA5,0x81, 0xBD,0x99,0x81,0x7E, 0x7E,0xFF,0xDB,0xFF, 0xC3,0xE7,0xFF,0x7E, 0x6C,0xFE,0xFE,0xFE, 0x7C,0x38,0x10,0x00, 0x10,0x38,0x7C,0xFE, 0x7C,0x38,0x10,0x00, 0x38,0x7C,0x38,0xFE, 0xFE,0x7C,0x38,0x7C, 0x10,0x10,0x38,0x7C, 0xFE,0x7C,0x38,0x7C, 0x00,0x00,0x18,0x3C, 0x3C,0x18,0x00,0x00, 0xFF,0xFF,0xE7,0xC3, 0xC3,0xE7,0xFF,0xFF, 0x00,0x3C,0x66,0x42, 0x42,0x66,0x3C,0x00, 0xFF,0xC3,0x99,0xBD, 0xBD,0x99,0xC3,0xFF, 0x0F,0x07,0x0D,0x7C, 0xCC,0xCC,0xCC,0x78, 0x3C,0x66,0x66,0x66, 0x3C,0x18,0x7E,0x18, 0x3F,0x33,0x3F,0x30, 0x30,0x70,0xF0,0xE0, 0x7F,0x63,0x7F,0x63, 0x63,0x67,0xE6,0xC0, 0x99,0x5A,0x3C,0xE7, 0xE7,0x3C,0x5A,0x99, 0x80,0xE0,0xF8,0xFE, 0xF8,0xE0,0x80,0x00, 0x02,0x0E,0x3E,0xFE, 0x3E,0x0E,0x02,0x00, 0x18,0x3C,0x7E,0x18, 0x18,0x7E,0x3C,0x18, 0x66,0x66,0x66,0x66, 0x00,0x00,0x66,0x00, 0x7F,0xDB,0xDB,0x7B, 0x1B,0x1B,0x1B,0x00, 0x3E,0x63,0x3C,0x66, 0x66,0x3C,0xC6,0x7C, 0x00,0x00,0x00,0x00, 0x7E,0x7E,0x7E,0x00, 0x18,0x3C,0x7E,0x18, 0x7E,0x3C,0x18,0xFF, 0x18,0x3C,0x7E,0x18, 0x18,0x18,0x18,0x00, 0x18,0x18,0x18,0x18, 0x7E,0x3C,0x18,0x00, 0x00,0x18,0x0C,0xFE, 0x0C,0x18,0x00,0x00, 0x00,0x30,0x60,0xFE, 0x60,0x30,0x00,0x00, 0x00,0x00,0xC0,0xC0, 0xC0,0xFE,0x00,0x00, 0x00,0x24,0x66,0xFF, 0x66,0x24,0x00,0x00, 0x00,0x18,0x3C,0x7E, 0xFF,0xFF,0x00,0x00, 0x00,0xFF,0xFF,0x7E, 0x3C,0x18,0x00,0x00, 0x00,0x00,0x00,0x00, 0x00,0x00,0x00,0x00, 0x30,0x78,0x78,0x30, 0x30,0x00,0x30,0x00, 0x6C,0x6C,0x6C,0x00, 0x00,0x00,0x00,0x00, 0x6C,0x6C,0xFE,0x6C, 0xFE,0x6C,0x6C,0x00, 0x30,0x7C,0xC0,0x78, 0x0C,0xF8,0x30,0x00, 0x00,0xC6,0xCC,0x18, 0x30,0x66,0xC6,0x00, 0x38,0x6C,0x38,0x76, 0xDC,0xCC,0x76,0x00, 0x60,0x60,0xC0,0x00, 0x00,0x00,0x00,0x00, 0x18,0x30,0x60,0x60, 0x60,0x30,0x18,0x00, 0x60,0x30,0x18,0x18, 0x18,0x30,0x60,0x00, 0x00,0x66,0x3C,0xFF, 0x3C,0x66,0x00,0x00, 0x00,0x30,0x30,0xFC, 0x30,0x30,0x00,0x00, 0x00,0x00,0x00,0x00, 0x00,0x30,0x30,0x60, 0x00,0x00,0x00,0xFC, 0x00,0x00,0x00,0x00, 0x00,0x00,0x00,0x00, 0x00,0x30,0x30,0x00, 0x06,0x0C,0x18,0x30, 0x60,0xC0,0x80,0x00, 0x7C,0xC6,0xCE,0xDE, 0xF6,0xE6,0x7C,0x00, 0x30,0x70,0x30,0x30, 0x30,0x30,0xFC,0x00, 0x78,0xCC,0x0C,0x38, 0x60,0xCC,0xFC,0x00, 0x78,0xCC,0x0C,0x38, 0x0C,0xCC,0x78,0x00, 0x1C,0x3C,0x6C,0xCC, 0xFE,0x0C,0x1E,0x00, 0xFC,0xC0,0xF8,0x0C, 0x0C,0xCC,0x78,0x00, 0x1C,0x30,0x60,0x7C, 0x66,0x66,0x3C,0x00, 0xFC,0xCC,0x0C,0x18, 0x30,0x30,0x30,0x00, 0x78,0xCC,0xCC,0x78, 0xCC,0xCC,0x78,0x00, 0x78,0xCC,0xCC,0x7C, 0x0C,0x18,0x70,0x00, 0x00,0x30,0x30,0x00, 0x00,0x30,0x30,0x00, 0x00,0x30,0x30,0x00, 0x30,0x30,0x60,0x00, 0x18,0x30,0x60,0xC0, 0x60,0x30,0x18,0x00, 0x00,0x00,0xFC,0x00, 0x00,0xFC,0x00,0x00, 0x60,0x30,0x18,0x0C, 0x18,0x30,0x60,0x00, 0x78,0xCC,0x0C,0x18, 0x30,0x00,0x30,0x00, 0x7C,0xC6,0xDE,0xDE, 0xDE,0xC0,0x78,0x00, 0x30,0x78,0xCC,0xCC, 0xFC,0xCC,0xCC,0x00, 0xFC,0x66,0x66,0x7C, 0x66,0x66,0xFC,0x00, 0x3C,0x66,0xC0,0xC0, 0xC0,0x66,0x3C,0x00, 0xF8,0x6C,0x66,0x66, 0x66,0x6C,0xF8,0x00, 0xFE,0x62,0x68,0x78, 0x68,0x62,0xFE,0x00, 0xFE,0x62,0x68,0x78, 0x68,0x60,0xF0,0x00, 0x3C,0x66,0xC0,0xC0, 0xCE,0x66,0x3E,0x00, 0xCC,0xCC,0xCC,0xFC, 0xCC,0xCC,0xCC,0x00, 0x78,0x30,0x30,0x30, 0x30,0x30,0x78,0x00, 0x1E,0x0C,0x0C,0x0C, 0xCC,0xCC,0x78,0x00, 0xE6,0x66,0x6C,0x78, 0x6C,0x66,0xE6,0x00, 0xF0,0x60,0x60,0x60, 0x62,0x66,0xFE,0x00, 0xC6,0xEE,0xFE,0xD6, 0xC6,0xC6,0xC6,0x00, 0xC6,0xE6,0xF6,0xDE, 0xCE,0xC6,0xC6,0x00, 0x38,0x6C,0xC6,0xC6, 0xC6,0x6C,0x38,0x00, 0xFC,0x66,0x66,0x7C, 0x60,0x60,0xF0,0x00, 0x78,0xCC,0xCC,0xCC, 0xCC,0xDC,0x78,0x1C, 0xFC,0x66,0x66,0x7C, 0x6C,0x66,0xE6,0x00, 0x78,0xCC,0xE0,0x70, 0x1C,0xCC,0x78,0x00, 0xFC,0xB4,0x30,0x30, 0x30,0x30,0x78,0x00, 0xCC,0xCC,0xCC,0xCC, 0xCC,0xCC,0xFC,0x00, 0xCC,0xCC,0xCC,0xCC, 0xFC,0x78,0x30,0x00, 0xC6,0xC6,0xC6,0xD6, 0xFE,0xEE,0xC6,0x00, 0xC6,0xC6,0x6C,0x38, 0x38,0x6C,0xC6,0x00, 0xCC,0xCC,0xCC,0x78, 0x30,0x30,0x78,0x00, 0xFE,0xC6,0x8C,0x18, 0x32,0x66,0xFE,0x00, 0x78,0x60,0x60,0x60, 0x60,0x60,0x78,0x00, 0xC0,0x60,0x30,0x18, 0x0C,0x06,0x02,0x00, 0x78,0x18,0x18,0x18, 0x18,0x18,0x78,0x00, 0x10,0x38,0x6C,0xC6, 0x00,0x00,0x00,0x00, 0x00,0x00,0x00,0x00, 0x00,0x00,0x00,0xFF, 0x30,0x30,0x18,0x00, 0x00,0x00,0x00,0x00, 0x00,0x00,0x78,0x0C, 0x7C,0xCC,0x76,0x00, 0xE0,0x60,0x60,0x7C, 0x66,0x66,0xDC,0x00, 0x00,0x00,0x78,0xCC, 0xC0,0xCC,0x78,0x00, 0x1C,0x0C,0x0C,0x7C, 0xCC,0xCC,0x76,0x00, 0x00,0x00,0x78,0xCC, 0xFC,0xC0,0x78,0x00, 0x38,0x6C,0x60,0xF8, 0x60,0x60,0xF0,0x00, 0x00,0x00,0x76,0xCC, 0xCC,0x7C,0x0C,0xF8, 0xE0,0x60,0x6C,0x76, 0x66,0x66,0xE6,0x00, 0x30,0x00,0x70,0x30, 0x30,0x30,0x78,0x00, 0x0C,0x00,0x0C,0x0C, 0x0C,0xCC,0xCC,0x78, 0xE0,0x60,0x66,0x6C, 0x78,0x6C,0x66,0x00, 0x70,0x30,0x30,0x30, 0x30,0x30,0x78,0x00, 0x00,0x00,0xCC,0xFE, 0xFE,0xD6,0xC6,0x00, 0x00,0x00,0xF8,0xCC, 0xCC,0xCC,0xCC,0x00, 0x00,0x00,0x78,0xCC, 0xCC,0xCC,0x78,0x00, 0x00,0x00,0xDC,0x66, 0x66,0x7C,0x60,0xF0, 0x00,0x00,0x7A,0xCC, 0xCC,0x7C,0x0C,0x0E, 0x00,0x00,0xDC,0x76, 0x66,0x60,0xF0,0x00, 0x00,0x00,0x7C,0xC0, 0x78,0x0C,0xF8,0x00, 0x10,0x30,0x7C,0x30, 0x30,0x34,0x18,0x00, 0x00,0x00,0xCC,0xCC, 0xCC,0xCC,0x76,0x00, 0x00,0x00,0xCC,0xCC, 0xCC,0x78,0x30,0x00, 0x00,0x00,0xC6,0xD6, 0xFE,0x7C,0x6C,0x00, 0x00,0x00,0xC6,0x6C, 0x38,0x6C,0xC6,0x00, 0x00,0x00,0xCC,0xCC, 0xCC,0x7C,0x0C,0xF8, 0x00,0x00,0x7E,0x4C, 0x18,0x32,0x7E,0x00, 0x1C,0x30,0x30,0xE0, 0x30,0x30,0x1C,0x00, 0x18,0x18,0x18,0x00, 0x18,0x18,0x18,0x00, 0xE0,0x30,0x30,0x1C, 0x30,0x30,0xE0,0x00, 0x76,0xDC,0x00,0x00, 0x00,0x00,0x00,0x00, 0x00,0x10,0x38,0x6C, 0xC6,0xC6,0xFE,0x00, 0x78,0xCC,0xC0,0xCC, 0x78,0x18,0x0C,0x78, 0xCC,0x00,0xCC,0xCC, 0xCC,0xCC,0x7E,0x00, 0x1C,0x00,0x78,0xCC, 0xFC,0xC0,0x78,0x00, 0x7E,0xC3,0x3C,0x06, 0x3E,0x66,0x3F,0x00, 0xCC,0x00,0x78,0x0C, 0x7C,0xCC,0x7E,0x00, 0xE0,0x00,0x78,0x0C, 0x7C,0xCC,0x7E,0x00, 0x30,0x30,0x78,0x0C, 0x7C,0xCC,0x7E,0x00, 0x00,0x00,0x78,0xC0, 0xC0,0x78,0x0C,0x38, 0x7E,0xC3,0x3C,0x66, 0x7E,0x60,0x3C,0x00, 0xCC,0x00,0x78,0xCC, 0xFC,0xC0,0x78,0x00, 0xE0,0x00,0x78,0xCC, 0xFC,0xC0,0x78,0x00, 0xCC,0x00,0x70,0x30, 0x30,0x30,0x78,0x00, 0x7C,0xC6,0x38,0x18, 0x18,0x18,0x3C,0x00, 0xE0,0x00,0x70,0x30, 0x30,0x30,0x78,0x00, 0xC6,0x38,0x6C,0xC6, 0xFE,0xC6,0xC6,0x00, 0x30,0x30,0x00,0x78, 0xCC,0xFC,0xCC,0x00, 0x1C,0x00,0xFC,0x60, 0x78,0x60,0xFC,0x00, 0x00,0x00,0x7E,0x18, 0x7E,0x98,0x7E,0x00, 0x3E,0x6C,0xCC,0xFE, 0xCC,0xCC,0xCE,0x00, 0x78,0xCC,0x00,0x78, 0xCC,0xCC,0x78,0x00, 0x00,0xCC,0x00,0x78, 0xCC,0xCC,0x78,0x00, 0x00,0xE0,0x00,0x78, 0xCC,0xCC,0x78,0x00, 0x78,0xCC,0x00,0xCC, 0xCC,0xCC,0x7F,0x00, 0x00,0xE0,0x00,0xCC, 0xCC,0xCC,0x7F,0x00, 0xCC,0x00,0xCC,0xCC, 0xCC,0x7C,0x0C,0xF8, 0xC3,0x18,0x3C,0x66, 0x66,0x3C,0x18,0x00, 0xCC,0x00,0xCC,0xCC, 0xCC,0xCC,0x78,0x00, 0x18,0x18,0x7E,0xC0, 0xC0,0x7E,0x18,0x18, 0x38,0x6C,0x64,0xF0, 0x60,0xE6,0xFC,0x00, 0xCC,0xCC,0x78,0xFC, 0x30,0xFC,0x30,0x30, 0xF8,0xCC,0xCC,0xFA, 0xC6,0xCF,0xC6,0x07, 0x0E,0x1B,0x18,0x3C, 0x18,0x18,0xD8,0x70, 0x1C,0x00,0x78,0x0C, 0x7C,0xCC,0x7E,0x00, 0x38,0x00,0x70,0x30, 0x30,0x30,0x78,0x00, 0x00,0x1C,0x00,0x78, 0xCC,0xCC,0x78,0x00, 0x1C,0x00,0xCC,0xCC, 0xCC,0xCC,0x7E,0x00, 0x00,0xF8,0x00,0xF8, 0xCC,0xCC,0xCC,0x00, 0xFC,0x00,0xCC,0xEC, 0xFC,0xDC,0xCC,0x00, 0x3C,0x6C,0x6C,0x3E, 0x00,0x7E,0x00,0x00, 0x38,0x6C,0x6C,0x38, 0x00,0x7C,0x00,0x00, 0x30,0x00,0x30,0x60, 0xC0,0xCC,0x78,0x00, 0x00,0x00,0x00,0xFC, 0xC0,0xC0,0x00,0x00, 0x00,0x00,0x00,0xFC, 0x0C,0x0C,0x00,0x00, 0xC3,0xC6,0xCC,0xDE, 0x33,0x66,0xCC,0x0F, 0xC3,0xC6,0xCC,0xDB, 0x37,0x6F,0xCF,0x03, 0x18,0x18,0x00,0x18, 0x18,0x18,0x18,0x00, 0x00,0x33,0x66,0xCC, 0x66,0x33,0x00,0x00, 0x00,0xCC,0x66,0x33, 0x66,0xCC,0x00,0x00, 0x22,0x88,0x22,0x88, 0x22,0x88,0x22,0x88, 0x55,0xAA,0x55,0xAA, 0x55,0xAA,0x55,0xAA, 0xDB,0x77,0xDB,0xEE, 0xDB,0x77,0xDB,0xEE, 0x18,0x18,0x18,0x18, 0x18,0x18,0x18,0x18, 0x18,0x18,0x18,0x18, 0xF8,0x18,0x18,0x18, 0x18,0x18,0xF8,0x18, 0xF8,0x18,0x18,0x18, 0x36,0x36,0x36,0x36, 0xF6,0x36,0x36,0x36, 0x00,0x00,0x00,0x00, 0xFE,0x36,0x36,0x36, 0x00,0x00,0xF8,0x18, 0xF8,0x18,0x18,0x18, 0x36,0x36,0xF6,0x06, 0xF6,0x36,0x36,0x36, 0x36,0x36,0x36,0x36, 0x36,0x36,0x36,0x36, 0x00,0x00,0xFE,0x06, 0xF6,0x36,0x36,0x36, 0x36,0x36,0xF6,0x06, 0xFE,0x00,0x00,0x00, 0x36,0x36,0x36,0x36, 0xFE,0x00,0x00,0x00, 0x18,0x18,0xF8,0x18, 0xF8,0x00,0x00,0x00, 0x00,0x00,0x00,0x00, 0xF8,0x18,0x18,0x18, 0x18,0x18,0x18,0x18, 0x1F,0x00,0x00,0x00, 0x18,0x18,0x18,0x18, 0xFF,0x00,0x00,0x00, 0x00,0x00,0x00,0x00, 0xFF,0x18,0x18,0x18, 0x18,0x18,0x18,0x18, 0x1F,0x18,0x18,0x18, 0x00,0x00,0x00,0x00, 0xFF,0x00,0x00,0x00, 0x18,0x18,0x18,0x18, 0xFF,0x18,0x18,0x18, 0x18,0x18,0x1F,0x18, 0x1F,0x18,0x18,0x18, 0x36,0x36,0x36,0x36, 0x37,0x36,0x36,0x36, 0x36,0x36,0x37,0x30, 0x3F,0x00,0x00,0x00, 0x00,0x00,0x3F,0x30, 0x37,0x36,0x36,0x36, 0x36,0x36,0xF7,0x00, 0xFF,0x00,0x00,0x00, 0x00,0x00,0xFF,0x00, 0xF7,0x36,0x36,0x36, 0x36,0x36,0x37,0x30, 0x37,0x36,0x36,0x36, 0x00,0x00,0xFF,0x00, 0xFF,0x00,0x00,0x00, 0x36,0x36,0xF7,0x00, 0xF7,0x36,0x36,0x36, 0x18,0x18,0xFF,0x00, 0xFF,0x00,0x00,0x00, 0x36,0x36,0x36,0x36, 0xFF,0x00,0x00,0x00, 0x00,0x00,0xFF,0x00, 0xFF,0x18,0x18,0x18, 0x00,0x00,0x00,0x00, 0xFF,0x36,0x36,0x36, 0x36,0x36,0x36,0x36, 0x3F,0x00,0x00,0x00, 0x18,0x18,0x1F,0x18, 0x1F,0x00,0x00,0x00, 0x00,0x00,0x1F,0x18, 0x1F,0x18,0x18,0x18, 0x00,0x00,0x00,0x00, 0x3F,0x36,0x36,0x36, 0x36,0x36,0x36,0x36, 0xFF,0x36,0x36,0x36, 0x18,0x18,0xFF,0x18, 0xFF,0x18,0x18,0x18, 0x18,0x18,0x18,0x18, 0xF8,0x00,0x00,0x00, 0x00,0x00,0x00,0x00, 0x1F,0x18,0x18,0x18, 0xFF,0xFF,0xFF,0xFF, 0xFF,0xFF,0xFF,0xFF, 0x00,0x00,0x00,0x00, 0xFF,0xFF,0xFF,0xFF, 0xF0,0xF0,0xF0,0xF0, 0xF0,0xF0,0xF0,0xF0, 0x0F,0x0F,0x0F,0x0F, 0x0F,0x0F,0x0F,0x0F, 0xFF,0xFF,0xFF,0xFF, 0x00,0x00,0x00,0x00, 0x00,0x00,0x76,0xDC, 0xC8,0xDC,0x76,0x00, 0x00,0x3C,0x66,0x7C, 0x66,0x7C,0x60,0x60, 0x00,0xFC,0xCC,0xC0, 0xC0,0xC0,0xC0,0x00, 0x00,0xFE,0x6C,0x6C, 0x6C,0x6C,0x6C,0x00, 0xFE,0xC6,0x60,0x30, 0x60,0xC6,0xFE,0x00, 0x00,0x00,0x7E,0xD8, 0xD8,0xD8,0x70,0x00, 0x00,0x66,0x66,0x66, 0x66,0x7C,0x60,0xC0, 0x00,0x76,0xDC,0x18, 0x18,0x18,0x18,0x00, 0xFC,0x30,0x78,0xCC, 0xCC,0x78,0x30,0xFC, 0x38,0x6C,0xC6,0xFE, 0xC6,0x6C,0x38,0x00, 0x38,0x6C,0xC6,0xC6, 0xC6,0x6C,0xEE,0x00, 0x1C,0x30,0x18,0x7C, 0xC6,0xC6,0x7C,0x00, 0x00,0x00,0x7E,0xDB, 0xDB,0x7E,0x00,0x00, 0x06,0x0C,0x7E,0xDB, 0xDB,0x7E,0x30,0x60, 0x38,0x60,0xC0,0xF8, 0xC0,0x60,0x38,0x00, 0x78,0xCC,0xCC,0xCC, 0xCC,0xCC,0xCC,0x00, 0x00,0xFC,0x00,0xFC, 0x00,0xFC,0x00,0x00, 0x30,0x30,0xFC,0x30, 0x30,0x00,0xFC,0x00, 0x60,0x30,0x18,0x30, 0x60,0x00,0xFC,0x00, 0x18,0x30,0x60,0x30, 0x18,0x00,0xFC,0x00, 0x0E,0x1B,0x1B,0x18, 0x18,0x18,0x18,0x18, 0x18,0x18,0x18,0x18, 0x18,0xD8,0xD8,0x70, 0x30,0x30,0x00,0xFC, 0x00,0x30,0x30,0x00, 0x00,0x76,0xDC,0x00, 0x76,0xDC,0x00,0x00, 0x38,0x6C,0x6C,0x38, 0x00,0x00,0x00,0x00, 0x00,0x00,0x00,0x18, 0x18,0x00,0x00,0x00, 0x00,0x00,0x00,0x00, 0x18,0x00,0x00,0x00, 0x0F,0x0C,0x0C,0x0C, 0xEC,0x6C,0x3C,0x1C, 0x7C,0x66,0x66,0x66, 0x66,0x00,0x00,0x00, 0x70,0x18,0x30,0x60, 0x78,0x00,0x00,0x00, 0x00,0x00,0x3C,0x3C, 0x3C,0x3C,0x00,0x00, 0x00,0x00,0x00,0x00, 0x00,0x00,0x00,0x00,
 };
 
+// CP437 (ANSI BBS) to font glyph translation tables, one per font choice. See App_ChangeUIFont().
+// ANSI fonts already use CP437 code points, so they get a straight pass-through table
+const static uint8_t		app_glyph_lut_cp437[256] = 
+{
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,	// 0x00
+	0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F,	// 0x10
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,	// 0x20
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,	// 0x30
+	0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,	// 0x40
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0x5C, 0x5D, 0x5E, 0x5F,	// 0x50
+	0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F,	// 0x60
+	0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x7B, 0x7C, 0x7D, 0x7E, 0x7F,	// 0x70
+	0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8A, 0x8B, 0x8C, 0x8D, 0x8E, 0x8F,	// 0x80
+	0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0x9B, 0x9C, 0x9D, 0x9E, 0x9F,	// 0x90
+	0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF,	// 0xA0
+	0xB0, 0xB1, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xBB, 0xBC, 0xBD, 0xBE, 0xBF,	// 0xB0
+	0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF,	// 0xC0
+	0xD0, 0xD1, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xDB, 0xDC, 0xDD, 0xDE, 0xDF,	// 0xD0
+	0xE0, 0xE1, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xEB, 0xEC, 0xED, 0xEE, 0xEF,	// 0xE0
+	0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF,	// 0xF0
+};
+
+// Foenix std font: box-drawing, blocks and shades go to the nearest Foeniscii line/fill glyph; accented and greek letters drop to plain ASCII
+const static uint8_t		app_glyph_lut_foenix[256] = 
+{
+	0x00, 0x6F, 0x6F, 0xFC, 0xFD, 0x2A, 0x2A, 0x2E, 0x07, 0x6F, 0x07, 0x6F, 0x2B, 0x64, 0x64, 0x2A,	// 0x00
+	0x3E, 0x3C, 0x7C, 0x21, 0x50, 0x53, 0x03, 0x7C, 0x5E, 0x76, 0x3E, 0x3C, 0x4C, 0x2D, 0x5E, 0x76,	// 0x10
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,	// 0x20
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,	// 0x30
+	0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,	// 0x40
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0x5C, 0x5D, 0x5E, 0x5F,	// 0x50
+	0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F,	// 0x60
+	0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x7B, 0x7C, 0x7D, 0x7E, 0x5E,	// 0x70
+	0x43, 0x75, 0x65, 0x61, 0x61, 0x61, 0x61, 0x63, 0x65, 0x65, 0x65, 0x69, 0x69, 0x69, 0x41, 0x41,	// 0x80
+	0x45, 0x61, 0x41, 0x6F, 0x6F, 0x6F, 0x75, 0x75, 0x79, 0x4F, 0x55, 0x63, 0x4C, 0x59, 0x50, 0x66,	// 0x90
+	0x61, 0x69, 0x6F, 0x75, 0x6E, 0x4E, 0x61, 0x6F, 0x3F, 0x2D, 0x2D, 0x32, 0x34, 0x21, 0x3C, 0x3E,	// 0xA0
+	0x10, 0xC7, 0x17, 0x82, 0x9E, 0x9E, 0xA8, 0xA1, 0xA1, 0xA8, 0xAE, 0xAA, 0xAC, 0xA3, 0xA3, 0xA1,	// 0xB0
+	0xA2, 0x9D, 0x9B, 0x9A, 0x96, 0x9C, 0x9A, 0xA4, 0xAB, 0xA9, 0xA7, 0xA5, 0xA4, 0xAD, 0xA6, 0xA7,	// 0xC0
+	0x9D, 0xA5, 0x9B, 0xA2, 0xA2, 0xA0, 0xA0, 0x9C, 0x9C, 0xA3, 0xA0, 0x07, 0x03, 0x89, 0x90, 0x0B,	// 0xD0
+	0x61, 0x42, 0x47, 0x70, 0x53, 0x73, 0x6D, 0x74, 0x46, 0x54, 0x4F, 0x64, 0x38, 0x66, 0x65, 0x6E,	// 0xE0
+	0x3D, 0x2B, 0x3E, 0x3C, 0x7C, 0x7C, 0x2F, 0x7E, 0x6F, 0x2E, 0x2E, 0x76, 0x6E, 0x32, 0x07, 0x20,	// 0xF0
+};
+
+// Foenix kana font: same as std up to 191, so it has the same line glyphs. kana occupy 192-255: the CP437 box-drawing
+// block (192-223) is sent to the line glyphs, as in the std table, and only 224-255 pass through untouched
+const static uint8_t		app_glyph_lut_kana[256] = 
+{
+	0x00, 0x6F, 0x6F, 0x2A, 0x2A, 0x2A, 0x2A, 0x2E, 0x07, 0x6F, 0x07, 0x6F, 0x2B, 0x64, 0x64, 0x2A,	// 0x00
+	0x3E, 0x3C, 0x7C, 0x21, 0x50, 0x53, 0x03, 0x7C, 0x5E, 0x76, 0x3E, 0x3C, 0x4C, 0x2D, 0x5E, 0x76,	// 0x10
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,	// 0x20
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,	// 0x30
+	0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,	// 0x40
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0x5C, 0x5D, 0x5E, 0x5F,	// 0x50
+	0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F,	// 0x60
+	0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x7B, 0x7C, 0x7D, 0x7E, 0x5E,	// 0x70
+	0x43, 0x75, 0x65, 0x61, 0x61, 0x61, 0x61, 0x63, 0x65, 0x65, 0x65, 0x69, 0x69, 0x69, 0x41, 0x41,	// 0x80
+	0x45, 0x61, 0x41, 0x6F, 0x6F, 0x6F, 0x75, 0x75, 0x79, 0x4F, 0x55, 0x63, 0x4C, 0x59, 0x50, 0x66,	// 0x90
+	0x61, 0x69, 0x6F, 0x75, 0x6E, 0x4E, 0x61, 0x6F, 0x3F, 0x2D, 0x2D, 0x32, 0x34, 0x21, 0x3C, 0x3E,	// 0xA0
+	0x10, 0x12, 0x17, 0x82, 0x9E, 0x9E, 0xA8, 0xA1, 0xA1, 0xA8, 0xAE, 0xAA, 0xAC, 0xA3, 0xA3, 0xA1,	// 0xB0
+	0xA2, 0x9D, 0x9B, 0x9A, 0x96, 0x9C, 0x9A, 0xA4, 0xAB, 0xA9, 0xA7, 0xA5, 0xA4, 0xAD, 0xA6, 0xA7,	// 0xC0
+	0x9D, 0xA5, 0x9B, 0xA2, 0xA2, 0xA0, 0xA0, 0x9C, 0x9C, 0xA3, 0xA0, 0x07, 0x03, 0x89, 0x90, 0x0B,	// 0xD0
+	0xE0, 0xE1, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xEB, 0xEC, 0xED, 0xEE, 0xEF,	// 0xE0
+	0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF,	// 0xF0
+};
+
+
 /*****************************************************************************/
 /*                             Global Variables                              */
 /*****************************************************************************/
 
 extern uint8_t*				global_uart_in_buffer;
 extern uint16_t				global_uart_write_idx;
+extern uint16_t				global_uart_read_idx;
+extern SerialErrorCounts	global_uart_error_counts;
+extern bool					global_uart_error_pending;
+extern uint8_t				global_uart_modem_status;
+extern bool					global_uart_modem_status_pending;
+extern bool					global_uart_rts_held;
+extern uint8_t				global_uart_tx_buffer[UART_TX_BUFFER_SIZE];
+extern volatile uint16_t	global_uart_tx_write_idx;
+extern volatile uint16_t	global_uart_tx_read_idx;
 
 uint8_t					global_file_buffer_storage[STORAGE_FILE_BUFFER_LEN];
 uint8_t*				global_file_buffer = global_file_buffer_storage;
@@ -161,6 +311,19 @@ bool					global_launcher_mode = false;
 ui_glyph_choice			global_ui_charset = UI_MODE_NOT_SET;
 font_choice				global_font = FONT_NOT_SET;
 
+static emulation_mode	app_emulation = EMULATION_ANSI;	// current terminal emulation
+static font_choice		app_ansi_font = FONT_IBM_ANSI;	// font to restore when switching back to ANSI emulation
+
+// status message to show when switching to each emulation
+static const uint8_t	app_emulation_msg_id[EMULATION_MAX] = 
+{
+	ID_STR_MSG_EMULATION_ANSI,
+	ID_STR_MSG_EMULATION_PETSCII,
+	ID_STR_MSG_EMULATION_ATASCII,
+	ID_STR_MSG_EMULATION_AVATAR,
+	ID_STR_MSG_EMULATION_RIP,
+};
+
 FATFS					global_ffs_device[DEVICE_MAX_FFS_DEVICE_COUNT];		// FFS objects for SD cards
 
 // char					app_search_phrase_human_readable_storage[MAX_SEARCH_PHRASE_LEN + 1];
@@ -218,6 +381,9 @@ void App_DrawTitleBar(void);
 // Switch font
 void App_ChangeUIFont(font_choice the_font);
 
+// Switch terminal emulation, loading whichever font the emulation needs
+void App_ChangeEmulation(emulation_mode new_mode);
+
 // display information about f/manager
 void App_ShowAppAboutInfo(void);
 
@@ -244,6 +410,36 @@ void App_ExitStealthTextUpdateMode(void);
 // have serial change baud rate and show msg and label
 void App_ChangeBaudRate(uint8_t new_config_index);
 
+// modem connection state or online time changed: redraw the status line, and follow the CONNECT rate if asked to
+void App_HandleModemStatusChange(void);
+
+// draw connection state (and time online) on the title bar
+void App_DisplayConnectionStatus(void);
+
+// start stepping through the baud rates, sending AT at each, until the modem answers OK
+void App_StartAutoBaud(void);
+
+// switch to the rate at app_autobaud_order[app_autobaud_step] and send AT
+void App_AutoBaudProbe(void);
+
+// call from the main loop while detection is running: move on to the next rate if the modem hasn't answered in time
+void App_AutoBaudCheck(void);
+
+// stop detection without a result, go back to the rate in use before it started, and say why
+void App_CancelAutoBaud(uint8_t the_string_id);
+
+// switch to the next data bits/parity/stop bits combination, and show msg and label
+void App_CycleLineFormat(void);
+
+// start sending a BREAK. the main loop ends it after BREAK_DURATION_TICKS.
+void App_StartBreak(void);
+
+// hang up by turning DTR off. the main loop turns it back on after HANG_UP_DTR_TICKS.
+void App_StartHangUp(void);
+
+// draw carrier detect (DCD) state on the title bar
+void App_DisplayCarrierStatus(void);
+
 		
 
 /*****************************************************************************/
@@ -278,6 +474,10 @@ void App_DrawTitleBar(void)
 	
 	// redraw baud display
 	Text_DrawStringAtXY(TERM_BAUD_X1, TITLE_BAR_Y, Strings_GetString(app_baud_config[app_current_baud_config].lbl_string_id_), ANSI_COLOR_BRIGHT_BLUE, COLOR_BLACK);	
+	Text_DrawStringAtXY(TERM_FORMAT_X1, TITLE_BAR_Y, Strings_GetString(app_line_format_config[app_current_line_format].lbl_string_id_), ANSI_COLOR_BRIGHT_BLUE, COLOR_BLACK);	
+	
+	App_DisplayConnectionStatus();
+	App_DisplayCarrierStatus();
 
 	// also draw the comms area
 	//Buffer_DrawCommunicationArea();
@@ -314,10 +514,12 @@ void App_ChangeUIFont(font_choice the_font)
 	}
 
 	// separately consider if a font needs to be loaded into VICKY, or just switched over
+	// each font also brings its own CP437 translation table, so BBS box-drawing etc. lands on the closest glyph
 	
 	if (the_font == FONT_STD)
 	{
 		Text_UpdateFontData((char*)app_font_std, PARAM_USE_PRIMARY_FONT_SLOT);
+		Serial_SetGlyphLUT(app_glyph_lut_foenix);
 	}
 	else if (the_font == FONT_STD_KANA)
 	{
@@ -326,20 +528,56 @@ void App_ChangeUIFont(font_choice the_font)
 		// R8(VICKY_MASTER_CTRL_REG_H) = (VICKY_RES_FON_SET);
 		// but if we just switch to font 2, when user toggles to kana entry and then back, event system will switch back to font 1. so load font 1 ALSO with kana font
 		Text_UpdateFontData((char*)app_font_ja, PARAM_USE_PRIMARY_FONT_SLOT);
+		Serial_SetGlyphLUT(app_glyph_lut_kana);
 	}
 	else if (the_font == FONT_STD_ANSI)
 	{
 		Text_UpdateFontData((char*)app_font_std_ansi, PARAM_USE_PRIMARY_FONT_SLOT);
+		Serial_SetGlyphLUT(app_glyph_lut_cp437);
 	}
 	else if (the_font == FONT_IBM_ANSI)
 	{
 		Text_UpdateFontData((char*)app_font_ibm_ansi, PARAM_USE_PRIMARY_FONT_SLOT);
+		Serial_SetGlyphLUT(app_glyph_lut_cp437);
 	}	
 
 	App_DrawTitleBar();
 }
 
 
+// Switch terminal emulation, loading whichever font the emulation needs
+void App_ChangeEmulation(emulation_mode new_mode)
+{
+	if (app_emulation != EMULATION_PETSCII && app_emulation != EMULATION_ATASCII)
+	{
+		// remember user's ANSI font choice so we can go back to it
+		app_ansi_font = global_font;
+	}
+	
+	// RIPscrip draws on the bitmap layer, which is only on while RIPscrip emulation is selected
+	if (RIP_Activate(new_mode == EMULATION_RIP) == false)
+	{
+		Buffer_NewMessage(Strings_GetString(ID_STR_ERROR_ALLOC_FAIL));
+		new_mode = EMULATION_ANSI;
+	}
+	
+	app_emulation = new_mode;
+	
+	// PETSCII and ATASCII glyphs are mapped onto the Foenix std font's line drawing and block characters
+	if (new_mode == EMULATION_PETSCII || new_mode == EMULATION_ATASCII)
+	{
+		App_ChangeUIFont(FONT_STD);
+	}
+	else
+	{
+		App_ChangeUIFont(app_ansi_font);
+	}
+	
+	Serial_SetEmulation(new_mode);
+	Buffer_NewMessage(Strings_GetString(app_emulation_msg_id[new_mode]));
+}
+
+
 // display information about f/manager
 void App_ShowAppAboutInfo(void)
 {
@@ -457,6 +695,9 @@ void App_Initialize(void)
 	//global_font = FONT_STD_ANSI;			// default to foenix look ANSI font
 	App_ChangeUIFont(FONT_IBM_ANSI);
 
+	// make sure the PSG is quiet until ANSI music asks for something
+	Music_Stop();
+	
 	// initialize serial port for terminal comms
 	Serial_InitUART();
 	Serial_InitANSIColors();
@@ -504,10 +745,59 @@ void App_MainLoop(void)
 		do
 		{
 			Serial_ProcessAvailableData();
+			
+			if (Serial_CheckZModemStart() == true)
+			{
+				Transfer_ReceiveZModem(true);
+			}
+			
+			if (Modem_CheckStatusChanged() == true)
+			{
+				App_HandleModemStatusChange();
+			}
+
+			if (app_autobaud_step != AUTOBAUD_NOT_RUNNING)
+			{
+				App_AutoBaudCheck();
+			}
+
+			if (app_break_active == true && (uint16_t)(app_ticks - app_break_start_tick) >= BREAK_DURATION_TICKS)
+			{
+				app_break_active = false;
+				Serial_SetBreak(false);
+			}
+
+			if (app_hang_up_active == true && (uint16_t)(app_ticks - app_hang_up_start_tick) >= HANG_UP_DTR_TICKS)
+			{
+				app_hang_up_active = false;
+				Serial_SetDTR(true);
+			}
+
+			if (global_uart_modem_status_pending == true)
+			{
+				global_uart_modem_status_pending = false;
+				Modem_SetCarrier((global_uart_modem_status & FLAG_UART_MSR_DCD) != 0);
+				App_DisplayCarrierStatus();
+			}
+
+			// a bad line can raise an error with every byte: report the running totals once a second at most.
+			// errors in between stay pending, so the next report includes them.
+			if (global_uart_error_pending == true && (uint16_t)(app_ticks - app_error_msg_tick) >= SERIAL_ERROR_MSG_TICKS)
+			{
+				global_uart_error_pending = false;
+				app_error_msg_tick = app_ticks;
+				sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_SERIAL_ERRORS), global_uart_error_counts.parity_, global_uart_error_counts.framing_, global_uart_error_counts.overrun_, global_uart_error_counts.break_);
+				Buffer_NewMessage(global_string_buff1);
+			}
 
 			user_input = Keyboard_GetKeyIfPressed();
 			
-			if (user_input > 0)
+			if (user_input > 0 && app_autobaud_step != AUTOBAUD_NOT_RUNNING)
+			{
+				// any key stops baud rate detection
+				App_CancelAutoBaud(ID_STR_MSG_AUTOBAUD_STOPPED);
+			}
+			else if (user_input > 0)
 			{
 				//sprintf(global_string_buff1, "input: %x (%d)", user_input, user_input);
 				//Buffer_NewMessage(global_string_buff1);
@@ -540,11 +830,89 @@ void App_MainLoop(void)
 				{
 					Serial_CycleForegroundColor();
 				}
-// 				else if (user_input == ACTION_RECEIVE_YMODEM)
-// 				{
-// 					Buffer_NewMessage("Starting YModem receive...");
-// 					Serial_StartYModemReceive();
-// 				}
+				else if (user_input == ACTION_TOGGLE_UTF8)
+				{
+					if (Serial_ToggleUTF8Mode() == true)
+					{
+						Buffer_NewMessage(Strings_GetString(ID_STR_MSG_UTF8_ON));
+					}
+					else
+					{
+						Buffer_NewMessage(Strings_GetString(ID_STR_MSG_UTF8_OFF));
+					}
+				}
+				else if (user_input == ACTION_TOGGLE_TELNET)
+				{
+					if (Serial_ToggleTelnetMode() == true)
+					{
+						Buffer_NewMessage(Strings_GetString(ID_STR_MSG_TELNET_ON));
+					}
+					else
+					{
+						Buffer_NewMessage(Strings_GetString(ID_STR_MSG_TELNET_OFF));
+					}
+				}
+				else if (user_input == ACTION_TOGGLE_CONNECT_BAUD)
+				{
+					app_baud_follows_connect = !app_baud_follows_connect;
+					Buffer_NewMessage(Strings_GetString(app_baud_follows_connect ? ID_STR_MSG_CONNECT_BAUD_ON : ID_STR_MSG_CONNECT_BAUD_OFF));
+				}
+				else if (user_input == ACTION_DETECT_BAUD)
+				{
+					App_StartAutoBaud();
+				}
+				else if (user_input == ACTION_CYCLE_LINE_FORMAT)
+				{
+					App_CycleLineFormat();
+				}
+				else if (user_input == ACTION_SEND_BREAK)
+				{
+					App_StartBreak();
+				}
+				else if (user_input == ACTION_CYCLE_EMULATION)
+				{
+					if (app_emulation + 1 >= EMULATION_MAX)
+					{
+						App_ChangeEmulation(EMULATION_ANSI);
+					}
+					else
+					{
+						App_ChangeEmulation(app_emulation + 1);
+					}
+				}
+				else if (user_input == ACTION_RECEIVE_YMODEM)
+				{
+					Transfer_ReceiveYModem(false);
+				}
+				else if (user_input == ACTION_RECEIVE_YMODEM_G)
+				{
+					Transfer_ReceiveYModem(true);
+				}
+				else if (user_input == ACTION_RECEIVE_ZMODEM)
+				{
+					Transfer_ReceiveZModem(false);
+				}
+				else if (user_input == ACTION_RECEIVE_KERMIT)
+				{
+					Transfer_ReceiveKermit();
+				}
+				else if (user_input == ACTION_SEND_YMODEM || user_input == ACTION_SEND_XMODEM || user_input == ACTION_SEND_KERMIT)
+				{
+					General_Strlcpy((char*)&global_dlg_title, Strings_GetString(ID_STR_DLG_UPLOAD_TITLE), COMM_BUFFER_MAX_STRING_LEN);
+					General_Strlcpy((char*)&global_dlg_body_msg, Strings_GetString(ID_STR_DLG_UPLOAD_BODY), APP_DIALOG_WIDTH);
+					global_string_buff2[0] = 0;	// clear whatever string had been in this buffer before
+					
+					success = Text_DisplayTextEntryDialog(&global_dlg, (char*)&temp_screen_buffer_char, (char*)&temp_screen_buffer_attr, global_string_buff2, APP_DIALOG_WIDTH - 4, APP_ACCENT_COLOR, APP_FOREGROUND_COLOR, APP_BACKGROUND_COLOR);
+					
+					if (success && user_input == ACTION_SEND_KERMIT)
+					{
+						Transfer_SendKermit(global_string_buff2);
+					}
+					else if (success)
+					{
+						Transfer_SendYModem(global_string_buff2, (user_input == ACTION_SEND_XMODEM));
+					}
+				}
 				else if (user_input == ACTION_SET_TIME)
 				{
 					General_Strlcpy((char*)&global_dlg_title, Strings_GetString(ID_STR_DLG_SET_CLOCK_TITLE), COMM_BUFFER_MAX_STRING_LEN);
@@ -560,6 +928,20 @@ void App_MainLoop(void)
 						App_DisplayTime();
 					}
 				}
+				else if (user_input == ACTION_SET_ANSWERBACK)
+				{
+					General_Strlcpy((char*)&global_dlg_title, Strings_GetString(ID_STR_DLG_ANSWERBACK_TITLE), COMM_BUFFER_MAX_STRING_LEN);
+					General_Strlcpy((char*)&global_dlg_body_msg, Strings_GetString(ID_STR_DLG_ANSWERBACK_BODY), APP_DIALOG_WIDTH);
+					General_Strlcpy(global_string_buff2, Serial_GetAnswerback(), SERIAL_ANSWERBACK_MAX_LEN + 1);	// start from the current message
+					
+					success = Text_DisplayTextEntryDialog(&global_dlg, (char*)&temp_screen_buffer_char, (char*)&temp_screen_buffer_attr, global_string_buff2, SERIAL_ANSWERBACK_MAX_LEN, APP_ACCENT_COLOR, APP_FOREGROUND_COLOR, APP_BACKGROUND_COLOR);
+					
+					if (success)
+					{
+						Serial_SetAnswerback(global_string_buff2);
+						Buffer_NewMessage(Strings_GetString(ID_STR_MSG_ANSWERBACK_SET));
+					}
+				}
 				else if (user_input == ACTION_DEBUG_DUMP)
 				{
 					if (Serial_DebugDump() == true)
@@ -571,26 +953,26 @@ void App_MainLoop(void)
 						Buffer_NewMessage(Strings_GetString(ID_STR_ERROR_GENERIC_DISK));
 					}
 				}
-// 2024/08/02 MB: did not succeed in getting either of the below approaches to work. the +++ATH thing definitely ruins the call, but modem still says connected.
-// 				else if (user_input == ACTION_ABORT_SESSION)
-// 				{
-// 					// user wants to abort connection. 
-// 					// TODO: confirm with dialog
-// 
-// 					// hang up by dropping DTR for at least 2 seconds
-// 					//sprintf(global_string_buff1, "trying to hang up. DTR=%x, will be=%x", R8(UART_MCR), R8(UART_MCR) | FLAG_UART_MCR_DTR);
-// 					sprintf(global_string_buff1, "trying to hang up...");
-// 					Buffer_NewMessage(global_string_buff1);
-// 					//R8(UART_MCR) = R8(UART_MCR) | FLAG_UART_MCR_DTR;
-// 
-// 					sprintf(global_string_buff1, "%s%c", (char*)"+++ATH", 13);	// needs return for modem to see it.
-// 					Serial_SendData((uint8_t*)global_string_buff1, 7);	// then need to wait for "OK", then send "ATH"
-// 
-// 					return;
-// 				}
+				else if (user_input == ACTION_HANG_UP)
+				{
+					App_StartHangUp();
+				}
+#ifdef TRANSFER_TRACE
+				else if (user_input == ACTION_DUMP_TRACE)
+				{
+					if (Trace_DumpToDisk() == true)
+					{
+						Buffer_NewMessage(Strings_GetString(ID_STR_MSG_TRACE_DUMP));
+					}
+					else
+					{
+						Buffer_NewMessage(Strings_GetString(ID_STR_ERROR_GENERIC_DISK));
+					}
+				}
+#endif
 				else
 				{
-					Serial_SendByte(user_input);
+					Serial_SendByte(Serial_TranslateKey(user_input));
 					
 					//Text_SetChar(user_input);
 				}
@@ -618,6 +1000,209 @@ void App_ChangeBaudRate(uint8_t new_config_index)
 }
 
 
+// modem connection state or online time changed: redraw the status line, and follow the CONNECT rate if asked to
+void App_HandleModemStatusChange(void)
+{
+	uint8_t		i;
+	
+	if (Modem_IsOnline() == true && app_was_online == false && app_baud_follows_connect == true)
+	{
+		for (i = 0; i < NUM_BAUD_CONFIGS; i++)
+		{
+			if (app_baud_config[i].rate_ == Modem_GetConnectRate())
+			{
+				if (i != app_current_baud_config)
+				{
+					App_ChangeBaudRate(i);
+				}
+				break;
+			}
+		}
+	}
+	
+	app_was_online = Modem_IsOnline();
+	
+	App_DisplayConnectionStatus();
+}
+
+
+// start stepping through the baud rates, sending AT at each, until the modem answers OK
+void App_StartAutoBaud(void)
+{
+	// once online, AT would go to the BBS, not the modem
+	if (Modem_IsOnline() == true)
+	{
+		Buffer_NewMessage(Strings_GetString(ID_STR_MSG_AUTOBAUD_ONLINE));
+		return;
+	}
+	
+	Buffer_NewMessage(Strings_GetString(ID_STR_MSG_AUTOBAUD_START));
+	
+	app_autobaud_prev_config = app_current_baud_config;
+	app_autobaud_start_tick = app_ticks;
+	app_autobaud_step = 0;
+	
+	App_AutoBaudProbe();
+}
+
+
+// switch to the rate at app_autobaud_order[app_autobaud_step] and send AT
+void App_AutoBaudProbe(void)
+{
+	static uint8_t	the_probe[3] = {'A', 'T', CH_ENTER};
+	
+	// LOGIC:
+	//   at the wrong rate, whatever the modem sends back arrives as garbage, and can't match "OK" on a line by itself.
+	//   Modem_StartProbe() resets the modem matcher so a half-matched line from the previous rate can't complete at this one,
+	//   and works out how long to wait for OK: longer at slow rates, where the probe and answer take a while just to send.
+	//   the rate is set directly rather than with App_ChangeBaudRate(), so the message area doesn't fill with 10 baud messages.
+	
+	app_current_baud_config = app_autobaud_order[app_autobaud_step];
+	Serial_SetBaud(app_baud_config[app_current_baud_config].divisor_);
+	
+	App_EnterStealthTextUpdateMode();
+	Text_DrawStringAtXY(TERM_BAUD_X1, TITLE_BAR_Y, Strings_GetString(app_baud_config[app_current_baud_config].lbl_string_id_), COLOR_BRIGHT_BLUE, COLOR_BLACK);
+	App_ExitStealthTextUpdateMode();
+	
+	Modem_StartProbe(app_baud_config[app_current_baud_config].rate_, app_ticks);
+	Serial_SendData(the_probe, sizeof(the_probe));
+}
+
+
+// call from the main loop while detection is running: move on to the next rate if the modem hasn't answered in time
+void App_AutoBaudCheck(void)
+{
+	uint16_t			the_ticks;
+	modem_probe_result	the_result;
+	
+	the_result = Modem_CheckProbe(app_ticks);
+	
+	if (the_result == MODEM_PROBE_ANSWERED)
+	{
+		the_ticks = app_ticks - app_autobaud_start_tick;
+		app_autobaud_step = AUTOBAUD_NOT_RUNNING;
+		
+		App_ChangeBaudRate(app_current_baud_config);
+		sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_AUTOBAUD_FOUND), the_ticks / MODEM_TICKS_PER_SECOND, ((the_ticks % MODEM_TICKS_PER_SECOND) * 10) / MODEM_TICKS_PER_SECOND);
+		Buffer_NewMessage(global_string_buff1);
+		return;
+	}
+	
+	if (the_result == MODEM_PROBE_WAITING)
+	{
+		return;
+	}
+	
+	if (++app_autobaud_step >= NUM_BAUD_CONFIGS)
+	{
+		App_CancelAutoBaud(ID_STR_MSG_AUTOBAUD_FAILED);
+		return;
+	}
+	
+	App_AutoBaudProbe();
+}
+
+
+// stop detection without a result, go back to the rate in use before it started, and say why
+void App_CancelAutoBaud(uint8_t the_string_id)
+{
+	app_autobaud_step = AUTOBAUD_NOT_RUNNING;
+	
+	App_ChangeBaudRate(app_autobaud_prev_config);
+	Buffer_NewMessage(Strings_GetString(the_string_id));
+}
+
+
+// switch to the next data bits/parity/stop bits combination, and show msg and label
+void App_CycleLineFormat(void)
+{
+	if (++app_current_line_format >= NUM_LINE_FORMATS)
+	{
+		app_current_line_format = 0;
+	}
+	
+	Serial_SetLineFormat(app_line_format_config[app_current_line_format].lcr_bits_);
+
+	App_EnterStealthTextUpdateMode();
+	sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_SET_LINE_FORMAT), Strings_GetString(app_line_format_config[app_current_line_format].lbl_string_id_));
+	Buffer_NewMessage(global_string_buff1);
+	Text_DrawStringAtXY(TERM_FORMAT_X1, TITLE_BAR_Y, Strings_GetString(app_line_format_config[app_current_line_format].lbl_string_id_), COLOR_BRIGHT_BLUE, COLOR_BLACK);
+	App_ExitStealthTextUpdateMode();
+}
+
+
+// start sending a BREAK. the main loop ends it after BREAK_DURATION_TICKS.
+void App_StartBreak(void)
+{
+	if (app_break_active == true)
+	{
+		return;
+	}
+	
+	app_break_start_tick = app_ticks;
+	app_break_active = true;
+	Serial_SetBreak(true);
+	
+	Buffer_NewMessage(Strings_GetString(ID_STR_MSG_SENT_BREAK));
+}
+
+
+// hang up by turning DTR off. the main loop turns it back on after HANG_UP_DTR_TICKS.
+void App_StartHangUp(void)
+{
+	if (app_hang_up_active == true)
+	{
+		return;
+	}
+	
+	app_hang_up_start_tick = app_ticks;
+	app_hang_up_active = true;
+	Serial_SetDTR(false);
+	
+	Buffer_NewMessage(Strings_GetString(ID_STR_MSG_HANG_UP));
+}
+
+
+// draw carrier detect (DCD) state on the title bar
+void App_DisplayCarrierStatus(void)
+{
+	App_EnterStealthTextUpdateMode();
+	Text_DrawStringAtXY(TERM_CARRIER_X1, TITLE_BAR_Y, Strings_GetString(ID_STR_LBL_CARRIER), ((global_uart_modem_status & FLAG_UART_MSR_DCD) != 0) ? COLOR_BRIGHT_GREEN : COLOR_DARK_GRAY, COLOR_BLACK);
+	App_ExitStealthTextUpdateMode();
+}
+
+
+// draw connection state (and time online) on the title bar
+void App_DisplayConnectionStatus(void)
+{
+	uint32_t	the_seconds;
+	uint8_t		the_color;
+	
+	if (Modem_IsOnline() == true)
+	{
+		the_seconds = Modem_GetOnlineSeconds();
+		sprintf(global_string_buff1, "%s %02lu:%02lu:%02lu", Strings_GetString(ID_STR_CONN_ONLINE), (unsigned long)(the_seconds / 3600), (unsigned long)((the_seconds / 60) % 60), (unsigned long)(the_seconds % 60));
+		the_color = COLOR_BRIGHT_GREEN;
+	}
+	else
+	{
+		sprintf(global_string_buff1, "%-*s", TERM_CONN_WIDTH, Strings_GetString(app_modem_result_label_id[Modem_GetLastResult()]));
+		the_color = COLOR_BRIGHT_YELLOW;
+	}
+	
+	App_EnterStealthTextUpdateMode();
+	Text_DrawStringAtXY(TERM_CONN_X1, TITLE_BAR_Y, global_string_buff1, the_color, COLOR_BLACK);
+	App_ExitStealthTextUpdateMode();
+}
+
+
+// returns the number of RTC periodic interrupts (16/sec) since startup. wraps every ~68 minutes: compare differences, not values.
+uint16_t App_GetTicks(void)
+{
+	return app_ticks;
+}
+
+
 // saves current cursor position and turns off visible cursor during non-serial UI updates
 // call this when redrawing UI, updating baud display, etc, where you don't want cursor to leave terminal area
 void App_EnterStealthTextUpdateMode(void)
@@ -641,18 +1226,20 @@ void App_ExitStealthTextUpdateMode(void)
 /*****************************************************************************/
 
 
-// Draws the progress bar frame on the screen
+// Draws the empty progress bar in the title bar
 void App_ShowProgressBar(void)
 {
-	Text_DrawHLine(TERM_PROGRESS_BAR_START_X, PROGRESS_BAR_Y - 1, TERM_PROGRESS_BAR_WIDTH, CH_UNDERSCORE, MENU_ACCENT_COLOR, APP_BACKGROUND_COLOR, CHAR_AND_ATTR);
-	Text_DrawHLine(TERM_PROGRESS_BAR_START_X, PROGRESS_BAR_Y,     TERM_PROGRESS_BAR_WIDTH, CH_SPACE,      MENU_ACCENT_COLOR, APP_BACKGROUND_COLOR, CHAR_AND_ATTR);
-	Text_DrawHLine(TERM_PROGRESS_BAR_START_X, PROGRESS_BAR_Y + 1, TERM_PROGRESS_BAR_WIDTH, CH_OVERSCORE,  MENU_ACCENT_COLOR, APP_BACKGROUND_COLOR, CHAR_AND_ATTR);
+	// the bar sits in the title bar: keep what it covers, to put back in App_HideProgressBar()
+	Text_CopyMemBoxLinearBuffer(app_progress_bar_saved_char, PROGRESS_BAR_START_X, PROGRESS_BAR_Y, PROGRESS_BAR_START_X + PROGRESS_BAR_WIDTH - 1, PROGRESS_BAR_Y, PARAM_COPY_FROM_SCREEN, PARAM_FOR_TEXT_CHAR);
+	Text_CopyMemBoxLinearBuffer(app_progress_bar_saved_attr, PROGRESS_BAR_START_X, PROGRESS_BAR_Y, PROGRESS_BAR_START_X + PROGRESS_BAR_WIDTH - 1, PROGRESS_BAR_Y, PARAM_COPY_FROM_SCREEN, PARAM_FOR_TEXT_ATTR);
+	Text_FillBox(PROGRESS_BAR_START_X, PROGRESS_BAR_Y, PROGRESS_BAR_START_X + PROGRESS_BAR_WIDTH - 1, PROGRESS_BAR_Y, CH_SPACE, COLOR_PROGRESS_BAR, COLOR_BLACK);
 }
 
-// Hides the progress bar frame on the screen
+// Hides the progress bar, putting back the part of the title bar it covered
 void App_HideProgressBar(void)
 {
-	Text_FillBox(TERM_PROGRESS_BAR_START_X, PROGRESS_BAR_Y - 1, (TERM_PROGRESS_BAR_START_X + TERM_PROGRESS_BAR_WIDTH - 1), PROGRESS_BAR_Y + 1, CH_SPACE, MENU_ACCENT_COLOR, APP_BACKGROUND_COLOR);
+	Text_CopyMemBoxLinearBuffer(app_progress_bar_saved_char, PROGRESS_BAR_START_X, PROGRESS_BAR_Y, PROGRESS_BAR_START_X + PROGRESS_BAR_WIDTH - 1, PROGRESS_BAR_Y, PARAM_COPY_TO_SCREEN, PARAM_FOR_TEXT_CHAR);
+	Text_CopyMemBoxLinearBuffer(app_progress_bar_saved_attr, PROGRESS_BAR_START_X, PROGRESS_BAR_Y, PROGRESS_BAR_START_X + PROGRESS_BAR_WIDTH - 1, PROGRESS_BAR_Y, PARAM_COPY_TO_SCREEN, PARAM_FOR_TEXT_ATTR);
 }
 
 
@@ -660,8 +1247,9 @@ void App_HideProgressBar(void)
 void App_UpdateProgressBar(uint8_t progress_bar_total)
 {
 	// logic:
-	//  - has access to 40 positions worth of status: 5 characters each with 8 slots
-	//  - so 2.5% complete = |, 5% = ||, 25%=||||||||  || (imagine PETSCII) 
+	//  - has access to 80 positions worth of status: 10 characters each with 8 slots
+	//  - so 1.25% complete = |, 2.5% = ||, 10% = |||||||| (one full character; imagine PETSCII) 
+	//  - % complete is scaled to slots first, so the bar is full at 100%, not at 80%
 	//  - draws spaces for not-yet-reached char spaces
 	//  - integer division (with non-signed) goes to floor. so 15/8 = 1 r7. 1 is the number of full blocks, 7 (minus 1) is the index to the partial block char
 
@@ -669,11 +1257,13 @@ void App_UpdateProgressBar(uint8_t progress_bar_total)
 	uint8_t		full_blocks;
 	uint8_t		the_char_code;
 	uint8_t		progress_bar_char_index;
+	uint8_t		the_slots;
 
 	progress_bar_total = (progress_bar_total > 100) ? 100 : progress_bar_total;
+	the_slots = ((uint16_t)progress_bar_total * (PROGRESS_BAR_WIDTH * PROGRESS_BAR_DIVISOR)) / 100;
 	
-	full_blocks = progress_bar_total / PROGRESS_BAR_DIVISOR;
-	progress_bar_char_index = progress_bar_total % PROGRESS_BAR_DIVISOR; // remainders will be 0-7: index to app_progress_bar_char[]
+	full_blocks = the_slots / PROGRESS_BAR_DIVISOR;
+	progress_bar_char_index = the_slots % PROGRESS_BAR_DIVISOR; // remainders will be 0-7: index to app_progress_bar_char[]
 
 	for (i = 0; i < PROGRESS_BAR_WIDTH; i++)
 	{
@@ -937,16 +1527,19 @@ __attribute__((interrupt(0xffee))) void irq_handler()
 			// this is a real time clock interrupt
 			//R8(VICKY_TEXT_CHAR_RAM + 159-4) = R8(VICKY_TEXT_CHAR_RAM  + 159-4) + 1; 
 			
-			// clear pending flag before doing any work
-			R8(INT_PENDING_REG1) = pending_int_value;
+			// clear pending flag before doing any work. only this one: a UART interrupt pending at the same time still needs handling below.
+			R8(INT_PENDING_REG1) = JR1_INT04_RTC;
 
 			// double check this is from the RATES function and not some other RTC interrupt
  			if ( (R8(RTC_FLAGS) & FLAG_RTC_PERIODIC_INT) != 0)
 			{
 				// LOGIC:
-				//   we use timer for 2 purposes:
+				//   we use timer for 5 purposes:
 				//     1. see if we need to refresh the clock display. this only needs to happen 1x/second at max.
 				//     2. see if a key has been held down long enough to repeat. this check needs to be on a shorter schedule.
+				//     3. step ANSI music playback. note lengths are counted in these ticks.
+				//     4. count time online for the status line.
+				//     5. time out baud rate detection probes (app_ticks).
 				
 				//R8(VICKY_TEXT_CHAR_RAM + 159-3) = R8(VICKY_TEXT_CHAR_RAM  + 159-3) + 1; 
 				
@@ -967,40 +1560,118 @@ __attribute__((interrupt(0xffee))) void irq_handler()
 				
 				// handle potential keyboard repeat
 				Keyboard_HandleRepeatTimerEvent();
+				
+				// play the next ANSI music note, if one is due
+				Music_HandleTimerEvent();
+				
+				// count time online
+				Modem_HandleTimerEvent();
+				
+				app_ticks++;
 			}
 		}
 		// is this interrupt firing because of UART serial activity?
-		else if ( (pending_int_value & JR1_INT00_UART) != 0)
+		if ( (pending_int_value & JR1_INT00_UART) != 0)
 		{	
-			serial_temp = (R8(UART_LSR) & UART_ERROR_MASK);
+			// clear pending flag before doing any work
+			R8(INT_PENDING_REG1) = JR1_INT00_UART;
 			
-			if (serial_temp > 0)
+			// reading MSR clears a modem status interrupt. keep the value if a line changed, the main loop acts on it.
+			serial_temp = R8(UART_MSR);
+			
+			if ( (serial_temp & UART_MSR_DELTA_MASK) != 0)
+			{
+				global_uart_modem_status = serial_temp;
+				global_uart_modem_status_pending = true;
+			}
+			
+			// LOGIC:
+			//   with the FIFO on, LSR's parity, framing, and break bits describe the byte at the top of the FIFO, not the whole FIFO.
+			//   so LSR is read before each byte: a bad byte is counted and dropped, and the good ones before and after it are kept.
+			//   overrun isn't tied to a byte (bytes were lost because the FIFO was full), and reading LSR clears it.
+			//   errors are counted by type. the main loop reports them: too slow to do from here.
+			while (true)
 			{
-				sprintf(global_string_buff1, "serial error %x", serial_temp);
-				Buffer_NewMessage(global_string_buff1);
-				// clear error by reading the data register. (I think that's supposed to work to clear errors anyway)
-				// Read and clear status registers
 				serial_temp = R8(UART_LSR);
-				serial_temp = R8(UART_MSR);
-				serial_temp = R8(UART_BASE);
+				
+				if ( (serial_temp & UART_ERROR_MASK) != 0)
+				{
+					if ( (serial_temp & UART_OVERRUN_ERROR) != 0)
+					{
+						global_uart_error_counts.overrun_++;
+					}
+					
+					if ( (serial_temp & UART_PARITY_ERROR) != 0)
+					{
+						global_uart_error_counts.parity_++;
+					}
+					
+					if ( (serial_temp & UART_FRAMING_ERROR) != 0)
+					{
+						global_uart_error_counts.framing_++;
+					}
+					
+					if ( (serial_temp & UART_BREAK_INTERRUPT) != 0)
+					{
+						global_uart_error_counts.break_++;
+					}
+					
+					global_uart_error_pending = true;
+				}
+				
+				if ( (serial_temp & UART_DATA_AVAILABLE) == 0)
+				{
+					break;
+				}
+				
+				if ( (serial_temp & UART_BYTE_ERROR_MASK) != 0)
+				{
+					// drop the bad byte (a break arrives as a 0 byte)
+					serial_temp = R8(UART_BASE);
+					continue;
+				}
+				
+				global_uart_in_buffer[global_uart_write_idx++] = R8(UART_BASE);
+				
+				if (global_uart_write_idx >= UART_BUFFER_SIZE)
+				{
+					global_uart_write_idx = 0;
+				}
 			}
-			else
+			
+			// nearly full: drop RTS so the modem stops sending until the app catches up. Serial_ResumeRTS() raises it again.
+			if (global_uart_rts_held == false && ((global_uart_write_idx - global_uart_read_idx) & UART_BUFFER_MASK) >= UART_RTS_OFF_LEVEL)
 			{
-				while ( (R8(UART_LSR) & UART_DATA_AVAILABLE) != 0)
+				R8(UART_MCR) = R8(UART_MCR) & (~FLAG_UART_MCR_RTS);
+				global_uart_rts_held = true;
+			}
+			
+			// transmit FIFO empty: refill it from the send buffer, or stop the THRE interrupt if there is nothing left to send
+			// with the THRE interrupt off, Serial_DrainTransmitBuffer() may be sending by polling: leave the send buffer to it
+			if ( (R8(UART_IER) & FLAG_UART_IER_TXA) != 0 && (R8(UART_LSR) & UART_THR_IS_EMPTY) != 0)
+			{
+				if (global_uart_tx_read_idx == global_uart_tx_write_idx)
 				{
-					global_uart_in_buffer[global_uart_write_idx++] = R8(UART_BASE);
+					R8(UART_IER) = R8(UART_IER) & (~FLAG_UART_IER_TXA);
+				}
+				else
+				{
+					serial_temp = UART_FIFO_SIZE;
 					
-					if (global_uart_write_idx > UART_BUFFER_SIZE)
+					while (serial_temp > 0 && global_uart_tx_read_idx != global_uart_tx_write_idx)
 					{
-						global_uart_write_idx = 0;
+						R8(UART_THR) = global_uart_tx_buffer[global_uart_tx_read_idx];
+						global_uart_tx_read_idx = (global_uart_tx_read_idx + 1) & UART_TX_BUFFER_MASK;
+						serial_temp--;
 					}
 				}
 			}
 		}
-		else
+		
+		// don't know what this is, but need to clear the pending flag
+		if ( (pending_int_value & (~(JR1_INT04_RTC | JR1_INT00_UART))) != 0)
 		{
-			// don't know what this is, but need to clear the pending flag
-			R8(INT_PENDING_REG1) = pending_int_value;
+			R8(INT_PENDING_REG1) = pending_int_value & (~(JR1_INT04_RTC | JR1_INT00_UART));
 		}		
 	}
 }
@@ -283,8 +283,15 @@ typedef struct baud_config
 	uint16_t	divisor_;
 	uint8_t		msg_string_id_;
 	uint8_t		lbl_string_id_;
+	uint32_t	rate_;			// bits per second, as a modem reports it in CONNECT messages
 }  baud_config;
 
+typedef struct line_format_config
+{
+	uint8_t		lcr_bits_;		// UART_DATA_BITS_x | UART_PARITY_x | UART_STOP_BITS_x
+	uint8_t		lbl_string_id_;
+}  line_format_config;
+
 
 // also defined in f256.h
 
@@ -299,10 +306,10 @@ typedef struct baud_config
 /*                       Public Function Prototypes                          */
 /*****************************************************************************/
 
-// Draws the progress bar frame on the screen
+// Draws the empty progress bar in the title bar
 void App_ShowProgressBar(void);
 
-// Hides the progress bar frame on the screen
+// Hides the progress bar, putting back the part of the title bar it covered
 void App_HideProgressBar(void);
 
 // draws the 'bar' part of the progress bar, according to a % complete passed (0-100 integer)
@@ -311,6 +318,9 @@ void App_UpdateProgressBar(uint8_t progress_bar_total);
 // read the real time clock and display it
 void App_DisplayTime(void);
 
+// returns the number of RTC periodic interrupts (16/sec) since startup. wraps every ~68 minutes: compare differences, not values.
+uint16_t App_GetTicks(void);
+
 // display error message, wait for user to confirm, and exit
 void App_Exit(uint8_t the_error_number);
 
@@ -52,6 +52,7 @@ static char 		comm_buff[COMM_BUFF_SIZE];
 static char			comm_temp_line_buff[COMM_BUFFER_MAX_STRING_LEN];	// temp storage for strings to be displayed in buffer; allows wrapping chars to be imebedded without modifying the source string
 static char*		comm_row[COMM_BUFFER_NUM_ROWS];
 static char**		comm_row_ptr[COMM_BUFFER_NUM_ROWS];	// ptp for the comms buffer rows, to allow scrolling
+static bool			comm_last_row_is_status = false;	// bottom row came from Buffer_UpdateStatusMessage(), and no message has arrived since
 
 
 /*****************************************************************************/
@@ -180,6 +181,7 @@ void Buffer_Clear(void)
 	
 	// reset the buffer lines-since-you-did-something-yourself count.
 	comm_curr_buff_row = 0;
+	comm_last_row_is_status = false;
 }
 
 
@@ -236,6 +238,8 @@ void Buffer_NewMessage(char* the_message)
 	char*		right_margin;
 	char*		start_of_string = comm_temp_line_buff;
 
+	comm_last_row_is_status = false;
+
 	//DEBUG_OUT(("%s %d: msg='%s'", __func__, __LINE__, the_message));
 	
 	// check that we haven't already displayed 3 lines worth of buffer since user last hit a key
@@ -290,3 +294,27 @@ void Buffer_NewMessage(char* the_message)
 }
 
 
+// shows a one-line status as the bottom most row. until another message arrives, each call rewrites that row in place instead of scrolling.
+void Buffer_UpdateStatusMessage(char* the_message)
+{
+	uint8_t		old_x;
+	uint8_t		old_y;
+	
+	if (comm_last_row_is_status == false)
+	{
+		Buffer_NewMessage(the_message);
+		comm_last_row_is_status = true;
+		return;
+	}
+	
+	// LOGIC: only the one row changes, so skip the full-box clear and redraw Buffer_RefreshDisplay() does
+	old_x = Text_GetX();
+	old_y = Text_GetY();
+	
+	sprintf(*comm_row_ptr[COMM_BUFFER_NUM_ROWS - 1], "%-*.*s", COMM_BUFFER_NUM_COLS, COMM_BUFFER_NUM_COLS, the_message);
+	Text_DrawStringAtXY(COMM_BUFFER_FIRST_COL, COMM_BUFFER_LAST_ROW, *comm_row_ptr[COMM_BUFFER_NUM_ROWS - 1], BUFFER_FOREGROUND_COLOR, BUFFER_BACKGROUND_COLOR);
+	
+	Text_SetXY(old_x, old_y);
+}
+
+
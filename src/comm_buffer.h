@@ -99,6 +99,9 @@ void Buffer_RefreshDisplay(void);
 // accepts a message as the bottom most row and displays it, scrolling other lines up
 void Buffer_NewMessage(char* the_message);
 
+// shows a one-line status as the bottom most row. until another message arrives, each call rewrites that row in place instead of scrolling.
+void Buffer_UpdateStatusMessage(char* the_message);
+
 
 
 #endif /* COMM_BUFFER_H_ */
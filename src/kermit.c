@@ -0,0 +1,1476 @@
+/*
+ * kermit.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ *
+ *  - Kermit sender and receiver, with long packets and sliding windows. file callbacks are in transfer.c.
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "comm_buffer.h"
+#include "kermit.h"
+#include "progress.h"
+#include "serial.h"
+#include "strings.h"
+#include "trace.h"
+#include "transfer.h"
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+// F256 includes
+#include "f256_e.h"
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+// packet types
+#define KERMIT_TYPE_SEND_INIT	'S'
+#define KERMIT_TYPE_FILE		'F'
+#define KERMIT_TYPE_ATTRIBUTES	'A'
+#define KERMIT_TYPE_DATA		'D'
+#define KERMIT_TYPE_EOF			'Z'
+#define KERMIT_TYPE_BREAK		'B'		// end of session
+#define KERMIT_TYPE_ACK			'Y'
+#define KERMIT_TYPE_NAK			'N'
+#define KERMIT_TYPE_ERROR		'E'
+
+// framing
+#define KERMIT_MARK				0x01	// SOH starts every packet
+#define KERMIT_EOL				0x0D	// we end packets with CR, and ask the other side to
+#define KERMIT_QCTL				'#'		// our control prefix
+#define KERMIT_QBIN				'&'		// 8th-bit prefix we ask for on a 7-bit link
+#define KERMIT_REPT				'~'		// repeat prefix
+#define KERMIT_MAX_SHORT		94		// longest normal packet: LEN is one printable character
+#define KERMIT_MIN_REPEAT		3		// shortest run worth a repeat prefix
+#define KERMIT_MAX_REPEAT		94
+
+// send-init capabilities (CAPAS)
+#define KERMIT_CAP_LONG			0x02	// long packets
+#define KERMIT_CAP_WINDOWS		0x04	// sliding windows
+#define KERMIT_CAP_ATTRIBUTES	0x08	// A packets
+#define KERMIT_CAP_MORE			0x01	// another CAPAS byte follows
+
+// send-init fields, in order
+#define KERMIT_INIT_MAXL		0
+#define KERMIT_INIT_TIME		1
+#define KERMIT_INIT_NPAD		2
+#define KERMIT_INIT_PADC		3
+#define KERMIT_INIT_EOL			4
+#define KERMIT_INIT_QCTL		5
+#define KERMIT_INIT_QBIN		6
+#define KERMIT_INIT_CHKT		7
+#define KERMIT_INIT_REPT		8
+#define KERMIT_INIT_CAPAS		9		// WINDO, MAXLX1, and MAXLX2 follow the last CAPAS byte
+#define KERMIT_INIT_LEN			13		// fields in our send-init
+
+#define KERMIT_TIMEOUT_SECS		5		// how long we ask the other side to wait for us
+#define KERMIT_MIN_TIMEOUT_MS	2000
+#define KERMIT_MAX_TIMEOUT_MS	60000	// the other side may ask for up to 94 seconds. a minute is plenty, and fits a uint16_t.
+#define KERMIT_POLL_MS			1000	// check for ESC this often while waiting
+#define KERMIT_MAX_ERRORS		10		// timeouts or bad packets in a row before giving up
+#define KERMIT_MAX_RETRIES		10		// times one packet is sent again before giving up
+#define KERMIT_RAW_SIZE			1024	// file data read for encoding at a time
+#define KERMIT_DECODE_SIZE		512		// decoded data handed to write_ at a time
+
+// results from Kermit_GetPacket(), besides packet types
+#define KERMIT_TIMEOUT			-1		// same as Serial_GetByte()
+#define KERMIT_BAD_PACKET		-2		// bad length or block check
+#define KERMIT_CANCELLED		-3		// the user pressed ESC
+
+// results from Kermit_ProcessPacket()
+#define KERMIT_CONTINUE			0
+#define KERMIT_DONE				1
+#define KERMIT_FAILED			2
+
+#define KERMIT_SLOT_MASK		(KERMIT_MAX_WINDOW - 1)
+#define KERMIT_SEQ_MASK			63		// sequence numbers are mod 64
+
+#define KERMIT_TOCHAR(x)		((uint8_t)((x) + 32))
+#define KERMIT_UNCHAR(x)		((uint8_t)((x) - 32))
+#define KERMIT_CTL(x)			((uint8_t)((x) ^ 64))
+#define KERMIT_CRC_UPDATE(crc, c)	(((crc) >> 8) ^ kermit_crc16_table[(uint8_t)(crc) ^ (c)])
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+// crc-16 as Kermit does it (poly 0x8408, reflected, no inversion) of every byte value
+static const uint16_t		kermit_crc16_table[256] =
+{
+	0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf,
+	0x8c48, 0x9dc1, 0xaf5a, 0xbed3, 0xca6c, 0xdbe5, 0xe97e, 0xf8f7,
+	0x1081, 0x0108, 0x3393, 0x221a, 0x56a5, 0x472c, 0x75b7, 0x643e,
+	0x9cc9, 0x8d40, 0xbfdb, 0xae52, 0xdaed, 0xcb64, 0xf9ff, 0xe876,
+	0x2102, 0x308b, 0x0210, 0x1399, 0x6726, 0x76af, 0x4434, 0x55bd,
+	0xad4a, 0xbcc3, 0x8e58, 0x9fd1, 0xeb6e, 0xfae7, 0xc87c, 0xd9f5,
+	0x3183, 0x200a, 0x1291, 0x0318, 0x77a7, 0x662e, 0x54b5, 0x453c,
+	0xbdcb, 0xac42, 0x9ed9, 0x8f50, 0xfbef, 0xea66, 0xd8fd, 0xc974,
+	0x4204, 0x538d, 0x6116, 0x709f, 0x0420, 0x15a9, 0x2732, 0x36bb,
+	0xce4c, 0xdfc5, 0xed5e, 0xfcd7, 0x8868, 0x99e1, 0xab7a, 0xbaf3,
+	0x5285, 0x430c, 0x7197, 0x601e, 0x14a1, 0x0528, 0x37b3, 0x263a,
+	0xdecd, 0xcf44, 0xfddf, 0xec56, 0x98e9, 0x8960, 0xbbfb, 0xaa72,
+	0x6306, 0x728f, 0x4014, 0x519d, 0x2522, 0x34ab, 0x0630, 0x17b9,
+	0xef4e, 0xfec7, 0xcc5c, 0xddd5, 0xa96a, 0xb8e3, 0x8a78, 0x9bf1,
+	0x7387, 0x620e, 0x5095, 0x411c, 0x35a3, 0x242a, 0x16b1, 0x0738,
+	0xffcf, 0xee46, 0xdcdd, 0xcd54, 0xb9eb, 0xa862, 0x9af9, 0x8b70,
+	0x8408, 0x9581, 0xa71a, 0xb693, 0xc22c, 0xd3a5, 0xe13e, 0xf0b7,
+	0x0840, 0x19c9, 0x2b52, 0x3adb, 0x4e64, 0x5fed, 0x6d76, 0x7cff,
+	0x9489, 0x8500, 0xb79b, 0xa612, 0xd2ad, 0xc324, 0xf1bf, 0xe036,
+	0x18c1, 0x0948, 0x3bd3, 0x2a5a, 0x5ee5, 0x4f6c, 0x7df7, 0x6c7e,
+	0xa50a, 0xb483, 0x8618, 0x9791, 0xe32e, 0xf2a7, 0xc03c, 0xd1b5,
+	0x2942, 0x38cb, 0x0a50, 0x1bd9, 0x6f66, 0x7eef, 0x4c74, 0x5dfd,
+	0xb58b, 0xa402, 0x9699, 0x8710, 0xf3af, 0xe226, 0xd0bd, 0xc134,
+	0x39c3, 0x284a, 0x1ad1, 0x0b58, 0x7fe7, 0x6e6e, 0x5cf5, 0x4d7c,
+	0xc60c, 0xd785, 0xe51e, 0xf497, 0x8028, 0x91a1, 0xa33a, 0xb2b3,
+	0x4a44, 0x5bcd, 0x6956, 0x78df, 0x0c60, 0x1de9, 0x2f72, 0x3efb,
+	0xd68d, 0xc704, 0xf59f, 0xe416, 0x90a9, 0x8120, 0xb3bb, 0xa232,
+	0x5ac5, 0x4b4c, 0x79d7, 0x685e, 0x1ce1, 0x0d68, 0x3ff3, 0x2e7a,
+	0xe70e, 0xf687, 0xc41c, 0xd595, 0xa12a, 0xb0a3, 0x8238, 0x93b1,
+	0x6b46, 0x7acf, 0x4854, 0x59dd, 0x2d62, 0x3ceb, 0x0e70, 0x1ff9,
+	0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330,
+	0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78,
+};
+
+// terms agreed in the send-init exchange. until then, the defaults every Kermit starts with.
+static uint8_t				kermit_chkt;			// block check type: 1, 2, or 3 (CRC)
+static uint8_t				kermit_qbin;			// 8th-bit prefix, or 0 if not in use
+static uint8_t				kermit_rept;			// repeat prefix, or 0 if not in use
+static uint8_t				kermit_rx_qctl;			// control prefix the other side uses
+static uint8_t				kermit_tx_eol;			// what the other side wants after each packet
+static uint8_t				kermit_window;			// packets in flight at once. 1: stop and wait.
+static uint16_t				kermit_max_send;		// longest packet the other side will take (LEN through the block check)
+static uint16_t				kermit_timeout_ms;		// how long to wait for the other side
+static bool					kermit_attributes;		// both sides handle A packets
+static bool					kermit_seven_bit;		// serial line is 7 data bits
+static bool					kermit_remote_error;	// the other side sent an E packet: don't send one back
+static bool					kermit_cancelled;		// the user pressed ESC: say so in the E packet
+
+// last packet received
+static uint8_t				kermit_packet[KERMIT_MAX_LONG + 3];	// data, then the block check
+static uint16_t				kermit_packet_len;
+static uint8_t				kermit_packet_seq;
+
+// the window. receiving: packets that arrived before one that is missing. sending: packets not yet ACKed.
+static KermitSlot			kermit_slots[KERMIT_MAX_WINDOW];
+static uint8_t				kermit_tx_base;			// sending: oldest packet not yet ACKed
+static uint8_t				kermit_tx_count;		// sending: packets in the window
+static uint8_t				kermit_tx_skip;			// sending: 'X' or 'Z' if the receiver asked us to stop this file (or all files), else 0
+static uint8_t				kermit_nbr_errors;
+
+// sending: file data waiting to be encoded
+static uint8_t				kermit_raw[KERMIT_RAW_SIZE];
+static uint16_t				kermit_raw_len;
+static uint16_t				kermit_raw_pos;
+
+// receiving: decoded data on its way to write_
+static uint8_t				kermit_decoded[KERMIT_DECODE_SIZE];
+
+// receiving: the file announced by the last F packet, opened when its data (or EOF) arrives
+static char					kermit_filename[KERMIT_FILE_NAME_MAX_LENGTH + 1];
+static uint32_t				kermit_filesize;
+static bool					kermit_file_pending;
+static bool					kermit_file_is_open;
+static int32_t				kermit_bytes_total;
+
+extern char*				global_string_buff1;
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// back to the terms every Kermit starts with, before the send-init exchange
+void Kermit_Reset(void);
+
+// get a byte from the other side. returns KERMIT_TIMEOUT if none arrives, or KERMIT_CANCELLED if the user pressed ESC while waiting
+int16_t Kermit_GetByte(void);
+
+// read the next packet into kermit_packet. returns its type, or KERMIT_TIMEOUT, KERMIT_BAD_PACKET, or KERMIT_CANCELLED
+int16_t Kermit_GetPacket(void);
+
+// send one packet. long format if it doesn't fit in a normal one.
+void Kermit_SendPacket(uint8_t the_type, uint8_t the_seq, const uint8_t* the_data, uint16_t the_len);
+
+// send an E packet, and show the_message
+void Kermit_SendError(uint8_t the_seq, const char* the_message);
+
+// the other side sent an E packet: show its message
+void Kermit_ShowRemoteError(void);
+
+// fill the_data with our send-init fields. returns the length.
+uint8_t Kermit_BuildInit(uint8_t* the_data);
+
+// take the other side's send-init fields, and settle what both sides will use.
+// the_reply gets our answer for the 8th-bit prefix field, for a receiver's ACK.
+void Kermit_ParseInit(const uint8_t* the_data, uint16_t the_len, uint8_t* the_reply);
+
+// encode the_src into the_dst for a data field, stopping before anything that won't fit in the_room
+// returns the encoded length. the_used gets how much of the_src was encoded.
+uint16_t Kermit_EncodeBuffer(const uint8_t* the_src, uint16_t the_len, uint16_t* the_used, uint8_t* the_dst, uint16_t the_room);
+
+// encode up to the_room bytes of the data field from kermit_raw, refilling it from read_ as needed
+// returns the encoded length: 0 at end of file. -1 if read_ failed.
+int16_t Kermit_Encode(const KermitCallbacks* the_callbacks, uint8_t* the_dst, uint16_t the_room);
+
+// decode a data field into the_dst, stopping before anything that won't fit in the_room
+// returns the decoded length. the_used gets how much of the_src was decoded.
+uint16_t Kermit_Decode(const uint8_t* the_src, uint16_t the_len, uint16_t* the_used, uint8_t* the_dst, uint16_t the_room);
+
+// receiving: act on a packet that arrived in order (it has been ACKed already)
+// returns KERMIT_CONTINUE, KERMIT_DONE (B packet), or KERMIT_FAILED
+uint8_t Kermit_ProcessPacket(const KermitCallbacks* the_callbacks, uint8_t the_type, const uint8_t* the_data, uint16_t the_len);
+
+// sending: wait for a response, and act on it: slide the window on ACKs, resend on NAKs and timeouts
+// returns false if the transfer has failed
+bool Kermit_HandleResponse(void);
+
+// sending: wait until the window has room, then return the slot for the next packet. returns NULL if the transfer has failed.
+KermitSlot* Kermit_NextSlot(void);
+
+// sending: send the packet in the_slot and add it to the window
+void Kermit_SendSlot(KermitSlot* the_slot, uint8_t the_type, uint16_t the_len);
+
+// sending: wait until every packet in the window has been ACKed. returns false if the transfer has failed.
+bool Kermit_Drain(void);
+
+// sending: send one packet and wait for its ACK. returns false if the transfer has failed.
+bool Kermit_Transact(uint8_t the_type, const uint8_t* the_data, uint16_t the_len);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+// back to the terms every Kermit starts with, before the send-init exchange
+void Kermit_Reset(void)
+{
+	uint8_t		i;
+	
+	kermit_chkt = 1;
+	kermit_qbin = 0;
+	kermit_rept = 0;
+	kermit_rx_qctl = KERMIT_QCTL;
+	kermit_tx_eol = KERMIT_EOL;
+	kermit_window = 1;
+	kermit_max_send = 80;
+	kermit_timeout_ms = KERMIT_TIMEOUT_SECS * 1000;
+	kermit_attributes = false;
+	kermit_seven_bit = Serial_IsSevenBit();
+	kermit_remote_error = false;
+	kermit_cancelled = false;
+	
+	kermit_tx_base = 0;
+	kermit_tx_count = 0;
+	kermit_tx_skip = 0;
+	kermit_nbr_errors = 0;
+	kermit_raw_len = 0;
+	kermit_raw_pos = 0;
+	kermit_file_pending = false;
+	kermit_file_is_open = false;
+	kermit_bytes_total = 0;
+	
+	for (i = 0; i < KERMIT_MAX_WINDOW; i++)
+	{
+		kermit_slots[i].type_ = 0;
+	}
+}
+
+
+// get a byte from the other side. returns KERMIT_TIMEOUT if none arrives, or KERMIT_CANCELLED if the user pressed ESC while waiting
+int16_t Kermit_GetByte(void)
+{
+	int16_t		the_byte;
+	uint16_t	the_time_left = kermit_timeout_ms;
+	uint16_t	the_wait;
+	
+	// wait a second at a time, so ESC works even while the other side is silent
+	while (1)
+	{
+		the_wait = (the_time_left > KERMIT_POLL_MS) ? KERMIT_POLL_MS : the_time_left;
+		
+		if ((the_byte = Serial_GetByte(the_wait)) >= 0)
+		{
+			break;
+		}
+		
+		if (Transfer_CheckCancel() == true)
+		{
+			kermit_cancelled = true;
+			return KERMIT_CANCELLED;
+		}
+		
+		the_time_left -= the_wait;
+		
+		if (the_time_left == 0)
+		{
+			return KERMIT_TIMEOUT;
+		}
+	}
+	
+	if (the_byte > 0 && kermit_seven_bit == true)
+	{
+		the_byte &= 0x7F;
+	}
+	
+	return the_byte;
+}
+
+
+// read the next packet into kermit_packet. returns its type, or KERMIT_TIMEOUT, KERMIT_BAD_PACKET, or KERMIT_CANCELLED
+int16_t Kermit_GetPacket(void)
+{
+	uint8_t		the_header[5];		// LEN SEQ TYPE, and LENX1 LENX2 for a long packet
+	uint8_t		header_len;
+	uint8_t		check_len;
+	uint16_t	the_count;			// data + block check
+	uint16_t	sum;
+	uint16_t	crc;
+	uint16_t	i;
+	int16_t		the_byte;
+	
+	// LOGIC:
+	//   MARK LEN SEQ TYPE DATA CHECK. a long packet has LEN = 0, and LENX1 LENX2 HCHECK after TYPE.
+	//   the block check covers everything from LEN to the end of the data, HCHECK included.
+	//   a MARK partway through means the rest of that packet was lost: start over from it.
+	//   S packets always use a type 1 check: whoever sends one hasn't agreed on anything yet.
+	
+restart:
+	do
+	{
+		if ((the_byte = Kermit_GetByte()) < 0)
+		{
+			return the_byte;
+		}
+	} while (the_byte != KERMIT_MARK);
+	
+	sum = 0;
+	crc = 0;
+	header_len = 3;
+	
+	for (i = 0; i < header_len; i++)
+	{
+		if ((the_byte = Kermit_GetByte()) < 0)
+		{
+			return the_byte;
+		}
+		
+		if (the_byte == KERMIT_MARK)
+		{
+			goto restart;
+		}
+		
+		the_header[i] = (uint8_t)the_byte;
+		sum += the_header[i];
+		crc = KERMIT_CRC_UPDATE(crc, the_header[i]);
+		
+		if (i == 0 && KERMIT_UNCHAR(the_header[0]) == 0)
+		{
+			header_len = 5;
+		}
+	}
+	
+	check_len = (the_header[2] == KERMIT_TYPE_SEND_INIT) ? 1 : kermit_chkt;
+	
+	if (header_len == 5)
+	{
+		// long packet: header check comes next
+		if ((the_byte = Kermit_GetByte()) < 0)
+		{
+			return the_byte;
+		}
+		
+		if (KERMIT_TOCHAR((sum + ((sum & 0xC0) >> 6)) & 0x3F) != the_byte)
+		{
+			return KERMIT_BAD_PACKET;
+		}
+		
+		sum += (uint8_t)the_byte;
+		crc = KERMIT_CRC_UPDATE(crc, (uint8_t)the_byte);
+		the_count = KERMIT_UNCHAR(the_header[3]) * 95 + KERMIT_UNCHAR(the_header[4]);
+	}
+	else
+	{
+		the_count = KERMIT_UNCHAR(the_header[0]);
+		
+		if (the_count < 2 + check_len || the_count > KERMIT_MAX_SHORT)
+		{
+			return KERMIT_BAD_PACKET;
+		}
+		
+		the_count -= 2;
+	}
+	
+	if (the_count < check_len || the_count - check_len > KERMIT_MAX_LONG)
+	{
+		return KERMIT_BAD_PACKET;
+	}
+	
+	kermit_packet_len = the_count - check_len;
+	
+	for (i = 0; i < the_count; i++)
+	{
+		if ((the_byte = Kermit_GetByte()) < 0)
+		{
+			return the_byte;
+		}
+		
+		if (the_byte == KERMIT_MARK)
+		{
+			goto restart;
+		}
+		
+		kermit_packet[i] = (uint8_t)the_byte;
+		
+		if (i < kermit_packet_len)
+		{
+			sum += (uint8_t)the_byte;
+			crc = KERMIT_CRC_UPDATE(crc, (uint8_t)the_byte);
+		}
+	}
+	
+	// the_count bytes read. compare the block check that followed the data.
+	i = kermit_packet_len;
+	
+	if (check_len == 1)
+	{
+		the_byte = (kermit_packet[i] != KERMIT_TOCHAR((sum + ((sum & 0xC0) >> 6)) & 0x3F));
+	}
+	else if (check_len == 2)
+	{
+		the_byte = (kermit_packet[i] != KERMIT_TOCHAR((sum >> 6) & 0x3F) || kermit_packet[i + 1] != KERMIT_TOCHAR(sum & 0x3F));
+	}
+	else
+	{
+		the_byte = (kermit_packet[i] != KERMIT_TOCHAR((crc >> 12) & 0x0F) || kermit_packet[i + 1] != KERMIT_TOCHAR((crc >> 6) & 0x3F) || kermit_packet[i + 2] != KERMIT_TOCHAR(crc & 0x3F));
+	}
+	
+	if (the_byte != 0)
+	{
+		TRACE((TRACE_KM_BAD_PACKET, the_header[2], kermit_packet_len));
+		return KERMIT_BAD_PACKET;
+	}
+	
+	kermit_packet_seq = KERMIT_UNCHAR(the_header[1]) & KERMIT_SEQ_MASK;
+	TRACE((TRACE_KM_PACKET, the_header[2], kermit_packet_seq));
+	
+	return the_header[2];
+}
+
+
+// send one packet. long format if it doesn't fit in a normal one.
+void Kermit_SendPacket(uint8_t the_type, uint8_t the_seq, const uint8_t* the_data, uint16_t the_len)
+{
+	uint8_t		the_header[6];
+	uint8_t		header_len;
+	uint8_t		check_len;
+	uint16_t	sum = 0;
+	uint16_t	crc = 0;
+	uint8_t		i;
+	
+	check_len = (the_type == KERMIT_TYPE_SEND_INIT) ? 1 : kermit_chkt;
+	
+	the_header[1] = KERMIT_TOCHAR(the_seq);
+	the_header[2] = the_type;
+	
+	if (the_len + 2 + check_len <= KERMIT_MAX_SHORT)
+	{
+		the_header[0] = KERMIT_TOCHAR(the_len + 2 + check_len);
+		header_len = 3;
+	}
+	else
+	{
+		the_header[0] = KERMIT_TOCHAR(0);
+		the_header[3] = KERMIT_TOCHAR((the_len + check_len) / 95);
+		the_header[4] = KERMIT_TOCHAR((the_len + check_len) % 95);
+		
+		for (i = 0; i < 5; i++)
+		{
+			sum += the_header[i];
+		}
+		
+		the_header[5] = KERMIT_TOCHAR((sum + ((sum & 0xC0) >> 6)) & 0x3F);
+		header_len = 6;
+		sum = 0;
+	}
+	
+	Serial_SendByte(KERMIT_MARK);
+	
+	for (i = 0; i < header_len; i++)
+	{
+		sum += the_header[i];
+		crc = KERMIT_CRC_UPDATE(crc, the_header[i]);
+		Serial_SendByte(the_header[i]);
+	}
+	
+	while (the_len--)
+	{
+		sum += *the_data;
+		crc = KERMIT_CRC_UPDATE(crc, *the_data);
+		Serial_SendByte(*the_data++);
+	}
+	
+	if (check_len == 1)
+	{
+		Serial_SendByte(KERMIT_TOCHAR((sum + ((sum & 0xC0) >> 6)) & 0x3F));
+	}
+	else if (check_len == 2)
+	{
+		Serial_SendByte(KERMIT_TOCHAR((sum >> 6) & 0x3F));
+		Serial_SendByte(KERMIT_TOCHAR(sum & 0x3F));
+	}
+	else
+	{
+		Serial_SendByte(KERMIT_TOCHAR((crc >> 12) & 0x0F));
+		Serial_SendByte(KERMIT_TOCHAR((crc >> 6) & 0x3F));
+		Serial_SendByte(KERMIT_TOCHAR(crc & 0x3F));
+	}
+	
+	Serial_SendByte(kermit_tx_eol);
+}
+
+
+// send an E packet, and show the_message
+void Kermit_SendError(uint8_t the_seq, const char* the_message)
+{
+	if (kermit_remote_error == false)
+	{
+		Kermit_SendPacket(KERMIT_TYPE_ERROR, the_seq, (const uint8_t*)the_message, strlen(the_message));
+	}
+	
+	sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_KERMIT_ERROR), the_message);
+	Buffer_NewMessage(global_string_buff1);
+}
+
+
+// the other side sent an E packet: show its message
+void Kermit_ShowRemoteError(void)
+{
+	kermit_remote_error = true;
+	
+	// the message is printable text, but keep it to what fits on a line
+	if (kermit_packet_len > KERMIT_FILE_NAME_MAX_LENGTH)
+	{
+		kermit_packet_len = KERMIT_FILE_NAME_MAX_LENGTH;
+	}
+	
+	kermit_packet[kermit_packet_len] = 0;
+	sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_KERMIT_REMOTE_ERROR), (char*)kermit_packet);
+	Buffer_NewMessage(global_string_buff1);
+}
+
+
+// fill the_data with our send-init fields. returns the length.
+uint8_t Kermit_BuildInit(uint8_t* the_data)
+{
+	the_data[KERMIT_INIT_MAXL] = KERMIT_TOCHAR(KERMIT_MAX_SHORT);
+	the_data[KERMIT_INIT_TIME] = KERMIT_TOCHAR(KERMIT_TIMEOUT_SECS);
+	the_data[KERMIT_INIT_NPAD] = KERMIT_TOCHAR(0);
+	the_data[KERMIT_INIT_PADC] = KERMIT_CTL(0);
+	the_data[KERMIT_INIT_EOL] = KERMIT_TOCHAR(KERMIT_EOL);
+	the_data[KERMIT_INIT_QCTL] = KERMIT_QCTL;
+	the_data[KERMIT_INIT_QBIN] = kermit_seven_bit ? KERMIT_QBIN : 'Y';	// 'Y': will prefix if you ask
+	the_data[KERMIT_INIT_CHKT] = '3';
+	the_data[KERMIT_INIT_REPT] = KERMIT_REPT;
+	the_data[KERMIT_INIT_CAPAS] = KERMIT_TOCHAR(KERMIT_CAP_LONG | KERMIT_CAP_WINDOWS | KERMIT_CAP_ATTRIBUTES);
+	the_data[KERMIT_INIT_CAPAS + 1] = KERMIT_TOCHAR(KERMIT_MAX_WINDOW);
+	the_data[KERMIT_INIT_CAPAS + 2] = KERMIT_TOCHAR(KERMIT_MAX_LONG / 95);
+	the_data[KERMIT_INIT_CAPAS + 3] = KERMIT_TOCHAR(KERMIT_MAX_LONG % 95);
+	
+	return KERMIT_INIT_LEN;
+}
+
+
+// take the other side's send-init fields, and settle what both sides will use.
+// the_reply gets our answer for the 8th-bit prefix field, for a receiver's ACK.
+void Kermit_ParseInit(const uint8_t* the_data, uint16_t the_len, uint8_t* the_reply)
+{
+	uint8_t		their_qbin;
+	uint8_t		our_qbin;
+	uint8_t		their_caps = 0;
+	uint16_t	i;
+	uint16_t	the_value;
+	uint32_t	the_timeout;
+	
+	// LOGIC:
+	//   each side lists what it can do; missing trailing fields mean the defaults (no prefixing, type 1 check, no long packets).
+	//   8th-bit prefixing happens if one side names a prefix character and the other says 'Y' (or names the same one).
+	//   we name '&' on a 7-bit line: without it, bytes over 127 would lose their top bit.
+	//   the block check, repeat prefix, long packets, and windows are used only if both sides offer them.
+	
+	if (the_len > KERMIT_INIT_MAXL && (the_value = KERMIT_UNCHAR(the_data[KERMIT_INIT_MAXL])) >= 10)
+	{
+		kermit_max_send = (the_value > KERMIT_MAX_SHORT) ? KERMIT_MAX_SHORT : the_value;
+	}
+	
+	// TIME is in seconds: work it out in 32 bits, as 66 seconds or more won't fit in 16
+	if (the_len > KERMIT_INIT_TIME && (the_timeout = (uint32_t)KERMIT_UNCHAR(the_data[KERMIT_INIT_TIME]) * 1000) > KERMIT_MIN_TIMEOUT_MS)
+	{
+		kermit_timeout_ms = (the_timeout > KERMIT_MAX_TIMEOUT_MS) ? KERMIT_MAX_TIMEOUT_MS : (uint16_t)the_timeout;
+	}
+	
+	if (the_len > KERMIT_INIT_EOL && KERMIT_UNCHAR(the_data[KERMIT_INIT_EOL]) < 32 && KERMIT_UNCHAR(the_data[KERMIT_INIT_EOL]) > 0)
+	{
+		kermit_tx_eol = KERMIT_UNCHAR(the_data[KERMIT_INIT_EOL]);
+	}
+	
+	if (the_len > KERMIT_INIT_QCTL && the_data[KERMIT_INIT_QCTL] > CH_SPACE)
+	{
+		kermit_rx_qctl = the_data[KERMIT_INIT_QCTL];
+	}
+	
+	their_qbin = (the_len > KERMIT_INIT_QBIN) ? the_data[KERMIT_INIT_QBIN] : 'N';
+	our_qbin = kermit_seven_bit ? KERMIT_QBIN : 'Y';
+	
+	// a prefix character is printable and not a letter or digit: 33-62 or 96-126
+	if ((their_qbin > 32 && their_qbin < 63) || (their_qbin > 95 && their_qbin < 127))
+	{
+		kermit_qbin = their_qbin;
+		*the_reply = 'Y';
+	}
+	else
+	{
+		kermit_qbin = (their_qbin == 'Y' && our_qbin != 'Y') ? our_qbin : 0;
+		*the_reply = our_qbin;
+	}
+	
+	kermit_chkt = (the_len > KERMIT_INIT_CHKT && the_data[KERMIT_INIT_CHKT] == '3') ? 3 : 1;
+	kermit_rept = (the_len > KERMIT_INIT_REPT && the_data[KERMIT_INIT_REPT] == KERMIT_REPT) ? KERMIT_REPT : 0;
+	
+	// CAPAS can run over several bytes; WINDO, MAXLX1, and MAXLX2 follow the last one
+	i = KERMIT_INIT_CAPAS;
+	
+	if (the_len > i)
+	{
+		their_caps = KERMIT_UNCHAR(the_data[i]);
+		
+		while (i < the_len && (KERMIT_UNCHAR(the_data[i]) & KERMIT_CAP_MORE) != 0)
+		{
+			i++;
+		}
+		
+		i++;
+	}
+	
+	if ((their_caps & KERMIT_CAP_WINDOWS) != 0 && the_len > i)
+	{
+		the_value = KERMIT_UNCHAR(the_data[i]);
+		kermit_window = (the_value > KERMIT_MAX_WINDOW) ? KERMIT_MAX_WINDOW : (the_value < 1 ? 1 : the_value);
+	}
+	
+	if ((their_caps & KERMIT_CAP_LONG) != 0)
+	{
+		// no MAXLX fields means 500
+		the_value = (the_len > i + 2) ? KERMIT_UNCHAR(the_data[i + 1]) * 95 + KERMIT_UNCHAR(the_data[i + 2]) : 500;
+		
+		if (the_value > KERMIT_MAX_SHORT)
+		{
+			kermit_max_send = (the_value > KERMIT_MAX_LONG) ? KERMIT_MAX_LONG : the_value;
+		}
+	}
+	
+	kermit_attributes = ((their_caps & KERMIT_CAP_ATTRIBUTES) != 0);
+	
+	TRACE((TRACE_KM_INIT, kermit_window, kermit_max_send));
+}
+
+
+// encode the_src into the_dst for a data field, stopping before anything that won't fit in the_room
+// returns the encoded length. the_used gets how much of the_src was encoded.
+uint16_t Kermit_EncodeBuffer(const uint8_t* the_src, uint16_t the_len, uint16_t* the_used, uint8_t* the_dst, uint16_t the_room)
+{
+	uint8_t		the_group[5];		// REPT count QBIN QCTL char, at most
+	uint8_t		group_len;
+	uint8_t		the_byte;
+	uint8_t		low_bits;
+	uint8_t		the_run;
+	uint16_t	i = 0;
+	uint16_t	the_out = 0;
+	
+	// LOGIC:
+	//   each byte becomes a group: [REPT count] [QBIN] [QCTL] char.
+	//   a run of 3 or more of the same byte is sent once, with a repeat count.
+	//   with QBIN agreed, a byte over 127 is sent as QBIN and its low 7 bits.
+	//   control characters are sent as QCTL and the character XOR 64. any prefix character standing for itself gets QCTL in front.
+	
+	while (i < the_len)
+	{
+		the_byte = the_src[i];
+		the_run = 1;
+		
+		if (kermit_rept != 0)
+		{
+			while (the_run < KERMIT_MAX_REPEAT && i + the_run < the_len && the_src[i + the_run] == the_byte)
+			{
+				the_run++;
+			}
+			
+			if (the_run < KERMIT_MIN_REPEAT)
+			{
+				the_run = 1;
+			}
+		}
+		
+		group_len = 0;
+		
+		if (the_run > 1)
+		{
+			the_group[group_len++] = kermit_rept;
+			the_group[group_len++] = KERMIT_TOCHAR(the_run);
+		}
+		
+		low_bits = the_byte & 0x7F;
+		
+		if (kermit_qbin != 0 && the_byte != low_bits)
+		{
+			the_group[group_len++] = kermit_qbin;
+			the_byte = low_bits;
+		}
+		
+		if (low_bits < 32 || low_bits == 127)
+		{
+			the_group[group_len++] = KERMIT_QCTL;
+			the_byte = KERMIT_CTL(the_byte);
+		}
+		else if (low_bits == KERMIT_QCTL || (low_bits == kermit_qbin && kermit_qbin != 0) || (low_bits == kermit_rept && kermit_rept != 0))
+		{
+			the_group[group_len++] = KERMIT_QCTL;
+		}
+		
+		the_group[group_len++] = the_byte;
+		
+		if (the_out + group_len > the_room)
+		{
+			break;
+		}
+		
+		memcpy(the_dst + the_out, the_group, group_len);
+		the_out += group_len;
+		i += the_run;
+	}
+	
+	*the_used = i;
+	return the_out;
+}
+
+
+// encode up to the_room bytes of the data field from kermit_raw, refilling it from read_ as needed
+// returns the encoded length: 0 at end of file. -1 if read_ failed.
+int16_t Kermit_Encode(const KermitCallbacks* the_callbacks, uint8_t* the_dst, uint16_t the_room)
+{
+	uint16_t	the_len = 0;
+	uint16_t	the_used;
+	int16_t		bytes_read;
+	
+	while (the_len < the_room)
+	{
+		if (kermit_raw_pos == kermit_raw_len)
+		{
+			bytes_read = the_callbacks->read_(kermit_raw, KERMIT_RAW_SIZE);
+			
+			if (bytes_read < 0)
+			{
+				return -1;
+			}
+			
+			kermit_raw_len = bytes_read;
+			kermit_raw_pos = 0;
+			
+			if (bytes_read == 0)
+			{
+				break;
+			}
+		}
+		
+		the_len += Kermit_EncodeBuffer(kermit_raw + kermit_raw_pos, kermit_raw_len - kermit_raw_pos, &the_used, the_dst + the_len, the_room - the_len);
+		kermit_raw_pos += the_used;
+		kermit_bytes_total += the_used;
+		
+		if (kermit_raw_pos < kermit_raw_len)
+		{
+			// packet is full
+			break;
+		}
+	}
+	
+	return the_len;
+}
+
+
+// decode a data field into the_dst, stopping before anything that won't fit in the_room
+// returns the decoded length. the_used gets how much of the_src was decoded.
+uint16_t Kermit_Decode(const uint8_t* the_src, uint16_t the_len, uint16_t* the_used, uint8_t* the_dst, uint16_t the_room)
+{
+	uint16_t	i = 0;
+	uint16_t	the_start;
+	uint16_t	the_out = 0;
+	uint8_t		the_run;
+	uint8_t		the_byte;
+	uint8_t		high_bit;
+	uint8_t		low_bits;
+	
+	while (i < the_len)
+	{
+		the_start = i;
+		the_run = 1;
+		high_bit = 0;
+		the_byte = the_src[i++];
+		
+		if (kermit_rept != 0 && the_byte == kermit_rept && i + 1 < the_len)
+		{
+			the_run = KERMIT_UNCHAR(the_src[i++]);
+			the_byte = the_src[i++];
+		}
+		
+		if (kermit_qbin != 0 && the_byte == kermit_qbin && i < the_len)
+		{
+			high_bit = 0x80;
+			the_byte = the_src[i++];
+		}
+		
+		if (the_byte == kermit_rx_qctl && i < the_len)
+		{
+			the_byte = the_src[i++];
+			low_bits = the_byte & 0x7F;
+			
+			// '#' 'A' is ^A, '#' '?' is DEL. '#' followed by a prefix character is that character.
+			if ((low_bits >= 64 && low_bits < 96) || low_bits == 63)
+			{
+				the_byte = KERMIT_CTL(the_byte);
+			}
+		}
+		
+		if (the_out + the_run > the_room)
+		{
+			i = the_start;
+			break;
+		}
+		
+		memset(the_dst + the_out, the_byte | high_bit, the_run);
+		the_out += the_run;
+	}
+	
+	*the_used = i;
+	return the_out;
+}
+
+
+// receiving: act on a packet that arrived in order (it has been ACKed already)
+// returns KERMIT_CONTINUE, KERMIT_DONE (B packet), or KERMIT_FAILED
+uint8_t Kermit_ProcessPacket(const KermitCallbacks* the_callbacks, uint8_t the_type, const uint8_t* the_data, uint16_t the_len)
+{
+	uint16_t	decoded_len;
+	uint16_t	the_used;
+	uint16_t	i;
+	uint8_t		attr_len;
+	
+	// open the file announced in the F packet once its attributes (if any) have come: they carry the size
+	if (kermit_file_pending == true && (the_type == KERMIT_TYPE_DATA || the_type == KERMIT_TYPE_EOF))
+	{
+		kermit_file_pending = false;
+		
+		if (the_callbacks->open_(kermit_filename, kermit_filesize) == false)
+		{
+			Kermit_SendError(0, "Can't create file");
+			return KERMIT_FAILED;
+		}
+		
+		kermit_file_is_open = true;
+	}
+	
+	switch (the_type)
+	{
+		case KERMIT_TYPE_FILE:
+			decoded_len = Kermit_Decode(the_data, the_len, &the_used, (uint8_t*)kermit_filename, KERMIT_FILE_NAME_MAX_LENGTH);
+			kermit_filename[decoded_len] = 0;
+			kermit_filesize = 0;
+			kermit_file_pending = true;
+			break;
+		
+		case KERMIT_TYPE_ATTRIBUTES:
+			// tag, tochar(length), value. '1' is the exact size in bytes.
+			i = 0;
+			
+			while (i + 1 < the_len)
+			{
+				attr_len = KERMIT_UNCHAR(the_data[i + 1]);
+				
+				if (the_data[i] == '1')
+				{
+					kermit_filesize = 0;
+					
+					for (the_used = i + 2; the_used < i + 2 + attr_len && the_used < the_len; the_used++)
+					{
+						kermit_filesize = kermit_filesize * 10 + (the_data[the_used] - '0');
+					}
+				}
+				
+				i += 2 + attr_len;
+			}
+			break;
+		
+		case KERMIT_TYPE_DATA:
+			while (the_len > 0)
+			{
+				decoded_len = Kermit_Decode(the_data, the_len, &the_used, kermit_decoded, KERMIT_DECODE_SIZE);
+				
+				if (decoded_len > 0 && the_callbacks->write_(kermit_decoded, decoded_len) == false)
+				{
+					Kermit_SendError(0, "Can't write file");
+					return KERMIT_FAILED;
+				}
+				
+				kermit_bytes_total += decoded_len;
+				the_data += the_used;
+				the_len -= the_used;
+				
+				if (the_used == 0)
+				{
+					break;
+				}
+			}
+			break;
+		
+		case KERMIT_TYPE_EOF:
+			// "D" in the data means the sender gave up on this file. keep what arrived, like the other protocols.
+			if (kermit_file_is_open == true)
+			{
+				kermit_file_is_open = false;
+				
+				if (the_callbacks->close_() == false)
+				{
+					Kermit_SendError(0, "Can't close file");
+					return KERMIT_FAILED;
+				}
+			}
+			break;
+		
+		case KERMIT_TYPE_BREAK:
+			return KERMIT_DONE;
+		
+		default:
+			break;
+	}
+	
+	return KERMIT_CONTINUE;
+}
+
+
+// sending: wait for a response, and act on it: slide the window on ACKs, resend on NAKs and timeouts
+// returns false if the transfer has failed
+bool Kermit_HandleResponse(void)
+{
+	int16_t		the_type;
+	uint8_t		the_offset;
+	KermitSlot*	the_slot;
+	uint8_t		the_reply;
+	
+	// the packets are still going out: don't start the clock on the receiver until they're gone
+	Serial_WaitForTransmit();
+	
+	the_type = Kermit_GetPacket();
+	
+	if (the_type == KERMIT_TYPE_ERROR)
+	{
+		Kermit_ShowRemoteError();
+		return false;
+	}
+	
+	if (the_type == KERMIT_CANCELLED)
+	{
+		return false;
+	}
+	
+	the_offset = (kermit_packet_seq - kermit_tx_base) & KERMIT_SEQ_MASK;
+	
+	if (the_type == KERMIT_TYPE_ACK && the_offset < kermit_tx_count)
+	{
+		the_slot = &kermit_slots[kermit_packet_seq & KERMIT_SLOT_MASK];
+		the_slot->acked_ = true;
+		kermit_nbr_errors = 0;
+		
+		if (the_slot->type_ == KERMIT_TYPE_SEND_INIT)
+		{
+			Kermit_ParseInit(kermit_packet, kermit_packet_len, &the_reply);
+		}
+		else if (kermit_packet_len > 0 && (the_slot->type_ == KERMIT_TYPE_DATA || the_slot->type_ == KERMIT_TYPE_ATTRIBUTES))
+		{
+			// receiver wants us to stop: 'X' this file, 'Z' the whole batch, 'N' (on attributes) refuses the file
+			if (kermit_packet[0] == 'X' || kermit_packet[0] == 'Z' || kermit_packet[0] == 'N')
+			{
+				kermit_tx_skip = kermit_packet[0];
+			}
+		}
+		
+		// slide the window past every ACKed packet at its bottom
+		while (kermit_tx_count > 0 && kermit_slots[kermit_tx_base & KERMIT_SLOT_MASK].acked_ == true)
+		{
+			kermit_slots[kermit_tx_base & KERMIT_SLOT_MASK].type_ = 0;
+			kermit_tx_base = (kermit_tx_base + 1) & KERMIT_SEQ_MASK;
+			kermit_tx_count--;
+		}
+		
+		return true;
+	}
+	
+	if (the_type == KERMIT_TYPE_NAK && the_offset == kermit_tx_count)
+	{
+		// NAK for the packet after the window: everything in it got through
+		while (kermit_tx_count > 0)
+		{
+			kermit_slots[kermit_tx_base & KERMIT_SLOT_MASK].type_ = 0;
+			kermit_tx_base = (kermit_tx_base + 1) & KERMIT_SEQ_MASK;
+			kermit_tx_count--;
+		}
+		
+		return true;
+	}
+	
+	if (kermit_tx_count == 0)
+	{
+		// nothing to resend
+		return (the_type != KERMIT_TIMEOUT || ++kermit_nbr_errors < KERMIT_MAX_ERRORS);
+	}
+	
+	// NAK for a packet in the window, a timeout, or garbage: send again the packet asked for, or the oldest one
+	if (the_type == KERMIT_TYPE_NAK && the_offset < kermit_tx_count)
+	{
+		the_slot = &kermit_slots[kermit_packet_seq & KERMIT_SLOT_MASK];
+	}
+	else if (the_type < 0)
+	{
+		Progress_AddError();
+		
+		if (++kermit_nbr_errors >= KERMIT_MAX_ERRORS)
+		{
+			return false;
+		}
+		
+		the_slot = &kermit_slots[kermit_tx_base & KERMIT_SLOT_MASK];
+	}
+	else
+	{
+		// an ACK or NAK from outside the window is left over from earlier. ignore it.
+		return true;
+	}
+	
+	if (the_slot->acked_ == true)
+	{
+		return true;
+	}
+	
+	if (++the_slot->retries_ > KERMIT_MAX_RETRIES)
+	{
+		return false;
+	}
+	
+	TRACE((TRACE_KM_RESEND, the_slot->type_, the_slot->seq_));
+	Progress_AddRetry();
+	Kermit_SendPacket(the_slot->type_, the_slot->seq_, the_slot->data_, the_slot->len_);
+	
+	return true;
+}
+
+
+// sending: wait until the window has room, then return the slot for the next packet. returns NULL if the transfer has failed.
+KermitSlot* Kermit_NextSlot(void)
+{
+	// deal with any answers that have already come in, so a NAKed packet goes out again before new ones
+	while (kermit_tx_count > 0 && Serial_BytesAvailable() > 0)
+	{
+		if (Kermit_HandleResponse() == false)
+		{
+			return NULL;
+		}
+	}
+	
+	while (kermit_tx_count >= kermit_window)
+	{
+		if (Kermit_HandleResponse() == false)
+		{
+			return NULL;
+		}
+	}
+	
+	return &kermit_slots[(kermit_tx_base + kermit_tx_count) & KERMIT_SLOT_MASK];
+}
+
+
+// sending: send the packet in the_slot and add it to the window
+void Kermit_SendSlot(KermitSlot* the_slot, uint8_t the_type, uint16_t the_len)
+{
+	the_slot->type_ = the_type;
+	the_slot->seq_ = (kermit_tx_base + kermit_tx_count) & KERMIT_SEQ_MASK;
+	the_slot->len_ = the_len;
+	the_slot->acked_ = false;
+	the_slot->retries_ = 0;
+	kermit_tx_count++;
+	
+	Kermit_SendPacket(the_type, the_slot->seq_, the_slot->data_, the_len);
+}
+
+
+// sending: wait until every packet in the window has been ACKed. returns false if the transfer has failed.
+bool Kermit_Drain(void)
+{
+	while (kermit_tx_count > 0)
+	{
+		if (Kermit_HandleResponse() == false)
+		{
+			return false;
+		}
+	}
+	
+	return true;
+}
+
+
+// sending: send one packet and wait for its ACK. returns false if the transfer has failed.
+bool Kermit_Transact(uint8_t the_type, const uint8_t* the_data, uint16_t the_len)
+{
+	KermitSlot*	the_slot;
+	
+	if ((the_slot = Kermit_NextSlot()) == NULL)
+	{
+		return false;
+	}
+	
+	memcpy(the_slot->data_, the_data, the_len);
+	Kermit_SendSlot(the_slot, the_type, the_len);
+	
+	return Kermit_Drain();
+}
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+// receive files with Kermit until the sender finishes the session (B packet). blocks until the transfer ends.
+// uses open_, write_, and close_. returns the number of bytes received, or -1 if the transfer was aborted
+int32_t Kermit_Receive(const KermitCallbacks* the_callbacks)
+{
+	uint8_t		the_init[KERMIT_INIT_LEN];
+	uint8_t		init_len = 0;
+	uint8_t		init_chkt = 1;		// block check agreed in the send-init exchange
+	int16_t		the_type;
+	uint8_t		rx_next = 0;		// oldest packet not yet received: the bottom of the window
+	uint8_t		rx_seen = 0;		// packets past rx_next that have arrived or been NAKed
+	uint8_t		the_offset;
+	uint8_t		the_result;
+	KermitSlot*	the_slot;
+	uint8_t		i;
+	
+	// LOGIC:
+	//   each packet is ACKed as soon as it arrives, before its data goes to disk, so a windowing sender keeps sending meanwhile.
+	//   a packet that arrives ahead of a missing one is ACKed and parked in its slot, and the missing ones are NAKed;
+	//   once the gap is filled, the parked packets are processed in order.
+	//   on a timeout or a damaged packet, the oldest missing packet is NAKed. NAKing packet 0 before the S
+	//   arrives also prods a sender that waits for the receiver to speak first.
+	
+	TRACE_RESET();
+	Kermit_Reset();
+	
+	while (true)
+	{
+		the_type = Kermit_GetPacket();
+		
+		if (the_type == KERMIT_TYPE_ERROR)
+		{
+			Kermit_ShowRemoteError();
+			goto kermit_abort;
+		}
+		
+		// ESC: checked once per packet, and once a second while nothing is arriving (in Kermit_GetByte())
+		if (the_type == KERMIT_CANCELLED || (the_type > 0 && Transfer_CheckCancel() == true))
+		{
+			Kermit_SendError(rx_next, "Cancelled");
+			goto kermit_abort;
+		}
+		
+		if (the_type < 0)
+		{
+			// before the S arrives, nothing has gone wrong yet: the user may still be starting the host end
+			if (init_len != 0)
+			{
+				Progress_AddError();
+			}
+			
+			if (++kermit_nbr_errors >= KERMIT_MAX_ERRORS)
+			{
+				Kermit_SendError(rx_next, "Too many errors");
+				goto kermit_abort;
+			}
+			
+			TRACE((TRACE_KM_NAK, 0, rx_next));
+			Kermit_SendPacket(KERMIT_TYPE_NAK, rx_next, NULL, 0);
+			continue;
+		}
+		
+		if (the_type == KERMIT_TYPE_SEND_INIT)
+		{
+			// the first S sets the terms; a repeat of it means our ACK was lost. either way, (re)send the same ACK.
+			if (init_len == 0)
+			{
+				init_len = Kermit_BuildInit(the_init);
+				Kermit_ParseInit(kermit_packet, kermit_packet_len, &the_init[KERMIT_INIT_QBIN]);
+				init_chkt = kermit_chkt;
+				rx_next = (kermit_packet_seq + 1) & KERMIT_SEQ_MASK;
+				rx_seen = 0;
+			}
+			
+			// the ACK to an S still uses a type 1 check: the new one starts with the next packet
+			kermit_chkt = 1;
+			Kermit_SendPacket(KERMIT_TYPE_ACK, (rx_next - 1) & KERMIT_SEQ_MASK, the_init, init_len);
+			kermit_chkt = init_chkt;
+			kermit_nbr_errors = 0;
+			continue;
+		}
+		
+		if (init_len == 0)
+		{
+			// nothing counts before the S
+			continue;
+		}
+		
+		the_offset = (kermit_packet_seq - rx_next) & KERMIT_SEQ_MASK;
+		
+		if (the_offset >= kermit_window)
+		{
+			// a packet from before the window: our ACK for it was lost. ACK it again.
+			if (((rx_next - kermit_packet_seq) & KERMIT_SEQ_MASK) <= KERMIT_MAX_WINDOW)
+			{
+				Kermit_SendPacket(KERMIT_TYPE_ACK, kermit_packet_seq, NULL, 0);
+			}
+			
+			continue;
+		}
+		
+		kermit_nbr_errors = 0;
+		Kermit_SendPacket(KERMIT_TYPE_ACK, kermit_packet_seq, NULL, 0);
+		
+		if (the_offset > 0)
+		{
+			// ahead of a missing packet: park it, and NAK any missing ones not NAKed yet
+			the_slot = &kermit_slots[kermit_packet_seq & KERMIT_SLOT_MASK];
+			the_slot->type_ = (uint8_t)the_type;
+			the_slot->seq_ = kermit_packet_seq;
+			the_slot->len_ = kermit_packet_len;
+			memcpy(the_slot->data_, kermit_packet, kermit_packet_len);
+			
+			for (i = rx_seen; i < the_offset; i++)
+			{
+				the_slot = &kermit_slots[(rx_next + i) & KERMIT_SLOT_MASK];
+				
+				if (the_slot->type_ == 0)
+				{
+					TRACE((TRACE_KM_NAK, 1, (rx_next + i) & KERMIT_SEQ_MASK));
+					Progress_AddError();
+					Kermit_SendPacket(KERMIT_TYPE_NAK, (rx_next + i) & KERMIT_SEQ_MASK, NULL, 0);
+				}
+			}
+			
+			if (rx_seen < the_offset + 1)
+			{
+				rx_seen = the_offset + 1;
+			}
+			
+			continue;
+		}
+		
+		// the packet we were waiting for. process it, then any parked packets that follow it.
+		the_result = Kermit_ProcessPacket(the_callbacks, (uint8_t)the_type, kermit_packet, kermit_packet_len);
+		
+		while (true)
+		{
+			if (the_result == KERMIT_FAILED)
+			{
+				goto kermit_abort;
+			}
+			
+			if (the_result == KERMIT_DONE)
+			{
+				return kermit_bytes_total;
+			}
+			
+			kermit_slots[rx_next & KERMIT_SLOT_MASK].type_ = 0;
+			rx_next = (rx_next + 1) & KERMIT_SEQ_MASK;
+			
+			if (rx_seen > 0)
+			{
+				rx_seen--;
+			}
+			
+			the_slot = &kermit_slots[rx_next & KERMIT_SLOT_MASK];
+			
+			if (the_slot->type_ == 0 || the_slot->seq_ != rx_next)
+			{
+				break;
+			}
+			
+			the_result = Kermit_ProcessPacket(the_callbacks, the_slot->type_, the_slot->data_, the_slot->len_);
+		}
+	}
+	
+kermit_abort:
+	if (kermit_file_is_open == true)
+	{
+		the_callbacks->close_();
+	}
+	
+	return -1;
+}
+
+
+// send the files next_file_ names with Kermit. blocks until the transfer ends.
+// uses next_file_, read_, and close_. returns the number of bytes sent, or -1 if the transfer was aborted
+int32_t Kermit_Send(const KermitCallbacks* the_callbacks)
+{
+	char		the_filename[KERMIT_FILE_NAME_MAX_LENGTH + 1];
+	uint32_t	the_filesize;
+	uint8_t		the_attrs[16];
+	uint8_t		attr_len;
+	KermitSlot*	the_slot;
+	int16_t		the_len;
+	uint16_t	the_room;
+	uint16_t	the_room_used;
+	const char*	the_error = "Transfer failed";
+	
+	// LOGIC:
+	//   S, F, A, Z, and B packets go one at a time: each waits for its ACK. D packets fill the window.
+	//   the next D packet is read from disk and encoded while the UART interrupt sends the ones before it,
+	//   and while the receiver is still ACKing them. a NAK or timeout resends only the packet concerned.
+	
+	TRACE_RESET();
+	Kermit_Reset();
+	
+	// the S packet and its ACK settle the terms; Kermit_HandleResponse() applies them when the ACK comes
+	if ((the_slot = Kermit_NextSlot()) == NULL)
+	{
+		goto kermit_abort;
+	}
+	
+	Kermit_SendSlot(the_slot, KERMIT_TYPE_SEND_INIT, Kermit_BuildInit(the_slot->data_));
+	
+	if (Kermit_Drain() == false)
+	{
+		goto kermit_abort;
+	}
+	
+	// room for data in a packet: the longest the receiver takes, less LEN SEQ TYPE LENX1 LENX2 HCHECK and the block check
+	the_room = kermit_max_send - 6 - kermit_chkt;
+	
+	while (kermit_tx_skip != 'Z' && the_callbacks->next_file_(the_filename, &the_filesize) == true)
+	{
+		kermit_file_is_open = true;
+		kermit_tx_skip = 0;
+		kermit_raw_len = 0;
+		kermit_raw_pos = 0;
+		
+		// F packet: the name, encoded like data
+		if ((the_slot = Kermit_NextSlot()) == NULL)
+		{
+			goto kermit_abort;
+		}
+		
+		the_len = Kermit_EncodeBuffer((const uint8_t*)the_filename, strlen(the_filename), &the_room_used, the_slot->data_, the_room);
+		Kermit_SendSlot(the_slot, KERMIT_TYPE_FILE, the_len);
+		
+		if (Kermit_Drain() == false)
+		{
+			goto kermit_abort;
+		}
+		
+		if (kermit_attributes == true)
+		{
+			// '1': exact size in bytes
+			attr_len = sprintf((char*)the_attrs + 2, "%lu", (unsigned long)the_filesize);
+			the_attrs[0] = '1';
+			the_attrs[1] = KERMIT_TOCHAR(attr_len);
+			
+			if (Kermit_Transact(KERMIT_TYPE_ATTRIBUTES, the_attrs, attr_len + 2) == false)
+			{
+				goto kermit_abort;
+			}
+		}
+		
+		while (kermit_tx_skip == 0)
+		{
+			// ESC: checked once per packet, and once a second while waiting for an answer (in Kermit_GetByte())
+			if (Transfer_CheckCancel() == true)
+			{
+				kermit_cancelled = true;
+				goto kermit_abort;
+			}
+			
+			if ((the_slot = Kermit_NextSlot()) == NULL)
+			{
+				goto kermit_abort;
+			}
+			
+			the_len = Kermit_Encode(the_callbacks, the_slot->data_, the_room);
+			
+			if (the_len < 0)
+			{
+				the_error = "Can't read file";
+				goto kermit_abort;
+			}
+			
+			if (the_len == 0)
+			{
+				break;
+			}
+			
+			Kermit_SendSlot(the_slot, KERMIT_TYPE_DATA, the_len);
+		}
+		
+		if (Kermit_Drain() == false)
+		{
+			goto kermit_abort;
+		}
+		
+		kermit_file_is_open = false;
+		the_callbacks->close_();
+		
+		// "D": discard. the receiver asked us to stop partway.
+		if (Kermit_Transact(KERMIT_TYPE_EOF, (const uint8_t*)"D", (kermit_tx_skip != 0) ? 1 : 0) == false)
+		{
+			goto kermit_abort;
+		}
+	}
+	
+	if (Kermit_Transact(KERMIT_TYPE_BREAK, NULL, 0) == false)
+	{
+		goto kermit_abort;
+	}
+	
+	return kermit_bytes_total;
+	
+kermit_abort:
+	Kermit_SendError((kermit_tx_base + kermit_tx_count) & KERMIT_SEQ_MASK, kermit_cancelled ? "Cancelled" : the_error);
+	
+	if (kermit_file_is_open == true)
+	{
+		the_callbacks->close_();
+	}
+	
+	return -1;
+}
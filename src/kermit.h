@@ -0,0 +1,102 @@
+//! @file kermit.h
+
+/*
+ * kermit.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ */
+
+#ifndef KERMIT_H_
+#define KERMIT_H_
+
+
+/* about this class: Kermit
+ *
+ * This sends and receives files with Kermit, for hosts (Unix systems, mainframe gateways) that speak nothing else
+ *
+ *** things this class needs to be able to do
+ * agree on packet size, window size, block check, and prefixing with the other side (the send-init exchange)
+ * use long packets (up to KERMIT_MAX_LONG bytes) and sliding windows, when the other side can
+ * keep working over 7-bit (7E1, 7O1) links, by prefixing bytes with the 8th bit set
+ * compress runs of the same byte with repeat counts
+ * recover from lost or damaged packets by NAKing or resending just those packets
+ * send and receive several files in one session, handing them to callbacks that read or store them
+ *
+ *** things objects of this class have
+ * the terms agreed with the other side
+ * the last packet received
+ * a window of packets: sent but not yet ACKed, or received ahead of one that is missing
+ *
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+
+// Platform includes
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+#define KERMIT_MAX_LONG				4096	// longest packet we send or accept, once long packets are agreed
+#define KERMIT_MAX_WINDOW			4		// most packets in flight at once. must be a power of 2 (slots are picked by sequence number).
+#define KERMIT_FILE_NAME_MAX_LENGTH	64		// file names are cut to this
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+typedef struct KermitCallbacks {
+	bool		(*open_)(const char* the_filename, uint32_t the_filesize);	// receiving: file announced (size 0 if the sender didn't say). return false to abort.
+	bool		(*write_)(const uint8_t* the_data, uint16_t the_len);	// receiving: good data, in order. return false to abort.
+	bool		(*next_file_)(char* the_filename, uint32_t* the_filesize);	// sending: fill in the next file (the_filename holds KERMIT_FILE_NAME_MAX_LENGTH + 1). return false when there are no more.
+	int16_t		(*read_)(uint8_t* the_data, uint16_t the_len);	// sending: returns bytes read, 0 at end of file, or -1 on error
+	bool		(*close_)(void);		// end of file, or transfer aborted
+} KermitCallbacks;
+
+typedef struct KermitSlot {
+	uint8_t		type_;			// packet type, or 0 if the slot is free
+	uint8_t		seq_;
+	bool		acked_;			// sending: the receiver has ACKed it
+	uint8_t		retries_;		// sending: times it has been sent again
+	uint16_t	len_;			// bytes in data_
+	uint8_t		data_[KERMIT_MAX_LONG];	// data field, encoded as it goes over the line
+} KermitSlot;
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// receive files with Kermit until the sender finishes the session (B packet). blocks until the transfer ends.
+// uses open_, write_, and close_. returns the number of bytes received, or -1 if the transfer was aborted
+int32_t Kermit_Receive(const KermitCallbacks* the_callbacks);
+
+// send the files next_file_ names with Kermit. blocks until the transfer ends.
+// uses next_file_, read_, and close_. returns the number of bytes sent, or -1 if the transfer was aborted
+int32_t Kermit_Send(const KermitCallbacks* the_callbacks);
+
+
+#endif /* KERMIT_H_ */
@@ -0,0 +1,345 @@
+/*
+ * modem.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ *
+ *  - Hayes result code matcher. serial.c passes every received byte through here before the emulation sees it.
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "modem.h"
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// F256 includes
+#include "f256_e.h"
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define MODEM_NO_CANDIDATE			0xFF	// current line can't be a result code
+#define MODEM_NUM_RESPONSES			8
+
+#define MODEM_PROBE_BASE_TICKS		8		// 0.5s for the modem to act on AT, and for the main loop to notice, at any rate
+#define MODEM_PROBE_BITS			160		// bits a probe puts on the line: AT CR out and CR LF OK CR LF back, with room for a modem that finishes echoing first
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+// result codes sharing a prefix (NO CARRIER, NO DIALTONE, NO ANSWER) must be listed together
+static const ModemResponse	modem_responses[MODEM_NUM_RESPONSES] =
+{
+	{ (char*)"OK", MODEM_RESULT_OK, },
+	{ (char*)"CONNECT", MODEM_RESULT_CONNECT, },
+	{ (char*)"RING", MODEM_RESULT_RING, },
+	{ (char*)"NO CARRIER", MODEM_RESULT_NO_CARRIER, },
+	{ (char*)"NO DIALTONE", MODEM_RESULT_NO_DIALTONE, },
+	{ (char*)"NO ANSWER", MODEM_RESULT_NO_ANSWER, },
+	{ (char*)"ERROR", MODEM_RESULT_ERROR, },
+	{ (char*)"BUSY", MODEM_RESULT_BUSY, },
+};
+
+// matcher state
+static bool					modem_at_line_start = true;
+static uint8_t				modem_candidate = MODEM_NO_CANDIDATE;	// index into modem_responses[] the line still matches
+static uint8_t				modem_match_pos;		// how many chars of the candidate have matched
+static bool					modem_matched;			// whole candidate matched: waiting for end of line
+static bool					modem_rate_done;		// CONNECT: something other than a digit followed the rate
+static uint32_t				modem_rate;				// CONNECT: rate digits collected so far
+
+// connection state
+static bool					modem_online = false;
+static modem_result			modem_last_result = MODEM_RESULT_NONE;
+static uint32_t				modem_connect_rate = 0;
+static volatile uint32_t	modem_online_seconds = 0;
+static volatile uint8_t		modem_ticks = 0;
+static volatile bool		modem_status_changed = true;
+
+// baud rate detection
+static uint16_t				modem_probe_tick;		// RTC tick count when the probe's AT was sent
+static uint8_t				modem_probe_timeout;	// ticks to wait for OK at the probe's rate
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// returns true if modem_responses[the_index] can be recognized in the current state
+// once online, a BBS could print anything; only NO CARRIER (modem back in command mode) is looked for
+bool Modem_CandidateAllowed(uint8_t the_index);
+
+// a complete result code line arrived: update connection state
+void Modem_HandleResult(modem_result the_result);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+// returns true if modem_responses[the_index] can be recognized in the current state
+// once online, a BBS could print anything; only NO CARRIER (modem back in command mode) is looked for
+bool Modem_CandidateAllowed(uint8_t the_index)
+{
+	return (modem_online == false || modem_responses[the_index].result_ == MODEM_RESULT_NO_CARRIER);
+}
+
+
+// a complete result code line arrived: update connection state
+void Modem_HandleResult(modem_result the_result)
+{
+	if (the_result == MODEM_RESULT_CONNECT)
+	{
+		modem_online = true;
+		modem_connect_rate = modem_rate;
+		modem_online_seconds = 0;
+		modem_ticks = 0;
+	}
+	else if (the_result == MODEM_RESULT_NO_CARRIER)
+	{
+		modem_online = false;
+	}
+
+	modem_last_result = the_result;
+	modem_status_changed = true;
+}
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+// forget connection state and any partly matched line: we are offline, in command mode
+void Modem_Reset(void)
+{
+	modem_at_line_start = true;
+	modem_candidate = MODEM_NO_CANDIDATE;
+	modem_matched = false;
+	modem_online = false;
+	modem_last_result = MODEM_RESULT_NONE;
+	modem_connect_rate = 0;
+	modem_status_changed = true;
+}
+
+
+// check one received byte against the result codes. cheap for bytes that can't be part of one.
+void Modem_ProcessByte(uint8_t the_byte)
+{
+	const char*	the_text;
+	uint8_t		i;
+
+	// LOGIC:
+	//   result codes arrive on a line by themselves: CR LF CONNECT 2400 CR LF
+	//   the first byte of a line picks the first result code starting with it; each byte after that either
+	//   advances the match, or moves to a later result code with the same prefix (NO CARRIER -> NO DIALTONE), or gives up.
+	//   once a line can't be a result code, every byte until the next CR/LF costs two compares.
+
+	if (the_byte == CH_ENTER || the_byte == CH_LF)
+	{
+		if (modem_matched == true)
+		{
+			Modem_HandleResult(modem_responses[modem_candidate].result_);
+		}
+
+		modem_at_line_start = true;
+		modem_candidate = MODEM_NO_CANDIDATE;
+		modem_matched = false;
+		return;
+	}
+
+	if (modem_at_line_start == true)
+	{
+		modem_at_line_start = false;
+		modem_match_pos = 0;
+
+		for (i = 0; i < MODEM_NUM_RESPONSES; i++)
+		{
+			if (modem_responses[i].text_[0] == the_byte && Modem_CandidateAllowed(i))
+			{
+				break;
+			}
+		}
+
+		if (i == MODEM_NUM_RESPONSES)
+		{
+			return;
+		}
+
+		modem_candidate = i;
+	}
+	else if (modem_candidate == MODEM_NO_CANDIDATE)
+	{
+		return;
+	}
+	else if (modem_matched == true)
+	{
+		// only CONNECT may have more on its line: " 2400", " 14400/ARQ", etc.
+		if (modem_responses[modem_candidate].result_ != MODEM_RESULT_CONNECT)
+		{
+			modem_candidate = MODEM_NO_CANDIDATE;
+			modem_matched = false;
+		}
+		else if (the_byte >= CH_0 && the_byte <= CH_9 && modem_rate_done == false)
+		{
+			modem_rate = modem_rate * 10 + (the_byte - CH_0);
+		}
+		else if (the_byte != CH_SPACE || modem_rate > 0)
+		{
+			modem_rate_done = true;
+		}
+
+		return;
+	}
+	else if (modem_responses[modem_candidate].text_[modem_match_pos] != the_byte)
+	{
+		// see if a later result code shares the prefix matched so far, and continues with this byte
+		the_text = modem_responses[modem_candidate].text_;
+
+		for (i = modem_candidate + 1; i < MODEM_NUM_RESPONSES; i++)
+		{
+			if (modem_responses[i].text_[modem_match_pos] == the_byte && strncmp(modem_responses[i].text_, the_text, modem_match_pos) == 0 && Modem_CandidateAllowed(i))
+			{
+				break;
+			}
+		}
+
+		if (i == MODEM_NUM_RESPONSES)
+		{
+			modem_candidate = MODEM_NO_CANDIDATE;
+			return;
+		}
+
+		modem_candidate = i;
+	}
+
+	// the_byte matched modem_responses[modem_candidate].text_[modem_match_pos]
+	if (modem_responses[modem_candidate].text_[++modem_match_pos] == 0)
+	{
+		modem_matched = true;
+		modem_rate = 0;
+		modem_rate_done = false;
+	}
+}
+
+
+// returns true if the modem has reported CONNECT, and not NO CARRIER since
+bool Modem_IsOnline(void)
+{
+	return modem_online;
+}
+
+
+// returns the most recent result code the modem sent
+modem_result Modem_GetLastResult(void)
+{
+	return modem_last_result;
+}
+
+
+// start waiting for the modem to answer an AT sent at the_rate. the_tick is the RTC tick count when AT was sent.
+// forgets any partly matched line, so one from a previous rate can't complete at this one
+void Modem_StartProbe(uint32_t the_rate, uint16_t the_tick)
+{
+	// LOGIC:
+	//   the modem needs about the same time to think at any rate, but at 300 baud just moving the probe and the answer
+	//   takes half a second. so the wait is a fixed part plus the time MODEM_PROBE_BITS take at the_rate, rounded up.
+	//   the_tick may be up to a tick late, which the fixed part covers.
+	
+	Modem_Reset();
+	
+	modem_probe_tick = the_tick;
+	modem_probe_timeout = MODEM_PROBE_BASE_TICKS + (uint8_t)(((uint32_t)MODEM_PROBE_BITS * MODEM_TICKS_PER_SECOND + the_rate - 1) / the_rate);
+}
+
+
+// check on the probe started by Modem_StartProbe(). the_tick is the RTC tick count now.
+modem_probe_result Modem_CheckProbe(uint16_t the_tick)
+{
+	if (modem_last_result == MODEM_RESULT_OK)
+	{
+		return MODEM_PROBE_ANSWERED;
+	}
+	
+	if ((uint16_t)(the_tick - modem_probe_tick) < modem_probe_timeout)
+	{
+		return MODEM_PROBE_WAITING;
+	}
+	
+	return MODEM_PROBE_TIMED_OUT;
+}
+
+
+// returns the rate reported by the last CONNECT, or 0 if it didn't report one
+uint32_t Modem_GetConnectRate(void)
+{
+	return modem_connect_rate;
+}
+
+
+// returns how many seconds we have been online
+uint32_t Modem_GetOnlineSeconds(void)
+{
+	return modem_online_seconds;
+}
+
+
+// returns true if connection state or the online timer has changed since the last call
+bool Modem_CheckStatusChanged(void)
+{
+	if (modem_status_changed == false)
+	{
+		return false;
+	}
+
+	modem_status_changed = false;
+	return true;
+}
+
+
+// the UART reported a change on the DCD line. losing carrier while online is the same as NO CARRIER.
+void Modem_SetCarrier(bool carrier_detected)
+{
+	// LOGIC:
+	//   only a drop is acted on. going online is left to CONNECT, which carries the rate.
+	//   modems set to AT&C0 hold DCD on all the time, so this never fires for them, and NO CARRIER still works.
+	
+	if (carrier_detected == false && modem_online == true)
+	{
+		Modem_HandleResult(MODEM_RESULT_NO_CARRIER);
+	}
+}
+
+
+// call from the RTC periodic interrupt: advances the online timer
+void Modem_HandleTimerEvent(void)
+{
+	if (modem_online == false)
+	{
+		return;
+	}
+
+	if (++modem_ticks >= MODEM_TICKS_PER_SECOND)
+	{
+		modem_ticks = 0;
+		modem_online_seconds++;
+		modem_status_changed = true;
+	}
+}
@@ -0,0 +1,130 @@
+//! @file modem.h
+
+/*
+ * modem.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ */
+
+#ifndef MODEM_H_
+#define MODEM_H_
+
+
+/* about this class: Modem
+ *
+ * This watches the receive stream for Hayes result codes (CONNECT, NO CARRIER, etc.) and tracks whether we are online
+ *
+ *** things this class needs to be able to do
+ * match result codes incrementally: one step per received byte, no line buffering
+ * track online/offline state, and how long we have been online
+ * go offline when the modem drops DCD, without waiting for NO CARRIER
+ * tell the app when the status line needs to be redrawn
+ *
+ *** things objects of this class have
+ * matcher state: which result code the current line could still be, and how much of it has matched
+ * connection state: online or not, last result code, rate from the last CONNECT, seconds online
+ *
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+
+// Platform includes
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+#define MODEM_TICKS_PER_SECOND		16		// RTC periodic interrupt runs every 62.5ms (EVENT_KEYBOARD_REPEAT_RTC_RATE)
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+typedef enum modem_result
+{
+	MODEM_RESULT_NONE			= 0,	// no result code seen yet
+	MODEM_RESULT_OK				,
+	MODEM_RESULT_CONNECT		,
+	MODEM_RESULT_RING			,
+	MODEM_RESULT_NO_CARRIER		,
+	MODEM_RESULT_ERROR			,
+	MODEM_RESULT_NO_DIALTONE	,
+	MODEM_RESULT_BUSY			,
+	MODEM_RESULT_NO_ANSWER		,
+} modem_result;
+
+typedef enum modem_probe_result
+{
+	MODEM_PROBE_WAITING			= 0,	// no answer yet, and still time for one
+	MODEM_PROBE_ANSWERED		,		// modem answered OK: it is listening at this rate
+	MODEM_PROBE_TIMED_OUT		,		// no OK in the time it takes at this rate: try another
+} modem_probe_result;
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+typedef struct ModemResponse {
+	char*			text_;		// result code as the modem sends it, on a line by itself
+	modem_result	result_;
+} ModemResponse;
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// forget connection state and any partly matched line: we are offline, in command mode
+void Modem_Reset(void);
+
+// check one received byte against the result codes. cheap for bytes that can't be part of one.
+void Modem_ProcessByte(uint8_t the_byte);
+
+// returns true if the modem has reported CONNECT, and not NO CARRIER since
+bool Modem_IsOnline(void);
+
+// returns the most recent result code the modem sent
+modem_result Modem_GetLastResult(void);
+
+// start waiting for the modem to answer an AT sent at the_rate. the_tick is the RTC tick count when AT was sent.
+// forgets any partly matched line, so one from a previous rate can't complete at this one
+void Modem_StartProbe(uint32_t the_rate, uint16_t the_tick);
+
+// check on the probe started by Modem_StartProbe(). the_tick is the RTC tick count now.
+modem_probe_result Modem_CheckProbe(uint16_t the_tick);
+
+// returns the rate reported by the last CONNECT, or 0 if it didn't report one
+uint32_t Modem_GetConnectRate(void);
+
+// returns how many seconds we have been online
+uint32_t Modem_GetOnlineSeconds(void);
+
+// returns true if connection state or the online timer has changed since the last call
+bool Modem_CheckStatusChanged(void);
+
+// the UART reported a change on the DCD line. losing carrier while online is the same as NO CARRIER.
+void Modem_SetCarrier(bool carrier_detected);
+
+// call from the RTC periodic interrupt: advances the online timer
+void Modem_HandleTimerEvent(void);
+
+
+#endif /* MODEM_H_ */
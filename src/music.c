@@ -0,0 +1,473 @@
+/*
+ * music.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ *
+ *  - ANSI music: serial.c hands us the MML string that follows ESC [ M (or ESC [ N), a byte at a time. the RTC interrupt plays it.
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "music.h"
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+
+// F256 includes
+#include "f256_e.h"
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define MUSIC_ATTENUATION			2		// PSG volume for notes: 0 = loudest, 15 = silent
+#define MUSIC_CHANNEL				0		// tone channel notes are played on
+
+// BASIC PLAY defaults, and the ranges it allows
+#define MUSIC_DEFAULT_OCTAVE		4
+#define MUSIC_DEFAULT_LENGTH		4		// quarter note
+#define MUSIC_DEFAULT_TEMPO			120		// quarter notes per minute
+#define MUSIC_MAX_OCTAVE			6
+#define MUSIC_MAX_LENGTH			64
+#define MUSIC_MIN_TEMPO				32
+#define MUSIC_MAX_TEMPO				255
+#define MUSIC_MAX_NOTE_NUM			84		// N1-N84 are notes, N0 is a rest
+
+// articulation: how much of each note's length is silent. stored as a shift of the note's ticks (0 = none)
+#define MUSIC_ARTIC_LEGATO			0		// ML: full length
+#define MUSIC_ARTIC_NORMAL			3		// MN: 7/8 sounding, 1/8 silent
+#define MUSIC_ARTIC_STACCATO		2		// MS: 3/4 sounding, 1/4 silent
+
+// ticks in a whole note at tempo 1, in 1/256ths of a tick: 4 quarter notes * 60 seconds * ticks per second * 256
+#define MUSIC_WHOLE_NOTE_FRACTIONS	((uint32_t)4 * 60 * MUSIC_TICKS_PER_SECOND * 256)
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+// play queue: Music_ProcessByte is the only writer, and the RTC interrupt the only reader
+static MusicNote		music_queue[MUSIC_QUEUE_SIZE];
+static volatile uint8_t	music_read_idx = 0;
+static volatile uint8_t	music_write_idx = 0;
+static uint8_t			music_ticks_left = 0;		// ticks remaining for the note now playing (interrupt only)
+static bool				music_sounding = false;		// true if the PSG channel is not silenced (interrupt only)
+
+// MML parser state
+static uint8_t			music_octave;
+static uint8_t			music_length;
+static uint8_t			music_tempo;
+static uint8_t			music_articulation;
+static uint8_t			music_command;				// command letter whose number etc we are collecting, or 0
+static uint16_t			music_number;
+static bool				music_has_number;
+static int8_t			music_accidental;			// semitones added by # + -
+static uint8_t			music_dots;
+static bool				music_m_pending;			// saw 'M': next letter is N, L, S, F, or B
+static bool				music_first_byte;			// "ESC [ MF" / "ESC [ MB": a leading F or B belongs to the M
+static uint8_t			music_tick_fraction;		// 1/256ths of a tick carried from one note to the next, so tempo doesn't drift
+
+// tone dividers for octave 0 (C = 32.7 Hz). octave n is divider >> n
+static const uint16_t	music_octave0_divider[12] =
+{
+	3421, 3228, 3047, 2876, 2715, 2562, 2419, 2283, 2155, 2034, 1920, 1812,
+};
+
+// semitone within the octave for notes A-G
+static const uint8_t	music_note_semitone[7] =
+{
+	9, 11, 0, 2, 4, 5, 7,
+};
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// write a tone divider (or 0 for silence) to the music channel of both PSGs
+void Music_SetTone(uint16_t the_divider);
+
+// add one entry to the play queue. drops it if the queue is full.
+void Music_Enqueue(uint16_t the_divider, uint8_t the_ticks);
+
+// queue a note (or rest, if the_divider is 0) of length the_length (4 = quarter note), with the_dots dots, at the current tempo and articulation
+void Music_QueueNote(uint16_t the_divider, uint16_t the_length, uint8_t the_dots);
+
+// PSG tone divider for note the_note_num, counting semitones up from C in octave 0
+uint16_t Music_NoteDivider(int16_t the_note_num);
+
+// the number, accidentals, and dots for music_command are complete: act on them
+void Music_EndCommand(void);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+// write a tone divider (or 0 for silence) to the music channel of both PSGs
+void Music_SetTone(uint16_t the_divider)
+{
+	if (the_divider == 0)
+	{
+		R8(PSG_BOTH) = FLAG_PSG_LATCH | (MUSIC_CHANNEL << PSG_CHANNEL_SHIFT) | FLAG_PSG_VOLUME | PSG_ATTENUATION_OFF;
+		music_sounding = false;
+		return;
+	}
+
+	R8(PSG_BOTH) = FLAG_PSG_LATCH | (MUSIC_CHANNEL << PSG_CHANNEL_SHIFT) | (the_divider & 0x0F);
+	R8(PSG_BOTH) = (the_divider >> 4) & 0x3F;
+	R8(PSG_BOTH) = FLAG_PSG_LATCH | (MUSIC_CHANNEL << PSG_CHANNEL_SHIFT) | FLAG_PSG_VOLUME | MUSIC_ATTENUATION;
+	music_sounding = true;
+}
+
+
+// add one entry to the play queue. drops it if the queue is full.
+void Music_Enqueue(uint16_t the_divider, uint8_t the_ticks)
+{
+	uint8_t		next_idx;
+
+	next_idx = (music_write_idx + 1) & MUSIC_QUEUE_MASK;
+
+	if (next_idx == music_read_idx)
+	{
+		return;
+	}
+
+	music_queue[music_write_idx].divider_ = the_divider;
+	music_queue[music_write_idx].ticks_ = the_ticks;
+
+	// only publish the entry once it is fully written
+	music_write_idx = next_idx;
+}
+
+
+// queue a note (or rest, if the_divider is 0) of length the_length (4 = quarter note), with the_dots dots, at the current tempo and articulation
+void Music_QueueNote(uint16_t the_divider, uint16_t the_length, uint8_t the_dots)
+{
+	uint32_t	the_fractions;
+	uint32_t	the_extra;
+	uint8_t		the_ticks;
+	uint8_t		silent_ticks = 0;
+
+	// LOGIC:
+	//   work in 1/256ths of a tick, and carry what doesn't fit in a whole tick over to the next note.
+	//   at 16 ticks/second, short notes are only a tick or two long, so rounding each one separately would
+	//   make fast passages run noticeably fast or slow.
+
+	the_fractions = MUSIC_WHOLE_NOTE_FRACTIONS / ((uint32_t)music_tempo * the_length);
+
+	for (the_extra = the_fractions; the_dots > 0; the_dots--)
+	{
+		the_extra >>= 1;
+		the_fractions += the_extra;
+	}
+
+	the_fractions += music_tick_fraction;
+	music_tick_fraction = (uint8_t)(the_fractions & 0xFF);
+	the_fractions >>= 8;
+
+	if (the_fractions == 0)
+	{
+		return;
+	}
+
+	the_ticks = (the_fractions > 255) ? 255 : (uint8_t)the_fractions;
+
+	if (the_divider != 0 && music_articulation != MUSIC_ARTIC_LEGATO)
+	{
+		silent_ticks = the_ticks >> music_articulation;
+		the_ticks -= silent_ticks;
+	}
+
+	Music_Enqueue(the_divider, the_ticks);
+
+	if (silent_ticks > 0)
+	{
+		Music_Enqueue(0, silent_ticks);
+	}
+}
+
+
+// PSG tone divider for note the_note_num, counting semitones up from C in octave 0
+uint16_t Music_NoteDivider(int16_t the_note_num)
+{
+	uint16_t	the_divider;
+
+	if (the_note_num < 0)
+	{
+		the_note_num = 0;
+	}
+
+	the_divider = music_octave0_divider[the_note_num % 12] >> (the_note_num / 12);
+
+	// the lowest octaves are below what a 10-bit divider can reach: play them an octave (or two) up
+	while (the_divider > PSG_MAX_DIVIDER)
+	{
+		the_divider >>= 1;
+	}
+
+	return the_divider;
+}
+
+
+// the number, accidentals, and dots for music_command are complete: act on them
+void Music_EndCommand(void)
+{
+	uint16_t	the_length;
+
+	the_length = (music_has_number == true && music_number >= 1 && music_number <= MUSIC_MAX_LENGTH) ? music_number : music_length;
+
+	switch (music_command)
+	{
+		case 'A':
+		case 'B':
+		case 'C':
+		case 'D':
+		case 'E':
+		case 'F':
+		case 'G':
+			Music_QueueNote(Music_NoteDivider((int16_t)music_octave * 12 + music_note_semitone[music_command - 'A'] + music_accidental), the_length, music_dots);
+			break;
+
+		case 'N':
+			if (music_number == 0)
+			{
+				Music_QueueNote(0, music_length, music_dots);
+			}
+			else if (music_number <= MUSIC_MAX_NOTE_NUM)
+			{
+				Music_QueueNote(Music_NoteDivider(music_number - 1), music_length, music_dots);
+			}
+			break;
+
+		case 'P':
+		case 'R':
+			Music_QueueNote(0, the_length, music_dots);
+			break;
+
+		case 'O':
+			if (music_number <= MUSIC_MAX_OCTAVE)
+			{
+				music_octave = music_number;
+			}
+			break;
+
+		case 'L':
+			if (music_number >= 1 && music_number <= MUSIC_MAX_LENGTH)
+			{
+				music_length = music_number;
+			}
+			break;
+
+		case 'T':
+			if (music_number >= MUSIC_MIN_TEMPO && music_number <= MUSIC_MAX_TEMPO)
+			{
+				music_tempo = music_number;
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	music_command = 0;
+}
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+// silence all PSG channels and forget any queued notes
+void Music_Stop(void)
+{
+	uint8_t		i;
+
+	__asm("SEI"); // the RTC interrupt must not see the queue half-reset
+
+	music_read_idx = 0;
+	music_write_idx = 0;
+	music_ticks_left = 0;
+
+	for (i = 0; i < PSG_NUM_CHANNELS; i++)
+	{
+		R8(PSG_BOTH) = FLAG_PSG_LATCH | (i << PSG_CHANNEL_SHIFT) | FLAG_PSG_VOLUME | PSG_ATTENUATION_OFF;
+	}
+
+	music_sounding = false;
+
+	__asm("CLI");
+}
+
+
+// start of an ANSI music string (the byte after ESC [ M or ESC [ N). resets octave, tempo, etc. to PLAY defaults
+void Music_BeginString(void)
+{
+	music_octave = MUSIC_DEFAULT_OCTAVE;
+	music_length = MUSIC_DEFAULT_LENGTH;
+	music_tempo = MUSIC_DEFAULT_TEMPO;
+	music_articulation = MUSIC_ARTIC_NORMAL;
+	music_command = 0;
+	music_m_pending = false;
+	music_first_byte = true;
+}
+
+
+// process one byte of an ANSI music string. completed notes are added to the play queue.
+// if the queue is full, notes are dropped rather than waiting for room
+void Music_ProcessByte(uint8_t the_byte)
+{
+	bool		was_first_byte;
+
+	was_first_byte = music_first_byte;
+	music_first_byte = false;
+
+	if (the_byte >= 'a' && the_byte <= 'z')
+	{
+		the_byte -= ('a' - 'A');
+	}
+
+	if (music_m_pending == true || (was_first_byte == true && (the_byte == 'F' || the_byte == 'B')))
+	{
+		// MN/ML/MS set articulation. MF/MB (foreground/background) don't matter: we never make the host wait.
+		music_m_pending = false;
+
+		if (the_byte == 'N')
+		{
+			music_articulation = MUSIC_ARTIC_NORMAL;
+		}
+		else if (the_byte == 'L')
+		{
+			music_articulation = MUSIC_ARTIC_LEGATO;
+		}
+		else if (the_byte == 'S')
+		{
+			music_articulation = MUSIC_ARTIC_STACCATO;
+		}
+
+		return;
+	}
+
+	if (the_byte >= CH_0 && the_byte <= CH_9)
+	{
+		if (music_number < 1000)
+		{
+			music_number = music_number * 10 + (the_byte - CH_0);
+		}
+
+		music_has_number = true;
+		return;
+	}
+
+	if (the_byte == '#' || the_byte == '+')
+	{
+		music_accidental++;
+		return;
+	}
+
+	if (the_byte == '-')
+	{
+		music_accidental--;
+		return;
+	}
+
+	if (the_byte == '.')
+	{
+		music_dots++;
+		return;
+	}
+
+	// anything else ends the command we were collecting
+	Music_EndCommand();
+
+	music_number = 0;
+	music_has_number = false;
+	music_accidental = 0;
+	music_dots = 0;
+
+	if ( (the_byte >= 'A' && the_byte <= 'G') || the_byte == 'N' || the_byte == 'O' || the_byte == 'L' || the_byte == 'T' || the_byte == 'P' || the_byte == 'R')
+	{
+		music_command = the_byte;
+	}
+	else if (the_byte == 'M')
+	{
+		music_m_pending = true;
+	}
+	else if (the_byte == '<')
+	{
+		if (music_octave > 0)
+		{
+			music_octave--;
+		}
+	}
+	else if (the_byte == '>')
+	{
+		if (music_octave < MUSIC_MAX_OCTAVE)
+		{
+			music_octave++;
+		}
+	}
+
+	// spaces, and commands we don't support (X substrings), are skipped
+}
+
+
+// true if the_byte can begin an MML string. serial.c checks the byte after "ESC [ MF" or "ESC [ MB" with this, to tell
+// ANSI music from a bare CSI M (Delete Line) followed by text. only upper case counts: BBS music is sent in upper case.
+bool Music_IsStringStart(uint8_t the_byte)
+{
+	return ( (the_byte >= 'A' && the_byte <= 'G') || the_byte == 'L' || the_byte == 'M' || the_byte == 'N' || the_byte == 'O' ||
+		the_byte == 'P' || the_byte == 'R' || the_byte == 'T' || the_byte == '<' || the_byte == '>' );
+}
+
+
+// end of an ANSI music string (0x0E). queues any note still being received.
+void Music_EndString(void)
+{
+	Music_EndCommand();
+	music_m_pending = false;
+}
+
+
+// call from the RTC periodic interrupt: advances playback by one tick
+void Music_HandleTimerEvent(void)
+{
+	MusicNote*	the_note;
+
+	// LOGIC:
+	//   keep this short: it runs inside the interrupt handler. no division, no modulo.
+
+	if (music_ticks_left > 0 && --music_ticks_left > 0)
+	{
+		return;
+	}
+
+	if (music_read_idx == music_write_idx)
+	{
+		if (music_sounding == true)
+		{
+			Music_SetTone(0);
+		}
+
+		return;
+	}
+
+	the_note = &music_queue[music_read_idx];
+	Music_SetTone(the_note->divider_);
+	music_ticks_left = the_note->ticks_;
+
+	music_read_idx = (music_read_idx + 1) & MUSIC_QUEUE_MASK;
+}
@@ -0,0 +1,111 @@
+//! @file music.h
+
+/*
+ * music.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ */
+
+#ifndef MUSIC_H_
+#define MUSIC_H_
+
+
+/* about this class: Music
+ *
+ * This plays BBS "ANSI music" (ESC [ M or ESC [ N, followed by a BASIC PLAY-style MML string, ended by 0x0E) on the PSG
+ *
+ *** things this class needs to be able to do
+ * accept the MML string one byte at a time, turning each note into a queue entry as soon as it is complete
+ * play queued notes from the RTC periodic interrupt, so neither parsing nor playback ever waits
+ * silence the PSG and forget queued notes on request
+ *
+ *** things objects of this class have
+ * a queue of notes: PSG tone divider + duration in RTC ticks
+ * MML parser state: octave, default length, tempo, articulation, the command currently being received
+ *
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+
+// Platform includes
+#include "f256_e.h"
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+// SN76489 PSG. writes to PSG_BOTH go to both the left and the right chip
+#define PSG_LEFT						0xf01600
+#define PSG_BOTH						0xf01608
+#define PSG_RIGHT						0xf01610
+	#define FLAG_PSG_LATCH				0b10000000		// first byte of a write: 1 cc t dddd. cc = channel, t = 1 for volume
+	#define FLAG_PSG_VOLUME				0b00010000		// set for volume (attenuation) writes, clear for tone writes
+	#define PSG_CHANNEL_SHIFT			5
+	#define PSG_ATTENUATION_OFF			0x0F			// 0 = loudest, 15 = silent
+#define PSG_CLOCK						3579545			// Hz. tone divider = PSG_CLOCK / (32 * frequency)
+#define PSG_MAX_DIVIDER					1023			// tone dividers are 10 bits
+#define PSG_NUM_CHANNELS				4				// 3 tone + 1 noise
+
+#define MUSIC_TICKS_PER_SECOND			16				// RTC periodic interrupt runs every 62.5ms (EVENT_KEYBOARD_REPEAT_RTC_RATE)
+#define MUSIC_QUEUE_SIZE				128				// must be a power of 2
+#define MUSIC_QUEUE_MASK				(MUSIC_QUEUE_SIZE - 1)
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+typedef struct MusicNote {
+	uint16_t		divider_;	// PSG tone divider, or 0 for a rest
+	uint8_t			ticks_;		// how many RTC ticks the note (or rest) lasts
+} MusicNote;
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// silence all PSG channels and forget any queued notes
+void Music_Stop(void);
+
+// start of an ANSI music string (the byte after ESC [ M or ESC [ N). resets octave, tempo, etc. to PLAY defaults
+void Music_BeginString(void);
+
+// process one byte of an ANSI music string. completed notes are added to the play queue.
+// if the queue is full, notes are dropped rather than waiting for room
+void Music_ProcessByte(uint8_t the_byte);
+
+// true if the_byte can begin an MML string. serial.c checks the byte after "ESC [ MF" or "ESC [ MB" with this, to tell
+// ANSI music from a bare CSI M (Delete Line) followed by text. only upper case counts: BBS music is sent in upper case.
+bool Music_IsStringStart(uint8_t the_byte);
+
+// end of an ANSI music string (0x0E). queues any note still being received.
+void Music_EndString(void);
+
+// call from the RTC periodic interrupt: advances playback by one tick
+void Music_HandleTimerEvent(void);
+
+
+#endif /* MUSIC_H_ */
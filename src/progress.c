@@ -0,0 +1,285 @@
+/*
+ * progress.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ *
+ *  - file transfer progress: bar, bytes, rate, time left, error and retry counts. transfer.c and the protocols report to it.
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "app.h"
+#include "comm_buffer.h"
+#include "progress.h"
+#include "strings.h"
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// F256 includes
+#include "f256_e.h"
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define PROGRESS_BIG_FILE			0x01000000	// from 16MB up, work out the percentage in 256-byte units, so bytes * 100 fits in 32 bits
+#define PROGRESS_SIZE_MAX_LEN		8			// "4095.9M" and its terminator: the longest a 32-bit byte count gets
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+static uint32_t				progress_file_size;		// 0 if the protocol didn't say
+static uint32_t				progress_file_bytes;	// of the current file, including any part already on disk
+static uint32_t				progress_total_bytes;	// this session, not counting any part already on disk
+static uint16_t				progress_errors;
+static uint16_t				progress_retries;
+static bool					progress_file_started;	// a file has started: there is something worth a final status line
+
+static ProgressSample		progress_samples[PROGRESS_NUM_SAMPLES];
+static uint8_t				progress_next_sample;	// where the next sample goes. once the ring is full, also the oldest sample.
+static uint8_t				progress_num_samples;
+static uint16_t				progress_last_redraw;	// App_GetTicks() at the last redraw
+
+extern char*				global_string_buff1;
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// record a (tick, byte count) sample, and return bytes per second since the oldest sample still in the ring
+uint16_t Progress_SampleRate(void);
+
+// write the_bytes to the_buffer in at most PROGRESS_SIZE_MAX_LEN - 1 characters: "512", "12.3K", "45.6M"
+void Progress_FormatSize(char* the_buffer, uint32_t the_bytes);
+
+// redraw the bar and the status line now
+void Progress_Redraw(void);
+
+// redraw, unless the last redraw was less than PROGRESS_REDRAW_TICKS ago
+void Progress_CheckRedraw(void);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+// record a (tick, byte count) sample, and return bytes per second since the oldest sample still in the ring
+uint16_t Progress_SampleRate(void)
+{
+	ProgressSample*	the_oldest;
+	uint16_t		the_ticks;
+	uint16_t		the_span;
+	uint32_t		the_rate;
+	
+	// LOGIC:
+	//   the rate is bytes moved between the oldest sample and now. samples are taken once per redraw,
+	//   so the ring covers the last PROGRESS_NUM_SAMPLES redraws: about 4 seconds while data is flowing.
+	//   that is long enough to smooth over ACK turnarounds and disk writes, and short enough to show a stall.
+	
+	the_ticks = App_GetTicks();
+	the_oldest = &progress_samples[(progress_num_samples < PROGRESS_NUM_SAMPLES) ? 0 : progress_next_sample];
+	the_span = the_ticks - the_oldest->ticks_;
+	
+	the_rate = 0;
+	
+	if (the_span > 0)
+	{
+		the_rate = ((progress_total_bytes - the_oldest->bytes_) * PROGRESS_TICKS_PER_SECOND) / the_span;
+	}
+	
+	progress_samples[progress_next_sample].ticks_ = the_ticks;
+	progress_samples[progress_next_sample].bytes_ = progress_total_bytes;
+	progress_next_sample = (progress_next_sample + 1) % PROGRESS_NUM_SAMPLES;
+	
+	if (progress_num_samples < PROGRESS_NUM_SAMPLES)
+	{
+		progress_num_samples++;
+	}
+	
+	return (the_rate > 0xFFFF) ? 0xFFFF : (uint16_t)the_rate;
+}
+
+
+// write the_bytes to the_buffer in at most PROGRESS_SIZE_MAX_LEN - 1 characters: "512", "12.3K", "45.6M"
+void Progress_FormatSize(char* the_buffer, uint32_t the_bytes)
+{
+	// LOGIC:
+	//   K and M are 1024 and 1024*1024, with one decimal place, worked out in whole numbers: no floating point on the 65816
+	
+	if (the_bytes < 1024)
+	{
+		sprintf(the_buffer, "%lu", (unsigned long)the_bytes);
+	}
+	else if (the_bytes < 0x00100000)
+	{
+		sprintf(the_buffer, "%lu.%uK", (unsigned long)(the_bytes >> 10), (unsigned int)(((the_bytes & 0x03FF) * 10) >> 10));
+	}
+	else
+	{
+		sprintf(the_buffer, "%lu.%uM", (unsigned long)(the_bytes >> 20), (unsigned int)(((the_bytes & 0x000FFFFF) >> 10) * 10 >> 10));
+	}
+}
+
+
+// redraw the bar and the status line now
+void Progress_Redraw(void)
+{
+	uint16_t	the_rate;
+	uint32_t	the_percent = 0;
+	uint32_t	the_seconds;
+	uint8_t		the_len;
+	char		the_done[PROGRESS_SIZE_MAX_LEN];
+	char		the_size[PROGRESS_SIZE_MAX_LEN];
+	
+	// LOGIC:
+	//   the status line is one row of the message area (COMM_BUFFER_NUM_COLS), so it is kept terse: "12.3K/45.6K 42% 1400cps 0:12 E0 R0".
+	//   even with every count at its largest, it stays under 60 characters.
+	
+	progress_last_redraw = App_GetTicks();
+	the_rate = Progress_SampleRate();
+	
+	if (progress_file_size > 0)
+	{
+		if (progress_file_size >= PROGRESS_BIG_FILE)
+		{
+			the_percent = ((progress_file_bytes >> 8) * 100) / (progress_file_size >> 8);
+		}
+		else
+		{
+			the_percent = (progress_file_bytes * 100) / progress_file_size;
+		}
+		
+		if (the_percent > 100)
+		{
+			the_percent = 100;	// XMODEM pads the last block
+		}
+		
+		Progress_FormatSize(the_done, progress_file_bytes);
+		Progress_FormatSize(the_size, progress_file_size);
+		the_len = sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_PROGRESS_SIZE), the_done, the_size, (unsigned int)the_percent);
+	}
+	else
+	{
+		Progress_FormatSize(the_done, progress_file_bytes);
+		the_len = sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_PROGRESS_BYTES), the_done);
+	}
+	
+	the_len += sprintf(global_string_buff1 + the_len, Strings_GetString(ID_STR_MSG_PROGRESS_RATE), (unsigned int)the_rate);
+	
+	if (progress_file_size > progress_file_bytes && the_rate > 0)
+	{
+		the_seconds = (progress_file_size - progress_file_bytes) / the_rate;
+		the_len += sprintf(global_string_buff1 + the_len, Strings_GetString(ID_STR_MSG_PROGRESS_TIME_LEFT), (unsigned long)(the_seconds / 60), (unsigned int)(the_seconds % 60));
+	}
+	
+	sprintf(global_string_buff1 + the_len, Strings_GetString(ID_STR_MSG_PROGRESS_ERRORS), progress_errors, progress_retries);
+	
+	App_UpdateProgressBar((uint8_t)the_percent);
+	Buffer_UpdateStatusMessage(global_string_buff1);
+}
+
+
+// redraw, unless the last redraw was less than PROGRESS_REDRAW_TICKS ago
+void Progress_CheckRedraw(void)
+{
+	if ((uint16_t)(App_GetTicks() - progress_last_redraw) >= PROGRESS_REDRAW_TICKS)
+	{
+		Progress_Redraw();
+	}
+}
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+// a transfer is starting: clear the counts and show the progress bar
+void Progress_Start(void)
+{
+	progress_file_size = 0;
+	progress_file_bytes = 0;
+	progress_total_bytes = 0;
+	progress_errors = 0;
+	progress_retries = 0;
+	progress_file_started = false;
+	
+	progress_num_samples = 0;
+	progress_next_sample = 0;
+	
+	// first sample: the rate is measured from here
+	Progress_SampleRate();
+	progress_last_redraw = App_GetTicks();
+	
+	App_ShowProgressBar();
+}
+
+
+// a file is starting. the_filesize is 0 if the protocol doesn't send it (XMODEM, or a Kermit sender without attributes).
+// the_offset is how much of it is already on disk (a resumed ZMODEM download): it counts as done, but not toward the rate.
+void Progress_NewFile(uint32_t the_filesize, uint32_t the_offset)
+{
+	progress_file_size = the_filesize;
+	progress_file_bytes = the_offset;
+	progress_file_started = true;
+	
+	// the file's name just went to the message area: start a fresh status line under it
+	Progress_Redraw();
+}
+
+
+// the_len more bytes of the current file have been received or sent
+void Progress_AddBytes(uint16_t the_len)
+{
+	progress_file_bytes += the_len;
+	progress_total_bytes += the_len;
+	
+	Progress_CheckRedraw();
+}
+
+
+// bad or missing data: a damaged block, a garbled response, or a timeout
+void Progress_AddError(void)
+{
+	progress_errors++;
+	
+	Progress_CheckRedraw();
+}
+
+
+// data sent again, because the receiver asked for it or didn't answer
+void Progress_AddRetry(void)
+{
+	progress_retries++;
+	
+	Progress_CheckRedraw();
+}
+
+
+// the transfer is over: show the final counts and hide the progress bar
+void Progress_End(void)
+{
+	if (progress_file_started == true)
+	{
+		Progress_Redraw();
+	}
+	
+	App_HideProgressBar();
+}
@@ -0,0 +1,100 @@
+//! @file progress.h
+
+/*
+ * progress.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ */
+
+#ifndef PROGRESS_H_
+#define PROGRESS_H_
+
+
+/* about this class: Progress
+ *
+ * This shows how a file transfer is going: a bar in the title bar, and a status line in the message area
+ *
+ *** things this class needs to be able to do
+ * count bytes transferred, per file and for the whole session
+ * work out bytes per second over the last few seconds, so a stall or a burst shows up quickly
+ * work out time left, when the protocol has told us the file size
+ * count errors (bad or missing data received) and retries (data sent again)
+ * redraw only a few times a second, however often it is called, so drawing never slows the transfer down
+ *
+ *** things objects of this class have
+ * byte, error, and retry counts, and the size of the current file
+ * a ring of recent (tick, byte count) samples, for the transfer rate
+ * when it last redrew
+ *
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+
+// Platform includes
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+#define PROGRESS_TICKS_PER_SECOND	16		// RTC periodic interrupt runs every 62.5ms (EVENT_KEYBOARD_REPEAT_RTC_RATE)
+#define PROGRESS_REDRAW_TICKS		4		// redraw (and sample the rate) at most every 4 ticks: 4 times a second
+#define PROGRESS_NUM_SAMPLES		16		// rate is averaged over this many samples: 4 seconds
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+typedef struct ProgressSample {
+	uint16_t		ticks_;			// App_GetTicks() when taken
+	uint32_t		bytes_;			// bytes transferred this session, at that time
+} ProgressSample;
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// a transfer is starting: clear the counts and show the progress bar
+void Progress_Start(void);
+
+// a file is starting. the_filesize is 0 if the protocol doesn't send it (XMODEM, or a Kermit sender without attributes).
+// the_offset is how much of it is already on disk (a resumed ZMODEM download): it counts as done, but not toward the rate.
+void Progress_NewFile(uint32_t the_filesize, uint32_t the_offset);
+
+// the_len more bytes of the current file have been received or sent
+void Progress_AddBytes(uint16_t the_len);
+
+// bad or missing data: a damaged block, a garbled response, or a timeout
+void Progress_AddError(void);
+
+// data sent again, because the receiver asked for it or didn't answer
+void Progress_AddRetry(void);
+
+// the transfer is over: show the final counts and hide the progress bar
+void Progress_End(void);
+
+
+#endif /* PROGRESS_H_ */
@@ -0,0 +1,763 @@
+/*
+ * rip.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ *
+ *  - streaming RIPscrip v1.54 interpreter. serial.c spots "!|" at the start of a line and hands us the rest of the line a byte at a time.
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "memory.h"
+#include "rip.h"
+#include "screen.h"
+#include "serial.h"
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+// F256 includes
+#include "f256_e.h"
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define RIP_SCALE_X(x)			((x) >> 1)				// 640 -> 320
+#define RIP_SCALE_Y(y)			(((y) * 4) / 7)			// 350 -> 200: the terminal body, so graphics line up with the text over them
+
+#define RIP_MAX_X				639		// RIPscrip's screen is 640x350. coordinates past it (MegaNums go to 1295) are pulled back to its edge.
+#define RIP_MAX_Y				349
+#define RIP_DRAW_HEIGHT			(TERM_BODY_HEIGHT * 8)	// bitmap rows under the terminal body. RIP_SCALE_Y(RIP_MAX_Y) is the last of them.
+
+#define RIP_TEXT_CELL_WIDTH		8		// RIPscrip text coordinates assume the 8x14 EGA font: 80x25 cells, which is our terminal body
+#define RIP_TEXT_CELL_HEIGHT	14
+
+#define RIP_MAX_ELLIPSE_RX		160		// keep ellipse math inside 32 bits: rx^2 * ry^2 must fit
+#define RIP_MAX_ELLIPSE_RY		120
+
+#define RIP_DEFAULT_COLOR		15		// white
+#define RIP_BITMAP_CTRL_ENABLE	0x01	// BITMAP_L0_CTRL: layer on, using CLUT 0
+
+#define RIP_ESCAPE_CHAR			'\\'
+#define RIP_COMMAND_CHAR		'|'
+#define RIP_FORMAT_TEXT			'T'
+#define RIP_FORMAT_POINTS		'N'
+
+// parser states
+#define RIP_STATE_COMMAND		0		// got '|', waiting for command letter
+#define RIP_STATE_PARAMS		1		// collecting MegaNum digits of fixed parameters
+#define RIP_STATE_POINTS		2		// collecting x,y pairs of a polygon/polyline
+#define RIP_STATE_TEXT			3		// drawing text until the next '|' or end of line
+#define RIP_STATE_SKIP			4		// command done or unsupported: ignore everything until the next '|'
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+static Bitmap*			rip_bitmap = NULL;
+static bool				rip_active = false;
+
+static uint8_t			rip_state = RIP_STATE_SKIP;
+static bool				rip_escape_next = false;		// got '\': next byte is literal (or a line continuation)
+static bool				rip_skip_lf = false;			// got '\' CR: the LF that follows is part of the continuation
+
+static const RIPCommand*	rip_command;				// command currently being received
+static const char*		rip_format;						// next parameter width in rip_command->params_
+static uint8_t			rip_digits_left;				// MegaNum digits still to come for the current parameter
+static uint16_t			rip_value;						// current parameter, as accumulated so far
+static uint8_t			rip_param_count;
+static uint16_t			rip_params[RIP_MAX_PARAMS];
+
+static uint16_t			rip_points_left;				// polygon/polyline points still to come
+static bool				rip_first_point;				// next polygon point is the first one
+static int16_t			rip_first_x, rip_first_y;		// first polygon point, so the shape can be closed
+static int16_t			rip_last_x, rip_last_y;			// previous polygon point, so each edge can be drawn as soon as it arrives
+
+static uint8_t			rip_draw_color = RIP_DEFAULT_COLOR;
+static uint8_t			rip_fill_color = RIP_DEFAULT_COLOR;
+static uint16_t			rip_pen_x;						// graphics cursor, in unscaled RIP coordinates
+static uint16_t			rip_pen_y;
+static uint16_t			rip_text_x;						// where the next text char goes, in unscaled RIP coordinates
+static uint16_t			rip_text_y;
+
+// parameter layout for each level 0 command we recognize. commands we recognize but don't draw are still listed, so their parameters are skipped correctly.
+static const RIPCommand	rip_commands[] =
+{
+	{'w', "222211"},			// text window
+	{'v', "2222"},				// viewport
+	{'*', ""},					// reset windows
+	{'e', ""},					// erase text window
+	{'E', ""},					// erase graphics viewport
+	{'g', "22"},				// text gotoxy
+	{'H', ""},					// text home
+	{'>', ""},					// text erase to end of line
+	{'c', "2"},					// drawing color
+	{'Q', "2222222222222222"},	// set all 16 palette entries
+	{'a', "22"},				// set one palette entry
+	{'W', "2"},					// write mode
+	{'m', "22"},				// move graphics cursor
+	{'T', "T"},					// text at graphics cursor
+	{'@', "22T"},				// text at x,y
+	{'Y', "2222"},				// font style
+	{'X', "22"},				// pixel
+	{'L', "2222"},				// line
+	{'R', "2222"},				// rectangle
+	{'B', "2222"},				// bar (filled rectangle, no border)
+	{'C', "222"},				// circle
+	{'O', "222222"},			// oval arc
+	{'o', "2222"},				// filled oval
+	{'A', "22222"},				// arc
+	{'V', "222222"},			// oval arc
+	{'I', "22222"},				// pie slice
+	{'i', "222222"},			// oval pie slice
+	{'Z', "222222222"},			// bezier curve
+	{'P', "2N"},				// polygon
+	{'p', "2N"},				// filled polygon
+	{'l', "2N"},				// polyline
+	{'F', "222"},				// flood fill
+	{'=', "242"},				// line style
+	{'S', "22"},				// fill style
+	{'s', "222222222"},			// user fill pattern
+	{'#', ""},					// no more RIP on this line
+};
+
+#define RIP_NUM_COMMANDS		(sizeof(rip_commands) / sizeof(RIPCommand))
+
+// power-on EGA palette: RIP color -> EGA 6-bit color value (rgbRGB)
+static const uint8_t	rip_default_palette[16] =
+{
+	0, 1, 2, 3, 4, 5, 20, 7, 56, 57, 58, 59, 60, 61, 62, 63,
+};
+
+// RIP (EGA) color 0-7 -> ANSI color 0-7, for text drawn on the text layer
+static const uint8_t	rip_ega_to_ansi_color[8] =
+{
+	ANSI_COLOR_BLACK, ANSI_COLOR_BLUE, ANSI_COLOR_GREEN, ANSI_COLOR_CYAN, ANSI_COLOR_RED, ANSI_COLOR_MAGENTA, ANSI_COLOR_YELLOW, ANSI_COLOR_WHITE,
+};
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// set palette entry the_color (0-15) in CLUT 0 to the_ega_value (0-63)
+void RIP_SetPaletteEntry(uint8_t the_color, uint8_t the_ega_value);
+
+// clear the bitmap, reset the palette and colors
+void RIP_Reset(void);
+
+// got a command letter: set up to receive its parameters
+void RIP_StartCommand(uint8_t the_byte);
+
+// a parameter is complete: store it and set up for the next one, or run the command
+void RIP_EndParam(void);
+
+// all fixed parameters received: draw the command
+void RIP_ExecuteCommand(void);
+
+// a polygon/polyline point is complete: draw the edge from the previous point
+void RIP_AddPoint(void);
+
+// draw one char of a text command on the text layer
+void RIP_DrawTextChar(uint8_t the_byte);
+
+// scale a RIP x coordinate to the bitmap, after pulling it back inside RIP's screen
+int16_t RIP_ScaleX(uint16_t the_x);
+
+// scale a RIP y coordinate to the bitmap, after pulling it back inside RIP's screen
+int16_t RIP_ScaleY(uint16_t the_y);
+
+// draw an ellipse in bitmap coordinates. outline is drawn as horizontal spans so there are no gaps on the flat parts.
+void RIP_DrawEllipse(int16_t cx, int16_t cy, int16_t rx, int16_t ry, uint8_t the_color, bool do_fill);
+
+// draw a horizontal span of an ellipse, clipped to the drawable part of the bitmap
+void RIP_DrawSpan(int16_t x, int16_t y, int16_t the_len, uint8_t the_color);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+// set palette entry the_color (0-15) in CLUT 0 to the_ega_value (0-63)
+void RIP_SetPaletteEntry(uint8_t the_color, uint8_t the_ega_value)
+{
+	uint32_t	the_addr;
+
+	// LOGIC:
+	//   EGA colors are 6 bits: rgbRGB. upper case bits are worth 0xAA, lower case 0x55
+	//   VICKY CLUT entries are 4 bytes: B, G, R, A
+
+	the_addr = VICKY_CLUT0 + ((uint32_t)(the_color & 0x0F) << 2);
+
+	R8(the_addr + 0) = ((the_ega_value & 0x01) ? 0xAA : 0) + ((the_ega_value & 0x08) ? 0x55 : 0);
+	R8(the_addr + 1) = ((the_ega_value & 0x02) ? 0xAA : 0) + ((the_ega_value & 0x10) ? 0x55 : 0);
+	R8(the_addr + 2) = ((the_ega_value & 0x04) ? 0xAA : 0) + ((the_ega_value & 0x20) ? 0x55 : 0);
+}
+
+
+// clear the bitmap, reset the palette and colors
+void RIP_Reset(void)
+{
+	uint8_t		i;
+
+	for (i = 0; i < 16; i++)
+	{
+		RIP_SetPaletteEntry(i, rip_default_palette[i]);
+	}
+
+	rip_draw_color = RIP_DEFAULT_COLOR;
+	rip_fill_color = RIP_DEFAULT_COLOR;
+	rip_pen_x = 0;
+	rip_pen_y = 0;
+
+	Bitmap_FillMemory(rip_bitmap, 0);
+}
+
+
+// got a command letter: set up to receive its parameters
+void RIP_StartCommand(uint8_t the_byte)
+{
+	uint8_t		i;
+
+	if (the_byte >= '1' && the_byte <= '9')
+	{
+		// level 1+ command: not supported
+		rip_state = RIP_STATE_SKIP;
+		return;
+	}
+
+	for (i = 0; i < RIP_NUM_COMMANDS; i++)
+	{
+		if (rip_commands[i].command_ == the_byte)
+		{
+			rip_command = &rip_commands[i];
+			rip_format = rip_command->params_;
+			rip_param_count = 0;
+			rip_value = 0;
+
+			if (*rip_format == 0)
+			{
+				RIP_ExecuteCommand();
+				rip_state = RIP_STATE_SKIP;
+			}
+			else if (*rip_format == RIP_FORMAT_TEXT)
+			{
+				RIP_ExecuteCommand();
+				rip_state = RIP_STATE_TEXT;
+			}
+			else
+			{
+				rip_digits_left = *rip_format - '0';
+				rip_state = RIP_STATE_PARAMS;
+			}
+
+			return;
+		}
+	}
+
+	rip_state = RIP_STATE_SKIP;
+}
+
+
+// a parameter is complete: store it and set up for the next one, or run the command
+void RIP_EndParam(void)
+{
+	rip_params[rip_param_count++] = rip_value;
+	rip_value = 0;
+	rip_format++;
+
+	if (*rip_format == 0)
+	{
+		RIP_ExecuteCommand();
+		rip_state = RIP_STATE_SKIP;
+	}
+	else if (*rip_format == RIP_FORMAT_TEXT)
+	{
+		RIP_ExecuteCommand();
+		rip_state = RIP_STATE_TEXT;
+	}
+	else if (*rip_format == RIP_FORMAT_POINTS)
+	{
+		// rip_params[0] is the point count. points are drawn as they arrive, not stored.
+		rip_points_left = rip_params[0];
+		rip_first_point = true;
+		rip_param_count = 0;
+		rip_digits_left = 2;
+		rip_state = (rip_points_left > 0) ? RIP_STATE_POINTS : RIP_STATE_SKIP;
+	}
+	else
+	{
+		rip_digits_left = *rip_format - '0';
+	}
+}
+
+
+// all fixed parameters received: draw the command
+void RIP_ExecuteCommand(void)
+{
+	int16_t		x1, y1, x2, y2;
+
+	// LOGIC:
+	//   the bitmap routines don't clip, and a bad coordinate would write past the bitmap into other memory.
+	//   every coordinate is pulled back inside RIP's screen before it is scaled, so lines, boxes, bars, and pixels
+	//   always land on the bitmap. ellipses can still reach past its edges, so RIP_DrawEllipse clips each span.
+
+	x1 = RIP_ScaleX(rip_params[0]);
+	y1 = RIP_ScaleY(rip_params[1]);
+	x2 = RIP_ScaleX(rip_params[2]);
+	y2 = RIP_ScaleY(rip_params[3]);
+
+	switch (rip_command->command_)
+	{
+		case '*':
+			RIP_Reset();
+			break;
+
+		case 'E':
+			Bitmap_FillMemory(rip_bitmap, 0);
+			break;
+
+		case 'c':
+			rip_draw_color = rip_params[0] & 0x0F;
+			break;
+
+		case 'Q':
+			for (x1 = 0; x1 < 16; x1++)
+			{
+				RIP_SetPaletteEntry(x1, rip_params[x1]);
+			}
+			break;
+
+		case 'a':
+			RIP_SetPaletteEntry(rip_params[0], rip_params[1]);
+			break;
+
+		case 'm':
+			rip_pen_x = rip_params[0];
+			rip_pen_y = rip_params[1];
+			break;
+
+		case 'T':
+			rip_text_x = rip_pen_x;
+			rip_text_y = rip_pen_y;
+			break;
+
+		case '@':
+			rip_text_x = rip_params[0];
+			rip_text_y = rip_params[1];
+			break;
+
+		case 'X':
+			Bitmap_SetPixelAtXY(rip_bitmap, x1, y1, rip_draw_color);
+			break;
+
+		case 'L':
+			Bitmap_DrawLine(rip_bitmap, x1, y1, x2, y2, rip_draw_color);
+			break;
+
+		case 'R':
+			Bitmap_DrawBoxCoords(rip_bitmap, x1, y1, x2, y2, rip_draw_color);
+			break;
+
+		case 'B':
+			if (x2 < x1)
+			{
+				x2 ^= x1; x1 ^= x2; x2 ^= x1;
+			}
+			if (y2 < y1)
+			{
+				y2 ^= y1; y1 ^= y2; y2 ^= y1;
+			}
+			Bitmap_FillBox(rip_bitmap, x1, y1, x2 - x1 + 1, y2 - y1 + 1, rip_fill_color);
+			break;
+
+		case 'C':
+			// RIP circles are aspect-corrected for EGA's tall pixels: 3/4 as many rows high as columns wide
+			RIP_DrawEllipse(x1, y1, RIP_ScaleX(rip_params[2]), RIP_ScaleY((rip_params[2] * 3) >> 2), rip_draw_color, PARAM_DO_NOT_FILL);
+			break;
+
+		case 'O':
+			// oval arc: we only draw it when it is a full oval
+			if (rip_params[3] - rip_params[2] >= 360)
+			{
+				RIP_DrawEllipse(x1, y1, RIP_ScaleX(rip_params[4]), RIP_ScaleY(rip_params[5]), rip_draw_color, PARAM_DO_NOT_FILL);
+			}
+			break;
+
+		case 'o':
+			RIP_DrawEllipse(x1, y1, x2, RIP_ScaleY(rip_params[3]), rip_fill_color, PARAM_DO_FILL);
+			RIP_DrawEllipse(x1, y1, x2, RIP_ScaleY(rip_params[3]), rip_draw_color, PARAM_DO_NOT_FILL);
+			break;
+
+		case 'S':
+			rip_fill_color = rip_params[1] & 0x0F;
+			break;
+
+		case 's':
+			rip_fill_color = rip_params[8] & 0x0F;
+			break;
+
+		default:
+			// recognized, but not drawn: arcs, pie slices, bezier, flood fill, line/font styles, text windows
+			break;
+	}
+}
+
+
+// a polygon/polyline point is complete: draw the edge from the previous point
+void RIP_AddPoint(void)
+{
+	int16_t		x;
+	int16_t		y;
+
+	x = RIP_ScaleX(rip_params[0]);
+	y = RIP_ScaleY(rip_params[1]);
+	rip_param_count = 0;
+
+	if (rip_first_point == true)
+	{
+		rip_first_point = false;
+		rip_first_x = x;
+		rip_first_y = y;
+	}
+	else
+	{
+		Bitmap_DrawLine(rip_bitmap, rip_last_x, rip_last_y, x, y, rip_draw_color);
+	}
+
+	rip_last_x = x;
+	rip_last_y = y;
+
+	if (--rip_points_left == 0)
+	{
+		// polygons close back to the first point. filled polygons are drawn as outlines.
+		if (rip_command->command_ != 'l')
+		{
+			Bitmap_DrawLine(rip_bitmap, rip_last_x, rip_last_y, rip_first_x, rip_first_y, rip_draw_color);
+		}
+
+		rip_state = RIP_STATE_SKIP;
+	}
+}
+
+
+// draw one char of a text command on the text layer
+void RIP_DrawTextChar(uint8_t the_byte)
+{
+	uint16_t	col;
+	uint16_t	row;
+
+	col = TERM_BODY_X1 + rip_text_x / RIP_TEXT_CELL_WIDTH;
+	row = TERM_BODY_Y1 + rip_text_y / RIP_TEXT_CELL_HEIGHT;
+	rip_text_x += RIP_TEXT_CELL_WIDTH;
+
+	if (col > TERM_BODY_X2 || row > TERM_BODY_Y2)
+	{
+		return;
+	}
+
+	Text_SetCharAndColorAtXY(col, row, the_byte, rip_ega_to_ansi_color[rip_draw_color & 0x07] | (rip_draw_color & 0x08), ANSI_COLOR_BLACK);
+}
+
+
+// scale a RIP x coordinate to the bitmap, after pulling it back inside RIP's screen
+int16_t RIP_ScaleX(uint16_t the_x)
+{
+	if (the_x > RIP_MAX_X)
+	{
+		the_x = RIP_MAX_X;
+	}
+
+	return RIP_SCALE_X((int16_t)the_x);
+}
+
+
+// scale a RIP y coordinate to the bitmap, after pulling it back inside RIP's screen
+int16_t RIP_ScaleY(uint16_t the_y)
+{
+	if (the_y > RIP_MAX_Y)
+	{
+		the_y = RIP_MAX_Y;
+	}
+
+	return RIP_SCALE_Y((int16_t)the_y);
+}
+
+
+// draw an ellipse in bitmap coordinates. outline is drawn as horizontal spans so there are no gaps on the flat parts.
+void RIP_DrawEllipse(int16_t cx, int16_t cy, int16_t rx, int16_t ry, uint8_t the_color, bool do_fill)
+{
+	int32_t		rx2;
+	int32_t		ry2;
+	int32_t		limit;
+	int16_t		dx;
+	int16_t		dy;
+	int16_t		prev_dx;
+	int16_t		span;
+
+	// LOGIC:
+	//   walk down from the widest row. on each row, shrink dx until (dx,dy) is inside the ellipse:
+	//     dx^2 * ry^2 + dy^2 * rx^2 <= rx^2 * ry^2
+	//   dx only ever shrinks, so the whole ellipse costs about rx + ry steps, with no square roots.
+	//   for an outline, each row draws from this row's dx out to the previous row's dx.
+
+	if (rx > RIP_MAX_ELLIPSE_RX)
+	{
+		rx = RIP_MAX_ELLIPSE_RX;
+	}
+
+	if (ry > RIP_MAX_ELLIPSE_RY)
+	{
+		ry = RIP_MAX_ELLIPSE_RY;
+	}
+
+	rx2 = (int32_t)rx * rx;
+	ry2 = (int32_t)ry * ry;
+	limit = rx2 * ry2;
+	dx = rx;
+	prev_dx = rx;
+
+	for (dy = 0; dy <= ry; dy++)
+	{
+		while (dx > 0 && (int32_t)dx * dx * ry2 + (int32_t)dy * dy * rx2 > limit)
+		{
+			dx--;
+		}
+
+		if (do_fill == true)
+		{
+			RIP_DrawSpan(cx - dx, cy + dy, dx * 2 + 1, the_color);
+			RIP_DrawSpan(cx - dx, cy - dy, dx * 2 + 1, the_color);
+		}
+		else if (dy == ry)
+		{
+			// the flat cap: it reaches out to the previous row's dx, so the sides join it without a gap
+			RIP_DrawSpan(cx - prev_dx, cy + dy, prev_dx * 2 + 1, the_color);
+			RIP_DrawSpan(cx - prev_dx, cy - dy, prev_dx * 2 + 1, the_color);
+		}
+		else
+		{
+			span = prev_dx - dx + 1;
+			RIP_DrawSpan(cx + dx, cy + dy, span, the_color);
+			RIP_DrawSpan(cx - prev_dx, cy + dy, span, the_color);
+			RIP_DrawSpan(cx + dx, cy - dy, span, the_color);
+			RIP_DrawSpan(cx - prev_dx, cy - dy, span, the_color);
+		}
+
+		prev_dx = dx;
+	}
+}
+
+
+// draw a horizontal span of an ellipse, clipped to the drawable part of the bitmap
+void RIP_DrawSpan(int16_t x, int16_t y, int16_t the_len, uint8_t the_color)
+{
+	if (y < 0 || y >= RIP_DRAW_HEIGHT)
+	{
+		return;
+	}
+
+	if (x < 0)
+	{
+		the_len += x;
+		x = 0;
+	}
+
+	if (x + the_len > RIP_BITMAP_WIDTH)
+	{
+		the_len = RIP_BITMAP_WIDTH - x;
+	}
+
+	if (the_len > 0)
+	{
+		Bitmap_DrawHLine(rip_bitmap, x, y, the_len, the_color);
+	}
+}
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+// turn the RIPscrip bitmap layer on or off. clears the bitmap and resets the palette when turning on.
+// returns false if the bitmap could not be allocated
+bool RIP_Activate(bool enable_it)
+{
+	if (enable_it == false)
+	{
+		if (rip_active == true)
+		{
+			Sys_SetModeText(false);
+			rip_active = false;
+		}
+
+		return true;
+	}
+
+	if (rip_bitmap == NULL)
+	{
+		// the bitmap lives at the start of VRAM; only the struct is allocated
+		if ( (rip_bitmap = Bitmap_New(RIP_BITMAP_WIDTH, RIP_BITMAP_HEIGHT, PARAM_USE_PASSED_VRAM, (uint8_t*)VRAM_START_ADDR)) == NULL)
+		{
+			return false;
+		}
+	}
+
+	R8(BITMAP_L0_VRAM_ADDR_L) = (uint8_t)(VRAM_START_ADDR & 0xFF);
+	R8(BITMAP_L0_VRAM_ADDR_M) = (uint8_t)((VRAM_START_ADDR >> 8) & 0xFF);
+	R8(BITMAP_L0_VRAM_ADDR_H) = (uint8_t)((VRAM_START_ADDR >> 16) & 0xFF);
+	R8(BITMAP_L0_CTRL) = RIP_BITMAP_CTRL_ENABLE;
+
+	RIP_Reset();
+	rip_state = RIP_STATE_SKIP;
+
+	Sys_SetGraphicMode(PARAM_SPRITES_OFF, PARAM_BITMAP_ON, PARAM_TILES_OFF, PARAM_TEXT_OVERLAY_ON, PARAM_TEXT_ON);
+	rip_active = true;
+
+	return true;
+}
+
+
+// reset the parser for a new RIPscrip line. call after receiving "!|" at the start of a line.
+void RIP_BeginLine(void)
+{
+	rip_state = RIP_STATE_COMMAND;
+	rip_escape_next = false;
+	rip_skip_lf = false;
+}
+
+
+// process one byte of a RIPscrip line. draws each command as soon as it is complete.
+// returns false when the byte ended the RIPscrip line (unescaped CR or LF); the byte has been consumed either way.
+bool RIP_ProcessByte(uint8_t the_byte)
+{
+	uint8_t		digit;
+
+	if (rip_skip_lf == true)
+	{
+		rip_skip_lf = false;
+
+		if (the_byte == CH_LF)
+		{
+			return true;
+		}
+	}
+
+	if (rip_escape_next == true)
+	{
+		rip_escape_next = false;
+
+		if (the_byte == CH_ENTER || the_byte == CH_LF)
+		{
+			// line continuation: the command carries on in the next line
+			rip_skip_lf = (the_byte == CH_ENTER);
+			return true;
+		}
+
+		// escaped '|', '!' or '\': only meaningful inside text
+		if (rip_state == RIP_STATE_TEXT)
+		{
+			RIP_DrawTextChar(the_byte);
+		}
+
+		return true;
+	}
+
+	if (the_byte == RIP_ESCAPE_CHAR)
+	{
+		rip_escape_next = true;
+		return true;
+	}
+
+	if (the_byte == CH_ENTER || the_byte == CH_LF)
+	{
+		// end of the RIP line. a command that is still missing parameters is dropped.
+		rip_state = RIP_STATE_SKIP;
+		return false;
+	}
+
+	if (the_byte == RIP_COMMAND_CHAR)
+	{
+		rip_state = RIP_STATE_COMMAND;
+		return true;
+	}
+
+	switch (rip_state)
+	{
+		case RIP_STATE_COMMAND:
+			RIP_StartCommand(the_byte);
+			break;
+
+		case RIP_STATE_PARAMS:
+		case RIP_STATE_POINTS:
+			// MegaNums are base 36: 0-9, then A-Z
+			if (the_byte >= '0' && the_byte <= '9')
+			{
+				digit = the_byte - '0';
+			}
+			else if (the_byte >= 'A' && the_byte <= 'Z')
+			{
+				digit = the_byte - 'A' + 10;
+			}
+			else if (the_byte >= 'a' && the_byte <= 'z')
+			{
+				digit = the_byte - 'a' + 10;
+			}
+			else
+			{
+				// malformed: give up on this command
+				rip_state = RIP_STATE_SKIP;
+				break;
+			}
+
+			rip_value = rip_value * 36 + digit;
+
+			if (--rip_digits_left > 0)
+			{
+				break;
+			}
+
+			if (rip_state == RIP_STATE_PARAMS)
+			{
+				RIP_EndParam();
+			}
+			else
+			{
+				rip_params[rip_param_count++] = rip_value;
+				rip_value = 0;
+				rip_digits_left = 2;
+
+				if (rip_param_count == 2)
+				{
+					RIP_AddPoint();
+				}
+			}
+			break;
+
+		case RIP_STATE_TEXT:
+			RIP_DrawTextChar(the_byte);
+			break;
+
+		default:
+			// RIP_STATE_SKIP
+			break;
+	}
+
+	return true;
+}
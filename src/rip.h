@@ -0,0 +1,91 @@
+//! @file rip.h
+
+/*
+ * rip.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ */
+
+#ifndef RIP_H_
+#define RIP_H_
+
+
+/* about this class: RIP
+ *
+ * This provides a streaming RIPscrip v1.54 interpreter that draws on the VICKY bitmap layer, under the text overlay
+ *
+ *** things this class needs to be able to do
+ * turn the bitmap layer on/off when RIPscrip emulation is selected/deselected
+ * accept one byte at a time of a RIPscrip line (the part after "!") and draw each command as soon as its last parameter arrives
+ * scale RIPscrip's 640x350 coordinate space down to the 320x240 bitmap
+ *
+ *** things objects of this class have
+ * a Bitmap pointing at VRAM_START_ADDR
+ * parser state for the command currently being received
+ *
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+
+// Platform includes
+#include "f256_e.h"
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+#define RIP_BITMAP_WIDTH		320		// RIPscrip is 640x350: we scale x by 1/2 and y by 4/7, into the 320x200 under the terminal body
+#define RIP_BITMAP_HEIGHT		240
+
+#define RIP_MAX_PARAMS			16		// most parameters of any RIPscrip command (RIP_SET_PALETTE)
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+typedef struct RIPCommand {
+	char			command_;	// command letter that follows the '|'
+	char*			params_;	// width in MegaNum digits of each fixed parameter. 'T' = free text follows, 'N' = count then that many x,y pairs
+} RIPCommand;
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// turn the RIPscrip bitmap layer on or off. clears the bitmap and resets the palette when turning on.
+// returns false if the bitmap could not be allocated
+bool RIP_Activate(bool enable_it);
+
+// reset the parser for a new RIPscrip line. call after receiving "!|" at the start of a line.
+void RIP_BeginLine(void);
+
+// process one byte of a RIPscrip line. draws each command as soon as it is complete.
+// returns false when the byte ended the RIPscrip line (unescaped CR or LF); the byte has been consumed either way.
+bool RIP_ProcessByte(uint8_t the_byte);
+
+
+#endif /* RIP_H_ */
@@ -47,7 +47,11 @@
 #define TERM_PROGRESS_BAR_START_X		20
 #define TERM_PROGRESS_BAR_START_Y		TITLE_BAR_Y
 #define TERM_PROGRESS_BAR_WIDTH			10
+#define TERM_CONN_X1					31	// connection state and time online
+#define TERM_CONN_WIDTH					15
 #define TERM_BAUD_X1					48
+#define TERM_FORMAT_X1					55	// data bits, parity, stop bits
+#define TERM_CARRIER_X1					59	// carrier detect indicator
 #define TERM_DATE_X1					62
 
 #define CH_PROGRESS_BAR_SOLID_CH1		134		// for drawing progress bars that use solid bars, this is the first char (least filled in)
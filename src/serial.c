@@ -16,9 +16,14 @@
 #include "app.h"
 #include "comm_buffer.h"
 #include "memory.h"
+#include "modem.h"
+#include "music.h"
+#include "rip.h"
 #include "screen.h"
 #include "serial.h"
+#include "sixel.h"
 #include "strings.h"
+#include "telnet.h"
 #include "ymodem.h"
 
 // C includes
@@ -43,9 +48,109 @@
 #define TERMINAL_DEFAULT_BACK_COLOR		ANSI_COLOR_BLACK	// defined by ANSI. do not change.
 #define TERMINAL_DEFAULT_FORE_COLOR		ANSI_COLOR_WHITE	// defined by ANSI. do not change.
 
-#define UART_MAX_SEND_ATTEMPTS	1000
 #define ANSI_MAX_SEQUENCE_LEN	128
 
+#define SERIAL_MS_TO_TICKS(ms)	(uint16_t)(((ms) >> 6) + 1)	// ms to RTC ticks (62.5ms), rounded up. >> 6 (64ms) is close enough for timeouts.
+#define SERIAL_TX_STALL_TICKS	16		// ~1 second without the send buffer draining: stop waiting on the THRE interrupt
+
+#define CH_SHIFT_OUT			0x0E	// SO: invoke G1 character set
+#define CH_SHIFT_IN				0x0F	// SI: invoke G0 character set
+#define CH_MUSIC_END			0x0E	// ends an ANSI music string (same byte as SO)
+#define SCS_DEC_SPECIAL_GRAPHICS	CH_0	// ESC ( 0 / ESC ) 0 designates DEC special graphics (line drawing)
+#define DEC_GRAPHICS_FIRST_CHAR	0x5F	// DEC special graphics only replaces 0x5F-0x7E
+#define DEC_GRAPHICS_LAST_CHAR	0x7E
+
+#define NARROW_BODY_X1			(TERM_BODY_X1 + 20)			// PETSCII and ATASCII screens are 40 columns, centered in the 80 column terminal area
+#define NARROW_BODY_X2			(NARROW_BODY_X1 + 39)
+#define PETSCII_DEFAULT_FORE_COLOR	ANSI_COLOR_BRIGHT_BLUE	// C64 power-on text color is light blue
+
+// PETSCII control codes we send in response to F256 keys
+#define PETSCII_RETURN			0x0D
+#define PETSCII_CURS_DOWN		0x11
+#define PETSCII_CURS_UP			0x91
+#define PETSCII_CURS_RIGHT		0x1D
+#define PETSCII_CURS_LEFT		0x9D
+#define PETSCII_HOME			0x13
+#define PETSCII_CLEAR			0x93
+#define PETSCII_DELETE			0x14
+#define PETSCII_INSERT			0x94
+#define PETSCII_F1				0x85	// F1/F3/F5/F7 are 0x85-0x88, F2/F4/F6/F8 are 0x89-0x8C
+
+// PETSCII dispatch actions, as stored in petscii_action[]
+#define PETSCII_ACT_PRINT		0x00	// printable: draw glyph
+#define PETSCII_ACT_IGNORE		0x01	// control code with no effect (or none we support)
+#define PETSCII_ACT_RETURN		0x02
+#define PETSCII_ACT_CURS_DOWN	0x03
+#define PETSCII_ACT_CURS_UP		0x04
+#define PETSCII_ACT_CURS_RIGHT	0x05
+#define PETSCII_ACT_CURS_LEFT	0x06
+#define PETSCII_ACT_RVS_ON		0x07
+#define PETSCII_ACT_RVS_OFF		0x08
+#define PETSCII_ACT_HOME		0x09
+#define PETSCII_ACT_CLEAR		0x0A
+#define PETSCII_ACT_DELETE		0x0B
+#define PETSCII_ACT_LOWER_CASE	0x0D	// switch to lower/upper case character set
+#define PETSCII_ACT_UPPER_CASE	0x0E	// switch to upper case/graphics character set
+#define PETSCII_ACT_COLOR		0x10	// 0x10-0x1F: set foreground to ANSI color (action - PETSCII_ACT_COLOR)
+
+#define ATASCII_DEFAULT_FORE_COLOR	ANSI_COLOR_BRIGHT_CYAN	// Atari power-on screen is light blue text on blue
+#define ATASCII_DEFAULT_BACK_COLOR	ANSI_COLOR_BLUE
+#define ATASCII_TAB_WIDTH		8
+
+// ATASCII control codes we send in response to F256 keys
+#define ATASCII_EOL				0x9B	// Atari end of line: used instead of CR and LF
+#define ATASCII_CURS_UP			0x1C
+#define ATASCII_CURS_DOWN		0x1D
+#define ATASCII_CURS_LEFT		0x1E
+#define ATASCII_CURS_RIGHT		0x1F
+#define ATASCII_BACKSPACE		0x7E
+#define ATASCII_TAB				0x7F
+#define ATASCII_DELETE_CHAR		0xFE
+#define ATASCII_INSERT_CHAR		0xFF
+
+// ATASCII dispatch actions, as stored in atascii_action[]
+#define ATASCII_ACT_PRINT		0x00	// printable: draw glyph, inverse if bit 7 set
+#define ATASCII_ACT_IGNORE		0x01	// control code with no effect (or none we support)
+#define ATASCII_ACT_EOL			0x02
+#define ATASCII_ACT_CURS_UP		0x03
+#define ATASCII_ACT_CURS_DOWN	0x04
+#define ATASCII_ACT_CURS_LEFT	0x05
+#define ATASCII_ACT_CURS_RIGHT	0x06
+#define ATASCII_ACT_CLEAR		0x07
+#define ATASCII_ACT_BACKSPACE	0x08
+#define ATASCII_ACT_TAB			0x09
+#define ATASCII_ACT_DELETE_LINE	0x0A
+#define ATASCII_ACT_INSERT_LINE	0x0B
+#define ATASCII_ACT_DELETE_CHAR	0x0C
+#define ATASCII_ACT_INSERT_CHAR	0x0D
+#define ATASCII_ACT_ESCAPE		0x0E	// print the next byte as a glyph even if it is a control code
+
+// AVT/0 parser phases (avt_phase)
+#define AVT_PHASE_NONE			0
+#define AVT_PHASE_COMMAND		1	// got ^V, waiting for command byte
+#define AVT_PHASE_ATTR			2	// got ^V ^A, waiting for attribute
+#define AVT_PHASE_GOTO_ROW		3	// got ^V ^H, waiting for row
+#define AVT_PHASE_GOTO_COL		4	// got ^V ^H <row>, waiting for column
+#define AVT_PHASE_REPEAT_CHAR	5	// got ^Y, waiting for char to repeat
+#define AVT_PHASE_REPEAT_COUNT	6	// got ^Y <char>, waiting for count
+
+// AVT/0 (Avatar level 0) control codes. anything else is passed through to the ANSI engine.
+#define AVT_CLEAR				0x0C	// ^L: clear screen, reset attribute to AVT_DEFAULT_ATTRIBUTE, home cursor
+#define AVT_COMMAND				0x16	// ^V: introduces one of the AVT_CMD_xxx commands below
+#define AVT_REPEAT				0x19	// ^Y <char> <count>: print char count times
+#define AVT_CMD_SET_ATTR		0x01	// ^V ^A <attr>: set PC-style attribute byte (low nibble fore, bits 4-6 back)
+#define AVT_CMD_BLINK			0x02	// ^V ^B: blink on. not supported, ignored.
+#define AVT_CMD_CURS_UP			0x03	// ^V ^C
+#define AVT_CMD_CURS_DOWN		0x04	// ^V ^D
+#define AVT_CMD_CURS_LEFT		0x05	// ^V ^E
+#define AVT_CMD_CURS_RIGHT		0x06	// ^V ^F
+#define AVT_CMD_CLEAR_EOL		0x07	// ^V ^G: clear from cursor to end of line
+#define AVT_CMD_GOTO_XY			0x08	// ^V ^H <row> <col>: move cursor, 1-based
+#define AVT_DEFAULT_ATTRIBUTE	0x03	// cyan on black, per the AVT/0 spec
+
+#define UTF8_REPLACEMENT_GLYPH	CH_QUESTION	// CP437 glyph shown for code points we have no mapping for, and for malformed sequences
+#define NUM_UNICODE_GLYPHS		164			// entries in serial_unicode_glyphs[]
+
 #define ANSI_FUNCTION_CUU			'A'		// Cursor Up
 #define ANSI_FUNCTION_CUD			'B'		// Cursor Down
 #define ANSI_FUNCTION_CUF			'C'		// Cursor Forward
@@ -66,6 +171,12 @@
 #define ANSI_FUNCTION_RESTORECURPOS	'u'		// restore cursor position from last saven
 #define ANSI_FUNCTION_PRIVHIDEMOUSE	'h'		// ?1000h is a private ANSI combo for "hide mouse pointer"
 #define ANSI_FUNCTION_PRIVSHOWMOUSE	'l'		// ?1000l is a private ANSI combo for "show mouse pointer"
+#define ANSI_FUNCTION_DL			'M'		// Delete Line. a bare CSI M followed by an MML character is ANSI music instead
+#define ANSI_FUNCTION_MUSIC			'N'		// ANSI music (BananaCom's form): an MML string follows, ended by CH_MUSIC_END
+#define ANSI_FUNCTION_DA			'c'		// Device Attributes: CSI c (primary, DA1) or CSI > c (secondary, DA2)
+
+#define CH_ENQ					0x05	// ENQ: host asks for our answerback message
+#define SERIAL_DEFAULT_ANSWERBACK	"f/term F256"
 
 
 
@@ -73,11 +184,11 @@
 /*                          File-scoped Variables                            */
 /*****************************************************************************/
 
-//static uint8_t					serial_ymodem_buffer[18000];
 
 static uint8_t			ansi_sequence_storage[ANSI_MAX_SEQUENCE_LEN + 1];
 static uint8_t*			ansi_sequence = ansi_sequence_storage;
-static uint8_t			ansi_phase = 0;	// 0 = not started; 1=ESC, 2=bracket (full on), 3=done
+static uint8_t			ansi_phase = 0;	// 0 = not started; 1=ESC, 2=bracket (full on), 3=ESC+paren (VT100 character set designation), 4=DCS string (ESC P), 5=ESC inside DCS string, 6=ANSI music string, 7=bare CSI M (music if F or B follows, else Delete Line), 8=bare CSI M then F or B (music if an MML character follows, else Delete Line)
+static uint8_t			ansi_music_prefix;	// phase 8: the F or B that followed a bare CSI M
 static bool				ansi_bold_mode = false;	// need to track bold mode between SGR commands as well as within one
 
 static uint8_t			serial_x;	// text coords need to maintained separately from
@@ -89,6 +200,40 @@ static uint8_t			serial_fg_color = TERMINAL_DEFAULT_FORE_COLOR;
 static uint8_t			serial_bg_color = TERMINAL_DEFAULT_BACK_COLOR;
 static uint8_t			serial_current_pref_color = ANSI_COLOR_BRIGHT_RED;			// user's preferred foreground color. ANSI will override.
 
+static const uint8_t*	serial_glyph_lut;	// byte -> glyph translation table in use for the current emulation
+static const uint8_t*	serial_font_glyph_lut;	// CP437 -> current font translation table. set by App_ChangeUIFont() via Serial_SetGlyphLUT()
+
+static emulation_mode	serial_emulation = EMULATION_ANSI;	// which terminal type incoming bytes are interpreted as
+static bool				petscii_reverse_mode = false;	// PETSCII RVS ON/OFF state
+static uint8_t			avt_phase = 0;	// 0 = not in an AVT/0 sequence; otherwise the AVT_PHASE_xxx we are collecting bytes for
+static uint8_t			avt_param;		// first parameter byte of a 2-parameter AVT/0 sequence (repeat char, goto row)
+static bool				atascii_escape_next = false;	// ATASCII ESC received: print next byte literally
+static bool				rip_at_line_start = true;	// RIPscrip commands are only recognized at the start of a line
+static bool				rip_bang_pending = false;	// got '!' at start of line: RIPscrip if next byte is '|'
+static bool				rip_line_active = false;	// bytes are going to the RIPscrip parser until end of line
+static bool				rip_skip_lf = false;		// RIPscrip line ended with CR: swallow the LF that follows
+static uint8_t			atascii_line_buffer[SCREEN_NUM_COLS];	// working buffer for ATASCII insert char
+
+static bool				scs_designating_g1;			// true if ESC ) (G1) is being designated, false if ESC ( (G0)
+static bool				serial_g0_is_graphics = false;	// true if G0 is DEC special graphics, false if ASCII
+static bool				serial_g1_is_graphics = false;	// true if G1 is DEC special graphics, false if ASCII
+static bool				serial_shifted_out = false;		// true if SO has invoked G1, false if G0 is in use (SI)
+static bool				serial_dec_graphics_active = false;	// true if the currently invoked set is DEC special graphics
+
+// replies to identification requests. preformatted, so answering needs no sprintf
+static const char		serial_da1_response[] = "\x1b[?1;2c";	// VT100 with Advanced Video Option
+static const char		serial_da2_response[] = "\x1b[>0;10;0c";	// VT100, firmware version 1.0, no options
+static char				serial_answerback[SERIAL_ANSWERBACK_MAX_LEN + 1] = SERIAL_DEFAULT_ANSWERBACK;	// sent in reply to ENQ
+static uint8_t			serial_answerback_len = sizeof(SERIAL_DEFAULT_ANSWERBACK) - 1;
+
+static bool				serial_telnet_mode = false;	// if true, received bytes go through the telnet IAC filter, and sent 0xFF bytes are doubled
+static bool				serial_utf8_mode = false;	// if true, incoming bytes >= 0x80 are treated as UTF-8 and decoded to CP437
+static const uint8_t	serial_zrqinit[] = {'*', '*', 0x18, 'B', '0', '0'};	// start of a ZMODEM ZRQINIT hex header: a sender is ready to go
+static uint8_t			serial_zrqinit_pos = 0;		// bytes of serial_zrqinit[] matched so far
+static bool				serial_zmodem_start = false;	// ZRQINIT arrived: the app should start a ZMODEM download
+static uint32_t			utf8_code_point;			// code point being accumulated from a multi-byte UTF-8 sequence
+static uint8_t			utf8_bytes_remaining;		// continuation bytes still expected for utf8_code_point. 0 = not in a sequence
+
 static ANSIcode			serial_ansi_actions[NUM_ANSI_CODES] = 
 {
 	{ (char*)"30m", ANSI_FG_BLACK, },
@@ -136,6 +281,153 @@ const static uint8_t ansi_text_color_lut[64] =
 	0xFF, 0xFF, 0xFF, 0x00,
 };
 
+// PETSCII byte -> PETSCII_ACT_xxx. the whole of PETSCII dispatch is one lookup in this table.
+const static uint8_t		petscii_action[256] = 
+{
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x1F, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x02, 0x0D, 0x01,	// 0x00
+	0x01, 0x03, 0x07, 0x09, 0x0B, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x11, 0x05, 0x12, 0x14,	// 0x10
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x20
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x30
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x40
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x50
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x60
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x70
+	0x01, 0x13, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x02, 0x0E, 0x01,	// 0x80
+	0x10, 0x04, 0x08, 0x0A, 0x01, 0x13, 0x19, 0x18, 0x17, 0x1A, 0x1C, 0x17, 0x15, 0x06, 0x1B, 0x1E,	// 0x90
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0xA0
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0xB0
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0xC0
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0xD0
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0xE0
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0xF0
+};
+
+// PETSCII -> Foenix std font glyphs, uppercase/graphics character set (the power-on set)
+const static uint8_t		petscii_glyph_lut_upper[256] = 
+{
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,	// 0x00
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,	// 0x10
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,	// 0x20
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,	// 0x30
+	0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,	// 0x40
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0x00, 0x5D, 0x5E, 0x3C,	// 0x50
+	0x96, 0xFE, 0x82, 0x96, 0x98, 0x99, 0x95, 0x84, 0x81, 0xBD, 0xBE, 0xBF, 0xA2, 0xBB, 0xBA, 0xA0,	// 0x60
+	0xA1, 0x4F, 0x94, 0xFC, 0x85, 0xBC, 0x9F, 0x6F, 0xFF, 0x80, 0xFD, 0x9C, 0xC7, 0x82, 0x70, 0xF4,	// 0x70
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,	// 0x80
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,	// 0x90
+	0x20, 0x89, 0x03, 0x0E, 0x5F, 0x86, 0xC7, 0x93, 0xC3, 0xF5, 0x92, 0x9A, 0xF2, 0xA2, 0xA1, 0x01,	// 0xA0
+	0xA0, 0x9D, 0x9B, 0x9E, 0x87, 0x88, 0x91, 0x0D, 0x0C, 0x02, 0xA3, 0xF3, 0xF4, 0xA3, 0xF5, 0xF6,	// 0xB0
+	0x96, 0xFE, 0x82, 0x96, 0x98, 0x99, 0x95, 0x84, 0x81, 0xBD, 0xBE, 0xBF, 0xA2, 0xBB, 0xBA, 0xA0,	// 0xC0
+	0xA1, 0x4F, 0x94, 0xFC, 0x85, 0xBC, 0x9F, 0x6F, 0xFF, 0x80, 0xFD, 0x9C, 0xC7, 0x82, 0x70, 0xF4,	// 0xD0
+	0x20, 0x89, 0x03, 0x0E, 0x5F, 0x86, 0xC7, 0x93, 0xC3, 0xF5, 0x92, 0x9A, 0xF2, 0xA2, 0xA1, 0x01,	// 0xE0
+	0xA0, 0x9D, 0x9B, 0x9E, 0x87, 0x88, 0x91, 0x0D, 0x0C, 0x02, 0xA3, 0xF3, 0xF4, 0xA3, 0xF5, 0x70,	// 0xF0
+};
+
+// PETSCII -> Foenix std font glyphs, lowercase/uppercase character set (switched in with 0x0E)
+const static uint8_t		petscii_glyph_lut_lower[256] = 
+{
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,	// 0x00
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,	// 0x10
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,	// 0x20
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,	// 0x30
+	0x40, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F,	// 0x40
+	0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x5B, 0x00, 0x5D, 0x5E, 0x3C,	// 0x50
+	0x96, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,	// 0x60
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x9C, 0xC7, 0x82, 0x70, 0xF4,	// 0x70
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,	// 0x80
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,	// 0x90
+	0x20, 0x89, 0x03, 0x0E, 0x5F, 0x86, 0xC7, 0x93, 0xC3, 0xF5, 0x92, 0x9A, 0xF2, 0xA2, 0xA1, 0x01,	// 0xA0
+	0xA0, 0x9D, 0x9B, 0x9E, 0x87, 0x88, 0x91, 0x0D, 0x0C, 0x02, 0xDE, 0xF3, 0xF4, 0xA3, 0xF5, 0xF6,	// 0xB0
+	0x96, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,	// 0xC0
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x9C, 0xC7, 0x82, 0x70, 0xF4,	// 0xD0
+	0x20, 0x89, 0x03, 0x0E, 0x5F, 0x86, 0xC7, 0x93, 0xC3, 0xF5, 0x92, 0x9A, 0xF2, 0xA2, 0xA1, 0x01,	// 0xE0
+	0xA0, 0x9D, 0x9B, 0x9E, 0x87, 0x88, 0x91, 0x0D, 0x0C, 0x02, 0xA3, 0xF3, 0xF4, 0xA3, 0xF5, 0x70,	// 0xF0
+};
+
+// ATASCII byte -> ATASCII_ACT_xxx. the whole of ATASCII dispatch is one lookup in this table.
+const static uint8_t		atascii_action[256] = 
+{
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x00
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0E, 0x03, 0x04, 0x05, 0x06,	// 0x10
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x20
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x30
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x40
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x50
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x60
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x08, 0x09,	// 0x70
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0x80
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x0A, 0x0B, 0x01, 0x01,	// 0x90
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0xA0
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0xB0
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0xC0
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0xD0
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,	// 0xE0
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x0C, 0x0D,	// 0xF0
+};
+
+// ATASCII -> Foenix std font glyphs. only 0-127: bit 7 selects inverse video, not a different glyph
+const static uint8_t		atascii_glyph_lut[128] = 
+{
+	0xFC, 0x9A, 0x93, 0xA3, 0x9E, 0xA1, 0x2F, 0x5C, 0xF2, 0xF2, 0xF3, 0xF4, 0xF5, 0x0D, 0x01, 0xF3,	// 0x00
+	0xFF, 0xA0, 0x96, 0x9C, 0xB4, 0x03, 0x87, 0x9B, 0x9D, 0x89, 0xA2, 0xB3, 0xFB, 0xF8, 0xF9, 0xFA,	// 0x10
+	0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,	// 0x20
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,	// 0x30
+	0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,	// 0x40
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0x5C, 0x5D, 0x5E, 0x5F,	// 0x50
+	0xFD, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F,	// 0x60
+	0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0xFE, 0x7C, 0xFB, 0xF9, 0xFA,	// 0x70
+};
+
+// IBM PC attribute color (0-7) -> ANSI color. PC order is BGR-ish (1=blue, 4=red), ANSI is RGB-ish (1=red, 4=blue).
+const static uint8_t		avt_pc_to_ansi_color[8] = 
+{
+	ANSI_COLOR_BLACK, ANSI_COLOR_BLUE, ANSI_COLOR_GREEN, ANSI_COLOR_CYAN, ANSI_COLOR_RED, ANSI_COLOR_MAGENTA, ANSI_COLOR_YELLOW, ANSI_COLOR_WHITE,
+};
+
+// VT100 DEC special graphics (0x5F-0x7E) -> CP437 line-drawing and symbol glyphs
+// the control-picture glyphs (HT, FF, CR, LF, NL, VT) have no CP437 equivalent and show as '?'
+const static uint8_t		serial_dec_graphics_lut[DEC_GRAPHICS_LAST_CHAR - DEC_GRAPHICS_FIRST_CHAR + 1] = 
+{
+	0x20, 0x04, 0xB1, 0x3F, 0x3F, 0x3F, 0x3F, 0xF8, 0xF1, 0x3F, 0x3F, 0xD9, 0xBF, 0xDA, 0xC0, 0xC5,	// 0x5F-0x6E
+	0xC4, 0xC4, 0xC4, 0xC4, 0x5F, 0xC3, 0xB4, 0xC1, 0xC2, 0xB3, 0xF3, 0xF2, 0xE3, 0x23, 0x9C, 0xFA,	// 0x6F-0x7E
+};
+
+// Unicode code point -> CP437 glyph, sorted by code point so it can be binary searched.
+// covers every CP437 glyph above 127, the printable ones below 32, plus a few common typographic stand-ins (smart quotes, dashes, ellipsis).
+// ASCII (0-127) is not in the table: it passes through as-is.
+// generated by test/gen_unicode_glyphs.py. edit that and paste its output here, rather than editing the table by hand.
+const static UnicodeGlyph	serial_unicode_glyphs[NUM_UNICODE_GLYPHS] = 
+{
+	{0x00A0, 0xFF}, {0x00A1, 0xAD}, {0x00A2, 0x9B}, {0x00A3, 0x9C}, {0x00A5, 0x9D}, {0x00A7, 0x15},
+	{0x00A9, 0x63}, {0x00AA, 0xA6}, {0x00AB, 0xAE}, {0x00AC, 0xAA}, {0x00AE, 0x52}, {0x00B0, 0xF8},
+	{0x00B1, 0xF1}, {0x00B2, 0xFD}, {0x00B5, 0xE6}, {0x00B6, 0x14}, {0x00B7, 0xFA}, {0x00BA, 0xA7},
+	{0x00BB, 0xAF}, {0x00BC, 0xAC}, {0x00BD, 0xAB}, {0x00BF, 0xA8}, {0x00C4, 0x8E}, {0x00C5, 0x8F},
+	{0x00C6, 0x92}, {0x00C7, 0x80}, {0x00C9, 0x90}, {0x00D1, 0xA5}, {0x00D6, 0x99}, {0x00DC, 0x9A},
+	{0x00DF, 0xE1}, {0x00E0, 0x85}, {0x00E1, 0xA0}, {0x00E2, 0x83}, {0x00E4, 0x84}, {0x00E5, 0x86},
+	{0x00E6, 0x91}, {0x00E7, 0x87}, {0x00E8, 0x8A}, {0x00E9, 0x82}, {0x00EA, 0x88}, {0x00EB, 0x89},
+	{0x00EC, 0x8D}, {0x00ED, 0xA1}, {0x00EE, 0x8C}, {0x00EF, 0x8B}, {0x00F1, 0xA4}, {0x00F2, 0x95},
+	{0x00F3, 0xA2}, {0x00F4, 0x93}, {0x00F6, 0x94}, {0x00F7, 0xF6}, {0x00F9, 0x97}, {0x00FA, 0xA3},
+	{0x00FB, 0x96}, {0x00FC, 0x81}, {0x00FF, 0x98}, {0x0192, 0x9F}, {0x0393, 0xE2}, {0x0398, 0xE9},
+	{0x03A3, 0xE4}, {0x03A6, 0xE8}, {0x03A9, 0xEA}, {0x03B1, 0xE0}, {0x03B4, 0xEB}, {0x03B5, 0xEE},
+	{0x03C0, 0xE3}, {0x03C3, 0xE5}, {0x03C4, 0xE7}, {0x03C6, 0xED}, {0x2013, 0x2D}, {0x2014, 0x2D},
+	{0x2018, 0x27}, {0x2019, 0x27}, {0x201C, 0x22}, {0x201D, 0x22}, {0x2022, 0x07}, {0x2026, 0xFA},
+	{0x203C, 0x13}, {0x207F, 0xFC}, {0x20A7, 0x9E}, {0x2190, 0x1B}, {0x2191, 0x18}, {0x2192, 0x1A},
+	{0x2193, 0x19}, {0x2194, 0x1D}, {0x2195, 0x12}, {0x21A8, 0x17}, {0x2219, 0xF9}, {0x221A, 0xFB},
+	{0x221E, 0xEC}, {0x221F, 0x1C}, {0x2229, 0xEF}, {0x2248, 0xF7}, {0x2261, 0xF0}, {0x2264, 0xF3},
+	{0x2265, 0xF2}, {0x2302, 0x7F}, {0x2310, 0xA9}, {0x2320, 0xF4}, {0x2321, 0xF5}, {0x2500, 0xC4},
+	{0x2502, 0xB3}, {0x250C, 0xDA}, {0x2510, 0xBF}, {0x2514, 0xC0}, {0x2518, 0xD9}, {0x251C, 0xC3},
+	{0x2524, 0xB4}, {0x252C, 0xC2}, {0x2534, 0xC1}, {0x253C, 0xC5}, {0x2550, 0xCD}, {0x2551, 0xBA},
+	{0x2552, 0xD5}, {0x2553, 0xD6}, {0x2554, 0xC9}, {0x2555, 0xB8}, {0x2556, 0xB7}, {0x2557, 0xBB},
+	{0x2558, 0xD4}, {0x2559, 0xD3}, {0x255A, 0xC8}, {0x255B, 0xBE}, {0x255C, 0xBD}, {0x255D, 0xBC},
+	{0x255E, 0xC6}, {0x255F, 0xC7}, {0x2560, 0xCC}, {0x2561, 0xB5}, {0x2562, 0xB6}, {0x2563, 0xB9},
+	{0x2564, 0xD1}, {0x2565, 0xD2}, {0x2566, 0xCB}, {0x2567, 0xCF}, {0x2568, 0xD0}, {0x2569, 0xCA},
+	{0x256A, 0xD8}, {0x256B, 0xD7}, {0x256C, 0xCE}, {0x2580, 0xDF}, {0x2584, 0xDC}, {0x2588, 0xDB},
+	{0x258C, 0xDD}, {0x2590, 0xDE}, {0x2591, 0xB0}, {0x2592, 0xB1}, {0x2593, 0xB2}, {0x25A0, 0xFE},
+	{0x25AC, 0x16}, {0x25B2, 0x1E}, {0x25BA, 0x10}, {0x25BC, 0x1F}, {0x25C4, 0x11}, {0x263A, 0x01},
+	{0x263B, 0x02}, {0x263C, 0x0F}, {0x2642, 0x0B}, {0x2660, 0x06}, {0x2663, 0x05}, {0x2665, 0x03},
+	{0x2666, 0x04}, {0x266B, 0x0E},
+};
+
 /*****************************************************************************/
 /*                             Global Variables                              */
 /*****************************************************************************/
@@ -143,6 +435,16 @@ const static uint8_t ansi_text_color_lut[64] =
 uint8_t*				global_uart_in_buffer = (uint8_t*)UART_BUFFER_START_ADDR;
 uint16_t				global_uart_write_idx;
 uint16_t				global_uart_read_idx;
+SerialErrorCounts		global_uart_error_counts;		// line errors, counted by the UART interrupt handler
+bool					global_uart_error_pending;		// interrupt handler counted an error the app hasn't reported yet
+uint8_t					global_uart_modem_status;		// last MSR value: FLAG_UART_MSR_DCD, etc.
+bool					global_uart_modem_status_pending;	// interrupt handler saw DCD/DSR/CTS/RI change; the app hasn't handled it yet
+bool					global_uart_rts_held;			// interrupt handler dropped RTS because the circular buffer is nearly full
+uint8_t					global_uart_tx_buffer[UART_TX_BUFFER_SIZE];	// bytes waiting to go out. the UART interrupt handler feeds them to the FIFO.
+volatile uint16_t		global_uart_tx_write_idx;
+volatile uint16_t		global_uart_tx_read_idx;
+
+static uint8_t			serial_line_format = UART_DATA_BITS | UART_STOP_BITS | UART_PARITY;	// LCR data/stop/parity bits
 
 extern char*			global_string_buff1;
 extern char*			global_string_buff2;
@@ -159,12 +461,59 @@ void Serial_SetDLAB(void);
 // turn off DLAB mode on UART chip
 void Serial_ClearDLAB(void);
 
+// raise RTS again if the interrupt handler dropped it and the circular buffer has drained enough. call after reading from the buffer.
+void Serial_ResumeRTS(void);
+
 // process a byte from the serial port, including checking for ANSI sequences and printing to screen
 void Serial_ProcessByte(uint8_t the_byte);
 
 // print a byte to screen, from the serial port
 void Serial_PrintByte(uint8_t the_byte);
 
+// feed one byte of a UTF-8 sequence to the decoder. prints the CP437 equivalent once a code point is complete.
+void Serial_DecodeUTF8Byte(uint8_t the_byte);
+
+// VT100 SCS: record which character set (ASCII or DEC special graphics) was designated into G0 or G1
+// the_byte is the final character of ESC ( x or ESC ) x
+void Serial_DesignateCharSet(uint8_t the_byte);
+
+// a DCS string has ended. if it was a sixel image, move the cursor to the line below it
+void Serial_EndDCS(void);
+
+// process a byte from the serial port in PETSCII mode
+void Serial_ProcessPETSCIIByte(uint8_t the_byte);
+
+// print a PETSCII byte to the 40 column screen, wrapping to the next line at the right edge
+void Serial_PETSCIIPrintByte(uint8_t the_byte);
+
+// process a byte from the serial port in ANSI+AVT/0 mode
+void Serial_ProcessAvatarByte(uint8_t the_byte);
+
+// process a byte from the serial port in ANSI+RIPscrip mode
+void Serial_ProcessRIPByte(uint8_t the_byte);
+
+// print the_byte the_count times, as one bulk write per screen row rather than the_count individual prints
+void Serial_RepeatByte(uint8_t the_byte, uint8_t the_count);
+
+// process a byte from the serial port in ATASCII mode
+void Serial_ProcessATASCIIByte(uint8_t the_byte);
+
+// print an ATASCII byte to the 40 column screen, wrapping to the next line at the right edge
+void Serial_ATASCIIPrintByte(uint8_t the_byte);
+
+// move PETSCII/ATASCII cursor down one line, scrolling if already at the bottom
+void Serial_NarrowLineFeed(void);
+
+// true if the send buffer has not drained at all for SERIAL_TX_STALL_TICKS. the_read_idx and the_start_tick track the last progress seen.
+bool Serial_TransmitStalled(uint16_t* the_read_idx, uint16_t* the_start_tick);
+
+// send everything in the send buffer by polling LSR, for when the THRE interrupt has stopped arriving
+// returns false, and drops what is left, if the UART takes nothing for SERIAL_TX_STALL_TICKS
+bool Serial_DrainTransmitBuffer(void);
+
+// look up the CP437 glyph for a unicode code point. returns UTF8_REPLACEMENT_GLYPH if there isn't one.
+uint8_t Serial_UnicodeToGlyph(uint32_t the_code_point);
+
 // process the ANSI sequence stored in ansi_sequence_storage
 void Serial_ProcessANSI(void);
 
@@ -230,12 +579,22 @@ void Serial_ANSIEraseInDisplay(uint8_t the_count);
 //   Cursor position does not change.
 void Serial_ANSIEraseInLine(uint8_t the_count);
 
+// ANSI DL - Delete Line
+// Deletes n (default 1) lines, starting with the cursor's line. Lines below move up, blank lines fill in at the bottom.
+//   Cursor position does not change.
+void Serial_ANSIDeleteLine(uint8_t the_count);
+
 // Device Status Report - 6n
 // when requested by host computer, we need to respond with info about our terminal
 // ESC[n;mR, where n is the row and m is the column.
 // unofficial 255n seems to be used to send back terminal size. e.g, 24;80
 void Serial_ANSISendDSR(uint8_t the_count);
 
+// Device Attributes - c
+// CSI c or CSI 0 c (DA1) asks what kind of terminal we are. CSI > c or CSI > 0 c (DA2) asks for terminal type and version.
+// ANSI sequence to process is already in ansi_sequence (ESC [ is not included)
+void Serial_ANSISendDA(void);
+
 // ANSI function handler for SGR: Select Graphic Rendition
 // ANSI sequence to process is already in ansi_sequence (ESC [ is not included)
 // the_len contains the length of the sequence, not including the final command character. 
@@ -258,6 +617,19 @@ void Serial_ClearDLAB(void)
 {
 	R8(UART_LCR) = R8(UART_LCR) & (~UART_DLAB_MASK);
 }
+
+
+// raise RTS again if the interrupt handler dropped it and the circular buffer has drained enough. call after reading from the buffer.
+void Serial_ResumeRTS(void)
+{
+	if (global_uart_rts_held == false || Serial_BytesAvailable() > UART_RTS_ON_LEVEL)
+	{
+		return;
+	}
+	
+	R8(UART_MCR) = R8(UART_MCR) | FLAG_UART_MCR_RTS;
+	global_uart_rts_held = false;
+}
 	
 
 // Moves the cursor n (default 1) cells in the given direction.
@@ -589,6 +961,11 @@ void Serial_ANSICursorMoveToXY()
 // clears the screen setting attributs to normal. homes the cursor
 void Serial_ANSIClear(void)
 {
+	if (serial_emulation != EMULATION_RIP)
+	{
+		Sixel_Hide();	// in RIPscrip mode, the bitmap layer belongs to RIP
+	}
+	
 	serial_fg_color = TERMINAL_DEFAULT_FORE_COLOR;
 	serial_bg_color = TERMINAL_DEFAULT_BACK_COLOR;
 	
@@ -629,6 +1006,11 @@ void Serial_ANSIEraseInDisplay(uint8_t the_count)
 			Text_FillBox(TERM_BODY_X1, TERM_BODY_Y1, TERM_BODY_X2, TERM_BODY_Y2, CH_SPACE, serial_fg_color, serial_bg_color);
 			serial_x = TERM_BODY_X1;
 			serial_y = TERM_BODY_Y1;
+			
+			if (serial_emulation != EMULATION_RIP)
+			{
+				Sixel_Hide();
+			}
 			break;
 			
 		default:
@@ -672,6 +1054,37 @@ void Serial_ANSIEraseInLine(uint8_t the_count)
 }
 
 
+// ANSI DL - Delete Line
+// Deletes n (default 1) lines, starting with the cursor's line. Lines below move up, blank lines fill in at the bottom.
+//   Cursor position does not change.
+void Serial_ANSIDeleteLine(uint8_t the_count)
+{
+	if (the_count == 0)
+	{
+		the_count = 1;
+	}
+	
+	// no point deleting more lines than there are from the cursor down
+	if (the_count > TERM_BODY_Y2 - serial_y + 1)
+	{
+		the_count = TERM_BODY_Y2 - serial_y + 1;
+	}
+	
+	while (the_count > 0)
+	{
+		if (serial_y < TERM_BODY_Y2)
+		{
+			Text_ScrollTextAndAttrRowsUp(serial_y + 1, TERM_BODY_Y2);
+		}
+		
+		Text_FillBox(TERM_BODY_X1, TERM_BODY_Y2, TERM_BODY_X2, TERM_BODY_Y2, CH_SPACE, serial_fg_color, serial_bg_color);
+		the_count--;
+	}
+	
+	Text_SetXY(serial_x, serial_y);
+}
+
+
 // Device Status Report - 6n
 // when requested by host computer, we need to respond with info about our terminal
 // ESC[n;mR, where n is the row and m is the column.
@@ -705,6 +1118,42 @@ void Serial_ANSISendDSR(uint8_t the_count)
 }
 
 
+// Device Attributes - c
+// CSI c or CSI 0 c (DA1) asks what kind of terminal we are. CSI > c or CSI > 0 c (DA2) asks for terminal type and version.
+// ANSI sequence to process is already in ansi_sequence (ESC [ is not included)
+void Serial_ANSISendDA(void)
+{
+	uint8_t*	the_params = ansi_sequence;
+	bool		is_secondary = false;
+	
+	if (*the_params == CH_GREATER)
+	{
+		is_secondary = true;
+		the_params++;
+	}
+	
+	// only a 0 parameter (or none) is a request. anything else is a reply from another terminal, or something we don't know
+	if (*the_params == CH_0)
+	{
+		the_params++;
+	}
+	
+	if (*the_params != ANSI_FUNCTION_DA)
+	{
+		return;
+	}
+	
+	if (is_secondary)
+	{
+		Serial_SendData((uint8_t*)serial_da2_response, sizeof(serial_da2_response) - 1);
+	}
+	else
+	{
+		Serial_SendData((uint8_t*)serial_da1_response, sizeof(serial_da1_response) - 1);
+	}
+}
+
+
 // ANSI function handler for SGR: Select Graphic Rendition
 // ANSI sequence to process is already in ansi_sequence (ESC [ is not included)
 // the_len contains the length of the sequence, not including the final command character. 
@@ -845,10 +1294,38 @@ void Serial_ProcessByte(uint8_t the_byte)
 	{
 		// TODO: dedicated routine to display chars, handling movement back to next line, scroll screen, etc. 
 		
+		if (utf8_bytes_remaining > 0 && the_byte < 0x80)
+		{
+			// UTF-8 sequence was cut short. show that something was lost, then handle this byte normally
+			utf8_bytes_remaining = 0;
+			Serial_PrintByte(UTF8_REPLACEMENT_GLYPH);
+		}
+		
 		if (ansi_phase == 0 && the_byte != CH_ESC)
 		{
 			// normal text, not part of ANSI sequence
-			Serial_PrintByte(the_byte);
+			if (the_byte == CH_ENQ)
+			{
+				Serial_SendData((uint8_t*)serial_answerback, serial_answerback_len);
+			}
+			else if (the_byte == CH_SHIFT_OUT || the_byte == CH_SHIFT_IN)
+			{
+				// VT100 locking shifts between G0 and G1
+				serial_shifted_out = (the_byte == CH_SHIFT_OUT);
+				serial_dec_graphics_active = serial_shifted_out ? serial_g1_is_graphics : serial_g0_is_graphics;
+			}
+			else if (serial_dec_graphics_active == true && the_byte >= DEC_GRAPHICS_FIRST_CHAR && the_byte <= DEC_GRAPHICS_LAST_CHAR)
+			{
+				Serial_PrintByte(serial_dec_graphics_lut[the_byte - DEC_GRAPHICS_FIRST_CHAR]);
+			}
+			else if (serial_utf8_mode == true && the_byte >= 0x80)
+			{
+				Serial_DecodeUTF8Byte(the_byte);
+			}
+			else
+			{
+				Serial_PrintByte(the_byte);
+			}
 		}
 		else
 		{
@@ -865,6 +1342,18 @@ void Serial_ProcessByte(uint8_t the_byte)
 					// now we have full starting sequence: ESC+bracket
 					ansi_phase = 2;
 				}
+				else if (the_byte == CH_LPAREN || the_byte == CH_RPAREN)
+				{
+					// VT100 select character set: ESC ( designates G0, ESC ) designates G1. next byte says which set.
+					ansi_phase = 3;
+					scs_designating_g1 = (the_byte == CH_RPAREN);
+				}
+				else if (the_byte == CH_UC_P)
+				{
+					// DCS: device control string, runs until ST (ESC \). sixel images come this way.
+					ansi_phase = 4;
+					Sixel_Begin(serial_x - TERM_BODY_X1, serial_y - TERM_BODY_Y1);
+				}
 				else
 				{
 					// turns out this wasn't ANSI after all.
@@ -872,6 +1361,94 @@ void Serial_ProcessByte(uint8_t the_byte)
 					Serial_PrintByte(the_byte);					
 				}
 			}
+			else if (ansi_phase == 3)
+			{
+				ansi_phase = 0;
+				Serial_DesignateCharSet(the_byte);
+			}
+			else if (ansi_phase == 4)
+			{
+				if (the_byte == CH_ESC)
+				{
+					ansi_phase = 5;
+				}
+				else
+				{
+					Sixel_ProcessByte(the_byte);
+				}
+			}
+			else if (ansi_phase == 6)
+			{
+				if (the_byte == CH_MUSIC_END)
+				{
+					ansi_phase = 0;
+					Music_EndString();
+				}
+				else if (the_byte == CH_ESC)
+				{
+					// unterminated music string: play what we got, and start the new sequence
+					Music_EndString();
+					ansi_phase = 1;
+					ansi_sequence = ansi_sequence_storage;
+				}
+				else if (the_byte == CH_ENTER || the_byte == CH_LF)
+				{
+					// music strings don't span lines: if this was text taken for music, at most one line of it is lost
+					Music_EndString();
+					ansi_phase = 0;
+					Serial_ProcessByte(the_byte);
+				}
+				else
+				{
+					Music_ProcessByte(the_byte);
+				}
+			}
+			else if (ansi_phase == 7)
+			{
+				// bare CSI M is the VT100 Delete Line, which curses sends all the time. only "ESC [ MF" and "ESC [ MB" may be music.
+				if (the_byte == 'F' || the_byte == 'B')
+				{
+					ansi_phase = 8;
+					ansi_music_prefix = the_byte;
+				}
+				else
+				{
+					ansi_phase = 0;
+					Serial_ANSIDeleteLine(1);
+					Serial_ProcessByte(the_byte);
+				}
+			}
+			else if (ansi_phase == 8)
+			{
+				// "ESC [ MFT120 C", "ESC [ MBL8 CDE", etc.: music. text after a Delete Line ("Fred") is printed.
+				if (Music_IsStringStart(the_byte) == true)
+				{
+					ansi_phase = 6;
+					Music_BeginString();
+					Music_ProcessByte(ansi_music_prefix);
+					Music_ProcessByte(the_byte);
+				}
+				else
+				{
+					ansi_phase = 0;
+					Serial_ANSIDeleteLine(1);
+					Serial_ProcessByte(ansi_music_prefix);
+					Serial_ProcessByte(the_byte);
+				}
+			}
+			else if (ansi_phase == 5)
+			{
+				// ESC \ (ST) ends the DCS string. any other ESC also ends it, and starts a new sequence.
+				ansi_phase = 0;
+				Serial_EndDCS();
+				
+				if (the_byte != CH_BSLASH)
+				{
+					ansi_phase = 1;
+					ansi_sequence = ansi_sequence_storage;
+					Serial_ProcessByte(the_byte);
+				}
+			}
 			else
 			{
 				// we were already in an ANSI sequence. collect.
@@ -926,7 +1503,7 @@ void Serial_PrintByte(uint8_t the_byte)
 	}
 	else
 	{
-		Text_SetCharAndColor(the_byte, serial_fg_color, serial_bg_color);
+		Text_SetCharAndColor(serial_glyph_lut[the_byte], serial_fg_color, serial_bg_color);
 		serial_x++;	// test lib moved ahead, but locally we need to know if wrapping happened.
 		update_vicky_curs_pos = false;
 
@@ -950,80 +1527,721 @@ void Serial_PrintByte(uint8_t the_byte)
 }
 
 
-// process the ANSI sequence stored in ansi_sequence_storage
-void Serial_ProcessANSI(void)
+// feed one byte of a UTF-8 sequence to the decoder. prints the CP437 equivalent once a code point is complete.
+void Serial_DecodeUTF8Byte(uint8_t the_byte)
 {
-	uint8_t			the_len;
-	uint8_t			ansi_function;
-	uint8_t			the_count;	// for single-number functions, will hold converted number
-	ansi_action		the_action = ANSI_UNRECOGNIZED;
-	
 	// LOGIC:
-	//   ANSI CSI (Control Sequence Introducer) sequences consist of ESC + [ + params + function code
-	//   The function code is a single byte, case sensitive
-	//   the parameters are read left to right, and can be stacked with semicolons
-	//
-	//   design here is to first distinguish which function it is by checking last letter,
-	//   then...
-	
-	ansi_sequence = ansi_sequence_storage;
-	
-	the_len = General_Strnlen((char*)ansi_sequence, ANSI_MAX_SEQUENCE_LEN + 1);
-	ansi_function = ansi_sequence[the_len-1];
-	--the_len; // so we can pass this to handler functions and not have it see the command code
-	the_count = atoi((char*)ansi_sequence);	// won't work for all functions, but that's fine.
+	//   lead byte tells us how many continuation bytes follow: 110xxxxx = 1, 1110xxxx = 2, 11110xxx = 3
+	//   continuation bytes are 10xxxxxx and each contribute 6 bits
+	//   anything out of place (stray continuation, invalid lead) prints the replacement glyph and resets
 	
-	switch (ansi_function)
+	if ((the_byte & 0xC0) == 0x80)
 	{
-		case ANSI_FUNCTION_CUU:
-			// Cursor Up
-			Serial_ANSICursorUp(the_count);
-			break;
-		
-		case ANSI_FUNCTION_SU:
-			// Scroll Up
-			Serial_ANSIScrollUp(false);
-			break;
-		
-		case ANSI_FUNCTION_CUD:
-			// Cursor Down
-			Serial_ANSICursorDown(the_count);
-			break;
-		
-		case ANSI_FUNCTION_SD:
-			// Scroll Down
-			Serial_ANSIScrollUp(false);
-			break;
-		
-		case ANSI_FUNCTION_CUF:
-			// Cursor Forward
-			Serial_ANSICursorRight(the_count);
-			break;
-		
-		case ANSI_FUNCTION_CUB:
-			// Cursor Back
-			Serial_ANSICursorLeft(the_count);
-			break;
-		
-		case ANSI_FUNCTION_CNL:
-			// Cursor Next Line
-			Serial_ANSICursorNextLine(the_count);
-			break;
+		if (utf8_bytes_remaining == 0)
+		{
+			Serial_PrintByte(UTF8_REPLACEMENT_GLYPH);
+			return;
+		}
 		
-		case ANSI_FUNCTION_CPL:
-			// Cursor Previous Line
-			Serial_ANSICursorPreviousLine(the_count);
-			break;
+		utf8_code_point = (utf8_code_point << 6) | (the_byte & 0x3F);
 		
-		case ANSI_FUNCTION_CHA:
-			// Cursor Horizontal Absolute
-			Serial_ANSICursorSetXPos(the_count);
-			break;
+		if (--utf8_bytes_remaining == 0)
+		{
+			Serial_PrintByte(Serial_UnicodeToGlyph(utf8_code_point));
+		}
 		
-		case ANSI_FUNCTION_CUP:
-			// Cursor Position
-			Serial_ANSICursorSetXYPos();
-			break;
+		return;
+	}
+	
+	if (utf8_bytes_remaining > 0)
+	{
+		// new lead byte before the previous sequence finished
+		Serial_PrintByte(UTF8_REPLACEMENT_GLYPH);
+	}
+	
+	if ((the_byte & 0xE0) == 0xC0)
+	{
+		utf8_code_point = the_byte & 0x1F;
+		utf8_bytes_remaining = 1;
+	}
+	else if ((the_byte & 0xF0) == 0xE0)
+	{
+		utf8_code_point = the_byte & 0x0F;
+		utf8_bytes_remaining = 2;
+	}
+	else if ((the_byte & 0xF8) == 0xF0)
+	{
+		utf8_code_point = the_byte & 0x07;
+		utf8_bytes_remaining = 3;
+	}
+	else
+	{
+		utf8_bytes_remaining = 0;
+		Serial_PrintByte(UTF8_REPLACEMENT_GLYPH);
+	}
+}
+
+
+// VT100 SCS: record which character set (ASCII or DEC special graphics) was designated into G0 or G1
+// the_byte is the final character of ESC ( x or ESC ) x
+void Serial_DesignateCharSet(uint8_t the_byte)
+{
+	bool	is_graphics;
+	
+	// LOGIC:
+	//   '0' is DEC special graphics. 'B' (US ASCII), 'A' (UK), and anything else we don't know fall back to ASCII,
+	//   which is the safe choice: text stays readable even if the host asked for a national set we don't have.
+	
+	is_graphics = (the_byte == SCS_DEC_SPECIAL_GRAPHICS);
+	
+	if (scs_designating_g1 == true)
+	{
+		serial_g1_is_graphics = is_graphics;
+	}
+	else
+	{
+		serial_g0_is_graphics = is_graphics;
+	}
+	
+	serial_dec_graphics_active = serial_shifted_out ? serial_g1_is_graphics : serial_g0_is_graphics;
+}
+
+
+// look up the CP437 glyph for a unicode code point. returns UTF8_REPLACEMENT_GLYPH if there isn't one.
+uint8_t Serial_UnicodeToGlyph(uint32_t the_code_point)
+{
+	int16_t		low = 0;
+	int16_t		high = NUM_UNICODE_GLYPHS - 1;
+	int16_t		mid;
+	uint16_t	this_code_point;
+	
+	if (the_code_point < 0x80)
+	{
+		// overlong encoding of plain ASCII. just show it.
+		return (uint8_t)the_code_point;
+	}
+	
+	if (the_code_point > 0xFFFF)
+	{
+		// nothing outside the BMP maps to a CP437 glyph
+		return UTF8_REPLACEMENT_GLYPH;
+	}
+	
+	while (low <= high)
+	{
+		mid = (low + high) >> 1;
+		this_code_point = serial_unicode_glyphs[mid].code_point_;
+		
+		if (this_code_point == the_code_point)
+		{
+			return serial_unicode_glyphs[mid].glyph_;
+		}
+		else if (this_code_point < the_code_point)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid - 1;
+		}
+	}
+	
+	return UTF8_REPLACEMENT_GLYPH;
+}
+
+
+// a DCS string has ended. if it was a sixel image, move the cursor to the line below it
+void Serial_EndDCS(void)
+{
+	uint8_t		the_rows;
+	
+	the_rows = Sixel_End();
+	
+	if (the_rows > 0)
+	{
+		serial_x = TERM_BODY_X1;
+		Serial_ANSICursorDown(the_rows);
+	}
+}
+
+
+// process a byte from the serial port in PETSCII mode
+void Serial_ProcessPETSCIIByte(uint8_t the_byte)
+{
+	uint8_t		the_action;
+	
+	// LOGIC:
+	//   PETSCII has no multi-byte sequences: every byte is either a glyph or a single-byte command.
+	//   one lookup in petscii_action[] tells us which, so no per-byte chain of comparisons is needed.
+	
+	the_action = petscii_action[the_byte];
+	
+	if (the_action == PETSCII_ACT_PRINT)
+	{
+		Serial_PETSCIIPrintByte(the_byte);
+		return;
+	}
+	
+	if (the_action >= PETSCII_ACT_COLOR)
+	{
+		serial_fg_color = the_action - PETSCII_ACT_COLOR;
+		return;
+	}
+	
+	switch (the_action)
+	{
+		case PETSCII_ACT_RETURN:
+			// RETURN is CR+LF on a C64, and also cancels reverse mode
+			petscii_reverse_mode = false;
+			serial_x = NARROW_BODY_X1;
+			Serial_NarrowLineFeed();
+			break;
+			
+		case PETSCII_ACT_CURS_DOWN:
+			Serial_NarrowLineFeed();
+			break;
+			
+		case PETSCII_ACT_CURS_UP:
+			if (serial_y > TERM_BODY_Y1)
+			{
+				serial_y--;
+			}
+			break;
+			
+		case PETSCII_ACT_CURS_RIGHT:
+			if (++serial_x > NARROW_BODY_X2)
+			{
+				serial_x = NARROW_BODY_X1;
+				Serial_NarrowLineFeed();
+			}
+			break;
+			
+		case PETSCII_ACT_CURS_LEFT:
+			if (serial_x > NARROW_BODY_X1)
+			{
+				serial_x--;
+			}
+			else if (serial_y > TERM_BODY_Y1)
+			{
+				serial_x = NARROW_BODY_X2;
+				serial_y--;
+			}
+			break;
+			
+		case PETSCII_ACT_RVS_ON:
+			petscii_reverse_mode = true;
+			break;
+			
+		case PETSCII_ACT_RVS_OFF:
+			petscii_reverse_mode = false;
+			break;
+			
+		case PETSCII_ACT_CLEAR:
+			Text_FillBox(NARROW_BODY_X1, TERM_BODY_Y1, NARROW_BODY_X2, TERM_BODY_Y2, CH_SPACE, serial_fg_color, serial_bg_color);
+			// fall through: clear also homes the cursor
+		
+		case PETSCII_ACT_HOME:
+			serial_x = NARROW_BODY_X1;
+			serial_y = TERM_BODY_Y1;
+			break;
+			
+		case PETSCII_ACT_DELETE:
+			// delete char to left of cursor, pulling the rest of the line in after it
+			if (serial_x > NARROW_BODY_X1)
+			{
+				Text_ShiftTextAndAttrLeft(serial_x, serial_y, 1, CH_SPACE, serial_fg_color, serial_bg_color);
+				serial_x--;
+			}
+			break;
+			
+		case PETSCII_ACT_LOWER_CASE:
+			serial_glyph_lut = petscii_glyph_lut_lower;
+			break;
+			
+		case PETSCII_ACT_UPPER_CASE:
+			serial_glyph_lut = petscii_glyph_lut_upper;
+			break;
+			
+		default:
+			// PETSCII_ACT_IGNORE
+			return;
+	}
+	
+	Text_SetXY(serial_x, serial_y);
+}
+
+
+// print a PETSCII byte to the 40 column screen, wrapping to the next line at the right edge
+void Serial_PETSCIIPrintByte(uint8_t the_byte)
+{
+	if (petscii_reverse_mode == true)
+	{
+		Text_SetCharAndColorAtXY(serial_x, serial_y, serial_glyph_lut[the_byte], serial_bg_color, serial_fg_color);
+	}
+	else
+	{
+		Text_SetCharAndColorAtXY(serial_x, serial_y, serial_glyph_lut[the_byte], serial_fg_color, serial_bg_color);
+	}
+	
+	if (++serial_x > NARROW_BODY_X2)
+	{
+		serial_x = NARROW_BODY_X1;
+		Serial_NarrowLineFeed();
+	}
+	
+	Text_SetXY(serial_x, serial_y);
+}
+
+
+// process a byte from the serial port in ANSI+RIPscrip mode
+void Serial_ProcessRIPByte(uint8_t the_byte)
+{
+	// LOGIC:
+	//   a line starting with "!|" is RIPscrip: it goes, byte by byte, to the RIP parser until the end of the line.
+	//   everything else is ANSI, and goes to the regular ANSI engine.
+	//   the RIP parser draws each command as soon as it is complete, so the screen builds up while data is still arriving.
+	
+	if (rip_line_active == true)
+	{
+		if (RIP_ProcessByte(the_byte) == false)
+		{
+			rip_line_active = false;
+			rip_at_line_start = true;
+			rip_skip_lf = (the_byte == CH_ENTER);
+		}
+		return;
+	}
+	
+	if (rip_skip_lf == true)
+	{
+		rip_skip_lf = false;
+		
+		if (the_byte == CH_LF)
+		{
+			return;
+		}
+	}
+	
+	if (rip_bang_pending == true)
+	{
+		rip_bang_pending = false;
+		
+		if (the_byte == '|')
+		{
+			rip_line_active = true;
+			RIP_BeginLine();
+			return;
+		}
+		
+		// not RIP after all: the '!' was text
+		Serial_ProcessByte('!');
+	}
+	else if (rip_at_line_start == true && the_byte == '!' && ansi_phase == 0)
+	{
+		rip_bang_pending = true;
+		return;
+	}
+	
+	rip_at_line_start = (the_byte == CH_ENTER || the_byte == CH_LF);
+	Serial_ProcessByte(the_byte);
+}
+
+
+// process a byte from the serial port in ANSI+AVT/0 mode
+void Serial_ProcessAvatarByte(uint8_t the_byte)
+{
+	uint8_t		temp;
+	
+	// LOGIC:
+	//   AVT/0 codes are control characters that don't appear in ANSI art, so BBSes mix the two freely.
+	//   anything that isn't part of an AVT/0 sequence goes to the regular ANSI engine.
+	//   AVT/0 codes are only recognized between ANSI sequences, not inside one.
+	
+	switch (avt_phase)
+	{
+		case AVT_PHASE_NONE:
+			if (ansi_phase != 0)
+			{
+				break;
+			}
+			
+			if (the_byte == AVT_REPEAT)
+			{
+				avt_phase = AVT_PHASE_REPEAT_CHAR;
+				return;
+			}
+			else if (the_byte == AVT_COMMAND)
+			{
+				avt_phase = AVT_PHASE_COMMAND;
+				return;
+			}
+			else if (the_byte == AVT_CLEAR)
+			{
+				Serial_ANSIClear();
+				serial_fg_color = avt_pc_to_ansi_color[AVT_DEFAULT_ATTRIBUTE];
+				return;
+			}
+			break;
+			
+		case AVT_PHASE_COMMAND:
+			avt_phase = AVT_PHASE_NONE;
+			
+			switch (the_byte)
+			{
+				case AVT_CMD_SET_ATTR:
+					avt_phase = AVT_PHASE_ATTR;
+					break;
+					
+				case AVT_CMD_CURS_UP:
+					Serial_ANSICursorUp(1);
+					break;
+					
+				case AVT_CMD_CURS_DOWN:
+					Serial_ANSICursorDown(1);
+					break;
+					
+				case AVT_CMD_CURS_LEFT:
+					Serial_ANSICursorLeft(1);
+					break;
+					
+				case AVT_CMD_CURS_RIGHT:
+					Serial_ANSICursorRight(1);
+					break;
+					
+				case AVT_CMD_CLEAR_EOL:
+					Text_FillBox(serial_x, serial_y, TERM_BODY_X2, serial_y, CH_SPACE, serial_fg_color, serial_bg_color);
+					Text_SetXY(serial_x, serial_y);
+					break;
+					
+				case AVT_CMD_GOTO_XY:
+					avt_phase = AVT_PHASE_GOTO_ROW;
+					break;
+					
+				default:
+					// AVT_CMD_BLINK, or AVT/0+ commands we don't support
+					break;
+			}
+			return;
+			
+		case AVT_PHASE_ATTR:
+			avt_phase = AVT_PHASE_NONE;
+			serial_fg_color = avt_pc_to_ansi_color[the_byte & 0x07] | (the_byte & 0x08);	// bit 3 = bright
+			serial_bg_color = avt_pc_to_ansi_color[(the_byte >> 4) & 0x07];
+			return;
+			
+		case AVT_PHASE_GOTO_ROW:
+			avt_param = the_byte;
+			avt_phase = AVT_PHASE_GOTO_COL;
+			return;
+			
+		case AVT_PHASE_GOTO_COL:
+			avt_phase = AVT_PHASE_NONE;
+			
+			// row and col are 1-based. clamp to the terminal area
+			temp = (avt_param == 0) ? 0 : avt_param - 1;
+			serial_y = (temp > TERM_BODY_Y2 - TERM_BODY_Y1) ? TERM_BODY_Y2 : TERM_BODY_Y1 + temp;
+			temp = (the_byte == 0) ? 0 : the_byte - 1;
+			serial_x = (temp > TERM_BODY_X2 - TERM_BODY_X1) ? TERM_BODY_X2 : TERM_BODY_X1 + temp;
+			Text_SetXY(serial_x, serial_y);
+			return;
+			
+		case AVT_PHASE_REPEAT_CHAR:
+			avt_param = the_byte;
+			avt_phase = AVT_PHASE_REPEAT_COUNT;
+			return;
+			
+		case AVT_PHASE_REPEAT_COUNT:
+			avt_phase = AVT_PHASE_NONE;
+			Serial_RepeatByte(avt_param, the_byte);
+			return;
+	}
+	
+	Serial_ProcessByte(the_byte);
+}
+
+
+// print the_byte the_count times, as one bulk write per screen row rather than the_count individual prints
+void Serial_RepeatByte(uint8_t the_byte, uint8_t the_count)
+{
+	uint8_t		x2;
+	
+	if (the_count == 0)
+	{
+		return;
+	}
+	
+	// line control chars need their normal handling for each repeat
+	if (the_byte == CH_ENTER || the_byte == CH_LF || the_byte == CH_FF || the_byte == CH_BKSP)
+	{
+		while (the_count-- > 0)
+		{
+			Serial_PrintByte(the_byte);
+		}
+		return;
+	}
+	
+	// like Serial_PrintByte(), text does not wrap: anything that runs past the right edge piles up in the last column
+	if (the_count > TERM_BODY_X2 - serial_x)
+	{
+		x2 = TERM_BODY_X2;
+	}
+	else
+	{
+		x2 = serial_x + the_count - 1;
+	}
+	
+	Text_FillBox(serial_x, serial_y, x2, serial_y, serial_glyph_lut[the_byte], serial_fg_color, serial_bg_color);
+	
+	serial_x = (x2 < TERM_BODY_X2) ? x2 + 1 : TERM_BODY_X2;
+	Text_SetXY(serial_x, serial_y);
+}
+
+
+// process a byte from the serial port in ATASCII mode
+void Serial_ProcessATASCIIByte(uint8_t the_byte)
+{
+	uint8_t		the_action;
+	
+	if (atascii_escape_next == true)
+	{
+		atascii_escape_next = false;
+		Serial_ATASCIIPrintByte(the_byte);
+		return;
+	}
+	
+	the_action = atascii_action[the_byte];
+	
+	switch (the_action)
+	{
+		case ATASCII_ACT_PRINT:
+			Serial_ATASCIIPrintByte(the_byte);
+			return;
+			
+		case ATASCII_ACT_ESCAPE:
+			atascii_escape_next = true;
+			return;
+			
+		case ATASCII_ACT_EOL:
+			serial_x = NARROW_BODY_X1;
+			Serial_NarrowLineFeed();
+			break;
+			
+		case ATASCII_ACT_CURS_UP:
+			if (serial_y > TERM_BODY_Y1)
+			{
+				serial_y--;
+			}
+			break;
+			
+		case ATASCII_ACT_CURS_DOWN:
+			if (serial_y < TERM_BODY_Y2)
+			{
+				serial_y++;
+			}
+			break;
+			
+		case ATASCII_ACT_CURS_LEFT:
+			// Atari cursor left/right wrap around within the line
+			if (serial_x > NARROW_BODY_X1)
+			{
+				serial_x--;
+			}
+			else
+			{
+				serial_x = NARROW_BODY_X2;
+			}
+			break;
+			
+		case ATASCII_ACT_CURS_RIGHT:
+			if (serial_x < NARROW_BODY_X2)
+			{
+				serial_x++;
+			}
+			else
+			{
+				serial_x = NARROW_BODY_X1;
+			}
+			break;
+			
+		case ATASCII_ACT_CLEAR:
+			Text_FillBox(NARROW_BODY_X1, TERM_BODY_Y1, NARROW_BODY_X2, TERM_BODY_Y2, CH_SPACE, serial_fg_color, serial_bg_color);
+			serial_x = NARROW_BODY_X1;
+			serial_y = TERM_BODY_Y1;
+			break;
+			
+		case ATASCII_ACT_BACKSPACE:
+			if (serial_x > NARROW_BODY_X1)
+			{
+				serial_x--;
+				Text_SetCharAndColorAtXY(serial_x, serial_y, CH_SPACE, serial_fg_color, serial_bg_color);
+			}
+			break;
+			
+		case ATASCII_ACT_TAB:
+			// tab stops every ATASCII_TAB_WIDTH columns. past the last one, go to start of next line
+			serial_x += ATASCII_TAB_WIDTH - ((serial_x - NARROW_BODY_X1) % ATASCII_TAB_WIDTH);
+			
+			if (serial_x > NARROW_BODY_X2)
+			{
+				serial_x = NARROW_BODY_X1;
+				Serial_NarrowLineFeed();
+			}
+			break;
+			
+		case ATASCII_ACT_DELETE_LINE:
+			if (serial_y < TERM_BODY_Y2)
+			{
+				Text_ScrollTextAndAttrRowsUp(serial_y + 1, TERM_BODY_Y2);
+			}
+			Text_FillBox(NARROW_BODY_X1, TERM_BODY_Y2, NARROW_BODY_X2, TERM_BODY_Y2, CH_SPACE, serial_fg_color, serial_bg_color);
+			serial_x = NARROW_BODY_X1;
+			break;
+			
+		case ATASCII_ACT_INSERT_LINE:
+			if (serial_y < TERM_BODY_Y2)
+			{
+				Text_ScrollTextAndAttrRowsDown(serial_y, TERM_BODY_Y2 - 1);
+			}
+			Text_FillBox(NARROW_BODY_X1, serial_y, NARROW_BODY_X2, serial_y, CH_SPACE, serial_fg_color, serial_bg_color);
+			serial_x = NARROW_BODY_X1;
+			break;
+			
+		case ATASCII_ACT_DELETE_CHAR:
+			Text_ShiftTextAndAttrLeft(serial_x + 1, serial_y, 1, CH_SPACE, serial_fg_color, serial_bg_color);
+			// shift pulled in whatever was right of the 40 column window
+			Text_SetCharAndColorAtXY(NARROW_BODY_X2, serial_y, CH_SPACE, serial_fg_color, serial_bg_color);
+			break;
+			
+		case ATASCII_ACT_INSERT_CHAR:
+			Text_ShiftTextAndAttrRight(atascii_line_buffer, serial_x, serial_y, 1, CH_SPACE, serial_fg_color, serial_bg_color);
+			// last char of the line was pushed out of the 40 column window: wipe it
+			Text_SetCharAndColorAtXY(NARROW_BODY_X2 + 1, serial_y, CH_SPACE, TERMINAL_DEFAULT_FORE_COLOR, TERMINAL_DEFAULT_BACK_COLOR);
+			break;
+			
+		default:
+			// ATASCII_ACT_IGNORE
+			return;
+	}
+	
+	Text_SetXY(serial_x, serial_y);
+}
+
+
+// print an ATASCII byte to the 40 column screen, wrapping to the next line at the right edge
+void Serial_ATASCIIPrintByte(uint8_t the_byte)
+{
+	uint8_t		colors[2];
+	uint8_t		inverse;
+	
+	// LOGIC:
+	//   bit 7 of an ATASCII character means "draw in inverse video". rather than test for it,
+	//   use it as an index into a fore/back color pair, so normal and inverse take the same path.
+	
+	colors[0] = serial_fg_color;
+	colors[1] = serial_bg_color;
+	inverse = the_byte >> 7;
+	
+	Text_SetCharAndColorAtXY(serial_x, serial_y, atascii_glyph_lut[the_byte & 0x7F], colors[inverse], colors[inverse ^ 1]);
+	
+	if (++serial_x > NARROW_BODY_X2)
+	{
+		serial_x = NARROW_BODY_X1;
+		Serial_NarrowLineFeed();
+	}
+	
+	Text_SetXY(serial_x, serial_y);
+}
+
+
+// move PETSCII/ATASCII cursor down one line, scrolling if already at the bottom
+void Serial_NarrowLineFeed(void)
+{
+	if (serial_y >= TERM_BODY_Y2)
+	{
+		Text_ScrollTextAndAttrRowsUp(TERM_BODY_Y1+1, TERM_BODY_Y2);
+		Text_FillBox(NARROW_BODY_X1, TERM_BODY_Y2, NARROW_BODY_X2, TERM_BODY_Y2, CH_SPACE, serial_fg_color, serial_bg_color);
+	}
+	else
+	{
+		++serial_y;
+	}
+}
+
+
+// process the ANSI sequence stored in ansi_sequence_storage
+void Serial_ProcessANSI(void)
+{
+	uint8_t			the_len;
+	uint8_t			ansi_function;
+	uint8_t			the_count;	// for single-number functions, will hold converted number
+	ansi_action		the_action = ANSI_UNRECOGNIZED;
+	
+	// LOGIC:
+	//   ANSI CSI (Control Sequence Introducer) sequences consist of ESC + [ + params + function code
+	//   The function code is a single byte, case sensitive
+	//   the parameters are read left to right, and can be stacked with semicolons
+	//
+	//   design here is to first distinguish which function it is by checking last letter,
+	//   then...
+	
+	ansi_sequence = ansi_sequence_storage;
+	
+	the_len = General_Strnlen((char*)ansi_sequence, ANSI_MAX_SEQUENCE_LEN + 1);
+	ansi_function = ansi_sequence[the_len-1];
+	--the_len; // so we can pass this to handler functions and not have it see the command code
+	the_count = atoi((char*)ansi_sequence);	// won't work for all functions, but that's fine.
+	
+	switch (ansi_function)
+	{
+		case ANSI_FUNCTION_CUU:
+			// Cursor Up
+			Serial_ANSICursorUp(the_count);
+			break;
+		
+		case ANSI_FUNCTION_SU:
+			// Scroll Up
+			Serial_ANSIScrollUp(false);
+			break;
+		
+		case ANSI_FUNCTION_CUD:
+			// Cursor Down
+			Serial_ANSICursorDown(the_count);
+			break;
+		
+		case ANSI_FUNCTION_SD:
+			// Scroll Down
+			Serial_ANSIScrollUp(false);
+			break;
+		
+		case ANSI_FUNCTION_CUF:
+			// Cursor Forward
+			Serial_ANSICursorRight(the_count);
+			break;
+		
+		case ANSI_FUNCTION_CUB:
+			// Cursor Back
+			Serial_ANSICursorLeft(the_count);
+			break;
+		
+		case ANSI_FUNCTION_CNL:
+			// Cursor Next Line
+			Serial_ANSICursorNextLine(the_count);
+			break;
+		
+		case ANSI_FUNCTION_CPL:
+			// Cursor Previous Line
+			Serial_ANSICursorPreviousLine(the_count);
+			break;
+		
+		case ANSI_FUNCTION_CHA:
+			// Cursor Horizontal Absolute
+			Serial_ANSICursorSetXPos(the_count);
+			break;
+		
+		case ANSI_FUNCTION_CUP:
+			// Cursor Position
+			Serial_ANSICursorSetXYPos();
+			break;
 
 		case ANSI_FUNCTION_SAVECURPOS:
 			// save current cursor position
@@ -1064,34 +2282,232 @@ void Serial_ProcessANSI(void)
 			Serial_ANSISendDSR(the_count);
 			break;
 		
-		case ANSI_FUNCTION_PRIVHIDEMOUSE:
-		case ANSI_FUNCTION_PRIVSHOWMOUSE:
-			// private functions we will not attempt to parse
-			break;
-			
-		default:
-			// unknown (to f/term) ANSI functions: capture in the buffer
-			Buffer_NewMessage((char*)ansi_sequence);
-			break;
+		case ANSI_FUNCTION_DA:
+			// Device Attributes
+			Serial_ANSISendDA();
+			break;
+		
+		case ANSI_FUNCTION_DL:
+			// Delete Line. with no parameters, it may be ANSI music instead: wait for the next bytes to tell
+			if (the_len == 0)
+			{
+				ansi_phase = 7;
+			}
+			else
+			{
+				Serial_ANSIDeleteLine(the_count);
+			}
+			break;
+		
+		case ANSI_FUNCTION_MUSIC:
+			// ANSI music: the MML string that follows is collected by Serial_ProcessByte, and played in the background
+			ansi_phase = 6;
+			Music_BeginString();
+			break;
+		
+		case ANSI_FUNCTION_PRIVHIDEMOUSE:
+		case ANSI_FUNCTION_PRIVSHOWMOUSE:
+			// private functions we will not attempt to parse
+			break;
+			
+		default:
+			// unknown (to f/term) ANSI functions: capture in the buffer
+			Buffer_NewMessage((char*)ansi_sequence);
+			break;
+	}
+}
+// stuff found I didn't detect:
+// 8;25;80t	: Ps = 8 ;  height ;  width ⇒  Resize the text area to given height and width in characters.  Omitted parameters reuse the current height or width.  Zero parameters use the display's height or width
+// 1;25r	: ESC [ <top> ; <bottom> r    set scroll region
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+
+
+// set up ANSI colors
+void Serial_InitANSIColors(void)
+{
+	// set standard color LUTs for text mode
+	memcpy((uint8_t*)(TEXT_FORE_LUT), &ansi_text_color_lut, 64);
+	memcpy((uint8_t*)(TEXT_BACK_LUT), &ansi_text_color_lut, 64);
+}
+
+
+// set the CP437 -> font glyph translation table used when printing incoming bytes
+// the_lut must point to 256 bytes, and must remain valid until replaced
+void Serial_SetGlyphLUT(const uint8_t* the_lut)
+{
+	serial_font_glyph_lut = the_lut;
+	
+	if (serial_emulation == EMULATION_ANSI || serial_emulation == EMULATION_AVATAR || serial_emulation == EMULATION_RIP)
+	{
+		serial_glyph_lut = the_lut;
+	}
+}
+
+
+// switch terminal emulation. clears the terminal area and homes the cursor.
+void Serial_SetEmulation(emulation_mode the_mode)
+{
+	serial_emulation = the_mode;
+
+	// drop any half-received sequence from the previous emulation
+	ansi_phase = 0;
+	ansi_sequence = ansi_sequence_storage;
+	utf8_bytes_remaining = 0;
+	avt_phase = AVT_PHASE_NONE;
+	rip_at_line_start = true;
+	rip_bang_pending = false;
+	rip_line_active = false;
+	rip_skip_lf = false;
+	
+	if (the_mode != EMULATION_RIP)
+	{
+		Sixel_Hide();
+	}
+	
+	Music_Stop();
+	
+	serial_fg_color = TERMINAL_DEFAULT_FORE_COLOR;
+	serial_bg_color = TERMINAL_DEFAULT_BACK_COLOR;
+	serial_x = TERM_BODY_X1;
+	serial_y = TERM_BODY_Y1;
+	
+	Text_FillBox(TERM_BODY_X1, TERM_BODY_Y1, TERM_BODY_X2, TERM_BODY_Y2, CH_SPACE, serial_fg_color, serial_bg_color);
+
+	if (the_mode == EMULATION_ANSI || the_mode == EMULATION_AVATAR || the_mode == EMULATION_RIP)
+	{
+		serial_glyph_lut = serial_font_glyph_lut;
+	}
+	else
+	{
+		if (the_mode == EMULATION_PETSCII)
+		{
+			serial_glyph_lut = petscii_glyph_lut_upper;
+			serial_fg_color = PETSCII_DEFAULT_FORE_COLOR;
+			petscii_reverse_mode = false;
+		}
+		else
+		{
+			// ATASCII handles its own glyph translation, as bit 7 is inverse video not a glyph
+			serial_fg_color = ATASCII_DEFAULT_FORE_COLOR;
+			serial_bg_color = ATASCII_DEFAULT_BACK_COLOR;
+			atascii_escape_next = false;
+		}
+		
+		serial_x = NARROW_BODY_X1;
+		Text_FillBox(NARROW_BODY_X1, TERM_BODY_Y1, NARROW_BODY_X2, TERM_BODY_Y2, CH_SPACE, serial_fg_color, serial_bg_color);
 	}
+	
+	Text_SetXY(serial_x, serial_y);
 }
-// stuff found I didn't detect:
-// 8;25;80t	: Ps = 8 ;  height ;  width ⇒  Resize the text area to given height and width in characters.  Omitted parameters reuse the current height or width.  Zero parameters use the display's height or width
-// 1;25r	: ESC [ <top> ; <bottom> r    set scroll region
 
 
-/*****************************************************************************/
-/*                        Public Function Definitions                        */
-/*****************************************************************************/
+// translate a key typed on the F256 into the byte the remote system expects for the current emulation
+uint8_t Serial_TranslateKey(uint8_t the_key)
+{
+	if (serial_emulation == EMULATION_ATASCII)
+	{
+		// ATASCII letters match ASCII; only line ending and editing keys differ
+		switch (the_key)
+		{
+			case CH_ENTER:			return ATASCII_EOL;
+			case KEY_CURS_UP:		return ATASCII_CURS_UP;
+			case KEY_CURS_DOWN:		return ATASCII_CURS_DOWN;
+			case KEY_CURS_LEFT:		return ATASCII_CURS_LEFT;
+			case KEY_CURS_RIGHT:	return ATASCII_CURS_RIGHT;
+			case CH_BKSP:			return ATASCII_BACKSPACE;
+			case CH_TAB:			return ATASCII_TAB;
+			case CH_DEL:			return ATASCII_DELETE_CHAR;
+			case KEY_INS:			return ATASCII_INSERT_CHAR;
+			default:				return the_key;
+		}
+	}
+	
+	if (serial_emulation != EMULATION_PETSCII)
+	{
+		return the_key;
+	}
+	
+	// LOGIC:
+	//   PETSCII swaps the case of letters relative to ASCII: unshifted letters are 0x41-0x5A, shifted are 0xC1-0xDA
+	//   cursor keys, HOME, DEL etc. are single byte control codes
+	
+	if (the_key >= CH_LC_A && the_key <= CH_LC_Z)
+	{
+		return the_key - (CH_LC_A - CH_UC_A);
+	}
+	
+	if (the_key >= CH_UC_A && the_key <= CH_UC_Z)
+	{
+		return the_key + 0x80;
+	}
+	
+	switch (the_key)
+	{
+		case CH_ENTER:			return PETSCII_RETURN;
+		case KEY_CURS_UP:		return PETSCII_CURS_UP;
+		case KEY_CURS_DOWN:		return PETSCII_CURS_DOWN;
+		case KEY_CURS_LEFT:		return PETSCII_CURS_LEFT;
+		case KEY_CURS_RIGHT:	return PETSCII_CURS_RIGHT;
+		case KEY_HOME:			return PETSCII_HOME;
+		case KEY_INS:			return PETSCII_INSERT;
+		case CH_BKSP:
+		case CH_DEL:			return PETSCII_DELETE;
+		case KEY_F1:			return PETSCII_F1;
+		case KEY_F3:			return PETSCII_F1 + 1;
+		case KEY_F5:			return PETSCII_F1 + 2;
+		case KEY_F7:			return PETSCII_F1 + 3;
+		case KEY_F2:			return PETSCII_F1 + 4;
+		case KEY_F4:			return PETSCII_F1 + 5;
+		case KEY_F6:			return PETSCII_F1 + 6;
+		case KEY_F8:			return PETSCII_F1 + 7;
+		default:				return the_key;
+	}
+}
 
 
+// set the answerback message sent when the host sends ENQ. longer messages are truncated to SERIAL_ANSWERBACK_MAX_LEN.
+void Serial_SetAnswerback(const char* the_answerback)
+{
+	General_Strlcpy(serial_answerback, the_answerback, SERIAL_ANSWERBACK_MAX_LEN + 1);
+	serial_answerback_len = General_Strnlen(serial_answerback, SERIAL_ANSWERBACK_MAX_LEN);
+}
 
-// set up ANSI colors
-void Serial_InitANSIColors(void)
+
+// the answerback message sent when the host sends ENQ
+const char* Serial_GetAnswerback(void)
 {
-	// set standard color LUTs for text mode
-	memcpy((uint8_t*)(TEXT_FORE_LUT), &ansi_text_color_lut, 64);
-	memcpy((uint8_t*)(TEXT_BACK_LUT), &ansi_text_color_lut, 64);
+	return serial_answerback;
+}
+
+
+// turn the telnet layer on or off. turn on when connected through a WiFi modem to a telnet BBS.
+// returns the new state: true if telnet mode is now on
+bool Serial_ToggleTelnetMode(void)
+{
+	serial_telnet_mode = !serial_telnet_mode;
+	
+	if (serial_telnet_mode == true)
+	{
+		Telnet_Reset();
+	}
+	
+	return serial_telnet_mode;
+}
+
+
+// turn UTF-8 decoding of incoming text on or off
+// returns the new state: true if UTF-8 decoding is now on
+bool Serial_ToggleUTF8Mode(void)
+{
+	serial_utf8_mode = !serial_utf8_mode;
+	utf8_bytes_remaining = 0;
+	
+	return serial_utf8_mode;
 }
 
 
@@ -1100,16 +2516,20 @@ void Serial_InitUART(void)
 {
 	uint8_t		junk;
 	
-	R8(UART_LCR) = UART_DATA_BITS | UART_STOP_BITS | UART_PARITY | UART_NO_BRK_SIG;
+	R8(UART_LCR) = serial_line_format | UART_NO_BRK_SIG;
 	Serial_SetDLAB();
 	R16(UART_DLL) = UART_BAUD_DIV_9600;
 	Serial_ClearDLAB();
-	R8(UART_MCR) = FLAG_UART_MCR_OUT2;
-	R8(UART_IER) = (FLAG_UART_IER_RXA | FLAG_UART_IER_ERR);	// enable interrupts on receive events
+	R8(UART_FCR) = UART_FIFO_ENABLE | UART_FIFO_RX_RESET | UART_FIFO_TX_RESET;	// 16-byte FIFOs on. receive trigger level stays at 1 byte.
+	R8(UART_MCR) = FLAG_UART_MCR_OUT2 | FLAG_UART_MCR_DTR | FLAG_UART_MCR_RTS;	// DTR must be on for Serial_SetDTR(false) to hang up
+	global_uart_rts_held = false;
+	global_uart_tx_write_idx = 0;
+	global_uart_tx_read_idx = 0;
+	R8(UART_IER) = (FLAG_UART_IER_RXA | FLAG_UART_IER_ERR | FLAG_UART_IER_STAT);	// enable interrupts on receive events and modem line changes
 	
 	// Read and clear status registers
 	junk = R8(UART_LSR);
-	junk = R8(UART_MSR);
+	global_uart_modem_status = R8(UART_MSR);
 
 	serial_x = TERM_BODY_X1;
 	serial_y = TERM_BODY_Y1;
@@ -1126,41 +2546,185 @@ void Serial_SetBaud(uint16_t new_baud_rate_divisor)
 }
 
 
+// change data bits, parity, and stop bits. leaves DLAB and BREAK as they are.
+// line_format is UART_DATA_BITS_x | UART_PARITY_x | UART_STOP_BITS_x. error counts restart, to judge the new format.
+void Serial_SetLineFormat(uint8_t line_format)
+{
+	serial_line_format = line_format & UART_LINE_FORMAT_MASK;
+	R8(UART_LCR) = (R8(UART_LCR) & (~UART_LINE_FORMAT_MASK)) | serial_line_format;
+	
+	global_uart_error_counts.overrun_ = 0;
+	global_uart_error_counts.parity_ = 0;
+	global_uart_error_counts.framing_ = 0;
+	global_uart_error_counts.break_ = 0;
+}
+
+
+// returns true if the line format has fewer than 8 data bits (7E1, etc.): the 8th bit of each byte doesn't get through
+bool Serial_IsSevenBit(void)
+{
+	return ((serial_line_format & UART_DATA_BITS) != UART_DATA_BITS_8);
+}
+
+
+// start (true) or stop (false) holding the transmit line in the BREAK state
+void Serial_SetBreak(bool break_on)
+{
+	if (break_on == true)
+	{
+		R8(UART_LCR) = R8(UART_LCR) | UART_BRK_SIG;
+	}
+	else
+	{
+		R8(UART_LCR) = R8(UART_LCR) & (~UART_BRK_SIG);
+	}
+}
+
+
+// turn DTR on (true) or off (false). most modems hang up when DTR goes off (AT&D2, the usual default).
+void Serial_SetDTR(bool dtr_on)
+{
+	if (dtr_on == true)
+	{
+		R8(UART_MCR) = R8(UART_MCR) | FLAG_UART_MCR_DTR;
+	}
+	else
+	{
+		R8(UART_MCR) = R8(UART_MCR) & (~FLAG_UART_MCR_DTR);
+	}
+}
+
+
 // send a byte over the UART serial connection
-// if the UART send buffer does not have space for the byte, it will try for UART_MAX_SEND_ATTEMPTS then return an error
+// if the send buffer is full, waits for the UART interrupt to make room
 // returns false on any error condition
 bool Serial_SendByte(uint8_t the_byte)
 {
-	uint8_t		error_check;
-// 	bool		uart_in_buff_is_empty = false;
-// 	uint16_t	num_tries = 0;
+	// in telnet mode, a 0xFF data byte must be sent as IAC IAC
+	if (serial_telnet_mode == true && the_byte == TELNET_IAC)
+	{
+		if (Serial_SendRawByte(TELNET_IAC) == false)
+		{
+			return false;
+		}
+	}
+	
+	return Serial_SendRawByte(the_byte);
+}
+
+
+// send a byte over the UART serial connection, without telnet IAC escaping. for telnet negotiation replies.
+// the byte is queued for the UART interrupt to send; this only waits if the send buffer is full.
+// returns false on any error condition
+bool Serial_SendRawByte(uint8_t the_byte)
+{
+	uint16_t	next_idx;
+	uint16_t	last_read_idx;
+	uint16_t	start_tick;
+	
+	// LOGIC:
+	//   writing THR directly overran the UART whenever more than one byte went out at a time: nothing waited for THRE.
+	//   bytes now go into global_uart_tx_buffer, and the interrupt handler refills the 16-byte FIFO each time it empties.
+	//   turning on the THRE interrupt when it is already on is harmless, and raises one right away if the FIFO is idle.
+	
+	//   if a THRE interrupt is ever lost, nothing drains the buffer: after SERIAL_TX_STALL_TICKS with no progress, send by polling instead.
 	
-	error_check = R8(UART_LSR) & UART_ERROR_MASK;
+	next_idx = (global_uart_tx_write_idx + 1) & UART_TX_BUFFER_MASK;
+	last_read_idx = global_uart_tx_read_idx;
+	start_tick = App_GetTicks();
 	
-	if (error_check > 0)
+	while (next_idx == global_uart_tx_read_idx)
 	{
-		goto error;
+		// full. the interrupt handler is draining it at line speed.
+		if (Serial_TransmitStalled(&last_read_idx, &start_tick) == true)
+		{
+			if (Serial_DrainTransmitBuffer() == false)
+			{
+				return false;
+			}
+		}
 	}
-
-// this code worked on F256Kc (MMU) version, compiled with cc65. also says uart buff is never empty on F256e with Calypsi. commenting out for now, as buffer does appear to be empty (at least acts that way)
-// 	while (uart_in_buff_is_empty == false && num_tries < UART_MAX_SEND_ATTEMPTS)
-// 	{
-// 		uart_in_buff_is_empty = R8(UART_LSR) & UART_THR_IS_EMPTY;
-// 		++num_tries;
-// 	};
-// 	
-// 	if (uart_in_buff_is_empty == true)
-// 	{
-// 		goto error;
-// 	}
 	
-	R8(UART_THR) = the_byte;
+	global_uart_tx_buffer[global_uart_tx_write_idx] = the_byte;
+	global_uart_tx_write_idx = next_idx;
+	
+	R8(UART_IER) = R8(UART_IER) | FLAG_UART_IER_TXA;
 	
 	return true;
+}
+
+
+// wait until the UART interrupt has taken every queued byte from the send buffer
+// returns false if the UART stopped taking bytes and the rest were dropped
+bool Serial_WaitForTransmit(void)
+{
+	uint16_t	last_read_idx = global_uart_tx_read_idx;
+	uint16_t	start_tick = App_GetTicks();
+	
+	while (global_uart_tx_read_idx != global_uart_tx_write_idx)
+	{
+		if (Serial_TransmitStalled(&last_read_idx, &start_tick) == true)
+		{
+			return Serial_DrainTransmitBuffer();
+		}
+	}
 	
-	error:
-		Text_SetChar('!');
+	return true;
+}
+
+
+// true if the send buffer has not drained at all for SERIAL_TX_STALL_TICKS. the_read_idx and the_start_tick track the last progress seen.
+bool Serial_TransmitStalled(uint16_t* the_read_idx, uint16_t* the_start_tick)
+{
+	if (global_uart_tx_read_idx != *the_read_idx)
+	{
+		*the_read_idx = global_uart_tx_read_idx;
+		*the_start_tick = App_GetTicks();
 		return false;
+	}
+	
+	return ((uint16_t)(App_GetTicks() - *the_start_tick) >= SERIAL_TX_STALL_TICKS);
+}
+
+
+// send everything in the send buffer by polling LSR, for when the THRE interrupt has stopped arriving
+// returns false, and drops what is left, if the UART takes nothing for SERIAL_TX_STALL_TICKS
+bool Serial_DrainTransmitBuffer(void)
+{
+	uint16_t	start_tick;
+	uint8_t		fifo_room;
+	
+	// LOGIC:
+	//   the interrupt handler only touches the send buffer while the THRE interrupt is on.
+	//   turning it off first means the two can't both move the read index. the next Serial_SendRawByte() turns it back on.
+	
+	R8(UART_IER) = R8(UART_IER) & (~FLAG_UART_IER_TXA);
+	start_tick = App_GetTicks();
+	
+	while (global_uart_tx_read_idx != global_uart_tx_write_idx)
+	{
+		if ( (R8(UART_LSR) & UART_THR_IS_EMPTY) != 0)
+		{
+			fifo_room = UART_FIFO_SIZE;
+			
+			while (fifo_room > 0 && global_uart_tx_read_idx != global_uart_tx_write_idx)
+			{
+				R8(UART_THR) = global_uart_tx_buffer[global_uart_tx_read_idx];
+				global_uart_tx_read_idx = (global_uart_tx_read_idx + 1) & UART_TX_BUFFER_MASK;
+				fifo_room--;
+			}
+			
+			start_tick = App_GetTicks();
+		}
+		else if ((uint16_t)(App_GetTicks() - start_tick) >= SERIAL_TX_STALL_TICKS)
+		{
+			// the UART isn't sending at all. drop the rest rather than hang.
+			global_uart_tx_read_idx = global_uart_tx_write_idx;
+			return false;
+		}
+	}
+	
+	return true;
 }
 
 
@@ -1192,6 +2756,8 @@ uint8_t Serial_SendData(uint8_t* the_buffer, uint16_t buffer_size)
 // returns false if no bytes were available
 bool Serial_ProcessAvailableData(void)
 {
+	uint8_t		the_byte;
+	
 	if (global_uart_read_idx == global_uart_write_idx)
 	{
 		// nothing in receive buffer
@@ -1201,49 +2767,200 @@ bool Serial_ProcessAvailableData(void)
 	{
 		while ( global_uart_read_idx != global_uart_write_idx )
 		{
-			Serial_ProcessByte(global_uart_in_buffer[global_uart_read_idx++]);
+			the_byte = global_uart_in_buffer[global_uart_read_idx++];
 			
-			if (global_uart_read_idx > UART_BUFFER_SIZE)
+			if (global_uart_read_idx >= UART_BUFFER_SIZE)
 			{
 				global_uart_read_idx = 0;
 			}
+			
+			// telnet commands are answered and dropped here, before any emulation sees them
+			if (serial_telnet_mode == false || Telnet_ProcessByte(the_byte) == true)
+			{
+				// ZMODEM auto-start. normal text costs 2 compares per byte.
+				if (the_byte == serial_zrqinit[serial_zrqinit_pos])
+				{
+					if (++serial_zrqinit_pos == sizeof(serial_zrqinit))
+					{
+						// stop here: the rest of the header, and anything after it, stays in the buffer for the ZMODEM receiver
+						serial_zrqinit_pos = 0;
+						serial_zmodem_start = true;
+						break;
+					}
+				}
+				else if (serial_zrqinit_pos != 0)
+				{
+					// "***" still has "**" matched
+					serial_zrqinit_pos = (the_byte != '*') ? 0 : (serial_zrqinit_pos == 2) ? 2 : 1;
+				}
+				
+				Modem_ProcessByte(the_byte);
+				
+				switch (serial_emulation)
+				{
+					case EMULATION_PETSCII:
+						Serial_ProcessPETSCIIByte(the_byte);
+						break;
+						
+					case EMULATION_ATASCII:
+						Serial_ProcessATASCIIByte(the_byte);
+						break;
+						
+					case EMULATION_AVATAR:
+						Serial_ProcessAvatarByte(the_byte);
+						break;
+						
+					case EMULATION_RIP:
+						Serial_ProcessRIPByte(the_byte);
+						break;
+						
+					default:
+						Serial_ProcessByte(the_byte);
+						break;
+				}
+			}
 		}
 	}
 	
+	Serial_ResumeRTS();
+	
 	return true;
 }
 
 
-// // get a single byte from UART serial connection
-// // returns -1 if no byte was received before specified timeout period passes
-// int16_t Serial_GetByte(int32_t the_timeout)
-// {
-// 	int16_t		the_byte = -1;
-// 	uint32_t	iiii;
-// 
-// 	for (iiii = 0; iiii < the_timeout; iiii++)
-// 	{
-// 		if (global_uart_read_idx == global_uart_write_idx)
-// 		{
-// 			// nothing in receive buffer
-// 			General_DelayTicks(300);
-// 		}
-// 		else
-// 		{
-// 			// at least 1 byte available in buffer
-// 			the_byte = (int16_t)global_uart_in_buffer[global_uart_read_idx++];
-// 			
-// 			if (global_uart_read_idx > UART_BUFFER_SIZE)
-// 			{
-// 				global_uart_read_idx = 0;
-// 			}
-// 
-// 			return the_byte;
-// 		}
-// 	}
-// 	
-// 	return the_byte;
-// }
+// returns true once after a ZMODEM sender's ZRQINIT header has arrived. what follows it is left in the receive buffer.
+bool Serial_CheckZModemStart(void)
+{
+	if (serial_zmodem_start == false)
+	{
+		return false;
+	}
+	
+	serial_zmodem_start = false;
+	return true;
+}
+
+
+// returns the number of received bytes waiting in the UART circular buffer
+uint16_t Serial_BytesAvailable(void)
+{
+	uint16_t	the_write_idx = global_uart_write_idx;	// copy: the interrupt handler can move it while we look
+	
+	if (the_write_idx >= global_uart_read_idx)
+	{
+		return the_write_idx - global_uart_read_idx;
+	}
+	
+	return (UART_BUFFER_SIZE - global_uart_read_idx) + the_write_idx;
+}
+
+
+// get a single byte from UART serial connection. telnet commands are answered and skipped if telnet mode is on.
+// returns -1 if no byte was received before specified timeout period passes
+int16_t Serial_GetByte(uint32_t the_timeout_ms)
+{
+	uint8_t		the_byte;
+	uint16_t	start_tick = App_GetTicks();
+	uint16_t	timeout_ticks = SERIAL_MS_TO_TICKS(the_timeout_ms);
+
+	while ((uint16_t)(App_GetTicks() - start_tick) < timeout_ticks)
+	{
+		if (global_uart_read_idx == global_uart_write_idx)
+		{
+			// nothing in receive buffer
+			continue;
+		}
+		
+		the_byte = global_uart_in_buffer[global_uart_read_idx++];
+		
+		if (global_uart_read_idx >= UART_BUFFER_SIZE)
+		{
+			global_uart_read_idx = 0;
+		}
+		
+		Serial_ResumeRTS();
+
+		if (serial_telnet_mode == false || Telnet_ProcessByte(the_byte) == true)
+		{
+			return (int16_t)the_byte;
+		}
+	}
+	
+	return -1;
+}
+
+
+// read the_len bytes from the UART into the_buffer, waiting for them to arrive
+// gives up if no new bytes arrive for the_timeout_ms. returns the number of bytes read, which is only less than the_len on a timeout.
+uint16_t Serial_ReadPacket(uint8_t* the_buffer, uint16_t the_len, uint32_t the_timeout_ms)
+{
+	uint16_t	start_tick;
+	uint16_t	timeout_ticks = SERIAL_MS_TO_TICKS(the_timeout_ms);
+	uint16_t	available;
+	uint16_t	last_available;
+	uint16_t	first_span;
+	int16_t		the_byte;
+	uint16_t	i;
+	
+	// LOGIC:
+	//   a 1K YMODEM block is 1029 bytes. reading it one Serial_GetByte() call at a time costs more than receiving it, at 19200+.
+	//   instead, wait until the whole block is in the circular buffer, then copy it out in 1 memcpy, or 2 if it wraps.
+	//   the timeout restarts whenever more bytes arrive, so it is an inter-byte timeout, as the byte-at-a-time version was.
+	//   in telnet mode, IAC IAC pairs mean the raw and data lengths differ, so bytes go through the telnet filter one at a time.
+	
+	if (serial_telnet_mode == true)
+	{
+		for (i = 0; i < the_len; i++)
+		{
+			the_byte = Serial_GetByte(the_timeout_ms);
+			
+			if (the_byte < 0)
+			{
+				break;
+			}
+			
+			the_buffer[i] = (uint8_t)the_byte;
+		}
+		
+		return i;
+	}
+	
+	start_tick = App_GetTicks();
+	last_available = Serial_BytesAvailable();
+	
+	while ((available = Serial_BytesAvailable()) < the_len)
+	{
+		if (available != last_available)
+		{
+			last_available = available;
+			start_tick = App_GetTicks();
+		}
+		else if ((uint16_t)(App_GetTicks() - start_tick) >= timeout_ticks)
+		{
+			// hand back what did arrive; caller will treat it as a short packet
+			the_len = available;
+			break;
+		}
+	}
+	
+	first_span = UART_BUFFER_SIZE - global_uart_read_idx;
+	
+	if (the_len < first_span)
+	{
+		memcpy(the_buffer, global_uart_in_buffer + global_uart_read_idx, the_len);
+		global_uart_read_idx += the_len;
+	}
+	else
+	{
+		memcpy(the_buffer, global_uart_in_buffer + global_uart_read_idx, first_span);
+		memcpy(the_buffer + first_span, global_uart_in_buffer, the_len - first_span);
+		global_uart_read_idx = the_len - first_span;
+	}
+	
+	Serial_ResumeRTS();
+	
+	return the_len;
+}
 
 
 // flush the in (Rx) buffer
@@ -1252,6 +2969,7 @@ void Serial_FlushInBuffer(void)
 {
 	global_uart_read_idx = 0;
 	global_uart_write_idx = 0;
+	Serial_ResumeRTS();
 }
 
 
@@ -1287,71 +3005,6 @@ void Serial_CycleForegroundColor(void)
 }
 
 
-// // start YMODEM file receive
-// bool Serial_StartYModemReceive(void)
-// {
-// 	int32_t		bytes_received;
-// //	uint8_t		temp_buffer[18000];
-// 	char		fname[92];
-// 	char*		the_filename = fname;
-// 	size_t		length = 18000;
-// 	uint32_t	i = 0;
-// 	FRESULT				the_result;
-// 	FIL					the_target_handle;
-// 	unsigned int		s_bytes_written_to_disk = 0;
-// 	char				temp_path_buffer[32];
-// 	
-// 	while (i < sizeof(fname)) { fname[i++] = '\0'; }
-// 	
-// 	sprintf(fname, "%s", "test.txt");
-// 	
-// 	bytes_received = fymodem_receive((uint8_t *)serial_ymodem_buffer, length, &the_filename);
-// 	sprintf(global_string_buff1, "ymodem done, bytes_received=%lu", bytes_received);
-// 	Buffer_NewMessage(global_string_buff1);
-// 	
-// 	if (bytes_received > 0)
-// 	{
-// 		General_CreateFilePathFromFolderAndFile(temp_path_buffer, "0:", the_filename, FILE_MAX_PATHNAME_SIZE);
-// 		Buffer_NewMessage(temp_path_buffer);
-// 	
-// 		// Get a target file handle for Writing
-// 		the_result = f_open(&the_target_handle, temp_path_buffer, FA_WRITE | FA_CREATE_ALWAYS);
-// 		
-// 		if (the_result != FR_OK)
-// 		{
-// 			//sprintf(global_string_buff1, "file '%s' could not be opened for copying into", the_target_file_path);
-// 			//Buffer_NewMessage(global_string_buff1);
-// 			return false;
-// 		}
-// 	
-// 		the_result = f_write(&the_target_handle, serial_ymodem_buffer, bytes_received, &s_bytes_written_to_disk);
-// 	
-// 		if (the_result != FR_OK)
-// 		{
-// 			//sprintf(global_string_buff1, "file '%s': got error writing", the_target_file_path);
-// 			//Buffer_NewMessage(global_string_buff1);
-// 			f_close(&the_target_handle);
-// 			return false;
-// 		}
-// 		
-// 		if ( s_bytes_written_to_disk < bytes_received )
-// 		{
-// 			// error or disk full
-// 			//sprintf(global_string_buff1, "%s %d: file '%s': tried to write %d, only wrote %d", __func__ , __LINE__, the_target_file_path, s_bytes_read_from_disk, s_bytes_written_to_disk);
-// 			//Buffer_NewMessage(global_string_buff1);
-// 			f_close(&the_target_handle);
-// 			return false;
-// 		}				
-// 		
-// 		f_close(&the_target_handle);
-// 			
-// 	}
-// 	
-// 	return bytes_received;
-// }
-
-
-
 // debug function - dump serial buffer to disk
 bool Serial_DebugDump(void)
 {
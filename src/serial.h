@@ -50,9 +50,18 @@
 
 #define NUM_ANSI_CODES			19
 
+#define SERIAL_ANSWERBACK_MAX_LEN	31		// longest answerback message (sent in reply to ENQ)
+
 //#define UART_BUFFER_SIZE		8192	// size of the circular buffer offloading serial data
 //#define UART_BUFFER_MASK		(UART_BUFFER_SIZE - 1)
 
+// receive flow control. the modem only honors RTS if hardware flow control is on (AT&K3 on most modems).
+#define UART_RTS_OFF_LEVEL		(UART_BUFFER_SIZE - 2048)	// interrupt handler drops RTS with this many bytes waiting. the rest is room for what arrives before the modem stops.
+#define UART_RTS_ON_LEVEL		2048	// RTS goes back on once readers have drained the buffer to this
+
+#define UART_TX_BUFFER_SIZE		2048	// send buffer, drained by the UART interrupt. holds a whole 1K YMODEM block.
+#define UART_TX_BUFFER_MASK		(UART_TX_BUFFER_SIZE - 1)
+
 // ANSI color codes
 #define ANSI_COLOR_BLACK			(uint8_t)0x00
 #define ANSI_COLOR_RED				(uint8_t)0x01
@@ -103,6 +112,17 @@ typedef enum ansi_action
 } ansi_action;
 
 
+typedef enum emulation_mode
+{
+	EMULATION_ANSI				= 0,	// ANSI-BBS with VT100 extras, 80 columns
+	EMULATION_PETSCII			,		// Commodore 64 PETSCII, 40 columns
+	EMULATION_ATASCII			,		// Atari 8-bit ATASCII, 40 columns
+	EMULATION_AVATAR			,		// ANSI-BBS plus AVT/0 (Avatar) codes, 80 columns
+	EMULATION_RIP				,		// ANSI-BBS plus RIPscrip vector graphics on the bitmap layer, 80 columns
+	EMULATION_MAX				,		// use as upper bound when cycling through emulations
+} emulation_mode;
+
+
 /*****************************************************************************/
 /*                                 Structs                                   */
 /*****************************************************************************/
@@ -112,6 +132,18 @@ typedef struct ANSIcode {
 	ansi_action		action_;
 } ANSIcode;
 
+typedef struct UnicodeGlyph {
+	uint16_t		code_point_;
+	uint8_t			glyph_;
+} UnicodeGlyph;
+
+typedef struct SerialErrorCounts {
+	uint16_t		overrun_;
+	uint16_t		parity_;
+	uint16_t		framing_;
+	uint16_t		break_;			// BREAKs received from the remote end
+} SerialErrorCounts;
+
 /*****************************************************************************/
 /*                             Global Variables                              */
 /*****************************************************************************/
@@ -125,6 +157,30 @@ typedef struct ANSIcode {
 // set up ANSI colors
 void Serial_InitANSIColors(void);
 
+// set the CP437 -> font glyph translation table used when printing incoming bytes
+// the_lut must point to 256 bytes, and must remain valid until replaced
+void Serial_SetGlyphLUT(const uint8_t* the_lut);
+
+// set the answerback message sent when the host sends ENQ. longer messages are truncated to SERIAL_ANSWERBACK_MAX_LEN.
+void Serial_SetAnswerback(const char* the_answerback);
+
+// the answerback message sent when the host sends ENQ
+const char* Serial_GetAnswerback(void);
+
+// turn the telnet layer on or off. turn on when connected through a WiFi modem to a telnet BBS.
+// returns the new state: true if telnet mode is now on
+bool Serial_ToggleTelnetMode(void);
+
+// turn UTF-8 decoding of incoming text on or off
+// returns the new state: true if UTF-8 decoding is now on
+bool Serial_ToggleUTF8Mode(void);
+
+// switch terminal emulation. clears the terminal area and homes the cursor.
+void Serial_SetEmulation(emulation_mode the_mode);
+
+// translate a key typed on the F256 into the byte the remote system expects for the current emulation
+uint8_t Serial_TranslateKey(uint8_t the_key);
+
 // set up UART for serial comms
 void Serial_InitUART(void);
 
@@ -132,22 +188,54 @@ void Serial_InitUART(void);
 // new_baud_rate_divisor must be UART_BAUD_DIV_4800, UART_BAUD_DIV_9600, etc.
 void Serial_SetBaud(uint16_t new_baud_rate_divisor);
 
+// change data bits, parity, and stop bits. leaves DLAB and BREAK as they are.
+// line_format is UART_DATA_BITS_x | UART_PARITY_x | UART_STOP_BITS_x. error counts restart, to judge the new format.
+void Serial_SetLineFormat(uint8_t line_format);
+
+// returns true if the line format has fewer than 8 data bits (7E1, etc.): the 8th bit of each byte doesn't get through
+bool Serial_IsSevenBit(void);
+
+// start (true) or stop (false) holding the transmit line in the BREAK state
+void Serial_SetBreak(bool break_on);
+
+// turn DTR on (true) or off (false). most modems hang up when DTR goes off (AT&D2, the usual default).
+void Serial_SetDTR(bool dtr_on);
+
 // send 1-255 bytes to the UART serial connection
 // returns # of bytes successfully sent (which may be less than number requested, in event of error, etc.)
 uint8_t Serial_SendData(uint8_t* the_buffer, uint16_t buffer_size);
 
 // send a byte over the UART serial connection
-// if the UART send buffer does not have space for the byte, it will try for UART_MAX_SEND_ATTEMPTS then return an error
+// if the send buffer is full, waits for the UART interrupt to make room
 // returns false on any error condition
 bool Serial_SendByte(uint8_t the_byte);
 
+// send a byte over the UART serial connection, without telnet IAC escaping. for telnet negotiation replies.
+// the byte is queued for the UART interrupt to send; this only waits if the send buffer is full.
+// returns false on any error condition
+bool Serial_SendRawByte(uint8_t the_byte);
+
 // Check for available data in the UART circular buffer and process any that are available.
 // returns false if no bytes were available
 bool Serial_ProcessAvailableData(void);
 
-// // get a single byte from UART serial connection
-// // returns -1 if no byte was received before specified timeout period passes
-// int16_t Serial_GetByte(int32_t the_timeout);
+// returns the number of received bytes waiting in the UART circular buffer
+uint16_t Serial_BytesAvailable(void);
+
+// returns true once after a ZMODEM sender's ZRQINIT header has arrived. what follows it is left in the receive buffer.
+bool Serial_CheckZModemStart(void);
+
+// wait until the UART interrupt has taken every queued byte from the send buffer
+// returns false if the UART stopped taking bytes and the rest were dropped
+bool Serial_WaitForTransmit(void);
+
+// get a single byte from UART serial connection. telnet commands are answered and skipped if telnet mode is on.
+// returns -1 if no byte was received before specified timeout period passes
+int16_t Serial_GetByte(uint32_t the_timeout_ms);
+
+// read the_len bytes from the UART into the_buffer, waiting for them to arrive
+// gives up if no new bytes arrive for the_timeout_ms. returns the number of bytes read, which is only less than the_len on a timeout.
+uint16_t Serial_ReadPacket(uint8_t* the_buffer, uint16_t the_len, uint32_t the_timeout_ms);
 
 // flush the in (Rx) buffer
 // resets circular buffer pointers so that any not-yet-processed bytes are forgotten about
@@ -162,8 +250,6 @@ void Serial_ANSICursorRestore(void);
 // cycle to the next foreground color, updating every cell in the terminal screen
 void Serial_CycleForegroundColor(void);
 
-// // start YMODEM file receive
-// bool Serial_StartYModemReceive(void);
 
 
 
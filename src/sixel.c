@@ -0,0 +1,425 @@
+/*
+ * sixel.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ *
+ *  - streaming Sixel decoder. serial.c hands us the body of each DCS string (ESC P ... ESC \) a byte at a time.
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "memory.h"
+#include "sixel.h"
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+// F256 includes
+#include "f256_e.h"
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define SIXEL_INTRODUCER			'q'		// final char of "ESC P p1;p2;p3 q" that marks a sixel image
+#define SIXEL_CHAR_FIRST			0x3F	// '?' = no pixels set
+#define SIXEL_CHAR_LAST				0x7E	// '~' = all 6 pixels set
+#define SIXEL_CMD_REPEAT			'!'		// !n<sixel>: draw <sixel> n times
+#define SIXEL_CMD_COLOR				'#'		// #n: select color register n. #n;u;x;y;z: define it (u=1 HLS, u=2 RGB)
+#define SIXEL_CMD_RASTER			'"'		// "pan;pad;ph;pv: raster attributes. ignored.
+#define SIXEL_CMD_CR				'$'		// back to left edge of current band
+#define SIXEL_CMD_NEWLINE			'-'		// left edge of next band, 6 pixels down
+#define SIXEL_BAND_HEIGHT			6
+
+#define SIXEL_COLOR_SPACE_HLS		1
+#define SIXEL_COLOR_SPACE_RGB		2
+
+#define SIXEL_BITMAP_CTRL_ENABLE	0x01	// BITMAP_L0_CTRL: layer on, using CLUT 0
+
+// parser states
+#define SIXEL_STATE_INTRO			0		// collecting DCS parameters, waiting for the final char
+#define SIXEL_STATE_DATA			1		// in sixel data
+#define SIXEL_STATE_IGNORE			2		// DCS string that isn't a sixel image
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+static Bitmap*			sixel_bitmap = NULL;		// only used to clear the layer
+static bool				sixel_layer_on = false;
+
+static uint8_t			sixel_state = SIXEL_STATE_IGNORE;
+static uint8_t			sixel_command;				// control char whose numeric parameters we are collecting, or 0
+static uint16_t			sixel_params[SIXEL_MAX_PARAMS];
+static uint8_t			sixel_param_count;
+
+static uint16_t			sixel_origin_x;				// left edge of the image, in bitmap pixels
+static uint16_t			sixel_x;					// next column to draw, in bitmap pixels
+static uint16_t			sixel_top_y;				// top edge of the image, in bitmap pixels
+static uint16_t			sixel_band_y;				// top row of the current band, in bitmap pixels
+static uint16_t			sixel_bottom_y;				// one past the lowest band drawn in so far
+static uint8_t			sixel_color;				// CLUT entry for the current color register
+
+// VT340 power-on colors for registers 0-15: R, G, B
+static const uint8_t	sixel_default_colors[16 * 3] =
+{
+	0x00, 0x00, 0x00,	0x33, 0x33, 0xCC,	0xCC, 0x24, 0x24,	0x33, 0xCC, 0x33,
+	0xCC, 0x33, 0xCC,	0x33, 0xCC, 0xCC,	0xCC, 0xCC, 0x33,	0x78, 0x78, 0x78,
+	0x45, 0x45, 0x45,	0x57, 0x57, 0x99,	0x99, 0x45, 0x45,	0x57, 0x99, 0x57,
+	0x99, 0x57, 0x99,	0x57, 0x99, 0x99,	0x99, 0x99, 0x57,	0xCC, 0xCC, 0xCC,
+};
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// turn on the bitmap layer and clear it, if not already on
+bool Sixel_ShowLayer(void);
+
+// set the CLUT entry for color register the_reg
+void Sixel_SetColorRegister(uint16_t the_reg, uint8_t r, uint8_t g, uint8_t b);
+
+// convert one DEC HLS channel to 0-255. p, q are in percent, t is the hue angle for this channel
+uint8_t Sixel_HLSChannel(int16_t p, int16_t q, int16_t t);
+
+// the numeric parameters for sixel_command are complete: act on them
+void Sixel_EndCommand(void);
+
+// draw one sixel (6 vertical pixels) the_count times, starting at sixel_x
+void Sixel_Draw(uint8_t the_sixel, uint16_t the_count);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+// turn on the bitmap layer and clear it, if not already on
+bool Sixel_ShowLayer(void)
+{
+	if (sixel_layer_on == true)
+	{
+		return true;
+	}
+
+	if (sixel_bitmap == NULL)
+	{
+		if ( (sixel_bitmap = Bitmap_New(SIXEL_BITMAP_WIDTH, SIXEL_BITMAP_HEIGHT, PARAM_USE_PASSED_VRAM, (uint8_t*)VRAM_START_ADDR)) == NULL)
+		{
+			return false;
+		}
+	}
+
+	Bitmap_FillMemory(sixel_bitmap, 0);
+
+	R8(BITMAP_L0_VRAM_ADDR_L) = (uint8_t)(VRAM_START_ADDR & 0xFF);
+	R8(BITMAP_L0_VRAM_ADDR_M) = (uint8_t)((VRAM_START_ADDR >> 8) & 0xFF);
+	R8(BITMAP_L0_VRAM_ADDR_H) = (uint8_t)((VRAM_START_ADDR >> 16) & 0xFF);
+	R8(BITMAP_L0_CTRL) = SIXEL_BITMAP_CTRL_ENABLE;
+
+	Sys_SetGraphicMode(PARAM_SPRITES_OFF, PARAM_BITMAP_ON, PARAM_TILES_OFF, PARAM_TEXT_OVERLAY_ON, PARAM_TEXT_ON);
+	sixel_layer_on = true;
+
+	return true;
+}
+
+
+// set the CLUT entry for color register the_reg
+void Sixel_SetColorRegister(uint16_t the_reg, uint8_t r, uint8_t g, uint8_t b)
+{
+	uint32_t	the_addr;
+
+	// VICKY CLUT entries are 4 bytes: B, G, R, A
+	the_addr = VICKY_CLUT0 + ((uint32_t)(SIXEL_FIRST_CLUT_ENTRY + (the_reg % SIXEL_NUM_COLOR_REGS)) << 2);
+
+	R8(the_addr + 0) = b;
+	R8(the_addr + 1) = g;
+	R8(the_addr + 2) = r;
+}
+
+
+// convert one DEC HLS channel to 0-255. p, q are in percent, t is the hue angle for this channel
+uint8_t Sixel_HLSChannel(int16_t p, int16_t q, int16_t t)
+{
+	int16_t		v;
+
+	if (t < 0)
+	{
+		t += 360;
+	}
+	else if (t >= 360)
+	{
+		t -= 360;
+	}
+
+	if (t < 60)
+	{
+		v = p + (int16_t)(((int32_t)(q - p) * t) / 60);
+	}
+	else if (t < 180)
+	{
+		v = q;
+	}
+	else if (t < 240)
+	{
+		v = p + (int16_t)(((int32_t)(q - p) * (240 - t)) / 60);
+	}
+	else
+	{
+		v = p;
+	}
+
+	return (uint8_t)(((int32_t)v * 255) / 100);
+}
+
+
+// the numeric parameters for sixel_command are complete: act on them
+void Sixel_EndCommand(void)
+{
+	int16_t		h;
+	int16_t		l;
+	int16_t		s;
+	int16_t		q;
+
+	if (sixel_command == SIXEL_CMD_COLOR)
+	{
+		if (sixel_param_count >= 5)
+		{
+			if (sixel_params[1] == SIXEL_COLOR_SPACE_RGB)
+			{
+				// RGB components are percentages
+				Sixel_SetColorRegister(sixel_params[0], (uint8_t)(((uint32_t)sixel_params[2] * 255) / 100), (uint8_t)(((uint32_t)sixel_params[3] * 255) / 100), (uint8_t)(((uint32_t)sixel_params[4] * 255) / 100));
+			}
+			else if (sixel_params[1] == SIXEL_COLOR_SPACE_HLS)
+			{
+				// DEC hue puts blue at 0 and red at 120: rotate to the usual red-at-0 before converting
+				h = (sixel_params[2] + 240) % 360;
+				l = sixel_params[3];
+				s = sixel_params[4];
+				q = (l < 50) ? (l * (100 + s)) / 100 : l + s - (l * s) / 100;
+				Sixel_SetColorRegister(sixel_params[0], Sixel_HLSChannel(2 * l - q, q, h + 120), Sixel_HLSChannel(2 * l - q, q, h), Sixel_HLSChannel(2 * l - q, q, h - 120));
+			}
+		}
+
+		sixel_color = SIXEL_FIRST_CLUT_ENTRY + (sixel_params[0] % SIXEL_NUM_COLOR_REGS);
+	}
+
+	// SIXEL_CMD_RASTER: we don't pre-fill the image area, so nothing to do
+	// SIXEL_CMD_REPEAT: handled when its sixel char arrives
+
+	sixel_command = 0;
+}
+
+
+// draw one sixel (6 vertical pixels) the_count times, starting at sixel_x
+void Sixel_Draw(uint8_t the_sixel, uint16_t the_count)
+{
+	uint8_t		bit;
+	uint16_t	y;
+	uint16_t	count;
+	uint16_t	i;
+	uint32_t	the_addr;
+
+	// LOGIC:
+	//   each sixel is a 6 pixel column; bit 0 is the top pixel. only set bits are drawn (background stays transparent).
+	//   a repeat is a horizontal run in each set row, which is contiguous in VRAM, so write it row by row.
+	//   anything falling outside the bitmap is dropped.
+
+	if (sixel_x >= SIXEL_BITMAP_WIDTH)
+	{
+		sixel_x += the_count;
+		return;
+	}
+
+	if (sixel_x + the_count > SIXEL_BITMAP_WIDTH)
+	{
+		count = SIXEL_BITMAP_WIDTH - sixel_x;
+	}
+	else
+	{
+		count = the_count;
+	}
+
+	for (bit = 0, y = sixel_band_y; bit < SIXEL_BAND_HEIGHT && y < SIXEL_BITMAP_HEIGHT; bit++, y++)
+	{
+		if ((the_sixel & (1 << bit)) == 0)
+		{
+			continue;
+		}
+
+		the_addr = VRAM_START_ADDR + (uint32_t)y * SIXEL_BITMAP_WIDTH + sixel_x;
+
+		for (i = 0; i < count; i++)
+		{
+			R8(the_addr + i) = sixel_color;
+		}
+	}
+
+	if (the_sixel != 0 && sixel_band_y + SIXEL_BAND_HEIGHT > sixel_bottom_y)
+	{
+		sixel_bottom_y = sixel_band_y + SIXEL_BAND_HEIGHT;
+	}
+
+	sixel_x += the_count;
+}
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+// start of a DCS string (ESC P). the_col and the_row are the text cursor position, relative to the terminal area: the image is drawn from there.
+void Sixel_Begin(uint8_t the_col, uint8_t the_row)
+{
+	sixel_state = SIXEL_STATE_INTRO;
+	sixel_command = 0;
+	sixel_param_count = 0;
+	sixel_params[0] = 0;
+	
+	sixel_origin_x = (uint16_t)the_col * SIXEL_PIXELS_PER_TEXT_COL;
+	sixel_x = sixel_origin_x;
+	sixel_top_y = (uint16_t)the_row * SIXEL_PIXELS_PER_TEXT_ROW;
+	sixel_band_y = sixel_top_y;
+	sixel_bottom_y = sixel_top_y;
+}
+
+
+// process one byte of a DCS string. draws each sixel as soon as it arrives.
+void Sixel_ProcessByte(uint8_t the_byte)
+{
+	uint8_t		i;
+	
+	if (sixel_state == SIXEL_STATE_IGNORE)
+	{
+		return;
+	}
+	
+	// numeric parameters, either for the DCS itself or for a sixel control char
+	if (the_byte >= CH_0 && the_byte <= CH_9)
+	{
+		if (sixel_param_count < SIXEL_MAX_PARAMS)
+		{
+			sixel_params[sixel_param_count] = sixel_params[sixel_param_count] * 10 + (the_byte - CH_0);
+		}
+		return;
+	}
+	
+	if (the_byte == CH_SEMIC)
+	{
+		if (++sixel_param_count < SIXEL_MAX_PARAMS)
+		{
+			sixel_params[sixel_param_count] = 0;
+		}
+		return;
+	}
+	
+	// any other char ends the parameter list
+	sixel_param_count++;
+	
+	if (sixel_state == SIXEL_STATE_INTRO)
+	{
+		if (the_byte != SIXEL_INTRODUCER)
+		{
+			// some other DCS string (DECRQSS etc): nothing we handle
+			sixel_state = SIXEL_STATE_IGNORE;
+			return;
+		}
+		
+		if (Sixel_ShowLayer() == false)
+		{
+			sixel_state = SIXEL_STATE_IGNORE;
+			return;
+		}
+		
+		for (i = 0; i < 16; i++)
+		{
+			Sixel_SetColorRegister(i, sixel_default_colors[i * 3], sixel_default_colors[i * 3 + 1], sixel_default_colors[i * 3 + 2]);
+		}
+		
+		sixel_color = SIXEL_FIRST_CLUT_ENTRY;
+		sixel_state = SIXEL_STATE_DATA;
+		sixel_param_count = 0;
+		sixel_params[0] = 0;
+		return;
+	}
+	
+	if (sixel_command != 0 && sixel_command != SIXEL_CMD_REPEAT)
+	{
+		Sixel_EndCommand();
+	}
+	
+	if (the_byte >= SIXEL_CHAR_FIRST && the_byte <= SIXEL_CHAR_LAST)
+	{
+		if (sixel_command == SIXEL_CMD_REPEAT)
+		{
+			Sixel_Draw(the_byte - SIXEL_CHAR_FIRST, (sixel_params[0] == 0) ? 1 : sixel_params[0]);
+			sixel_command = 0;
+		}
+		else
+		{
+			Sixel_Draw(the_byte - SIXEL_CHAR_FIRST, 1);
+		}
+	}
+	else if (the_byte == SIXEL_CMD_CR)
+	{
+		sixel_x = sixel_origin_x;
+	}
+	else if (the_byte == SIXEL_CMD_NEWLINE)
+	{
+		sixel_x = sixel_origin_x;
+		sixel_band_y += SIXEL_BAND_HEIGHT;
+	}
+	else if (the_byte == SIXEL_CMD_REPEAT || the_byte == SIXEL_CMD_COLOR || the_byte == SIXEL_CMD_RASTER)
+	{
+		sixel_command = the_byte;
+	}
+	
+	// start collecting parameters afresh for whatever comes next
+	sixel_param_count = 0;
+	sixel_params[0] = 0;
+}
+
+
+// end of the DCS string (ST).
+// returns the number of text rows the image covered, so the caller can move the text cursor below it. returns 0 if the DCS string was not a sixel image.
+uint8_t Sixel_End(void)
+{
+	uint8_t		the_state;
+	
+	the_state = sixel_state;
+	sixel_state = SIXEL_STATE_IGNORE;
+	
+	if (the_state != SIXEL_STATE_DATA)
+	{
+		return 0;
+	}
+	
+	// round the image height up to whole text rows
+	return (uint8_t)((sixel_bottom_y - sixel_top_y + SIXEL_PIXELS_PER_TEXT_ROW - 1) / SIXEL_PIXELS_PER_TEXT_ROW);
+}
+
+
+// turn the bitmap layer back off, if a sixel image turned it on. call when the terminal screen is cleared.
+void Sixel_Hide(void)
+{
+	if (sixel_layer_on == true)
+	{
+		Sys_SetModeText(false);
+		sixel_layer_on = false;
+	}
+}
@@ -0,0 +1,93 @@
+//! @file sixel.h
+
+/*
+ * sixel.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ */
+
+#ifndef SIXEL_H_
+#define SIXEL_H_
+
+
+/* about this class: Sixel
+ *
+ * This provides a streaming Sixel image decoder that draws straight into the VICKY bitmap layer, under the text overlay
+ *
+ *** things this class needs to be able to do
+ * turn the bitmap layer on when an image arrives, and off again when the screen is cleared
+ * accept one byte at a time of a DCS string, and plot each sixel as soon as it arrives
+ * map sixel color registers onto a reserved range of graphics CLUT 0
+ *
+ *** things objects of this class have
+ * parser state for the current DCS string: current color, position, pending numeric parameters
+ * no image buffer: memory use does not depend on image size
+ *
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+
+// Platform includes
+#include "f256_e.h"
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+#define SIXEL_BITMAP_WIDTH			320
+#define SIXEL_BITMAP_HEIGHT			240
+#define SIXEL_PIXELS_PER_TEXT_COL	4		// 80 text columns over 320 pixels
+#define SIXEL_PIXELS_PER_TEXT_ROW	8		// 30 text rows over 240 pixels
+
+#define SIXEL_FIRST_CLUT_ENTRY		16		// CLUT 0 entries 0-15 are used by RIPscrip; sixel color registers start after them
+#define SIXEL_NUM_COLOR_REGS		240		// registers 0-239 map to CLUT 0 entries 16-255. higher register numbers wrap around.
+#define SIXEL_MAX_PARAMS			5		// most numeric parameters of any sixel control (# color definition)
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// start of a DCS string (ESC P). the_col and the_row are the text cursor position, relative to the terminal area: the image is drawn from there.
+void Sixel_Begin(uint8_t the_col, uint8_t the_row);
+
+// process one byte of a DCS string. draws each sixel as soon as it arrives.
+void Sixel_ProcessByte(uint8_t the_byte);
+
+// end of the DCS string (ST).
+// returns the number of text rows the image covered, so the caller can move the text cursor below it. returns 0 if the DCS string was not a sixel image.
+uint8_t Sixel_End(void);
+
+// turn the bitmap layer back off, if a sixel image turned it on. call when the terminal screen is cleared.
+void Sixel_Hide(void);
+
+
+#endif /* SIXEL_H_ */
@@ -103,6 +103,74 @@ static char* strings[NUM_STRINGS]= {
      (char*)"F256K",
      (char*)"F256K2",
      (char*)"<unknown hardware>",
+     (char*)"UTF-8 decoding on. Unicode text will be shown with the nearest CP437 glyph.",
+     (char*)"UTF-8 decoding off. Incoming bytes shown as-is.",
+     (char*)"Emulation: ANSI-BBS (80 columns)",
+     (char*)"Emulation: PETSCII (40 columns)",
+     (char*)"Emulation: ATASCII (40 columns)",
+     (char*)"Emulation: ANSI-BBS + AVT/0 (80 columns)",
+     (char*)"Emulation: ANSI-BBS + RIPscrip graphics (80 columns)",
+     (char*)"Telnet mode on. Telnet commands from the host are answered and hidden.",
+     (char*)"Telnet mode off. Incoming bytes passed through as-is.",
+     (char*)"Offline",
+     (char*)"Online",
+     (char*)"Ringing",
+     (char*)"No carrier",
+     (char*)"Modem error",
+     (char*)"No dialtone",
+     (char*)"Busy",
+     (char*)"No answer",
+     (char*)"Baud rate will follow the rate in the modem's CONNECT message.",
+     (char*)"Baud rate will not change on CONNECT.",
+     (char*)"Detecting modem baud rate... (any key stops)",
+     (char*)"Modem answered OK after %u.%u seconds",
+     (char*)"No answer from modem. Baud rate unchanged.",
+     (char*)"Can't detect baud rate while online",
+     (char*)"Baud rate detection stopped. Baud rate unchanged.",
+     (char*)"8N1",
+     (char*)"7E1",
+     (char*)"7O1",
+     (char*)"8E1",
+     (char*)"8O1",
+     (char*)"8N2",
+     (char*)"Line format set to %s",
+     (char*)"BREAK sent",
+     (char*)"Serial errors: parity %u, framing %u, overrun %u, break %u",
+     (char*)"CD",
+     (char*)"Hanging up (dropping DTR)...",
+     (char*)"Starting YMODEM download. Start the upload on the BBS.",
+     (char*)"Receiving %s (%lu bytes)",
+     (char*)"Download complete: %u file(s), %lu bytes",
+     (char*)"Download failed or cancelled",
+     (char*)"Transfer trace written to trace.txt",
+     (char*)"Starting YMODEM-G download. Start the upload on the BBS.",
+     (char*)"Starting ZMODEM download. Start the upload on the BBS.",
+     (char*)"Resuming %s at %lu of %lu bytes",
+     (char*)"Skipping %s: already downloaded",
+     (char*)"ZMODEM download started by the BBS.",
+     (char*)"Upload Files",
+     (char*)"File name(s) on SD card, space between:",
+     (char*)"Starting YMODEM upload. Start the download on the BBS.",
+     (char*)"Starting XMODEM-1K upload. Start the download on the BBS.",
+     (char*)"Sending %s (%lu bytes)",
+     (char*)"Skipping %s: could not open it",
+     (char*)"Upload complete: %u file(s), %lu bytes",
+     (char*)"Upload failed or cancelled",
+     (char*)"Starting Kermit download. Start the upload on the BBS.",
+     (char*)"Starting Kermit upload. Start the download on the BBS.",
+     (char*)"Kermit: %s",
+     (char*)"Kermit: host says %s",
+     (char*)"%s/%s %u%%",
+     (char*)"%s",
+     (char*)" %ucps",
+     (char*)" %lu:%02u",
+     (char*)" E%u R%u",
+     (char*)"Answerback",
+     (char*)"Sent when the host asks who we are:",
+     (char*)"Answerback message set",
+     (char*)"Transfer cancelled (ESC)",
+     (char*)"Checking the copy of %s already on the SD card",
+     (char*)"Replacing the copy of %s on the SD card (%lu bytes)",
 };
 
 
@@ -116,8 +116,76 @@
 #define ID_STR_MACHINE_K 70
 #define ID_STR_MACHINE_K2 71
 #define ID_STR_MACHINE_UNKNOWN 72
-#define NUM_STRINGS 73
-#define TOTAL_STRING_BYTES 1809
+#define ID_STR_MSG_UTF8_ON 73
+#define ID_STR_MSG_UTF8_OFF 74
+#define ID_STR_MSG_EMULATION_ANSI 75
+#define ID_STR_MSG_EMULATION_PETSCII 76
+#define ID_STR_MSG_EMULATION_ATASCII 77
+#define ID_STR_MSG_EMULATION_AVATAR 78
+#define ID_STR_MSG_EMULATION_RIP 79
+#define ID_STR_MSG_TELNET_ON 80
+#define ID_STR_MSG_TELNET_OFF 81
+#define ID_STR_CONN_OFFLINE 82
+#define ID_STR_CONN_ONLINE 83
+#define ID_STR_CONN_RING 84
+#define ID_STR_CONN_NO_CARRIER 85
+#define ID_STR_CONN_ERROR 86
+#define ID_STR_CONN_NO_DIALTONE 87
+#define ID_STR_CONN_BUSY 88
+#define ID_STR_CONN_NO_ANSWER 89
+#define ID_STR_MSG_CONNECT_BAUD_ON 90
+#define ID_STR_MSG_CONNECT_BAUD_OFF 91
+#define ID_STR_MSG_AUTOBAUD_START 92
+#define ID_STR_MSG_AUTOBAUD_FOUND 93
+#define ID_STR_MSG_AUTOBAUD_FAILED 94
+#define ID_STR_MSG_AUTOBAUD_ONLINE 95
+#define ID_STR_MSG_AUTOBAUD_STOPPED 96
+#define ID_STR_LINE_FORMAT_8N1 97
+#define ID_STR_LINE_FORMAT_7E1 98
+#define ID_STR_LINE_FORMAT_7O1 99
+#define ID_STR_LINE_FORMAT_8E1 100
+#define ID_STR_LINE_FORMAT_8O1 101
+#define ID_STR_LINE_FORMAT_8N2 102
+#define ID_STR_MSG_SET_LINE_FORMAT 103
+#define ID_STR_MSG_SENT_BREAK 104
+#define ID_STR_MSG_SERIAL_ERRORS 105
+#define ID_STR_LBL_CARRIER 106
+#define ID_STR_MSG_HANG_UP 107
+#define ID_STR_MSG_TRANSFER_YMODEM_START 108
+#define ID_STR_MSG_TRANSFER_RECEIVING 109
+#define ID_STR_MSG_TRANSFER_DONE 110
+#define ID_STR_MSG_TRANSFER_FAILED 111
+#define ID_STR_MSG_TRACE_DUMP 112
+#define ID_STR_MSG_TRANSFER_YMODEM_G_START 113
+#define ID_STR_MSG_TRANSFER_ZMODEM_START 114
+#define ID_STR_MSG_TRANSFER_RESUMING 115
+#define ID_STR_MSG_TRANSFER_SKIPPING 116
+#define ID_STR_MSG_TRANSFER_ZMODEM_AUTO 117
+#define ID_STR_DLG_UPLOAD_TITLE 118
+#define ID_STR_DLG_UPLOAD_BODY 119
+#define ID_STR_MSG_TRANSFER_YMODEM_SEND_START 120
+#define ID_STR_MSG_TRANSFER_XMODEM_SEND_START 121
+#define ID_STR_MSG_TRANSFER_SENDING 122
+#define ID_STR_MSG_TRANSFER_CANT_OPEN 123
+#define ID_STR_MSG_TRANSFER_UPLOAD_DONE 124
+#define ID_STR_MSG_TRANSFER_UPLOAD_FAILED 125
+#define ID_STR_MSG_TRANSFER_KERMIT_START 126
+#define ID_STR_MSG_TRANSFER_KERMIT_SEND_START 127
+#define ID_STR_MSG_KERMIT_ERROR 128
+#define ID_STR_MSG_KERMIT_REMOTE_ERROR 129
+#define ID_STR_MSG_PROGRESS_SIZE 130
+#define ID_STR_MSG_PROGRESS_BYTES 131
+#define ID_STR_MSG_PROGRESS_RATE 132
+#define ID_STR_MSG_PROGRESS_TIME_LEFT 133
+#define ID_STR_MSG_PROGRESS_ERRORS 134
+#define ID_STR_DLG_ANSWERBACK_TITLE 135
+#define ID_STR_DLG_ANSWERBACK_BODY 136
+#define ID_STR_MSG_ANSWERBACK_SET 137
+#define ID_STR_MSG_TRANSFER_CANCELLED 138
+#define ID_STR_MSG_TRANSFER_CHECKING 139
+#define ID_STR_MSG_TRANSFER_REPLACING 140
+#define NUM_STRINGS 141
+#define TOTAL_STRING_BYTES 3911
 
 
 /*****************************************************************************/
@@ -0,0 +1,336 @@
+/*
+ * telnet.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ *
+ *  - telnet IAC filter. serial.c passes each received byte through here first when telnet mode is on.
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "app.h"
+#include "screen.h"
+#include "serial.h"
+#include "telnet.h"
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+
+// F256 includes
+#include "f256_e.h"
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+// parser states
+#define TELNET_STATE_DATA		0		// normal data
+#define TELNET_STATE_IAC		1		// got IAC
+#define TELNET_STATE_OPTION		2		// got IAC + WILL/WONT/DO/DONT: next byte is the option
+#define TELNET_STATE_SB_OPTION	3		// got IAC SB: next byte is the option
+#define TELNET_STATE_SB_DATA	4		// collecting subnegotiation data
+#define TELNET_STATE_SB_IAC		5		// got IAC inside subnegotiation data
+
+// one bit per option we will negotiate, for telnet_local_opts and telnet_remote_opts
+#define TELNET_BIT_BINARY		0b00000001
+#define TELNET_BIT_ECHO			0b00000010
+#define TELNET_BIT_SGA			0b00000100
+#define TELNET_BIT_TTYPE		0b00001000
+#define TELNET_BIT_NAWS			0b00010000
+
+#define TELNET_LOCAL_SUPPORTED	(TELNET_BIT_BINARY | TELNET_BIT_SGA | TELNET_BIT_TTYPE | TELNET_BIT_NAWS)	// options we will do (host sends DO)
+#define TELNET_REMOTE_SUPPORTED	(TELNET_BIT_BINARY | TELNET_BIT_ECHO | TELNET_BIT_SGA)	// options we let the host do (host sends WILL)
+
+#define CH_NUL					0x00
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+static uint8_t			telnet_state = TELNET_STATE_DATA;
+static uint8_t			telnet_verb;			// WILL/WONT/DO/DONT waiting for its option
+static uint8_t			telnet_sb_option;		// option of the subnegotiation being collected
+static uint8_t			telnet_sb_data[TELNET_SB_MAX_LEN];
+static uint8_t			telnet_sb_len;
+static uint8_t			telnet_local_opts = 0;	// TELNET_BIT_xxx: options on for our side
+static uint8_t			telnet_remote_opts = 0;	// TELNET_BIT_xxx: options on for the host side
+static bool				telnet_last_was_cr = false;	// telnet sends a bare CR as CR NUL outside binary mode
+
+// replies that never change. preformatted so they can go straight to the UART
+static const uint8_t	telnet_naws_reply[] =
+{
+	TELNET_IAC, TELNET_SB, TELNET_OPT_NAWS, 0, TERM_BODY_WIDTH, 0, TERM_BODY_HEIGHT, TELNET_IAC, TELNET_SE,
+};
+
+static const uint8_t	telnet_ttype_reply[] =
+{
+	TELNET_IAC, TELNET_SB, TELNET_OPT_TTYPE, TELNET_TTYPE_IS, 'A', 'N', 'S', 'I', TELNET_IAC, TELNET_SE,
+};
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// send the_len bytes as-is (no IAC doubling)
+void Telnet_Send(const uint8_t* the_buffer, uint8_t the_len);
+
+// send IAC the_verb the_option
+void Telnet_SendCommand(uint8_t the_verb, uint8_t the_option);
+
+// TELNET_BIT_xxx for the_option, or 0 if it is not one we negotiate
+uint8_t Telnet_OptionBit(uint8_t the_option);
+
+// host sent IAC telnet_verb the_option: agree, refuse, or ignore if nothing changes
+void Telnet_HandleOption(uint8_t the_option);
+
+// host finished a subnegotiation (IAC SE)
+void Telnet_HandleSubnegotiation(void);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+// send the_len bytes as-is (no IAC doubling)
+void Telnet_Send(const uint8_t* the_buffer, uint8_t the_len)
+{
+	while (the_len > 0)
+	{
+		Serial_SendRawByte(*the_buffer++);
+		the_len--;
+	}
+}
+
+
+// send IAC the_verb the_option
+void Telnet_SendCommand(uint8_t the_verb, uint8_t the_option)
+{
+	uint8_t		the_command[3];
+
+	the_command[0] = TELNET_IAC;
+	the_command[1] = the_verb;
+	the_command[2] = the_option;
+
+	Telnet_Send(the_command, 3);
+}
+
+
+// TELNET_BIT_xxx for the_option, or 0 if it is not one we negotiate
+uint8_t Telnet_OptionBit(uint8_t the_option)
+{
+	switch (the_option)
+	{
+		case TELNET_OPT_BINARY:
+			return TELNET_BIT_BINARY;
+
+		case TELNET_OPT_ECHO:
+			return TELNET_BIT_ECHO;
+
+		case TELNET_OPT_SGA:
+			return TELNET_BIT_SGA;
+
+		case TELNET_OPT_TTYPE:
+			return TELNET_BIT_TTYPE;
+
+		case TELNET_OPT_NAWS:
+			return TELNET_BIT_NAWS;
+
+		default:
+			return 0;
+	}
+}
+
+
+// host sent IAC telnet_verb the_option: agree, refuse, or ignore if nothing changes
+void Telnet_HandleOption(uint8_t the_option)
+{
+	uint8_t		the_bit;
+
+	// LOGIC:
+	//   only answer when an option actually changes state (or to refuse one we don't support).
+	//   answering a request that changes nothing is how two telnet ends get into a negotiation loop.
+
+	the_bit = Telnet_OptionBit(the_option);
+
+	switch (telnet_verb)
+	{
+		case TELNET_DO:
+			if ((the_bit & TELNET_LOCAL_SUPPORTED) == 0)
+			{
+				Telnet_SendCommand(TELNET_WONT, the_option);
+			}
+			else if ((telnet_local_opts & the_bit) == 0)
+			{
+				telnet_local_opts |= the_bit;
+				Telnet_SendCommand(TELNET_WILL, the_option);
+
+				if (the_option == TELNET_OPT_NAWS)
+				{
+					Telnet_Send(telnet_naws_reply, sizeof(telnet_naws_reply));
+				}
+			}
+			break;
+
+		case TELNET_DONT:
+			if ((telnet_local_opts & the_bit) != 0)
+			{
+				telnet_local_opts &= ~the_bit;
+				Telnet_SendCommand(TELNET_WONT, the_option);
+			}
+			break;
+
+		case TELNET_WILL:
+			if ((the_bit & TELNET_REMOTE_SUPPORTED) == 0)
+			{
+				Telnet_SendCommand(TELNET_DONT, the_option);
+			}
+			else if ((telnet_remote_opts & the_bit) == 0)
+			{
+				telnet_remote_opts |= the_bit;
+				Telnet_SendCommand(TELNET_DO, the_option);
+			}
+			break;
+
+		case TELNET_WONT:
+			if ((telnet_remote_opts & the_bit) != 0)
+			{
+				telnet_remote_opts &= ~the_bit;
+				Telnet_SendCommand(TELNET_DONT, the_option);
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+
+// host finished a subnegotiation (IAC SE)
+void Telnet_HandleSubnegotiation(void)
+{
+	if (telnet_sb_option == TELNET_OPT_TTYPE && telnet_sb_len > 0 && telnet_sb_data[0] == TELNET_TTYPE_SEND)
+	{
+		Telnet_Send(telnet_ttype_reply, sizeof(telnet_ttype_reply));
+	}
+}
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+// forget any partial IAC sequence and negotiated options. call when telnet mode is turned on.
+void Telnet_Reset(void)
+{
+	telnet_state = TELNET_STATE_DATA;
+	telnet_local_opts = 0;
+	telnet_remote_opts = 0;
+	telnet_last_was_cr = false;
+}
+
+
+// process one byte received from the UART. answers any negotiation it completes.
+// returns true if the byte is data that should go on to the emulation, false if it was part of a telnet command
+bool Telnet_ProcessByte(uint8_t the_byte)
+{
+	switch (telnet_state)
+	{
+		case TELNET_STATE_DATA:
+			if (the_byte == TELNET_IAC)
+			{
+				telnet_state = TELNET_STATE_IAC;
+				return false;
+			}
+
+			if (the_byte == CH_NUL && telnet_last_was_cr == true && (telnet_remote_opts & TELNET_BIT_BINARY) == 0)
+			{
+				telnet_last_was_cr = false;
+				return false;
+			}
+
+			telnet_last_was_cr = (the_byte == CH_ENTER);
+			return true;
+
+		case TELNET_STATE_IAC:
+			telnet_state = TELNET_STATE_DATA;
+
+			if (the_byte == TELNET_IAC)
+			{
+				// escaped 0xFF data byte
+				telnet_last_was_cr = false;
+				return true;
+			}
+
+			if (the_byte == TELNET_WILL || the_byte == TELNET_WONT || the_byte == TELNET_DO || the_byte == TELNET_DONT)
+			{
+				telnet_verb = the_byte;
+				telnet_state = TELNET_STATE_OPTION;
+			}
+			else if (the_byte == TELNET_SB)
+			{
+				telnet_state = TELNET_STATE_SB_OPTION;
+			}
+
+			// any other command (NOP, GA, AYT, etc.) has no option byte and needs nothing from us
+			return false;
+
+		case TELNET_STATE_OPTION:
+			telnet_state = TELNET_STATE_DATA;
+			Telnet_HandleOption(the_byte);
+			return false;
+
+		case TELNET_STATE_SB_OPTION:
+			telnet_sb_option = the_byte;
+			telnet_sb_len = 0;
+			telnet_state = TELNET_STATE_SB_DATA;
+			return false;
+
+		case TELNET_STATE_SB_DATA:
+			if (the_byte == TELNET_IAC)
+			{
+				telnet_state = TELNET_STATE_SB_IAC;
+			}
+			else if (telnet_sb_len < TELNET_SB_MAX_LEN)
+			{
+				telnet_sb_data[telnet_sb_len++] = the_byte;
+			}
+			return false;
+
+		case TELNET_STATE_SB_IAC:
+			if (the_byte == TELNET_SE)
+			{
+				telnet_state = TELNET_STATE_DATA;
+				Telnet_HandleSubnegotiation();
+			}
+			else
+			{
+				// IAC IAC inside a subnegotiation is a literal 0xFF
+				telnet_state = TELNET_STATE_SB_DATA;
+
+				if (the_byte == TELNET_IAC && telnet_sb_len < TELNET_SB_MAX_LEN)
+				{
+					telnet_sb_data[telnet_sb_len++] = the_byte;
+				}
+			}
+			return false;
+
+		default:
+			telnet_state = TELNET_STATE_DATA;
+			return true;
+	}
+}
@@ -0,0 +1,98 @@
+//! @file telnet.h
+
+/*
+ * telnet.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ */
+
+#ifndef TELNET_H_
+#define TELNET_H_
+
+
+/* about this class: Telnet
+ *
+ * This strips and answers telnet IAC sequences that WiFi modems in transparent mode pass through from telnet BBSes
+ *
+ *** things this class needs to be able to do
+ * sit between the UART receive buffer and the emulation parsers, passing through only data bytes
+ * answer option negotiation: agree to BINARY, SGA, TTYPE, and NAWS on our side, and BINARY, ECHO, and SGA on the host side; refuse everything else
+ * report the terminal size (NAWS) and type (TTYPE) when asked
+ *
+ *** things objects of this class have
+ * parser state for the IAC sequence being received
+ * which options are currently on, for each side
+ *
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+
+// Platform includes
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+// telnet commands (RFC 854)
+#define TELNET_IAC				0xFF	// Interpret As Command. IAC IAC is a literal 0xFF data byte
+#define TELNET_DONT				0xFE
+#define TELNET_DO				0xFD
+#define TELNET_WONT				0xFC
+#define TELNET_WILL				0xFB
+#define TELNET_SB				0xFA	// subnegotiation begin
+#define TELNET_SE				0xF0	// subnegotiation end
+
+// telnet options
+#define TELNET_OPT_BINARY		0		// RFC 856
+#define TELNET_OPT_ECHO			1		// RFC 857
+#define TELNET_OPT_SGA			3		// RFC 858: suppress go ahead
+#define TELNET_OPT_TTYPE		24		// RFC 1091: terminal type
+#define TELNET_OPT_NAWS			31		// RFC 1073: negotiate about window size
+
+#define TELNET_TTYPE_IS			0
+#define TELNET_TTYPE_SEND		1
+
+#define TELNET_SB_MAX_LEN		8		// subnegotiation bytes kept. we only need the first one (TTYPE SEND).
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// forget any partial IAC sequence and negotiated options. call when telnet mode is turned on.
+void Telnet_Reset(void);
+
+// process one byte received from the UART. answers any negotiation it completes.
+// returns true if the byte is data that should go on to the emulation, false if it was part of a telnet command
+bool Telnet_ProcessByte(uint8_t the_byte);
+
+
+#endif /* TELNET_H_ */
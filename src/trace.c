@@ -0,0 +1,164 @@
+/*
+ * trace.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ *
+ *  - binary event ring for file transfers. formatting only happens when the ring is dumped, after the transfer.
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "trace.h"
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// F256 includes
+#include "f256_e.h"
+
+#include "ff.h"
+
+
+#ifdef TRANSFER_TRACE
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define TRACE_DUMP_FILE_PATH		"0:trace.txt"
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+static TraceEntry			trace_ring[TRACE_RING_SIZE];
+static uint8_t				trace_write_idx = 0;
+static bool					trace_wrapped = false;		// true once the ring has filled and old entries are being overwritten
+
+static const char*			trace_event_name[TRACE_NUM_EVENTS] = 
+{
+	"none",
+	"ym start",
+	"ym timeout",
+	"ym packet",
+	"ym short packet",
+	"ym seq error",
+	"ym crc error",
+	"ym wrong seq",
+	"ym duplicate",
+	"ym rx error",
+	"ym eot",
+	"ym file done",
+	"ym can",
+	"ym sender abort",
+	"ym start char",
+	"ym abort char",
+	"ym bad start",
+	"ym tx start",
+	"ym tx file",
+	"ym tx resend",
+	"ym tx abort",
+	"zm header",
+	"zm data error",
+	"km init",
+	"km packet",
+	"km bad packet",
+	"km nak",
+	"km resend",
+};
+
+extern char*				global_string_buff1;
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+// forget all recorded events
+void Trace_Reset(void)
+{
+	trace_write_idx = 0;
+	trace_wrapped = false;
+}
+
+
+// record one event, overwriting the oldest if the ring is full. use through the TRACE() macro.
+void Trace_Add(uint8_t the_event, uint8_t the_arg8, uint16_t the_arg16)
+{
+	TraceEntry*		the_entry = &trace_ring[trace_write_idx];
+	
+	the_entry->event_ = the_event;
+	the_entry->arg8_ = the_arg8;
+	the_entry->arg16_ = the_arg16;
+	
+	if (++trace_write_idx == 0)
+	{
+		trace_wrapped = true;
+	}
+}
+
+
+// write recorded events, oldest first, to a text file on the SD card
+// returns false on any disk error
+bool Trace_DumpToDisk(void)
+{
+	FIL				the_file;
+	UINT			bytes_written;
+	uint8_t			the_idx;
+	uint16_t		the_count;
+	uint16_t		i;
+	int				the_len;
+	TraceEntry*		the_entry;
+	
+	if (f_open(&the_file, TRACE_DUMP_FILE_PATH, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+	{
+		return false;
+	}
+	
+	the_idx = (trace_wrapped == true) ? trace_write_idx : 0;
+	the_count = (trace_wrapped == true) ? TRACE_RING_SIZE : trace_write_idx;
+	
+	for (i = 0; i < the_count; i++)
+	{
+		the_entry = &trace_ring[the_idx++];
+		
+		the_len = sprintf(global_string_buff1, "%3u %-16s %3u %5u\n", i, (the_entry->event_ < TRACE_NUM_EVENTS) ? trace_event_name[the_entry->event_] : "?", the_entry->arg8_, the_entry->arg16_);
+		
+		if (f_write(&the_file, global_string_buff1, the_len, &bytes_written) != FR_OK)
+		{
+			f_close(&the_file);
+			return false;
+		}
+	}
+	
+	return (f_close(&the_file) == FR_OK);
+}
+
+
+#endif /* TRANSFER_TRACE */
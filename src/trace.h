@@ -0,0 +1,128 @@
+//! @file trace.h
+
+/*
+ * trace.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+
+/* about this class: Trace
+ *
+ * This records what a file transfer protocol did, cheaply enough to leave in the transfer's inner loop
+ *
+ *** things this class needs to be able to do
+ * record an event as an ID plus 2 numbers, with no string formatting
+ * keep only the most recent events, in a fixed-size ring
+ * write the recorded events to disk as text once the transfer is over
+ * compile to nothing unless TRANSFER_TRACE is defined (see Makefile)
+ *
+ *** things objects of this class have
+ * the ring of events, and where the next one goes
+ *
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+
+// Platform includes
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+#define TRACE_RING_SIZE			256		// entries kept. 256 so a uint8_t index rolls over by itself.
+
+// use as TRACE((TRACE_YM_PACKET, seq, size)); double parentheses, like DEBUG_OUT() in debug.h
+#ifdef TRANSFER_TRACE
+	#define TRACE(x)			Trace_Add x
+	#define TRACE_RESET()		Trace_Reset()
+#else
+	#define TRACE(x)
+	#define TRACE_RESET()
+#endif
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+typedef enum trace_event
+{
+	TRACE_NONE					= 0,
+	TRACE_YM_START				,	// receive started
+	TRACE_YM_TIMEOUT			,	// nothing arrived where a block should start
+	TRACE_YM_PACKET				,	// good block. arg8: seq, arg16: size
+	TRACE_YM_SHORT_PACKET		,	// block stopped arriving partway. arg16: bytes received
+	TRACE_YM_SEQ_ERROR			,	// seq and its complement disagree. arg8: seq, arg16: complement
+	TRACE_YM_CRC_ERROR			,	// arg8: seq, arg16: CRC remainder
+	TRACE_YM_WRONG_SEQ			,	// block out of order. arg8: seq, arg16: blocks received so far
+	TRACE_YM_DUPLICATE			,	// sender repeated the last block. arg8: seq, arg16: blocks received so far
+	TRACE_YM_RX_ERROR			,	// bad block NAKed. arg8: ym_rx_packet() result, arg16: errors in a row
+	TRACE_YM_EOT				,	// end of file
+	TRACE_YM_FILE_DONE			,	// file closed. arg16: blocks received
+	TRACE_YM_CAN				,	// sender cancelled (CAN CAN)
+	TRACE_YM_SENDER_ABORT		,	// transfer ended because the sender cancelled
+	TRACE_YM_START_CHAR			,	// 'C' where a block should start. arg8: the byte
+	TRACE_YM_ABORT_CHAR			,	// 'A' or 'a' where a block should start. arg8: the byte
+	TRACE_YM_BAD_START			,	// unexpected byte where a block should start. arg8: the byte
+	TRACE_YM_TX_START			,	// send started. arg8: 1 for XMODEM-1K
+	TRACE_YM_TX_FILE			,	// next file to send. arg16: low 16 bits of its size
+	TRACE_YM_TX_RESEND			,	// block not ACKed, sent again. arg8: seq, arg16: what came back instead (0xFFFF: nothing)
+	TRACE_YM_TX_ABORT			,	// send ended early. arg16: low 16 bits of bytes sent
+	TRACE_ZM_HEADER				,	// header (or error) received. arg8: type, arg16: low 16 bits of file position
+	TRACE_ZM_DATA_ERROR			,	// bad data subpacket, ZRPOS sent. arg8: error, arg16: low 16 bits of file position
+	TRACE_KM_INIT				,	// send-init terms settled. arg8: window, arg16: longest packet we may send
+	TRACE_KM_PACKET				,	// good packet. arg8: type, arg16: seq
+	TRACE_KM_BAD_PACKET			,	// block check failed. arg8: type, arg16: data length
+	TRACE_KM_NAK				,	// NAK sent. arg8: 0 after a timeout or bad packet, 1 for a gap in the window, arg16: seq
+	TRACE_KM_RESEND				,	// packet sent again. arg8: type, arg16: seq
+	TRACE_NUM_EVENTS
+} trace_event;
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+typedef struct TraceEntry {
+	uint8_t			event_;			// trace_event
+	uint8_t			arg8_;
+	uint16_t		arg16_;
+} TraceEntry;
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// forget all recorded events
+void Trace_Reset(void);
+
+// record one event, overwriting the oldest if the ring is full. use through the TRACE() macro.
+void Trace_Add(uint8_t the_event, uint8_t the_arg8, uint16_t the_arg16);
+
+// write recorded events, oldest first, to a text file on the SD card
+// returns false on any disk error
+bool Trace_DumpToDisk(void);
+
+
+#endif /* TRACE_H_ */
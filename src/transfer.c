@@ -0,0 +1,642 @@
+/*
+ * transfer.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ *
+ *  - file transfer glue: protocol code (ymodem.c, zmodem.c, kermit.c) hands us blocks, we write them to the SD card, or read them from it to send
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "app.h"
+#include "comm_buffer.h"
+#include "general.h"
+#include "kermit.h"
+#include "progress.h"
+#include "strings.h"
+#include "transfer.h"
+#include "ymodem.h"
+#include "zmodem.h"
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+// F256 includes
+#include "f256_e.h"
+
+#include "ff.h"
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define TRANSFER_TARGET_FOLDER		"0:"	// received files go in the root of the SD card, and files to send are read from there
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+static FIL					transfer_file;
+static bool					transfer_file_is_open = false;
+static uint8_t				transfer_buffer[TRANSFER_BUFFER_SIZE];	// data received but not yet written, or read but not yet sent
+static uint16_t				transfer_buffer_len;					// bytes in transfer_buffer
+static uint16_t				transfer_buffer_pos;					// sending: next byte of transfer_buffer to hand to the protocol
+static uint16_t				transfer_file_count;					// files completed this session
+static const char*			transfer_send_list;						// sending: names not yet sent, separated by spaces
+static char					transfer_short_name[FILE_MAX_FILENAME_SIZE];	// zmodem: file being received, for messages
+static uint32_t				transfer_file_size;						// zmodem: size the sender gave
+static uint32_t				transfer_existing_size;					// zmodem: size of the file already on disk under that name
+
+extern char*				global_string_buff1;
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// write whatever is in transfer_buffer to the open file. returns false on a disk error or a full disk.
+bool Transfer_FlushBuffer(void);
+
+// build the SD card path for a file the sender named. any folders in the sender's name are dropped.
+// the_short_name gets the bare file name, for messages
+void Transfer_BuildPath(const char* the_filename, char* the_path, char* the_short_name);
+
+// ymodem/kermit callback: sender announced a file. create it on the SD card.
+bool Transfer_OpenFile(const char* the_filename, uint32_t the_filesize);
+
+// zmodem callback: sender announced a file. open it, keeping what is on the SD card until the protocol has checked it.
+// sets the_offset to how much of it may be there already: the_filesize if all of it
+bool Transfer_ResumeFile(const char* the_filename, uint32_t the_filesize, uint32_t* the_offset);
+
+// zmodem callback: read back the_len bytes of the file being resumed, from the start, so the protocol can check them
+bool Transfer_ReadBack(uint8_t* the_data, uint16_t the_len);
+
+// zmodem callback: receive from the_offset on, dropping anything on the SD card past it. the_offset is the file's size to skip it.
+bool Transfer_StartAt(uint32_t the_offset);
+
+// ymodem/zmodem/kermit callback: add received data to the file
+bool Transfer_WriteData(const uint8_t* the_data, uint16_t the_len);
+
+// ymodem/zmodem/kermit callback: file ended (or the transfer was aborted). write out the rest and close it.
+bool Transfer_CloseFile(void);
+
+// ymodem/kermit send callback: open the next file named in transfer_send_list. names that can't be opened are reported and skipped.
+// the_filename gets the name to send. returns false when there are no more names.
+bool Transfer_NextSendFile(char* the_filename, uint32_t* the_filesize);
+
+// ymodem/kermit send callback: copy up to the_len bytes of the file being sent to the_data
+// returns bytes copied, 0 at end of file, or -1 on a disk error
+int16_t Transfer_ReadData(uint8_t* the_data, uint16_t the_len);
+
+// ymodem/kermit send callback: file sent (or the transfer was aborted). close it.
+bool Transfer_CloseSendFile(void);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+// write whatever is in transfer_buffer to the open file. returns false on a disk error or a full disk.
+bool Transfer_FlushBuffer(void)
+{
+	UINT		bytes_written;
+	FRESULT		the_result;
+	
+	if (transfer_buffer_len == 0)
+	{
+		return true;
+	}
+	
+	the_result = f_write(&transfer_file, transfer_buffer, transfer_buffer_len, &bytes_written);
+	
+	if (the_result != FR_OK || bytes_written < transfer_buffer_len)
+	{
+		return false;
+	}
+	
+	transfer_buffer_len = 0;
+	
+	return true;
+}
+
+
+// build the SD card path for a file the sender named. any folders in the sender's name are dropped.
+// the_short_name gets the bare file name, for messages
+void Transfer_BuildPath(const char* the_filename, char* the_path, char* the_short_name)
+{
+	const char*	the_name = the_filename;
+	
+	// the sender may include its own folders in the name. we only want the last part.
+	while (*the_filename != 0)
+	{
+		if (*the_filename == '/' || *the_filename == '\\')
+		{
+			the_name = the_filename + 1;
+		}
+		
+		the_filename++;
+	}
+	
+	General_Strlcpy(the_short_name, the_name, FILE_MAX_FILENAME_SIZE);
+	General_CreateFilePathFromFolderAndFile(the_path, TRANSFER_TARGET_FOLDER, the_short_name, FILE_MAX_PATHNAME_SIZE);
+}
+
+
+// ymodem/kermit callback: sender announced a file. create it on the SD card.
+bool Transfer_OpenFile(const char* the_filename, uint32_t the_filesize)
+{
+	char		the_path[FILE_MAX_PATHNAME_SIZE];
+	char		the_short_name[FILE_MAX_FILENAME_SIZE];
+	
+	Transfer_BuildPath(the_filename, the_path, the_short_name);
+	
+	if (f_open(&transfer_file, the_path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+	{
+		return false;
+	}
+	
+	transfer_file_is_open = true;
+	transfer_buffer_len = 0;
+	
+	sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_TRANSFER_RECEIVING), the_short_name, (unsigned long)the_filesize);
+	Buffer_NewMessage(global_string_buff1);
+	Progress_NewFile(the_filesize, 0);
+	
+	return true;
+}
+
+
+// zmodem callback: sender announced a file. open it, keeping what is on the SD card until the protocol has checked it.
+// sets the_offset to how much of it may be there already: the_filesize if all of it
+bool Transfer_ResumeFile(const char* the_filename, uint32_t the_filesize, uint32_t* the_offset)
+{
+	char		the_path[FILE_MAX_PATHNAME_SIZE];
+	
+	// LOGIC:
+	//   a file with the same name that is no bigger than the one offered may be an earlier, interrupted download of it.
+	//   zmodem.c asks the sender whether it is (ZCRC), reading it back through Transfer_ReadBack(), then calls Transfer_StartAt().
+	//   the resume point is rounded down to a whole sector: the last sector of an interrupted write may not have made it to disk,
+	//   and starting on a sector boundary keeps every later f_write() aligned, which is the fast case for FatFs.
+	//   a bigger file, or a sender that didn't give a size, means start from scratch.
+	
+	*the_offset = 0;
+	
+	Transfer_BuildPath(the_filename, the_path, transfer_short_name);
+	
+	if (f_open(&transfer_file, the_path, FA_READ | FA_WRITE | FA_OPEN_ALWAYS) != FR_OK)
+	{
+		return false;
+	}
+	
+	transfer_file_is_open = true;
+	transfer_buffer_len = 0;
+	transfer_file_size = the_filesize;
+	transfer_existing_size = f_size(&transfer_file);
+	
+	if (the_filesize > 0 && transfer_existing_size == the_filesize)
+	{
+		*the_offset = the_filesize;
+	}
+	else if (the_filesize > 0 && transfer_existing_size < the_filesize)
+	{
+		*the_offset = transfer_existing_size & ~((uint32_t)TRANSFER_SECTOR_SIZE - 1);
+	}
+	
+	if (*the_offset > 0)
+	{
+		sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_TRANSFER_CHECKING), transfer_short_name);
+		Buffer_NewMessage(global_string_buff1);
+	}
+	
+	return true;
+}
+
+
+// zmodem callback: read back the_len bytes of the file being resumed, from the start, so the protocol can check them
+bool Transfer_ReadBack(uint8_t* the_data, uint16_t the_len)
+{
+	UINT		bytes_read;
+	
+	return (f_read(&transfer_file, the_data, the_len, &bytes_read) == FR_OK && bytes_read == the_len);
+}
+
+
+// zmodem callback: receive from the_offset on, dropping anything on the SD card past it. the_offset is the file's size to skip it.
+bool Transfer_StartAt(uint32_t the_offset)
+{
+	if (transfer_file_size > 0 && the_offset == transfer_file_size)
+	{
+		f_close(&transfer_file);
+		transfer_file_is_open = false;
+		
+		sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_TRANSFER_SKIPPING), transfer_short_name);
+		Buffer_NewMessage(global_string_buff1);
+		
+		return true;
+	}
+	
+	if (f_lseek(&transfer_file, the_offset) != FR_OK || f_truncate(&transfer_file) != FR_OK)
+	{
+		f_close(&transfer_file);
+		transfer_file_is_open = false;
+		return false;
+	}
+	
+	if (the_offset > 0)
+	{
+		sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_TRANSFER_RESUMING), transfer_short_name, (unsigned long)the_offset, (unsigned long)transfer_file_size);
+	}
+	else if (transfer_existing_size > 0)
+	{
+		sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_TRANSFER_REPLACING), transfer_short_name, (unsigned long)transfer_file_size);
+	}
+	else
+	{
+		sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_TRANSFER_RECEIVING), transfer_short_name, (unsigned long)transfer_file_size);
+	}
+	
+	Buffer_NewMessage(global_string_buff1);
+	Progress_NewFile(transfer_file_size, the_offset);
+	
+	return true;
+}
+
+
+// ymodem/zmodem/kermit callback: add received data to the file
+bool Transfer_WriteData(const uint8_t* the_data, uint16_t the_len)
+{
+	uint16_t	the_span;
+	
+	// LOGIC:
+	//   data is staged in transfer_buffer and written in whole TRANSFER_BUFFER_SIZE chunks.
+	//   with the file position on a sector boundary, FatFs writes those sectors straight from our buffer, no copy through its window.
+	//   the protocols ACK (if they ACK at all) before handing data to us, so more is arriving in the UART buffer while f_write runs:
+	//   that ring buffer is what covers SD card latency. YMODEM won't send past 1 unACKed block; YMODEM-G and ZMODEM
+	//   stream, and are held off by RTS if the ring buffer gets close to full.
+	
+	Progress_AddBytes(the_len);
+	
+	while (the_len > 0)
+	{
+		the_span = TRANSFER_BUFFER_SIZE - transfer_buffer_len;
+		
+		if (the_span > the_len)
+		{
+			the_span = the_len;
+		}
+		
+		memcpy(transfer_buffer + transfer_buffer_len, the_data, the_span);
+		transfer_buffer_len += the_span;
+		the_data += the_span;
+		the_len -= the_span;
+		
+		if (transfer_buffer_len == TRANSFER_BUFFER_SIZE && Transfer_FlushBuffer() == false)
+		{
+			return false;
+		}
+	}
+	
+	return true;
+}
+
+
+// ymodem/zmodem/kermit callback: file ended (or the transfer was aborted). write out the rest and close it.
+bool Transfer_CloseFile(void)
+{
+	bool	success;
+	
+	if (transfer_file_is_open == false)
+	{
+		return true;
+	}
+	
+	success = Transfer_FlushBuffer();
+	
+	if (f_close(&transfer_file) != FR_OK)
+	{
+		success = false;
+	}
+	
+	transfer_file_is_open = false;
+	
+	if (success == true)
+	{
+		transfer_file_count++;
+	}
+	
+	return success;
+}
+
+
+// ymodem/kermit send callback: open the next file named in transfer_send_list. names that can't be opened are reported and skipped.
+// the_filename gets the name to send. returns false when there are no more names.
+bool Transfer_NextSendFile(char* the_filename, uint32_t* the_filesize)
+{
+	char		the_path[FILE_MAX_PATHNAME_SIZE];
+	char		the_short_name[FILE_MAX_FILENAME_SIZE];
+	uint8_t		the_len;
+	
+	while (true)
+	{
+		while (*transfer_send_list == CH_SPACE)
+		{
+			transfer_send_list++;
+		}
+		
+		if (*transfer_send_list == 0)
+		{
+			return false;
+		}
+		
+		the_len = 0;
+		
+		while (*transfer_send_list != 0 && *transfer_send_list != CH_SPACE)
+		{
+			if (the_len < FYMODEM_FILE_NAME_MAX_LENGTH)
+			{
+				the_filename[the_len++] = *transfer_send_list;
+			}
+			
+			transfer_send_list++;
+		}
+		
+		the_filename[the_len] = 0;
+		
+		Transfer_BuildPath(the_filename, the_path, the_short_name);
+		
+		if (f_open(&transfer_file, the_path, FA_READ) == FR_OK)
+		{
+			break;
+		}
+		
+		sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_TRANSFER_CANT_OPEN), the_short_name);
+		Buffer_NewMessage(global_string_buff1);
+	}
+	
+	transfer_file_is_open = true;
+	transfer_buffer_len = 0;
+	transfer_buffer_pos = 0;
+	
+	// the receiver gets the bare name, without any folder
+	General_Strlcpy(the_filename, the_short_name, FYMODEM_FILE_NAME_MAX_LENGTH + 1);
+	*the_filesize = f_size(&transfer_file);
+	
+	sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_TRANSFER_SENDING), the_short_name, (unsigned long)*the_filesize);
+	Buffer_NewMessage(global_string_buff1);
+	Progress_NewFile(*the_filesize, 0);
+	
+	return true;
+}
+
+
+// ymodem/kermit send callback: copy up to the_len bytes of the file being sent to the_data
+// returns bytes copied, 0 at end of file, or -1 on a disk error
+int16_t Transfer_ReadData(uint8_t* the_data, uint16_t the_len)
+{
+	UINT		bytes_read;
+	uint16_t	the_span;
+	int16_t		the_total = 0;
+	
+	// LOGIC:
+	//   the file is read TRANSFER_BUFFER_SIZE at a time. from a sector boundary, FatFs reads whole sectors straight into
+	//   transfer_buffer, with no copy through its window, and one f_read covers 4 YMODEM blocks.
+	//   ymodem asks for the next block right after queuing the current one, so the read happens while the UART
+	//   interrupt is still sending, not while the receiver waits.
+	
+	while (the_len > 0)
+	{
+		if (transfer_buffer_pos == transfer_buffer_len)
+		{
+			if (f_read(&transfer_file, transfer_buffer, TRANSFER_BUFFER_SIZE, &bytes_read) != FR_OK)
+			{
+				return -1;
+			}
+			
+			transfer_buffer_len = bytes_read;
+			transfer_buffer_pos = 0;
+			
+			if (bytes_read == 0)
+			{
+				break;
+			}
+		}
+		
+		the_span = transfer_buffer_len - transfer_buffer_pos;
+		
+		if (the_span > the_len)
+		{
+			the_span = the_len;
+		}
+		
+		memcpy(the_data, transfer_buffer + transfer_buffer_pos, the_span);
+		transfer_buffer_pos += the_span;
+		the_data += the_span;
+		the_len -= the_span;
+		the_total += the_span;
+	}
+	
+	// counted when read, not when ACKed: the protocols read at most a block or packet ahead of what they have sent
+	Progress_AddBytes(the_total);
+	
+	return the_total;
+}
+
+
+// ymodem/kermit send callback: file sent (or the transfer was aborted). close it.
+bool Transfer_CloseSendFile(void)
+{
+	if (transfer_file_is_open == false)
+	{
+		return true;
+	}
+	
+	transfer_file_is_open = false;
+	transfer_buffer_len = 0;
+	
+	if (f_close(&transfer_file) != FR_OK)
+	{
+		return false;
+	}
+	
+	transfer_file_count++;
+	
+	return true;
+}
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+// returns true if the user has pressed ESC to cancel the transfer, and says so in the message area
+// protocol code calls this while receiving, at least once a second, so even a stalled transfer can be stopped
+bool Transfer_CheckCancel(void)
+{
+	// other keys mean nothing during a transfer: they are dropped
+	if (Keyboard_GetKeyIfPressed() != CH_ESC)
+	{
+		return false;
+	}
+	
+	Buffer_NewMessage(Strings_GetString(ID_STR_MSG_TRANSFER_CANCELLED));
+	
+	return true;
+}
+
+
+// receive one or more files with YMODEM, writing them to the SD card. blocks until the transfer ends.
+// streaming selects YMODEM-G, for error-correcting links: no per-block ACKs, and any bad block ends the transfer
+// returns true if at least one file was received and the transfer ended normally
+bool Transfer_ReceiveYModem(bool streaming)
+{
+	static const fymodem_rx_callbacks	the_callbacks = {Transfer_OpenFile, Transfer_WriteData, Transfer_CloseFile};
+	int32_t		bytes_received;
+	
+	Buffer_NewMessage(Strings_GetString(streaming ? ID_STR_MSG_TRANSFER_YMODEM_G_START : ID_STR_MSG_TRANSFER_YMODEM_START));
+	
+	transfer_file_count = 0;
+	Progress_Start();
+	bytes_received = fymodem_receive_cb(&the_callbacks, streaming);
+	Progress_End();
+	
+	if (bytes_received <= 0 || transfer_file_count == 0)
+	{
+		Buffer_NewMessage(Strings_GetString(ID_STR_MSG_TRANSFER_FAILED));
+		return false;
+	}
+	
+	sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_TRANSFER_DONE), transfer_file_count, (unsigned long)bytes_received);
+	Buffer_NewMessage(global_string_buff1);
+	
+	return true;
+}
+
+
+// receive one or more files with ZMODEM, writing them to the SD card. blocks until the transfer ends.
+// a file already partly on the SD card (from an interrupted download) is resumed where it left off, if the sender agrees it is the same file
+// started_by_sender is true if the sender's ZRQINIT started the download, rather than the user
+// returns true if the transfer ended normally
+bool Transfer_ReceiveZModem(bool started_by_sender)
+{
+	static const ZModemCallbacks	the_callbacks = {Transfer_ResumeFile, Transfer_ReadBack, Transfer_StartAt, Transfer_WriteData, Transfer_CloseFile};
+	int32_t		bytes_received;
+	
+	Buffer_NewMessage(Strings_GetString(started_by_sender ? ID_STR_MSG_TRANSFER_ZMODEM_AUTO : ID_STR_MSG_TRANSFER_ZMODEM_START));
+	
+	transfer_file_count = 0;
+	Progress_Start();
+	bytes_received = ZModem_Receive(&the_callbacks);
+	Progress_End();
+	
+	if (bytes_received < 0)
+	{
+		Buffer_NewMessage(Strings_GetString(ID_STR_MSG_TRANSFER_FAILED));
+		return false;
+	}
+	
+	sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_TRANSFER_DONE), transfer_file_count, (unsigned long)bytes_received);
+	Buffer_NewMessage(global_string_buff1);
+	
+	return true;
+}
+
+
+// send one or more files from the SD card with YMODEM batch, or the first of them with XMODEM-1K. blocks until the transfer ends.
+// the_file_list is file names in the root of the SD card, separated by spaces. names that can't be opened are skipped.
+// returns true if at least one file was sent and the transfer ended normally
+bool Transfer_SendYModem(const char* the_file_list, bool xmodem)
+{
+	static const fymodem_tx_callbacks	the_callbacks = {Transfer_NextSendFile, Transfer_ReadData, Transfer_CloseSendFile};
+	int32_t		bytes_sent;
+	
+	Buffer_NewMessage(Strings_GetString(xmodem ? ID_STR_MSG_TRANSFER_XMODEM_SEND_START : ID_STR_MSG_TRANSFER_YMODEM_SEND_START));
+	
+	transfer_send_list = the_file_list;
+	transfer_file_count = 0;
+	Progress_Start();
+	bytes_sent = fymodem_send_cb(&the_callbacks, xmodem);
+	Progress_End();
+	
+	if (bytes_sent < 0 || transfer_file_count == 0)
+	{
+		Buffer_NewMessage(Strings_GetString(ID_STR_MSG_TRANSFER_UPLOAD_FAILED));
+		return false;
+	}
+	
+	sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_TRANSFER_UPLOAD_DONE), transfer_file_count, (unsigned long)bytes_sent);
+	Buffer_NewMessage(global_string_buff1);
+	
+	return true;
+}
+
+
+// receive one or more files with Kermit, writing them to the SD card. blocks until the transfer ends.
+// returns true if at least one file was received and the transfer ended normally
+bool Transfer_ReceiveKermit(void)
+{
+	static const KermitCallbacks	the_callbacks = {Transfer_OpenFile, Transfer_WriteData, NULL, NULL, Transfer_CloseFile};
+	int32_t		bytes_received;
+	
+	Buffer_NewMessage(Strings_GetString(ID_STR_MSG_TRANSFER_KERMIT_START));
+	
+	transfer_file_count = 0;
+	Progress_Start();
+	bytes_received = Kermit_Receive(&the_callbacks);
+	Progress_End();
+	
+	if (bytes_received < 0 || transfer_file_count == 0)
+	{
+		Buffer_NewMessage(Strings_GetString(ID_STR_MSG_TRANSFER_FAILED));
+		return false;
+	}
+	
+	sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_TRANSFER_DONE), transfer_file_count, (unsigned long)bytes_received);
+	Buffer_NewMessage(global_string_buff1);
+	
+	return true;
+}
+
+
+// send one or more files from the SD card with Kermit. blocks until the transfer ends.
+// the_file_list is file names in the root of the SD card, separated by spaces. names that can't be opened are skipped.
+// returns true if at least one file was sent and the transfer ended normally
+bool Transfer_SendKermit(const char* the_file_list)
+{
+	static const KermitCallbacks	the_callbacks = {NULL, NULL, Transfer_NextSendFile, Transfer_ReadData, Transfer_CloseSendFile};
+	int32_t		bytes_sent;
+	
+	Buffer_NewMessage(Strings_GetString(ID_STR_MSG_TRANSFER_KERMIT_SEND_START));
+	
+	transfer_send_list = the_file_list;
+	transfer_file_count = 0;
+	Progress_Start();
+	bytes_sent = Kermit_Send(&the_callbacks);
+	Progress_End();
+	
+	if (bytes_sent < 0 || transfer_file_count == 0)
+	{
+		Buffer_NewMessage(Strings_GetString(ID_STR_MSG_TRANSFER_UPLOAD_FAILED));
+		return false;
+	}
+	
+	sprintf(global_string_buff1, Strings_GetString(ID_STR_MSG_TRANSFER_UPLOAD_DONE), transfer_file_count, (unsigned long)bytes_sent);
+	Buffer_NewMessage(global_string_buff1);
+	
+	return true;
+}
@@ -0,0 +1,105 @@
+//! @file transfer.h
+
+/*
+ * transfer.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ */
+
+#ifndef TRANSFER_H_
+#define TRANSFER_H_
+
+
+/* about this class: Transfer
+ *
+ * This connects the file transfer protocols to the SD card: received files are written to disk as they arrive, and sent files are read from it
+ *
+ *** things this class needs to be able to do
+ * run a YMODEM, YMODEM-G, or ZMODEM download, storing each file on the SD card under the name the sender gave it
+ * resume a ZMODEM download from the part of the file already on the SD card
+ * write in whole-sector chunks, so file size is limited by disk space, not RAM
+ * close (and keep) a partial file if the transfer is aborted
+ * run a YMODEM batch or XMODEM-1K upload of files the user names, reading ahead in whole-sector chunks
+ * run a Kermit download or upload, for hosts that offer nothing else (or only 7-bit lines)
+ *
+ *** things objects of this class have
+ * the file being received or sent, and a staging buffer for data not yet written to it (or read but not yet sent)
+ * the names of files still to be sent
+ *
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+
+// Platform includes
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+#define TRANSFER_SECTOR_SIZE		512		// FatFs sector size
+#define TRANSFER_BUFFER_SIZE		(TRANSFER_SECTOR_SIZE * 8)	// received data is written to disk, and data to send is read from it, in chunks this big
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// returns true if the user has pressed ESC to cancel the transfer, and says so in the message area
+// protocol code calls this while receiving, at least once a second, so even a stalled transfer can be stopped
+bool Transfer_CheckCancel(void);
+
+// receive one or more files with YMODEM, writing them to the SD card. blocks until the transfer ends.
+// streaming selects YMODEM-G, for error-correcting links: no per-block ACKs, and any bad block ends the transfer
+// returns true if at least one file was received and the transfer ended normally
+bool Transfer_ReceiveYModem(bool streaming);
+
+// receive one or more files with ZMODEM, writing them to the SD card. blocks until the transfer ends.
+// a file already partly on the SD card (from an interrupted download) is resumed where it left off
+// started_by_sender is true if the sender's ZRQINIT started the download, rather than the user
+// returns true if the transfer ended normally
+bool Transfer_ReceiveZModem(bool started_by_sender);
+
+// send one or more files from the SD card with YMODEM batch, or the first of them with XMODEM-1K. blocks until the transfer ends.
+// the_file_list is file names in the root of the SD card, separated by spaces. names that can't be opened are skipped.
+// returns true if at least one file was sent and the transfer ended normally
+bool Transfer_SendYModem(const char* the_file_list, bool xmodem);
+
+// receive one or more files with Kermit, writing them to the SD card. blocks until the transfer ends.
+// returns true if at least one file was received and the transfer ended normally
+bool Transfer_ReceiveKermit(void);
+
+// send one or more files from the SD card with Kermit. blocks until the transfer ends.
+// the_file_list is file names in the root of the SD card, separated by spaces. names that can't be opened are skipped.
+// returns true if at least one file was sent and the transfer ended normally
+bool Transfer_SendKermit(const char* the_file_list);
+
+
+#endif /* TRANSFER_H_ */
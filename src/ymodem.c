@@ -17,8 +17,6 @@
  * Add rx/tx callbacks if eg storing file to external storage,
  * and full buffer cannot be in memory at the same time.
  *
- * Add support for Ymodem-G standard as described in docs for streaming.
- *
  * Add suppport for async operation mode if calling system cannot handle
  * that calls are synchroneus and blocking.
  *
@@ -35,7 +33,11 @@
 #include "ymodem.h"
 
 #include "comm_buffer.h"
+#include "general.h"
+#include "progress.h"
 #include "serial.h"
+#include "trace.h"
+#include "transfer.h"
 
 #include <stdint.h>
 
@@ -56,6 +58,10 @@ extern char*			global_string_buff1;
 #define YM_PACKET_1K_SIZE          (1024)
 #define YM_PACKET_RX_TIMEOUT_MS    (1000)
 #define YM_PACKET_ERROR_MAX_NBR    (5)
+#define YM_START_ERROR_MAX_NBR     (60)     /* how many 'C's (one a second) to send before giving up on the sender */
+#define YM_PURGE_TIMEOUT_MS        (1000)   /* after a bad start byte, the line must be quiet this long before we NAK */
+#define YM_TX_START_TIMEOUT_MS     (60000)  /* how long to wait for the receiver's first 'C' */
+#define YM_TX_ACK_TIMEOUT_MS       (10000)  /* receivers may be writing the last block to disk before they answer */
 
 /* contants defined by YModem protocol */
 #define YM_SOH                     (0x01)  /* start of 128-byte data packet */
@@ -65,17 +71,25 @@ extern char*			global_string_buff1;
 #define YM_NAK                     (0x15)  /* Negative ACKnowledge, receiver ERROR, retry */
 #define YM_CAN                     (0x18)  /* two CAN in succession will abort transfer */
 #define YM_CRC                     (0x43)  /* 'C' == 0x43, request 16-bit CRC, use in place of first NAK for CRC mode */
+#define YM_G                       (0x47)  /* 'G' == 0x47, request YMODEM-G: CRC mode, blocks streamed without ACKs */
 #define YM_ABT1                    (0x41)  /* 'A' == 0x41, assume try abort by user typing */
 #define YM_ABT2                    (0x61)  /* 'a' == 0x61, assume try abort by user typing */
+#define YM_CPMEOF                  (0x1A)  /* pads the last block of a file */
 
 /* ------------------------------------------------ */
 
 /* user callbacks, implement these for your target */
 /* user function __ym_getchar() should return -1 in case of timeout */
-#define __ym_getchar(timeout_ms) Serial_GetByte((int)timeout_ms)
+#define __ym_getchar(timeout_ms) Serial_GetByte(timeout_ms)
+/* user function __ym_getpacket() should return the number of bytes read, less than len only on timeout */
+#define __ym_getpacket(buf, len, timeout_ms) Serial_ReadPacket(buf, len, timeout_ms)
 #define __ym_putchar(c)          (void)Serial_SendByte(c)
 #define __ym_sleep_ms(delay_ms)  General_DelayTicks(delay_ms/1000)
 #define __ym_flush()             Serial_FlushInBuffer()
+/* user function __ym_txwait() should return once every byte given to __ym_putchar() has been sent */
+#define __ym_txwait()            Serial_WaitForTransmit()
+/* user function __ym_cancelled() should return true if the user asked to stop the transfer */
+#define __ym_cancelled()         Transfer_CheckCancel()
 /* example functions for POSIX/Unix */
 #define __ym_getchar_posix(timeout_ms) read(timeout_ms/1000)
 #define __ym_putchar_posix(c)          (void)write(c)
@@ -86,17 +100,51 @@ extern char*			global_string_buff1;
 #define YM_ERR(fmt, ...) do { sprintf(global_string_buff1, fmt, __VA_ARGS__); Buffer_NewMessage(global_string_buff1); } while(0)
 
 /* ------------------------------------------------ */
-/* calculate crc16-ccitt very fast
-   Idea from: http://www.ccsinfo.com/forum/viewtopic.php?t=24977
-*/
+/* crc16-ccitt (xmodem: poly 0x1021, init 0) of every byte value shifted through the high byte.
+   MB: the 65816 has no barrel shifter, so the shift-and-xor version costs ~20 shifts per byte.
+       one table lookup per byte instead. 512 bytes of table for the inner loop of every transfer. zmodem.c uses it too. */
+const uint16_t ym_crc16_table[256] =
+{
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+  0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+  0x1231, 0x0210, 0x3273, 0x2252, 0x52b5, 0x4294, 0x72f7, 0x62d6,
+  0x9339, 0x8318, 0xb37b, 0xa35a, 0xd3bd, 0xc39c, 0xf3ff, 0xe3de,
+  0x2462, 0x3443, 0x0420, 0x1401, 0x64e6, 0x74c7, 0x44a4, 0x5485,
+  0xa56a, 0xb54b, 0x8528, 0x9509, 0xe5ee, 0xf5cf, 0xc5ac, 0xd58d,
+  0x3653, 0x2672, 0x1611, 0x0630, 0x76d7, 0x66f6, 0x5695, 0x46b4,
+  0xb75b, 0xa77a, 0x9719, 0x8738, 0xf7df, 0xe7fe, 0xd79d, 0xc7bc,
+  0x48c4, 0x58e5, 0x6886, 0x78a7, 0x0840, 0x1861, 0x2802, 0x3823,
+  0xc9cc, 0xd9ed, 0xe98e, 0xf9af, 0x8948, 0x9969, 0xa90a, 0xb92b,
+  0x5af5, 0x4ad4, 0x7ab7, 0x6a96, 0x1a71, 0x0a50, 0x3a33, 0x2a12,
+  0xdbfd, 0xcbdc, 0xfbbf, 0xeb9e, 0x9b79, 0x8b58, 0xbb3b, 0xab1a,
+  0x6ca6, 0x7c87, 0x4ce4, 0x5cc5, 0x2c22, 0x3c03, 0x0c60, 0x1c41,
+  0xedae, 0xfd8f, 0xcdec, 0xddcd, 0xad2a, 0xbd0b, 0x8d68, 0x9d49,
+  0x7e97, 0x6eb6, 0x5ed5, 0x4ef4, 0x3e13, 0x2e32, 0x1e51, 0x0e70,
+  0xff9f, 0xefbe, 0xdfdd, 0xcffc, 0xbf1b, 0xaf3a, 0x9f59, 0x8f78,
+  0x9188, 0x81a9, 0xb1ca, 0xa1eb, 0xd10c, 0xc12d, 0xf14e, 0xe16f,
+  0x1080, 0x00a1, 0x30c2, 0x20e3, 0x5004, 0x4025, 0x7046, 0x6067,
+  0x83b9, 0x9398, 0xa3fb, 0xb3da, 0xc33d, 0xd31c, 0xe37f, 0xf35e,
+  0x02b1, 0x1290, 0x22f3, 0x32d2, 0x4235, 0x5214, 0x6277, 0x7256,
+  0xb5ea, 0xa5cb, 0x95a8, 0x8589, 0xf56e, 0xe54f, 0xd52c, 0xc50d,
+  0x34e2, 0x24c3, 0x14a0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+  0xa7db, 0xb7fa, 0x8799, 0x97b8, 0xe75f, 0xf77e, 0xc71d, 0xd73c,
+  0x26d3, 0x36f2, 0x0691, 0x16b0, 0x6657, 0x7676, 0x4615, 0x5634,
+  0xd94c, 0xc96d, 0xf90e, 0xe92f, 0x99c8, 0x89e9, 0xb98a, 0xa9ab,
+  0x5844, 0x4865, 0x7806, 0x6827, 0x18c0, 0x08e1, 0x3882, 0x28a3,
+  0xcb7d, 0xdb5c, 0xeb3f, 0xfb1e, 0x8bf9, 0x9bd8, 0xabbb, 0xbb9a,
+  0x4a75, 0x5a54, 0x6a37, 0x7a16, 0x0af1, 0x1ad0, 0x2ab3, 0x3a92,
+  0xfd2e, 0xed0f, 0xdd6c, 0xcd4d, 0xbdaa, 0xad8b, 0x9de8, 0x8dc9,
+  0x7c26, 0x6c07, 0x5c64, 0x4c45, 0x3ca2, 0x2c83, 0x1ce0, 0x0cc1,
+  0xef1f, 0xff3e, 0xcf5d, 0xdf7c, 0xaf9b, 0xbfba, 0x8fd9, 0x9ff8,
+  0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0,
+};
+
+/* calculate crc16-ccitt, table driven */
 static uint16_t ym_crc16(const uint8_t *buf, uint16_t len) 
 {
-  uint16_t x;
   uint16_t crc = 0;
   while (len--) {
-    x = (crc >> 8) ^ *buf++;
-    x ^= x >> 4;
-    crc = (crc << 8) ^ (x << 12) ^ (x << 5) ^ x;
+    crc = (crc << 8) ^ ym_crc16_table[(uint8_t)(crc >> 8) ^ *buf++];
   }
   return crc;
 }
@@ -163,6 +211,7 @@ static void ym_readU32(const uint8_t* buf, uint32_t *val)
   *    >0: packet length
   * @return 0: normally return, success
   *        -1: timeout or packet error
+  *        -2: bad start byte: the rest of a damaged block may still be arriving
   *         1: abort by user / corrupt packet
   */
 static int16_t ym_rx_packet(uint8_t *rxdata,
@@ -177,9 +226,8 @@ static int16_t ym_rx_packet(uint8_t *rxdata,
   if (c < 0)
   {
     /* end of stream */
-		sprintf(global_string_buff1, "%s %d: end of stream? c=%i '%c'", __func__, __LINE__, c, c);
-		Buffer_NewMessage(global_string_buff1);
-	return -1;
+    TRACE((TRACE_YM_TIMEOUT, 0, 0));
+    return -1;
   }
 
   uint32_t rx_packet_size;
@@ -188,20 +236,15 @@ static int16_t ym_rx_packet(uint8_t *rxdata,
 	{
 		case YM_SOH:
 			rx_packet_size = YM_PACKET_SIZE;
-			sprintf(global_string_buff1, "%s %d: rx_packet_size = YM_PACKET_SIZE", __func__, __LINE__);
-			Buffer_NewMessage(global_string_buff1);
 			break;
 
 		case YM_STX:
 			rx_packet_size = YM_PACKET_1K_SIZE;
-			sprintf(global_string_buff1, "%s %d: rx_packet_size = YM_PACKET_1K_SIZE", __func__, __LINE__);
-			Buffer_NewMessage(global_string_buff1);
 			break;
 
 		case YM_EOT:
 			/* ok */
-			sprintf(global_string_buff1, "%s %d: YM_EOT - ok", __func__, __LINE__);
-			Buffer_NewMessage(global_string_buff1);
+			TRACE((TRACE_YM_EOT, 0, 0));
 			return 0;
 
 		case YM_CAN:
@@ -211,8 +254,7 @@ static int16_t ym_rx_packet(uint8_t *rxdata,
 			{
 				*rxlen = -1;
 				/* ok */
-				sprintf(global_string_buff1, "%s %d: YM_CAN - ok", __func__, __LINE__);
-				Buffer_NewMessage(global_string_buff1);
+				TRACE((TRACE_YM_CAN, 0, 0));
 				return 0;
 			}
 			/* fall-through */
@@ -222,8 +264,7 @@ static int16_t ym_rx_packet(uint8_t *rxdata,
 			if (packets_rxed == 0)
 			{
 				/* could be start condition, first byte */
-				sprintf(global_string_buff1, "%s %d: could be start condition, first byte", __func__, __LINE__);
-				Buffer_NewMessage(global_string_buff1);
+				TRACE((TRACE_YM_START_CHAR, c, 0));
 				return 1;
 			}
 			/* fall-through */
@@ -231,54 +272,29 @@ static int16_t ym_rx_packet(uint8_t *rxdata,
 		case YM_ABT1:
 		case YM_ABT2:
 			/* User try abort, 'A' or 'a' received */
-			sprintf(global_string_buff1, "%s %d: User try abort c='%c'", __func__, __LINE__, c);
-			Buffer_NewMessage(global_string_buff1);
+			TRACE((TRACE_YM_ABORT_CHAR, c, 0));
 			return 1;
 
 		default:
-			/* This case could be the result of corruption on the first octet
-			of the packet, but it's more likely that it's the user banging
-			on the terminal trying to abort a transfer. Technically, the
-			former case deserves a NAK, but for now we'll just treat this
-			as an abort case. */
-			*rxlen = -1;
-			sprintf(global_string_buff1, "%s %d: corruption on the first octet? c=%i '%c'", __func__, __LINE__, c, c);
-			Buffer_NewMessage(global_string_buff1);
-			return 0;
+			/* MB: corruption on the first octet of the packet. the caller lets the rest of the block go by,
+			   then NAKs it like any other bad block (YMODEM-G aborts, as it does for any bad block). */
+			TRACE((TRACE_YM_BAD_START, c, 0));
+			return -2;
 	}
 
-// 	sprintf(global_string_buff1, "%s %d: past switch", __func__, __LINE__);
-// 	Buffer_NewMessage(global_string_buff1);
-// General_DelayTicks(1000);  
-
 	/* store data RXed */
 	*rxdata = (uint8_t)c;
 	
-	uint16_t i;
+	/* rest of the packet in one read: the per-byte call overhead is what limits speed */
+	uint16_t i = 1 + __ym_getpacket(rxdata + 1, rx_packet_size + YM_PACKET_OVERHEAD - 1, timeout_ms);
   
-	for (i = 1; i < (rx_packet_size + YM_PACKET_OVERHEAD); i++)
+	if (i < (rx_packet_size + YM_PACKET_OVERHEAD))
 	{
-		c = __ym_getchar(timeout_ms);
-		
-		if (c < 0)
-		{
-			/* end of stream */
-				//sprintf(global_string_buff1, "%s %d: end of stream; i=%lu, c=%lu, rxdata='%s'", __func__, __LINE__, i, c, rxdata);
-				sprintf(global_string_buff1, "%s %d: end of stream; i=%u, c=%i", __func__, __LINE__, i, c);
-				Buffer_NewMessage(global_string_buff1);
-				General_DelayTicks(200);  
-			return -1;
-		}
-		
-		/* store data RXed */
-		rxdata[i] = (uint8_t)c;
+		/* end of stream */
+		TRACE((TRACE_YM_SHORT_PACKET, 0, i));
+		return -1;
 	}
 
-	//sprintf(global_string_buff1, "%s %d: packet read; i=%lu, rxdata='%s'", __func__, __LINE__, i, rxdata);
-	sprintf(global_string_buff1, "%s %d: packet read; i=%u", __func__, __LINE__, i);
-	Buffer_NewMessage(global_string_buff1);
-	General_DelayTicks(1000);   
-
 	// just a sanity check on the sequence number/complement value. caller should check for in-order arrival.
 	uint8_t seq_nbr = (rxdata[YM_PACKET_SEQNO_INDEX] & 0xff);
 	uint8_t seq_cmp = ((rxdata[YM_PACKET_SEQNO_COMP_INDEX] ^ 0xff) & 0xff);
@@ -286,42 +302,34 @@ static int16_t ym_rx_packet(uint8_t *rxdata,
 	if (seq_nbr != seq_cmp)
 	{
 		/* seq nbr error */
-			sprintf(global_string_buff1, "%s %d: seq nbr error (%x, %x)", __func__, __LINE__, seq_nbr, seq_cmp);
-			Buffer_NewMessage(global_string_buff1);
-		//return 1;
+		TRACE((TRACE_YM_SEQ_ERROR, seq_nbr, seq_cmp));
+		return -1;
 	}
   
-	/* check CRC16 match */
+	/* check CRC16 match. running the CRC over the data and its CRC trailer gives 0 when they agree */
 	uint16_t crc16_val = ym_crc16((const unsigned char *)(rxdata + YM_PACKET_HEADER), rx_packet_size + YM_PACKET_TRAILER);
 
-// 	if (crc16_val)
-// 	{
-// 		/* CRC error, non zero */
-// 			//sprintf(global_string_buff1, "%s %d: CRC error, non zero; rxdata='%s'", __func__, __LINE__, rxdata);
-// 			sprintf(global_string_buff1, "%s %d: CRC error, non zero", __func__, __LINE__);
-// 			Buffer_NewMessage(global_string_buff1);
-// 		return 1;
-// 	}
+	if (crc16_val)
+	{
+		/* CRC error, non zero */
+		TRACE((TRACE_YM_CRC_ERROR, seq_nbr, crc16_val));
+		return -1;
+	}
 
 	*rxlen = rx_packet_size;
 	/* success */
-		//sprintf(global_string_buff1, "%s %d: success; rxdata='%s'", __func__, __LINE__, rxdata);
-		sprintf(global_string_buff1, "%s %d: success", __func__, __LINE__);
-		Buffer_NewMessage(global_string_buff1);
+	TRACE((TRACE_YM_PACKET, seq_nbr, rx_packet_size));
 	return 0;
 }
 
 /* ------------------------------------------------- */
 /**
- * Receive a file using the ymodem protocol
- * @param rxdata Pointer to the first byte
- * @param rxlen  Max in length
- * @return The length of the file received, or 0 on error
+ * Receive files using the ymodem protocol, handing each one to callbacks
+ * @param cb        Called for each file header, data block, and end of file
+ * @param streaming true for YMODEM-G: the sender does not wait for ACKs, so any bad block aborts the transfer
+ * @return The number of bytes received, or 0 on error
  */
-int32_t fymodem_receive(uint8_t *rxdata,
-                        size_t rxlen,
-                        char** fname_ptp
-                        )
+int32_t fymodem_receive_cb(const fymodem_rx_callbacks *cb, bool streaming)
 {
 	/* alloc 1k on stack, ok? */
 	uint8_t rx_packet_data[YM_PACKET_1K_SIZE + YM_PACKET_OVERHEAD];
@@ -329,20 +337,27 @@ int32_t fymodem_receive(uint8_t *rxdata,
 	
 	uint8_t filesize_asc[YM_FILE_SIZE_LENGTH];
 	uint32_t filesize = 0;
+	uint32_t bytes_left = 0;
+	int32_t bytes_total = 0;
 
-	//char filename[FYMODEM_FILE_NAME_MAX_LENGTH];
+	char filename[FYMODEM_FILE_NAME_MAX_LENGTH + 1];
 	
 	bool first_try = true;
 	bool session_done = false;
 	
 	uint32_t nbr_errors = 0;
+	uint16_t files_rxed = 0;
 
-	sprintf(global_string_buff1, "%s %d: starting...", __func__, __LINE__);
-	Buffer_NewMessage(global_string_buff1);
+	/* MB: YMODEM-G is for error-correcting links. the only ACK is for EOT; blocks arrive back to back,
+	       as fast as the sender can send them, and RTS back-pressure holds it off while a block goes to disk.
+	       a block can't be asked for again, so one bad block ends the transfer. */
+	uint8_t start_char = streaming ? YM_G : YM_CRC;
+
+	TRACE_RESET();
+	TRACE((TRACE_YM_START, 0, 0));
 
 	/* z-term string */
-	//filename[0] = 0;
-	*(fname_ptp)[0] = 0;
+	filename[0] = 0;
   
 	/* receive files */
 	do
@@ -351,7 +366,7 @@ int32_t fymodem_receive(uint8_t *rxdata,
 		if (first_try) 
 		{
 		  /* initiate transfer */
-		  __ym_putchar(YM_CRC);
+		  __ym_putchar(start_char);
 		}
 		first_try = false;
 	
@@ -359,11 +374,14 @@ int32_t fymodem_receive(uint8_t *rxdata,
 		bool file_done = false;
 		uint32_t packets_rxed = 0;
 	
-		/* set start position of rxing data */
-		uint8_t *rxptr = rxdata;
-		
 		do
 		{ /* ! file_done */
+			/* MB: ESC cancels. checked once per block, or once a second while nothing is arriving */
+			if (__ym_cancelled())
+			{
+				goto rx_err_handler;
+			}
+			
 			/* receive packets */
 			int16_t res = ym_rx_packet(rx_packet_data,  &rx_packet_len,  packets_rxed, YM_PACKET_RX_TIMEOUT_MS);
 			
@@ -378,11 +396,10 @@ int32_t fymodem_receive(uint8_t *rxdata,
 					{
 						case -1:
 						{
-							/* aborted by sender */
+							/* aborted by sender. MB: close the file, as rx_err_handler does, so what has arrived is written out */
 							__ym_putchar(YM_ACK);
-							//sprintf(global_string_buff1, "%s %d: aborted by sender. data='%s'", __func__, __LINE__, rx_packet_data);
-							sprintf(global_string_buff1, "%s %d: aborted by sender.", __func__, __LINE__);
-							Buffer_NewMessage(global_string_buff1);
+							TRACE((TRACE_YM_SENDER_ABORT, 0, 0));
+							cb->close();
 							return 0;						
 						}
 	
@@ -390,30 +407,42 @@ int32_t fymodem_receive(uint8_t *rxdata,
 						{
 							/* EOT - End Of Transmission */
 							__ym_putchar(YM_ACK);
+							if (!cb->close()) {
+								YM_ERR("YM: could not close '%s'\n", filename);
+								goto rx_err_handler;
+							}
 							/* TODO: Add some sort of sanity check on the number of
 							packets received and the advertised file length. */
 							file_done = true;
-							sprintf(global_string_buff1, "%s %d: file_done", __func__, __LINE__);
-							Buffer_NewMessage(global_string_buff1);
+							files_rxed++;
+							TRACE((TRACE_YM_FILE_DONE, 0, packets_rxed));
 							/* resend CRC to re-initiate transfer */
-							__ym_putchar(YM_CRC);
+							__ym_putchar(start_char);
 							break;						
 						}
 	
 						default: 
 						{
 							/* normal packet, check seq nbr */
-							//sprintf(global_string_buff1, "%s %d: normal packet, check seq nbr. data='%s'", __func__, __LINE__, rx_packet_data);
-							sprintf(global_string_buff1, "%s %d: normal packet, check seq nbr.", __func__, __LINE__);
-							Buffer_NewMessage(global_string_buff1);
 
 							uint8_t seq_nbr = rx_packet_data[YM_PACKET_SEQNO_INDEX];
 							
-							if (seq_nbr != (packets_rxed & 0xff)) 
+							if (streaming && seq_nbr != (packets_rxed & 0xff))
+							{
+								/* a YMODEM-G sender never repeats a block: a missing one can't be got back */
+								YM_ERR("YM: block %u out of order - ABORT.\n", (unsigned int)seq_nbr);
+								goto rx_err_handler;
+							}
+							else if (packets_rxed > 0 && seq_nbr == ((packets_rxed - 1) & 0xff))
+							{
+								/* repeat of the last block: our ACK was lost. ACK it again, don't store it twice */
+								TRACE((TRACE_YM_DUPLICATE, seq_nbr, packets_rxed));
+								__ym_putchar(YM_ACK);
+							}
+							else if (seq_nbr != (packets_rxed & 0xff)) 
 							{
 								/* wrong seq number */
-								sprintf(global_string_buff1, "%s %d: wrong seq number: %d vs %d", __func__, __LINE__, seq_nbr, packets_rxed & 0xff);
-								Buffer_NewMessage(global_string_buff1);
+								TRACE((TRACE_YM_WRONG_SEQ, seq_nbr, packets_rxed));
 								__ym_putchar(YM_NAK);
 							} 
 							else
@@ -443,10 +472,10 @@ int32_t fymodem_receive(uint8_t *rxdata,
 										
 										while ((*file_ptr != '\0') && (i < FYMODEM_FILE_NAME_MAX_LENGTH))
 										{
-											*(fname_ptp)[i++] = *file_ptr++;
+											filename[i++] = *file_ptr++;
 										}
 										
-										*(fname_ptp)[i++] = '\0';
+										filename[i++] = '\0';
 										/* skip null term char */
 										file_ptr++;
 										/* read file size */
@@ -461,16 +490,24 @@ int32_t fymodem_receive(uint8_t *rxdata,
 										/* convert file size */
 										ym_readU32(filesize_asc, &filesize);
 										
-										/* check file size */
-										if (filesize > rxlen)
+										bytes_left = filesize;
+										
+										/* let the caller open the file (and check it has room for it) */
+										if (!cb->open(filename, filesize))
 										{
-											YM_ERR("YM: RX buffer too small (0x%08x vs 0x%08x)\n", (unsigned int)rxlen, (unsigned int)filesize);
+											YM_ERR("YM: could not open '%s' (%lu bytes)\n", filename, (unsigned long)filesize);
 											goto rx_err_handler;
-											sprintf(global_string_buff1, "%s %d: RX buffer too small (0x%08x vs 0x%08x)", __func__, __LINE__, (unsigned int)rxlen, (unsigned int)filesize);
-											Buffer_NewMessage(global_string_buff1);
 										}
-										__ym_putchar(YM_ACK);
-										__ym_putchar(crc_nak ? YM_CRC : YM_NAK);
+										if (streaming)
+										{
+											/* no ACK in YMODEM-G: G starts the file */
+											__ym_putchar(YM_G);
+										}
+										else
+										{
+											__ym_putchar(YM_ACK);
+											__ym_putchar(crc_nak ? YM_CRC : YM_NAK);
+										}
 										crc_nak = false;
 									}
 									else
@@ -484,29 +521,29 @@ int32_t fymodem_receive(uint8_t *rxdata,
 								}
 								else
 								{
-									/* This shouldn't happen, but we check anyway in case the
-									sender sent wrong info in its filename packet */
-
-									sprintf(global_string_buff1, "%s %d: sender sent wrong info in its filename packet?", __func__, __LINE__);
-									Buffer_NewMessage(global_string_buff1);
-								
-									if (((rxptr + rx_packet_len) - rxdata) > (int32_t)rxlen)
+									/* data block, in order. the last block is padded out with ^Z: only keep what the header said
+									   the file has, which also drops any blocks a sender sends past that size.
+									   a sender that didn't give a size gets every block whole. */
+									if (filesize > 0 && (uint32_t)rx_packet_len > bytes_left)
 									{
-										YM_ERR("YM: RX buffer overflow (exceeded 0x%08x)\n", (unsigned int)rxlen);
-											sprintf(global_string_buff1, "%s %d: RX buffer overflow (exceeded 0x%08x)", __func__, __LINE__, (unsigned int)rxlen);
-											Buffer_NewMessage(global_string_buff1);
-										goto rx_err_handler;
+										rx_packet_len = (int16_t)bytes_left;
 									}
 									
-									int32_t i;
+									bytes_left -= rx_packet_len;
+									bytes_total += rx_packet_len;
 									
-									for (i = 0; i < rx_packet_len; i++)
+									/* ACK before storing the block: the sender transmits the next block into the
+									   UART buffer while the caller is busy writing this one to disk */
+									if (!streaming)
 									{
-										rxptr[i] = rx_packet_data[YM_PACKET_HEADER + i];
+										__ym_putchar(YM_ACK);
 									}
 									
-									rxptr += rx_packet_len;
-									__ym_putchar(YM_ACK);
+									if (rx_packet_len > 0 && !cb->write(rx_packet_data + YM_PACKET_HEADER, (uint16_t)rx_packet_len))
+									{
+										YM_ERR("YM: could not write '%s'\n", filename);
+										goto rx_err_handler;
+									}
 								}
 								packets_rxed++;
 							}  /* sequence number check ok */
@@ -519,13 +556,18 @@ int32_t fymodem_receive(uint8_t *rxdata,
 				default:
 				{
 					/* ym_rx_packet() returned error */
-							//sprintf(global_string_buff1, "%s %d: ym_rx_packet() returned error. data='%s'", __func__, __LINE__, rx_packet_data);
-							sprintf(global_string_buff1, "%s %d: ym_rx_packet() returned error (res=%d)", __func__, __LINE__, res);
-							Buffer_NewMessage(global_string_buff1);
-							
+					TRACE((TRACE_YM_RX_ERROR, res, nbr_errors));
+					
 					if (packets_rxed > 0)
 					{
+						if (streaming)
+						{
+							YM_ERR("YM: block %u bad - ABORT.\n", (unsigned int)(packets_rxed & 0xff));
+							goto rx_err_handler;
+						}
+						
 						nbr_errors++;
+						Progress_AddError();
 						
 						if (nbr_errors >= YM_PACKET_ERROR_MAX_NBR)
 						{
@@ -533,7 +575,29 @@ int32_t fymodem_receive(uint8_t *rxdata,
 							goto rx_err_handler;
 						}
 					}
-					__ym_putchar(YM_CRC);
+					else if (++nbr_errors >= YM_START_ERROR_MAX_NBR)
+					{
+						/* MB: no header block, so don't ask forever. after a file, the sender has skipped (or we lost)
+						       the empty block that ends the batch, and what we have is complete. before one, there is no sender. */
+						if (files_rxed > 0)
+						{
+							file_done = true;
+							session_done = true;
+							break;
+						}
+						
+						YM_ERR("YM: no header block in %u tries - ABORT.\n", (unsigned int)nbr_errors);
+						goto rx_err_handler;
+					}
+					/* MB: a bad start byte means the rest of the block is still coming: wait for it to finish, or the
+					       NAK crosses it and every byte of it counts as another bad start */
+					if (res == -2)
+					{
+						(void)__ym_getpacket(rx_packet_data, sizeof(rx_packet_data), YM_PURGE_TIMEOUT_MS);
+					}
+					
+					/* 'C' (or 'G') asks for the header block again. after that, a bad block gets a NAK */
+					__ym_putchar(packets_rxed == 0 ? start_char : YM_NAK);
 					break;
 				} /* default */
 			} /* switch */
@@ -545,41 +609,89 @@ int32_t fymodem_receive(uint8_t *rxdata,
 	} while (! session_done);
 
   /* return bytes received */
-  return filesize;
+  return bytes_total;
 
 rx_err_handler:
 	__ym_putchar(YM_CAN);
 	__ym_putchar(YM_CAN);
+	cb->close();
 	__ym_sleep_ms(1000);
-	sprintf(global_string_buff1, "%s %d: error", __func__, __LINE__);
-	Buffer_NewMessage(global_string_buff1);
+	/* a YMODEM-G sender can have most of a block in flight when it sees the CANs */
+	__ym_flush();
 	return 0;
 }
 
-/* ------------------------------------ */
-static void ym_send_packet(uint8_t *txdata,
-                           int32_t block_nbr)
-{
-  int32_t tx_packet_size;
+/* ------------------------------------------------- */
+/* fymodem_receive(): callbacks that store the file in one caller-provided RAM buffer */
+static uint8_t *ym_ram_rxdata;
+static uint8_t *ym_ram_rxptr;
+static size_t ym_ram_rxlen;
+static char *ym_ram_fname;
 
-  /* We use a short packet for block 0, all others are 1K */
-  if (block_nbr == 0) {
-    tx_packet_size = YM_PACKET_SIZE;
+static bool ym_ram_open(const char *filename, uint32_t filesize)
+{
+  if (filesize > ym_ram_rxlen) {
+    YM_ERR("YM: RX buffer too small (0x%08x vs 0x%08x)\n", (unsigned int)ym_ram_rxlen, (unsigned int)filesize);
+    return false;
   }
-  else {
-    tx_packet_size = YM_PACKET_1K_SIZE;
+  strncpy(ym_ram_fname, filename, FYMODEM_FILE_NAME_MAX_LENGTH);
+  ym_ram_rxptr = ym_ram_rxdata;
+  return true;
+}
+
+static bool ym_ram_write(const uint8_t *data, uint16_t len)
+{
+  if (((ym_ram_rxptr + len) - ym_ram_rxdata) > (int32_t)ym_ram_rxlen) {
+    YM_ERR("YM: RX buffer overflow (exceeded 0x%08x)\n", (unsigned int)ym_ram_rxlen);
+    return false;
   }
+  memcpy(ym_ram_rxptr, data, len);
+  ym_ram_rxptr += len;
+  return true;
+}
 
+static bool ym_ram_close(void)
+{
+  return true;
+}
+
+/**
+ * Receive a file using the ymodem protocol
+ * @param rxdata Pointer to the first byte
+ * @param rxlen  Max in length
+ * @return The length of the file received, or 0 on error
+ */
+int32_t fymodem_receive(uint8_t *rxdata,
+                        size_t rxlen,
+                        char** fname_ptp
+                        )
+{
+  static const fymodem_rx_callbacks ram_callbacks = { ym_ram_open, ym_ram_write, ym_ram_close };
+
+  ym_ram_rxdata = rxdata;
+  ym_ram_rxlen = rxlen;
+  ym_ram_fname = *fname_ptp;
+  ym_ram_fname[0] = 0;
+
+  return fymodem_receive_cb(&ram_callbacks, false);
+}
+
+/* ------------------------------------ */
+/* queue one block for the UART. tx_packet_size is YM_PACKET_SIZE (SOH) or YM_PACKET_1K_SIZE (STX); txdata must be padded to it */
+static void ym_send_packet(const uint8_t *txdata,
+                           uint8_t block_nbr,
+                           uint16_t tx_packet_size)
+{
   uint16_t crc16_val = ym_crc16(txdata, tx_packet_size);
   
   /* For 128 byte packets use SOH, for 1K use STX */
-  __ym_putchar( (block_nbr == 0) ? YM_SOH : YM_STX );
+  __ym_putchar( (tx_packet_size == YM_PACKET_SIZE) ? YM_SOH : YM_STX );
   /* write seq numbers */
-  __ym_putchar(block_nbr & 0xFF);
+  __ym_putchar(block_nbr);
   __ym_putchar(~block_nbr & 0xFF);
   
   /* write txdata */
-  int32_t i;
+  uint16_t i;
   for (i = 0; i < tx_packet_size; i++) {
     __ym_putchar(txdata[i]);
   }
@@ -590,13 +702,12 @@ static void ym_send_packet(uint8_t *txdata,
 }
 
 /* ----------------------------------------------- */
-/* Send block 0 (the filename block), filename might be truncated to fit. */
-static void ym_send_packet0(const char* filename,
-                            int32_t filesize)
+/* Build block 0 (the filename block), filename might be truncated to fit. no filename builds the empty block that ends a batch. */
+static void ym_build_packet0(uint8_t *block,
+                             const char* filename,
+                             int32_t filesize)
 {
   int32_t pos = 0;
-  /* put 256byte on stack, ok? reuse other stack mem? */
-  uint8_t block[YM_PACKET_SIZE];
   if (filename) {
     /* write filename */
     while (*filename && (pos < YM_PACKET_SIZE - YM_FILE_SIZE_LENGTH - 2)) {
@@ -613,116 +724,318 @@ static void ym_send_packet0(const char* filename,
   while (pos < YM_PACKET_SIZE) {
     block[pos++] = 0;
   }
-  
-  /* send header block */
-  ym_send_packet(block, 0);
 }
 
 /* ------------------------------------------------- */
-static void ym_send_data_packets(uint8_t* txdata,
-                                 uint32_t txlen,
-                                 uint32_t timeout_ms)
+/* wait for the receiver's answer to a block: YM_ACK, YM_NAK, YM_CRC, YM_CAN (only for two in a row), or -1 on timeout.
+   anything else is line noise, or the tail of whatever the receiver printed before it started. */
+static int32_t ym_tx_response(uint32_t timeout_ms)
 {
-  int32_t block_nbr = 1;
-  
-  while (txlen > 0) {
-    /* check if send full 1k packet */
-    uint32_t send_size;
-    if (txlen > YM_PACKET_1K_SIZE) {
-      send_size = YM_PACKET_1K_SIZE;
-    } else {
-      send_size = txlen;
-    }
-    /* send packet */
-    ym_send_packet(txdata, block_nbr);
-    int32_t c = __ym_getchar(timeout_ms);
-    switch (c) {
-    case YM_ACK: {
-      txdata += send_size;
-      txlen  -= send_size;
-      block_nbr++;
-      break;
-    }
-    case -1:
-    case YM_CAN: {
-      return;
-    }
-    default:
-      break;
-    }
-  }
-  
-  int32_t ch;
-  do {
-    __ym_putchar(YM_EOT);
-    ch = __ym_getchar(timeout_ms);
-  } while ((ch != YM_ACK) && (ch != -1));
-  
-  /* send last data packet */
-  if (ch == YM_ACK) {
-    ch = __ym_getchar(timeout_ms);
-    if (ch == YM_CRC) {
-      do {
-        ym_send_packet0(0, 0);
-        ch = __ym_getchar(timeout_ms);
-      } while ((ch != YM_ACK) && (ch != -1));
-    }
-  }
+	int32_t ch;
+	bool got_can = false;
+	
+	/* MB: the block may still be going out: don't start the clock on the receiver until the UART is done with it */
+	__ym_txwait();
+
+	for (;;)
+	{
+		ch = __ym_getchar(timeout_ms);
+		
+		if (ch == YM_CAN)
+		{
+			if (got_can)
+			{
+				return YM_CAN;
+			}
+			got_can = true;
+			continue;
+		}
+		
+		if (ch == YM_ACK || ch == YM_NAK || ch == YM_CRC || ch < 0)
+		{
+			return ch;
+		}
+		
+		got_can = false;
+	}
 }
 
-/* ------------------------------------------------------- */
-int32_t fymodem_send(uint8_t* txdata, size_t txsize, const char* filename)
+/* ------------------------------------------------- */
+/* wait until the receiver ACKs a block, sending it again as needed. returns false if the receiver cancelled or it never got through.
+   the block must already have been queued with ym_send_packet(): the caller may have had other work to do while it went out */
+static bool ym_tx_block(const uint8_t *txdata, uint8_t block_nbr, uint16_t tx_packet_size)
 {
-  /* flush the RX FIFO, after a cool off delay */
-  __ym_sleep_ms(1000);
-  __ym_flush();
-  (void)__ym_getchar(1000);
+	uint8_t nbr_errors = 0;
+	int32_t ch;
+	
+	for (;;)
+	{
+		ch = ym_tx_response(YM_TX_ACK_TIMEOUT_MS);
+		
+		if (ch == YM_ACK)
+		{
+			return true;
+		}
+		
+		if (ch == YM_CAN)
+		{
+			YM_ERR("YM: receiver cancelled at block %u\n", (unsigned int)block_nbr);
+			return false;
+		}
+		
+		/* NAK, timeout, or a 'C' from a receiver that never saw it: send it again */
+		if (++nbr_errors >= YM_PACKET_ERROR_MAX_NBR)
+		{
+			YM_ERR("YM: block %u not acknowledged - ABORT.\n", (unsigned int)block_nbr);
+			return false;
+		}
+		
+		if (ch < 0)
+		{
+			Progress_AddError();
+		}
+		
+		TRACE((TRACE_YM_TX_RESEND, block_nbr, (uint16_t)ch));
+		Progress_AddRetry();
+		ym_send_packet(txdata, block_nbr, tx_packet_size);
+	}
+}
 
-  /* not in the specs, send CRC here just for balance */
-  int32_t ch;
-  do {
-    __ym_putchar(YM_CRC);
-    ch = __ym_getchar(1000);
-  } while (ch < 0);
-  
-  /* we do require transfer with CRC */
-  if (ch != YM_CRC) {
-    goto tx_err_handler;
-  }
+/* ------------------------------------------------- */
+/* send EOT until the receiver ACKs it. some receivers NAK the first EOT, to be sure it wasn't noise */
+static bool ym_tx_eot(void)
+{
+	uint8_t nbr_errors = 0;
+	int32_t ch;
+	
+	do
+	{
+		__ym_putchar(YM_EOT);
+		ch = ym_tx_response(YM_PACKET_RX_TIMEOUT_MS);
+		
+		if (ch == YM_ACK)
+		{
+			return true;
+		}
+	} while (ch != YM_CAN && ++nbr_errors < YM_PACKET_ERROR_MAX_NBR);
+	
+	return false;
+}
 
-  bool crc_nak = true;
-  bool file_done = false;
-  do {
-    ym_send_packet0(filename, txsize);
-    /* When the receiving program receives this block and successfully
-       opened the output file, it shall acknowledge this block with an ACK
-       character and then proceed with a normal XMODEM file transfer
-       beginning with a "C" or NAK tranmsitted by the receiver. */
-    ch = __ym_getchar(YM_PACKET_RX_TIMEOUT_MS);
-    if (ch == YM_ACK) {
-      ch = __ym_getchar(YM_PACKET_RX_TIMEOUT_MS);
-      if (ch == YM_CRC) {
-        ym_send_data_packets(txdata, txsize, YM_PACKET_RX_TIMEOUT_MS);
-        /* success */
-        file_done = true;
-      }
-    }
-    else if ((ch == YM_CRC) && (crc_nak)) {
-      crc_nak = false;
-      continue;
-    }
-    else if ((ch != YM_NAK) || (crc_nak)) {
-      goto tx_err_handler;
-    }
-  } while (! file_done);
+/* ------------------------------------------------- */
+/* wait for the receiver to ask for the next block 0 (or the first data block) with 'C' */
+static bool ym_tx_wait_for_crc(uint32_t timeout_ms)
+{
+	int32_t ch;
+	
+	do
+	{
+		ch = ym_tx_response(timeout_ms);
+	} while (ch == YM_ACK);
+	
+	if (ch == YM_NAK)
+	{
+		YM_ERR("YM: receiver sent %s: checksum mode not supported\n", "NAK");
+	}
+	
+	return (ch == YM_CRC);
+}
+
+/**
+ * Send files using the ymodem (or xmodem-1k) protocol, reading each one through callbacks
+ * @param cb     Called for the name and size of each file, to read its data, and when it is done
+ * @param xmodem true for XMODEM-1K: no block 0, and only the first file is sent
+ * @return The number of bytes sent, or -1 on error
+ */
+int32_t fymodem_send_cb(const fymodem_tx_callbacks *cb, bool xmodem)
+{
+	/* MB: two 1K blocks: the one going out (and kept until ACKed, in case it must be sent again), and the next one.
+	       the UART interrupt sends a queued block on its own, so the next block is read from disk during that time,
+	       instead of between the ACK and the next block. */
+	static uint8_t tx_blocks[2][YM_PACKET_1K_SIZE];
+	uint8_t *tx_block = tx_blocks[0];
+	uint8_t *next_block = tx_blocks[1];
+	uint8_t *swap_block;
+	int16_t tx_len;
+	int16_t next_len;
+	uint16_t tx_packet_size;
+	uint8_t block_nbr;
+
+	char filename[FYMODEM_FILE_NAME_MAX_LENGTH + 1];
+	uint32_t filesize;
+	int32_t bytes_total = 0;
+	bool file_open = false;
+
+	TRACE_RESET();
+	TRACE((TRACE_YM_TX_START, (uint8_t)xmodem, 0));
+
+	__ym_flush();
+
+	/* the receiver starts everything off with 'C' */
+	if (!ym_tx_wait_for_crc(YM_TX_START_TIMEOUT_MS))
+	{
+		YM_ERR("YM: no 'C' from receiver in %u seconds\n", (unsigned int)(YM_TX_START_TIMEOUT_MS / 1000));
+		goto tx_err_handler;
+	}
+
+	while (cb->next_file(filename, &filesize))
+	{
+		file_open = true;
+		TRACE((TRACE_YM_TX_FILE, 0, (uint16_t)filesize));
+
+		if (!xmodem)
+		{
+			/* block 0 carries the name and size. once the receiver has the file open, it ACKs, then asks for data with 'C' */
+			ym_build_packet0(tx_block, filename, filesize);
+			ym_send_packet(tx_block, 0, YM_PACKET_SIZE);
+
+			if (!ym_tx_block(tx_block, 0, YM_PACKET_SIZE) || !ym_tx_wait_for_crc(YM_TX_ACK_TIMEOUT_MS))
+			{
+				goto tx_err_handler;
+			}
+		}
+
+		block_nbr = 1;
+		next_len = cb->read(next_block, YM_PACKET_1K_SIZE);
+
+		while (next_len > 0)
+		{
+			swap_block = tx_block;
+			tx_block = next_block;
+			next_block = swap_block;
+			tx_len = next_len;
 
-  return txsize;
+			/* a short last block goes as 128 bytes if it fits. either way, pad it with CP/M EOF */
+			tx_packet_size = (tx_len <= YM_PACKET_SIZE) ? YM_PACKET_SIZE : YM_PACKET_1K_SIZE;
+			memset(tx_block + tx_len, YM_CPMEOF, tx_packet_size - tx_len);
+
+			ym_send_packet(tx_block, block_nbr, tx_packet_size);
+
+			/* read ahead while the UART sends */
+			next_len = cb->read(next_block, YM_PACKET_1K_SIZE);
+
+			if (next_len < 0)
+			{
+				YM_ERR("YM: could not read '%s'\n", filename);
+				goto tx_err_handler;
+			}
+
+			if (!ym_tx_block(tx_block, block_nbr, tx_packet_size))
+			{
+				goto tx_cancelled;
+			}
+
+			bytes_total += tx_len;
+			block_nbr++;
+		}
+
+		if (next_len < 0)
+		{
+			YM_ERR("YM: could not read '%s'\n", filename);
+			goto tx_err_handler;
+		}
+
+		if (!ym_tx_eot())
+		{
+			YM_ERR("YM: EOT for '%s' not acknowledged\n", filename);
+			goto tx_cancelled;
+		}
+
+		file_open = false;
+		TRACE((TRACE_YM_FILE_DONE, 0, block_nbr));
+
+		if (!cb->close())
+		{
+			goto tx_err_handler;
+		}
+
+		if (xmodem)
+		{
+			return bytes_total;
+		}
+
+		/* the receiver asks for the next block 0 */
+		if (!ym_tx_wait_for_crc(YM_TX_ACK_TIMEOUT_MS))
+		{
+			goto tx_err_handler;
+		}
+	}
+
+	if (!xmodem)
+	{
+		/* an empty block 0 ends the batch */
+		ym_build_packet0(tx_block, 0, 0);
+		ym_send_packet(tx_block, 0, YM_PACKET_SIZE);
+
+		if (!ym_tx_block(tx_block, 0, YM_PACKET_SIZE))
+		{
+			goto tx_cancelled;
+		}
+	}
+
+	return bytes_total;
 
  tx_err_handler:
-  __ym_putchar(YM_CAN);
-  __ym_putchar(YM_CAN);
-  __ym_sleep_ms(1000);
-  return 0;
+	__ym_putchar(YM_CAN);
+	__ym_putchar(YM_CAN);
+	__ym_txwait();
+
+ tx_cancelled:
+	if (file_open)
+	{
+		cb->close();
+	}
+	TRACE((TRACE_YM_TX_ABORT, 0, bytes_total));
+	return -1;
+}
+
+/* ------------------------------------------------- */
+/* fymodem_send(): callbacks that send one file from a caller-provided RAM buffer */
+static const uint8_t *ym_ram_txptr;
+static size_t ym_ram_txlen;
+static const char *ym_ram_tx_fname;
+
+static bool ym_ram_next_file(char *filename, uint32_t *filesize)
+{
+  if (ym_ram_tx_fname == NULL) {
+    return false;
+  }
+  strncpy(filename, ym_ram_tx_fname, FYMODEM_FILE_NAME_MAX_LENGTH);
+  filename[FYMODEM_FILE_NAME_MAX_LENGTH] = 0;
+  *filesize = ym_ram_txlen;
+  ym_ram_tx_fname = NULL;
+  return true;
+}
+
+static int16_t ym_ram_read(uint8_t *buf, uint16_t len)
+{
+  if (len > ym_ram_txlen) {
+    len = ym_ram_txlen;
+  }
+  memcpy(buf, ym_ram_txptr, len);
+  ym_ram_txptr += len;
+  ym_ram_txlen -= len;
+  return len;
+}
+
+/**
+ * Send a file using the ymodem protocol
+ * @param txdata   Pointer to the first byte
+ * @param txsize   Length of the file
+ * @param filename Name to send in block 0
+ * @return The length of the file sent, or 0 on error
+ */
+int32_t fymodem_send(uint8_t* txdata, size_t txsize, const char* filename)
+{
+  static const fymodem_tx_callbacks ram_callbacks = { ym_ram_next_file, ym_ram_read, ym_ram_close };
+  int32_t res;
+
+  ym_ram_txptr = txdata;
+  ym_ram_txlen = txsize;
+  ym_ram_tx_fname = filename;
+
+  res = fymodem_send_cb(&ram_callbacks, false);
+  return (res < 0) ? 0 : res;
 }
 
 /* ------------------------------------ */
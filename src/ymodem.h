@@ -28,6 +28,26 @@
 /* max length of filename */
 #define FYMODEM_FILE_NAME_MAX_LENGTH  (64)
 
+/* receive callbacks, for storing files somewhere other than one RAM buffer (eg, straight to disk) */
+typedef struct fymodem_rx_callbacks {
+  bool (*open)(const char *filename, uint32_t filesize);  /* file header received. return false to refuse the file */
+  bool (*write)(const uint8_t *data, uint16_t len);       /* data block received and ACKed (if not YMODEM-G). return false to abort */
+  bool (*close)(void);                                    /* end of file, or transfer aborted */
+} fymodem_rx_callbacks;
+
+/* send callbacks, for sending files from somewhere other than one RAM buffer (eg, straight from disk) */
+typedef struct fymodem_tx_callbacks {
+  bool (*next_file)(char *filename, uint32_t *filesize);  /* fill in the next file to send (filename holds FYMODEM_FILE_NAME_MAX_LENGTH + 1). return false when there are no more */
+  int16_t (*read)(uint8_t *buf, uint16_t len);            /* read up to len bytes of the current file. returns bytes read, 0 at end of file, or -1 on error */
+  bool (*close)(void);                                    /* file sent, or transfer aborted */
+} fymodem_tx_callbacks;
+
+/* crc16-ccitt lookup table (xmodem flavor), shared with the zmodem receiver */
+extern const uint16_t ym_crc16_table[256];
+
+/* receive files over ymodem, handing each one to callbacks. streaming selects YMODEM-G */
+int32_t fymodem_receive_cb(const fymodem_rx_callbacks *cb, bool streaming);
+
 /* receive file over ymodem */
 // int32_t fymodem_receive(uint8_t *rxdata,
 //                         size_t rxsize,
@@ -36,6 +56,9 @@ int32_t fymodem_receive(uint8_t *rxdata,
                         size_t rxsize,
                         char** fname_ptp);
 
+/* send files over ymodem, reading each one through callbacks. xmodem selects XMODEM-1K: one file, no block 0 */
+int32_t fymodem_send_cb(const fymodem_tx_callbacks *cb, bool xmodem);
+
 /* send file over ymodem */
 int32_t fymodem_send(uint8_t *txdata,
                      size_t txsize,
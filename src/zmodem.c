@@ -0,0 +1,930 @@
+/*
+ * zmodem.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ *
+ *  - ZMODEM receiver. same serial and file callbacks as the YMODEM receiver, see transfer.c.
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "progress.h"
+#include "serial.h"
+#include "trace.h"
+#include "transfer.h"
+#include "ymodem.h"
+#include "zmodem.h"
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// F256 includes
+#include "f256_e.h"
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+// framing
+#define ZMODEM_ZPAD				'*'		// header start: ZPAD (ZPAD) ZDLE format
+#define ZMODEM_ZDLE				0x18	// escape character. same value as CAN: 5 in a row cancels the transfer.
+#define ZMODEM_ZBIN				'A'		// binary header, CRC-16
+#define ZMODEM_ZHEX				'B'		// hex header, CRC-16
+#define ZMODEM_ZBIN32			'C'		// binary header, CRC-32
+#define ZMODEM_ZCRCE			'h'		// subpacket end: frame ends, header follows
+#define ZMODEM_ZCRCG			'i'		// subpacket end: frame continues, no response wanted
+#define ZMODEM_ZCRCQ			'j'		// subpacket end: frame continues, ZACK wanted
+#define ZMODEM_ZCRCW			'k'		// subpacket end: frame ends, ZACK wanted
+#define ZMODEM_ZRUB0			'l'		// escaped 0x7F
+#define ZMODEM_ZRUB1			'm'		// escaped 0xFF
+
+// header types
+#define ZMODEM_ZRQINIT			0
+#define ZMODEM_ZRINIT			1
+#define ZMODEM_ZSINIT			2
+#define ZMODEM_ZACK				3
+#define ZMODEM_ZFILE			4
+#define ZMODEM_ZSKIP			5
+#define ZMODEM_ZNAK				6
+#define ZMODEM_ZABORT			7
+#define ZMODEM_ZFIN				8
+#define ZMODEM_ZRPOS			9
+#define ZMODEM_ZDATA			10
+#define ZMODEM_ZEOF				11
+#define ZMODEM_ZFERR			12
+#define ZMODEM_ZCRC				13
+#define ZMODEM_ZCHALLENGE		14
+#define ZMODEM_ZCOMPL			15
+#define ZMODEM_ZCAN				16
+#define ZMODEM_ZFREECNT			17
+#define ZMODEM_ZCOMMAND			18
+
+// ZRINIT capability flags (ZF0, the last byte of the header)
+#define ZMODEM_CANFDX			0x01	// full duplex
+#define ZMODEM_CANOVIO			0x02	// can receive while writing to disk
+#define ZMODEM_CANFC32			0x20	// can use CRC-32
+#define ZMODEM_RX_FLAGS			((uint32_t)(ZMODEM_CANFDX | ZMODEM_CANOVIO | ZMODEM_CANFC32) << 24)	// buffer size 0: stream without stopping
+
+// ZFILE conversion option (ZF0)
+#define ZMODEM_ZF0				4		// index of ZF0 in zmodem_header
+#define ZMODEM_ZCRECOV			3		// sender asks to carry on an interrupted transfer (sz -r)
+
+// results from the read functions, besides byte values
+#define ZMODEM_TIMEOUT			-1		// same as Serial_GetByte()
+#define ZMODEM_BAD_FRAME		-2		// bad CRC, bad escape, or too long
+#define ZMODEM_CANCELLED		-3		// sender sent 5 CANs, or the user pressed ESC
+#define ZMODEM_FRAME_END		0x0100	// ORed with ZCRCx by ZModem_GetEscapedByte()
+
+#define ZMODEM_HEADER_LEN		5		// type + 4 bytes of position or flags
+#define ZMODEM_CRC32_RESIDUE	0xDEBB20E3	// CRC-32 over data and its own (complemented) CRC
+#define ZMODEM_CANCEL_COUNT		5
+#define ZMODEM_RX_TIMEOUT_MS	5000
+#define ZMODEM_RX_POLL_MS		1000	// check for ESC this often while waiting
+#define ZMODEM_MAX_ERRORS		10		// errors in a row before giving up
+#define ZMODEM_MAX_GARBAGE		16384	// bytes skipped looking for a header. after a ZRPOS, everything the sender had already streamed gets skipped.
+
+#define ZMODEM_XON				0x11
+#define ZMODEM_XOFF				0x13
+#define ZMODEM_CH_BS			0x08
+
+#define ZMODEM_CRC16_UPDATE(crc, c)	(((crc) << 8) ^ ym_crc16_table[(uint8_t)((crc) >> 8) ^ (c)])
+#define ZMODEM_CRC32_UPDATE(crc, c)	(zmodem_crc32_table[(uint8_t)(crc) ^ (c)] ^ ((crc) >> 8))
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+// crc-32 (poly 0xEDB88320, reflected) of every byte value
+static const uint32_t		zmodem_crc32_table[256] =
+{
+	0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f, 0xe963a535, 0x9e6495a3,
+	0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988, 0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91,
+	0x1db71064, 0x6ab020f2, 0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
+	0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9, 0xfa0f3d63, 0x8d080df5,
+	0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172, 0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b,
+	0x35b5a8fa, 0x42b2986c, 0xdbbbc9d6, 0xacbcf940, 0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
+	0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423, 0xcfba9599, 0xb8bda50f,
+	0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924, 0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d,
+	0x76dc4190, 0x01db7106, 0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
+	0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d, 0x91646c97, 0xe6635c01,
+	0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e, 0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457,
+	0x65b0d9c6, 0x12b7e950, 0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
+	0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7, 0xa4d1c46d, 0xd3d6f4fb,
+	0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0, 0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9,
+	0x5005713c, 0x270241aa, 0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
+	0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81, 0xb7bd5c3b, 0xc0ba6cad,
+	0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a, 0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683,
+	0xe3630b12, 0x94643b84, 0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
+	0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb, 0x196c3671, 0x6e6b06e7,
+	0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc, 0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5,
+	0xd6d6a3e8, 0xa1d1937e, 0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
+	0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55, 0x316e8eef, 0x4669be79,
+	0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236, 0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f,
+	0xc5ba3bbe, 0xb2bd0b28, 0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
+	0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f, 0x72076785, 0x05005713,
+	0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38, 0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21,
+	0x86d3d2d4, 0xf1d4e242, 0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
+	0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69, 0x616bffd3, 0x166ccf45,
+	0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2, 0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db,
+	0xaed16a4a, 0xd9d65adc, 0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
+	0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693, 0x54de5729, 0x23d967bf,
+	0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94, 0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d,
+};
+
+static const char			zmodem_hex_digits[] = "0123456789abcdef";
+
+static uint8_t				zmodem_header[ZMODEM_HEADER_LEN];	// last header received: type, then P0..P3 (or ZF3..ZF0)
+static bool					zmodem_crc32_mode;					// last binary header was ZBIN32: data subpackets use CRC-32 too
+static uint8_t				zmodem_data[ZMODEM_MAX_DATA + 1];	// one data subpacket. +1: ZCRCx goes after the data for the CRC.
+static uint16_t				zmodem_data_len;
+
+
+/*****************************************************************************/
+/*                       Private Function Prototypes                         */
+/*****************************************************************************/
+
+// get a raw byte, skipping XON/XOFF (the sender escapes real ones).
+// returns ZMODEM_TIMEOUT if none arrives, or ZMODEM_CANCELLED if the user pressed ESC while waiting
+int16_t ZModem_GetByte(void);
+
+// get a byte, undoing ZDLE escapes. ZCRCx comes back ORed with ZMODEM_FRAME_END.
+// returns ZMODEM_TIMEOUT, ZMODEM_BAD_FRAME, or ZMODEM_CANCELLED on error
+int16_t ZModem_GetEscapedByte(void);
+
+// get 2 hex digits as a byte. returns ZMODEM_TIMEOUT or ZMODEM_BAD_FRAME on error.
+int16_t ZModem_GetHexByte(void);
+
+// read the CRC that follows the_data, as ZDLE escaped bytes, and check it. CRC-32 if zmodem_crc32_mode.
+// returns 0 if it matches, or ZMODEM_TIMEOUT, ZMODEM_BAD_FRAME, or ZMODEM_CANCELLED
+int16_t ZModem_CheckCRC(const uint8_t* the_data, uint16_t the_len);
+
+// skip to the next header and read it into zmodem_header
+// returns the header type, or ZMODEM_TIMEOUT, ZMODEM_BAD_FRAME, or ZMODEM_CANCELLED
+int16_t ZModem_GetHeader(void);
+
+// returns the position (P0..P3) from the last header
+uint32_t ZModem_GetHeaderPosition(void);
+
+// read a data subpacket into zmodem_data
+// returns the ZCRCx that ended it, or ZMODEM_TIMEOUT, ZMODEM_BAD_FRAME, or ZMODEM_CANCELLED
+int16_t ZModem_GetData(void);
+
+// send a hex header. the_value is the position, or flags with ZF0 in the top byte.
+void ZModem_SendHexHeader(uint8_t the_type, uint32_t the_value);
+
+// check that the first the_offset bytes on disk match the sender's file, by asking it for their CRC-32 (ZCRC)
+// the_offset is set to 0 if they don't. a sender that doesn't answer is only trusted if it asked for crash recovery (ZCRECOV).
+// returns false if the transfer was cancelled
+bool ZModem_CheckResume(const ZModemCallbacks* the_callbacks, uint32_t* the_offset, bool sender_recovers);
+
+// tell the sender we are giving up: CANs to stop it, backspaces to erase them from a shell
+void ZModem_SendCancel(void);
+
+
+/*****************************************************************************/
+/*                       Private Function Definitions                        */
+/*****************************************************************************/
+
+// get a raw byte, skipping XON/XOFF (the sender escapes real ones).
+// returns ZMODEM_TIMEOUT if none arrives, or ZMODEM_CANCELLED if the user pressed ESC while waiting
+int16_t ZModem_GetByte(void)
+{
+	int16_t		the_byte;
+	uint8_t		the_polls = 0;
+	
+	while (1)
+	{
+		the_byte = Serial_GetByte(ZMODEM_RX_POLL_MS);
+		
+		if (the_byte < 0)
+		{
+			if (Transfer_CheckCancel() == true)
+			{
+				return ZMODEM_CANCELLED;
+			}
+			
+			if (++the_polls >= ZMODEM_RX_TIMEOUT_MS / ZMODEM_RX_POLL_MS)
+			{
+				return ZMODEM_TIMEOUT;
+			}
+		}
+		else if ((the_byte & 0x7F) != ZMODEM_XON && (the_byte & 0x7F) != ZMODEM_XOFF)
+		{
+			return the_byte;
+		}
+	}
+}
+
+
+// get a byte, undoing ZDLE escapes. ZCRCx comes back ORed with ZMODEM_FRAME_END.
+// returns ZMODEM_TIMEOUT, ZMODEM_BAD_FRAME, or ZMODEM_CANCELLED on error
+int16_t ZModem_GetEscapedByte(void)
+{
+	int16_t		the_byte;
+	uint8_t		can_count = 1;
+	
+	the_byte = ZModem_GetByte();
+	
+	if (the_byte != ZMODEM_ZDLE)
+	{
+		return the_byte;
+	}
+	
+	while ((the_byte = ZModem_GetByte()) == ZMODEM_ZDLE)
+	{
+		if (++can_count >= ZMODEM_CANCEL_COUNT)
+		{
+			return ZMODEM_CANCELLED;
+		}
+	}
+	
+	switch (the_byte)
+	{
+		case ZMODEM_TIMEOUT:
+			return ZMODEM_TIMEOUT;
+		
+		case ZMODEM_ZCRCE:
+		case ZMODEM_ZCRCG:
+		case ZMODEM_ZCRCQ:
+		case ZMODEM_ZCRCW:
+			return the_byte | ZMODEM_FRAME_END;
+		
+		case ZMODEM_ZRUB0:
+			return 0x7F;
+		
+		case ZMODEM_ZRUB1:
+			return 0xFF;
+		
+		default:
+			// control characters are sent as ZDLE (c ^ 0x40)
+			if ((the_byte & 0x60) == 0x40)
+			{
+				return the_byte ^ 0x40;
+			}
+			
+			return ZMODEM_BAD_FRAME;
+	}
+}
+
+
+// get 2 hex digits as a byte. returns ZMODEM_TIMEOUT or ZMODEM_BAD_FRAME on error.
+int16_t ZModem_GetHexByte(void)
+{
+	int16_t		the_byte;
+	uint8_t		the_value = 0;
+	uint8_t		i;
+	
+	for (i = 0; i < 2; i++)
+	{
+		the_byte = ZModem_GetByte();
+		
+		if (the_byte < 0)
+		{
+			return the_byte;
+		}
+		
+		the_byte &= 0x7F;
+		
+		if (the_byte >= '0' && the_byte <= '9')
+		{
+			the_byte -= '0';
+		}
+		else if (the_byte >= 'a' && the_byte <= 'f')
+		{
+			the_byte -= ('a' - 10);
+		}
+		else
+		{
+			return ZMODEM_BAD_FRAME;
+		}
+		
+		the_value = (the_value << 4) | (uint8_t)the_byte;
+	}
+	
+	return the_value;
+}
+
+
+// read the CRC that follows the_data, as ZDLE escaped bytes, and check it. CRC-32 if zmodem_crc32_mode.
+// returns 0 if it matches, or ZMODEM_TIMEOUT, ZMODEM_BAD_FRAME, or ZMODEM_CANCELLED
+int16_t ZModem_CheckCRC(const uint8_t* the_data, uint16_t the_len)
+{
+	uint32_t	crc32;
+	uint16_t	crc16;
+	int16_t		the_byte;
+	uint8_t		i;
+	
+	// LOGIC:
+	//   run the CRC on through the received CRC bytes: that leaves 0 (CRC-16) or a fixed residue (CRC-32) if they agree.
+	//   no need to assemble the received CRC, or to care about its byte order.
+	
+	if (zmodem_crc32_mode == true)
+	{
+		crc32 = 0xFFFFFFFF;
+		
+		while (the_len--)
+		{
+			crc32 = ZMODEM_CRC32_UPDATE(crc32, *the_data++);
+		}
+		
+		for (i = 0; i < 4; i++)
+		{
+			if ((the_byte = ZModem_GetEscapedByte()) < 0)
+			{
+				return the_byte;
+			}
+			
+			crc32 = ZMODEM_CRC32_UPDATE(crc32, (uint8_t)the_byte);
+		}
+		
+		return (crc32 == ZMODEM_CRC32_RESIDUE) ? 0 : ZMODEM_BAD_FRAME;
+	}
+	
+	crc16 = 0;
+	
+	while (the_len--)
+	{
+		crc16 = ZMODEM_CRC16_UPDATE(crc16, *the_data++);
+	}
+	
+	for (i = 0; i < 2; i++)
+	{
+		if ((the_byte = ZModem_GetEscapedByte()) < 0)
+		{
+			return the_byte;
+		}
+		
+		crc16 = ZMODEM_CRC16_UPDATE(crc16, (uint8_t)the_byte);
+	}
+	
+	return (crc16 == 0) ? 0 : ZMODEM_BAD_FRAME;
+}
+
+
+// skip to the next header and read it into zmodem_header
+// returns the header type, or ZMODEM_TIMEOUT, ZMODEM_BAD_FRAME, or ZMODEM_CANCELLED
+int16_t ZModem_GetHeader(void)
+{
+	int16_t		the_byte;
+	uint16_t	garbage_count = 0;
+	uint8_t		can_count = 0;
+	uint8_t		the_state = 0;	// 0: looking for ZPAD, 1: got ZPAD, 2: got ZPAD ZDLE
+	uint8_t		hex_header[ZMODEM_HEADER_LEN + 2];
+	uint16_t	crc16;
+	uint8_t		i;
+	
+	// LOGIC:
+	//   headers start ZPAD ZDLE format, or ZPAD ZPAD ZDLE format for hex. anything else is skipped:
+	//   the rest of a frame we've asked to have resent, line noise, or a BBS menu.
+	
+	while (the_state != 3)
+	{
+		if ((the_byte = ZModem_GetByte()) < 0)
+		{
+			return the_byte;
+		}
+		
+		if (the_byte != ZMODEM_ZDLE)
+		{
+			can_count = 0;
+		}
+		else if (++can_count >= ZMODEM_CANCEL_COUNT)
+		{
+			return ZMODEM_CANCELLED;
+		}
+		
+		if (the_byte == ZMODEM_ZPAD)
+		{
+			the_state = 1;
+		}
+		else if (the_byte == ZMODEM_ZDLE && the_state == 1)
+		{
+			the_state = 2;
+		}
+		else if (the_state == 2 && (the_byte == ZMODEM_ZBIN || the_byte == ZMODEM_ZHEX || the_byte == ZMODEM_ZBIN32))
+		{
+			the_state = 3;
+		}
+		else
+		{
+			the_state = 0;
+			
+			if (++garbage_count > ZMODEM_MAX_GARBAGE)
+			{
+				return ZMODEM_BAD_FRAME;
+			}
+		}
+	}
+	
+	if (the_byte == ZMODEM_ZHEX)
+	{
+		// hex headers always use CRC-16, and don't change the mode for data subpackets
+		crc16 = 0;
+		
+		for (i = 0; i < ZMODEM_HEADER_LEN + 2; i++)
+		{
+			if ((the_byte = ZModem_GetHexByte()) < 0)
+			{
+				return the_byte;
+			}
+			
+			hex_header[i] = (uint8_t)the_byte;
+			crc16 = ZMODEM_CRC16_UPDATE(crc16, hex_header[i]);
+		}
+		
+		if (crc16 != 0)
+		{
+			return ZMODEM_BAD_FRAME;
+		}
+		
+		memcpy(zmodem_header, hex_header, ZMODEM_HEADER_LEN);
+		
+		// hex headers end with CR LF
+		if (((the_byte = ZModem_GetByte()) & 0x7F) == CH_ENTER)
+		{
+			ZModem_GetByte();
+		}
+		
+		return zmodem_header[0];
+	}
+	
+	zmodem_crc32_mode = (the_byte == ZMODEM_ZBIN32);
+	
+	for (i = 0; i < ZMODEM_HEADER_LEN; i++)
+	{
+		the_byte = ZModem_GetEscapedByte();
+		
+		if (the_byte < 0)
+		{
+			return the_byte;
+		}
+		
+		if (the_byte & ZMODEM_FRAME_END)
+		{
+			return ZMODEM_BAD_FRAME;
+		}
+		
+		zmodem_header[i] = (uint8_t)the_byte;
+	}
+	
+	if ((the_byte = ZModem_CheckCRC(zmodem_header, ZMODEM_HEADER_LEN)) < 0)
+	{
+		return the_byte;
+	}
+	
+	return zmodem_header[0];
+}
+
+
+// returns the position (P0..P3) from the last header
+uint32_t ZModem_GetHeaderPosition(void)
+{
+	return (uint32_t)zmodem_header[1] | ((uint32_t)zmodem_header[2] << 8) | ((uint32_t)zmodem_header[3] << 16) | ((uint32_t)zmodem_header[4] << 24);
+}
+
+
+// read a data subpacket into zmodem_data
+// returns the ZCRCx that ended it, or ZMODEM_TIMEOUT, ZMODEM_BAD_FRAME, or ZMODEM_CANCELLED
+int16_t ZModem_GetData(void)
+{
+	int16_t		the_byte;
+	int16_t		the_result;
+	uint16_t	the_len = 0;
+	
+	while (1)
+	{
+		the_byte = ZModem_GetEscapedByte();
+		
+		if (the_byte < 0)
+		{
+			return the_byte;
+		}
+		
+		if (the_byte & ZMODEM_FRAME_END)
+		{
+			break;
+		}
+		
+		if (the_len == ZMODEM_MAX_DATA)
+		{
+			return ZMODEM_BAD_FRAME;
+		}
+		
+		zmodem_data[the_len++] = (uint8_t)the_byte;
+	}
+	
+	// the CRC covers the ZCRCx too
+	zmodem_data[the_len] = (uint8_t)the_byte;
+	zmodem_data_len = the_len;
+	
+	if ((the_result = ZModem_CheckCRC(zmodem_data, the_len + 1)) < 0)
+	{
+		return the_result;
+	}
+	
+	return the_byte & 0xFF;
+}
+
+
+// send a hex header. the_value is the position, or flags with ZF0 in the top byte.
+void ZModem_SendHexHeader(uint8_t the_type, uint32_t the_value)
+{
+	uint8_t		the_header[ZMODEM_HEADER_LEN + 2];
+	uint16_t	crc16 = 0;
+	uint8_t		i;
+	
+	the_header[0] = the_type;
+	
+	for (i = 1; i < ZMODEM_HEADER_LEN; i++)
+	{
+		the_header[i] = (uint8_t)the_value;
+		the_value >>= 8;
+	}
+	
+	for (i = 0; i < ZMODEM_HEADER_LEN; i++)
+	{
+		crc16 = ZMODEM_CRC16_UPDATE(crc16, the_header[i]);
+	}
+	
+	the_header[ZMODEM_HEADER_LEN] = (uint8_t)(crc16 >> 8);
+	the_header[ZMODEM_HEADER_LEN + 1] = (uint8_t)crc16;
+	
+	Serial_SendByte(ZMODEM_ZPAD);
+	Serial_SendByte(ZMODEM_ZPAD);
+	Serial_SendByte(ZMODEM_ZDLE);
+	Serial_SendByte(ZMODEM_ZHEX);
+	
+	for (i = 0; i < ZMODEM_HEADER_LEN + 2; i++)
+	{
+		Serial_SendByte(zmodem_hex_digits[the_header[i] >> 4]);
+		Serial_SendByte(zmodem_hex_digits[the_header[i] & 0x0F]);
+	}
+	
+	Serial_SendByte(CH_ENTER);
+	Serial_SendByte(CH_LF | 0x80);
+	
+	// XON in case the sender's side was stopped by line noise. not after ZACK (mid-frame) or ZFIN (session over).
+	if (the_type != ZMODEM_ZACK && the_type != ZMODEM_ZFIN)
+	{
+		Serial_SendByte(ZMODEM_XON);
+	}
+}
+
+
+// check that the first the_offset bytes on disk match the sender's file, by asking it for their CRC-32 (ZCRC)
+// the_offset is set to 0 if they don't. a sender that doesn't answer is only trusted if it asked for crash recovery (ZCRECOV).
+// returns false if the transfer was cancelled
+bool ZModem_CheckResume(const ZModemCallbacks* the_callbacks, uint32_t* the_offset, bool sender_recovers)
+{
+	uint32_t	crc32 = 0xFFFFFFFF;
+	uint32_t	the_remaining = *the_offset;
+	uint16_t	the_len;
+	uint16_t	i;
+	int16_t		the_type;
+	
+	// LOGIC:
+	//   a file on disk with the same name, and no bigger than the one offered, might be an interrupted copy of it, or might not.
+	//   ZCRC asks the sender for the CRC-32 of its first the_offset bytes. it works that out while we do the same for
+	//   the copy on disk, read back through zmodem_data, which isn't needed again until the sender's answer is in.
+	//   without an answer, only a sender that said it is resuming (ZCRECOV) is believed. otherwise, start the file over.
+	
+	ZModem_SendHexHeader(ZMODEM_ZCRC, *the_offset);
+	
+	while (the_remaining > 0)
+	{
+		the_len = (the_remaining > ZMODEM_MAX_DATA) ? ZMODEM_MAX_DATA : (uint16_t)the_remaining;
+		
+		if (the_callbacks->read_(zmodem_data, the_len) == false)
+		{
+			// can't tell: start over
+			*the_offset = 0;
+			break;
+		}
+		
+		for (i = 0; i < the_len; i++)
+		{
+			crc32 = ZMODEM_CRC32_UPDATE(crc32, zmodem_data[i]);
+		}
+		
+		the_remaining -= the_len;
+		
+		if (Transfer_CheckCancel() == true)
+		{
+			return false;
+		}
+	}
+	
+	the_type = ZModem_GetHeader();
+	TRACE((TRACE_ZM_HEADER, (uint8_t)the_type, 0));
+	
+	if (the_type == ZMODEM_CANCELLED || the_type == ZMODEM_ZCAN || the_type == ZMODEM_ZABORT)
+	{
+		return false;
+	}
+	
+	if (the_type == ZMODEM_ZCRC)
+	{
+		if (ZModem_GetHeaderPosition() != ~crc32)
+		{
+			*the_offset = 0;
+		}
+	}
+	else if (sender_recovers == false)
+	{
+		*the_offset = 0;
+	}
+	
+	return true;
+}
+
+
+// tell the sender we are giving up: CANs to stop it, backspaces to erase them from a shell
+void ZModem_SendCancel(void)
+{
+	uint8_t		i;
+	
+	for (i = 0; i < 10; i++)
+	{
+		Serial_SendByte(ZMODEM_ZDLE);
+	}
+	
+	for (i = 0; i < 10; i++)
+	{
+		Serial_SendByte(ZMODEM_CH_BS);
+	}
+}
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+// receive files over ZMODEM until the sender finishes the session. blocks until the transfer ends.
+// returns the number of bytes received (not counting any that were already on disk), or -1 if the transfer was aborted
+int32_t ZModem_Receive(const ZModemCallbacks* the_callbacks)
+{
+	int16_t		the_type;
+	int16_t		the_end;
+	uint32_t	the_pos = 0;			// next byte of the file we need
+	uint32_t	the_filesize;
+	int32_t		bytes_total = 0;
+	uint8_t		nbr_errors = 0;
+	bool		file_is_open = false;
+	bool		in_frame;
+	char*		the_text;
+	
+	// LOGIC:
+	//   we advertise a 0 buffer size, so the sender streams each file as one ZDATA frame of ZCRCG subpackets.
+	//   RTS back-pressure (serial.c) stops it while a chunk goes to disk; nothing is ACKed unless the sender asks (ZCRCQ/ZCRCW).
+	//   a bad subpacket isn't retried on its own: we send ZRPOS with the position of the last good byte,
+	//   skip everything until the sender's new ZDATA header for that position, and carry on from there.
+	//   the same ZRPOS, sent in answer to ZFILE, is how a file partly on disk from an earlier session is resumed,
+	//   once ZModem_CheckResume() has made sure what is on disk is really the start of the file being offered.
+	
+	TRACE_RESET();
+	ZModem_SendHexHeader(ZMODEM_ZRINIT, ZMODEM_RX_FLAGS);
+	
+	while (1)
+	{
+		the_type = ZModem_GetHeader();
+		TRACE((TRACE_ZM_HEADER, (uint8_t)the_type, (uint16_t)the_pos));
+		
+		if (the_type == ZMODEM_CANCELLED || the_type == ZMODEM_ZCAN || the_type == ZMODEM_ZABORT)
+		{
+			goto zmodem_abort;
+		}
+		
+		if (the_type < 0)
+		{
+			if (++nbr_errors >= ZMODEM_MAX_ERRORS)
+			{
+				goto zmodem_abort;
+			}
+			
+			// nudge the sender: from where we got to in the file, or to start the next one
+			if (file_is_open == true)
+			{
+				Progress_AddError();
+				ZModem_SendHexHeader(ZMODEM_ZRPOS, the_pos);
+			}
+			else
+			{
+				ZModem_SendHexHeader(ZMODEM_ZRINIT, ZMODEM_RX_FLAGS);
+			}
+			
+			continue;
+		}
+		
+		switch (the_type)
+		{
+			case ZMODEM_ZRQINIT:
+				ZModem_SendHexHeader(ZMODEM_ZRINIT, ZMODEM_RX_FLAGS);
+				break;
+			
+			case ZMODEM_ZSINIT:
+				// sender's options and attention string. we have no use for either, but must ACK
+				if (ZModem_GetData() < 0)
+				{
+					ZModem_SendHexHeader(ZMODEM_ZNAK, 0);
+				}
+				else
+				{
+					ZModem_SendHexHeader(ZMODEM_ZACK, 0);
+				}
+				break;
+			
+			case ZMODEM_ZFILE:
+				if (ZModem_GetData() < 0)
+				{
+					ZModem_SendHexHeader(ZMODEM_ZNAK, 0);
+					break;
+				}
+				
+				if (file_is_open == true)
+				{
+					// sender gave up on the last file without ZEOF
+					the_callbacks->close_();
+					file_is_open = false;
+				}
+				
+				// file name, NUL, then size in decimal, then mtime, mode, etc., which we ignore
+				zmodem_data[zmodem_data_len] = 0;
+				the_text = (char*)zmodem_data + strlen((char*)zmodem_data) + 1;
+				the_filesize = 0;
+				
+				while (the_text < (char*)zmodem_data + zmodem_data_len && *the_text >= '0' && *the_text <= '9')
+				{
+					the_filesize = the_filesize * 10 + (*the_text++ - '0');
+				}
+				
+				the_pos = 0;
+				
+				if (the_callbacks->open_((char*)zmodem_data, the_filesize, &the_pos) == false)
+				{
+					goto zmodem_abort;
+				}
+				
+				file_is_open = true;
+				
+				if (the_pos > 0 && ZModem_CheckResume(the_callbacks, &the_pos, zmodem_header[ZMODEM_ZF0] == ZMODEM_ZCRECOV) == false)
+				{
+					goto zmodem_abort;
+				}
+				
+				if (the_callbacks->start_(the_pos) == false)
+				{
+					goto zmodem_abort;
+				}
+				
+				if (the_filesize > 0 && the_pos >= the_filesize)
+				{
+					// already have all of it
+					file_is_open = false;
+					ZModem_SendHexHeader(ZMODEM_ZSKIP, 0);
+					break;
+				}
+				
+				nbr_errors = 0;
+				ZModem_SendHexHeader(ZMODEM_ZRPOS, the_pos);
+				break;
+			
+			case ZMODEM_ZDATA:
+				if (file_is_open == false)
+				{
+					break;
+				}
+				
+				if (ZModem_GetHeaderPosition() != the_pos)
+				{
+					// data from before our last ZRPOS. ask again
+					if (++nbr_errors >= ZMODEM_MAX_ERRORS)
+					{
+						goto zmodem_abort;
+					}
+					
+					ZModem_SendHexHeader(ZMODEM_ZRPOS, the_pos);
+					break;
+				}
+				
+				in_frame = true;
+				
+				while (in_frame == true)
+				{
+					// ESC cancels. checked once per subpacket, as the sender never stops to wait for us.
+					if (Transfer_CheckCancel() == true)
+					{
+						goto zmodem_abort;
+					}
+					
+					the_end = ZModem_GetData();
+					
+					if (the_end < 0)
+					{
+						TRACE((TRACE_ZM_DATA_ERROR, (uint8_t)the_end, (uint16_t)the_pos));
+						Progress_AddError();
+						
+						if (the_end == ZMODEM_CANCELLED || ++nbr_errors >= ZMODEM_MAX_ERRORS)
+						{
+							goto zmodem_abort;
+						}
+						
+						ZModem_SendHexHeader(ZMODEM_ZRPOS, the_pos);
+						break;
+					}
+					
+					nbr_errors = 0;
+					the_pos += zmodem_data_len;
+					bytes_total += zmodem_data_len;
+					
+					// answer before the disk write, so the sender isn't waiting on the SD card
+					if (the_end == ZMODEM_ZCRCQ || the_end == ZMODEM_ZCRCW)
+					{
+						ZModem_SendHexHeader(ZMODEM_ZACK, the_pos);
+					}
+					
+					if (zmodem_data_len > 0 && the_callbacks->write_(zmodem_data, zmodem_data_len) == false)
+					{
+						goto zmodem_abort;
+					}
+					
+					in_frame = (the_end == ZMODEM_ZCRCG || the_end == ZMODEM_ZCRCQ);
+				}
+				break;
+			
+			case ZMODEM_ZEOF:
+				// a ZEOF that went out before the sender saw our ZRPOS doesn't count. wait for the resent data.
+				if (file_is_open == false || ZModem_GetHeaderPosition() != the_pos)
+				{
+					break;
+				}
+				
+				file_is_open = false;
+				
+				if (the_callbacks->close_() == false)
+				{
+					goto zmodem_abort;
+				}
+				
+				ZModem_SendHexHeader(ZMODEM_ZRINIT, ZMODEM_RX_FLAGS);
+				break;
+			
+			case ZMODEM_ZFIN:
+				if (file_is_open == true)
+				{
+					// sender ended the session without ZEOF: write out and close what arrived
+					file_is_open = false;
+					the_callbacks->close_();
+				}
+				
+				ZModem_SendHexHeader(ZMODEM_ZFIN, 0);
+				
+				// sender closes with "OO" (over and out). don't wait long for it.
+				if (Serial_GetByte(500) == 'O')
+				{
+					Serial_GetByte(500);
+				}
+				
+				return bytes_total;
+			
+			case ZMODEM_ZFREECNT:
+				// free space unknown: 0
+				ZModem_SendHexHeader(ZMODEM_ZACK, 0);
+				break;
+			
+			case ZMODEM_ZCOMMAND:
+				// never run commands from the other end. say it finished, with an error.
+				ZModem_GetData();
+				ZModem_SendHexHeader(ZMODEM_ZCOMPL, 1);
+				break;
+			
+			default:
+				break;
+		}
+	}
+	
+zmodem_abort:
+	if (file_is_open == true)
+	{
+		the_callbacks->close_();
+	}
+	
+	ZModem_SendCancel();
+	Serial_FlushInBuffer();
+	
+	return -1;
+}
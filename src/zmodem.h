@@ -0,0 +1,85 @@
+//! @file zmodem.h
+
+/*
+ * zmodem.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ */
+
+#ifndef ZMODEM_H_
+#define ZMODEM_H_
+
+
+/* about this class: ZModem
+ *
+ * This receives files with ZMODEM, handing them to callbacks that store them
+ *
+ *** things this class needs to be able to do
+ * read hex, binary (CRC-16), and binary (CRC-32) headers, and CRC-16 or CRC-32 data subpackets
+ * let the sender stream: no ACK per subpacket unless the sender asks for one
+ * recover from a bad subpacket by asking the sender to go back to the last good byte (ZRPOS), instead of starting over
+ * start a file partway in, when the callbacks already have part of it (crash recovery), once the sender's CRC says it is the same file
+ * give up cleanly on repeated errors, or when the sender cancels
+ *
+ *** things objects of this class have
+ * the last header received, and whether the sender is using CRC-32
+ * one data subpacket
+ *
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+
+// Platform includes
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+#define ZMODEM_MAX_DATA				1024	// longest data subpacket accepted. longer ones are refused with ZRPOS; senders then shrink them.
+
+
+/*****************************************************************************/
+/*                               Enumerations                                */
+/*****************************************************************************/
+
+
+
+/*****************************************************************************/
+/*                                 Structs                                   */
+/*****************************************************************************/
+
+typedef struct ZModemCallbacks {
+	bool		(*open_)(const char* the_filename, uint32_t the_filesize, uint32_t* the_offset);	// file announced. set the_offset to how much of it may be on disk already (the_filesize: all of it). return false to abort.
+	bool		(*read_)(uint8_t* the_data, uint16_t the_len);		// read back what is on disk, from the start, to compare with the sender's copy. return false on a disk error.
+	bool		(*start_)(uint32_t the_offset);		// receive from the_offset: anything on disk past it is dropped. the file's size means skip it. return false to abort.
+	bool		(*write_)(const uint8_t* the_data, uint16_t the_len);	// good data, in order. return false to abort.
+	bool		(*close_)(void);		// end of file, or transfer aborted
+} ZModemCallbacks;
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// receive files over ZMODEM until the sender finishes the session. blocks until the transfer ends.
+// returns the number of bytes received (not counting any that were already on disk), or -1 if the transfer was aborted
+int32_t ZModem_Receive(const ZModemCallbacks* the_callbacks);
+
+
+#endif /* ZMODEM_H_ */
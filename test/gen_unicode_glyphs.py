@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+#
+# gen_unicode_glyphs.py
+#
+#  Created on: Oct 19, 2026
+#      Author: micahbly
+#
+#  - generates serial_unicode_glyphs[] (Unicode code point -> CP437 glyph) for serial.c
+#
+#  "gen_unicode_glyphs.py" prints the table, ready to paste into serial.c
+#  "gen_unicode_glyphs.py --check ../src/serial.c" exits non-zero if the table in serial.c doesn't match
+
+import re
+import sys
+
+
+# CP437 glyphs below 32, by the code point they are drawn as. the bytes Serial_PrintByte acts on
+# (BS, LF, FF, CR), and HT, are left out: a code point must never turn into cursor movement.
+CP437_LOW_GLYPHS = {
+	0x263A: 0x01, 0x263B: 0x02, 0x2665: 0x03, 0x2666: 0x04, 0x2663: 0x05, 0x2660: 0x06, 0x2022: 0x07,
+	0x2642: 0x0B, 0x266B: 0x0E, 0x263C: 0x0F, 0x25BA: 0x10, 0x25C4: 0x11, 0x2195: 0x12, 0x203C: 0x13,
+	0x00B6: 0x14, 0x00A7: 0x15, 0x25AC: 0x16, 0x21A8: 0x17, 0x2191: 0x18, 0x2193: 0x19, 0x2192: 0x1A,
+	0x2190: 0x1B, 0x221F: 0x1C, 0x2194: 0x1D, 0x25B2: 0x1E, 0x25BC: 0x1F, 0x2302: 0x7F,
+}
+
+# common characters with no CP437 glyph, and the nearest thing CP437 has
+STAND_INS = {
+	0x00A9: ord('c'),	# copyright
+	0x00AE: ord('R'),	# registered
+	0x2013: ord('-'),	# en dash
+	0x2014: ord('-'),	# em dash
+	0x2018: ord("'"),	# left single quote
+	0x2019: ord("'"),	# right single quote
+	0x201C: ord('"'),	# left double quote
+	0x201D: ord('"'),	# right double quote
+	0x2026: 0xFA,		# ellipsis -> middle dot
+}
+
+ENTRIES_PER_LINE = 6
+
+
+def build_table():
+	table = {}
+
+	for glyph in range(0x80, 0x100):
+		table[ord(bytes([glyph]).decode('cp437'))] = glyph
+
+	table.update(CP437_LOW_GLYPHS)
+	table.update(STAND_INS)
+
+	return sorted(table.items())
+
+
+def format_table(table):
+	lines = []
+
+	for start in range(0, len(table), ENTRIES_PER_LINE):
+		entries = table[start:start + ENTRIES_PER_LINE]
+		lines.append('\t' + ' '.join('{0x%04X, 0x%02X},' % entry for entry in entries))
+
+	return '\n'.join(lines)
+
+
+def check(serial_c_path, table):
+	source = open(serial_c_path).read()
+
+	body = re.search(r'serial_unicode_glyphs\[NUM_UNICODE_GLYPHS\] = \n\{\n(.*?)\n\};', source, re.S)
+	count = re.search(r'#define NUM_UNICODE_GLYPHS\s+(\d+)', source)
+
+	if body is None or count is None:
+		print('gen_unicode_glyphs: serial_unicode_glyphs[] not found in %s' % serial_c_path)
+		return 1
+
+	if body.group(1) != format_table(table):
+		print('gen_unicode_glyphs: serial_unicode_glyphs[] in %s does not match the generated table' % serial_c_path)
+		return 1
+
+	if int(count.group(1)) != len(table):
+		print('gen_unicode_glyphs: NUM_UNICODE_GLYPHS is %s, table has %d entries' % (count.group(1), len(table)))
+		return 1
+
+	print('gen_unicode_glyphs: ok (%d entries)' % len(table))
+	return 0
+
+
+if __name__ == '__main__':
+	table = build_table()
+
+	if len(sys.argv) == 3 and sys.argv[1] == '--check':
+		sys.exit(check(sys.argv[2], table))
+
+	print('#define NUM_UNICODE_GLYPHS\t\t%d' % len(table))
+	print(format_table(table))
@@ -0,0 +1,115 @@
+/*
+ * host.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ *
+ *  - stands in for the app, message area, and general library calls when modules are run on a host. see host.h.
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+#include "host.h"
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+uint8_t				host_registers[HOST_REGISTER_MASK + 1];
+uint16_t			host_ticks;
+uint16_t			host_ticks_per_call;
+uint16_t			host_failures;
+bool				host_verbose;
+
+static char			host_string_buff1[256];
+static char			host_string_buff2[256];
+
+char*				global_string_buff1 = host_string_buff1;
+char*				global_string_buff2 = host_string_buff2;
+
+
+/*****************************************************************************/
+/*                        Public Function Definitions                        */
+/*****************************************************************************/
+
+// print a one-line pass/fail summary for the_test_name and return the exit code for main()
+int Host_Finish(const char* the_test_name)
+{
+	if (host_failures > 0)
+	{
+		printf("%s: %u check(s) FAILED\n", the_test_name, (unsigned int)host_failures);
+		return 1;
+	}
+
+	printf("%s: ok\n", the_test_name);
+	return 0;
+}
+
+
+// **** stand-ins for app.c, comm_buffer.c, and the general library *****
+
+uint16_t App_GetTicks(void)
+{
+	uint16_t	the_ticks = host_ticks;
+
+	host_ticks += host_ticks_per_call;
+
+	return the_ticks;
+}
+
+
+void Buffer_NewMessage(char* the_message)
+{
+	if (host_verbose == true)
+	{
+		printf("  msg: %s\n", the_message);
+	}
+}
+
+
+void Buffer_UpdateStatusMessage(char* the_message)
+{
+	if (host_verbose == true)
+	{
+		printf("  status: %s\n", the_message);
+	}
+}
+
+
+void General_DelayTicks(uint16_t ticks)
+{
+	host_ticks += ticks;
+}
+
+
+int16_t General_Strlcpy(char* dst, const char* src, size_t max_len)
+{
+	size_t	the_len = strlen(src);
+
+	if (max_len > 0)
+	{
+		size_t	the_copy = (the_len >= max_len) ? max_len - 1 : the_len;
+
+		memcpy(dst, src, the_copy);
+		dst[the_copy] = 0;
+	}
+
+	return (int16_t)the_len;
+}
+
+
+int16_t General_Strnlen(const char *the_string, size_t max_len)
+{
+	return (int16_t)strnlen(the_string, max_len);
+}
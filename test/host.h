@@ -0,0 +1,87 @@
+//! @file host.h
+
+/*
+ * host.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ */
+
+#ifndef HOST_H_
+#define HOST_H_
+
+
+/* about this class: Host
+ *
+ * This is the glue that lets f/term modules run on a Linux or Mac host, so they can be checked without an F256
+ *
+ *** things this class needs to be able to do
+ * stand in for the app, message area, and general library calls the modules make
+ * give the modules a simulated RTC tick counter that the test controls
+ * give the modules somewhere harmless to write hardware registers
+ * count failed checks, so a test can exit non-zero
+ *
+ *** how tests use it
+ * a test #includes the module's .c after this header, so it can see the module's private state,
+ *   then defines whatever else that module calls (serial, text, bitmap) to record what happened
+ * host.c is linked into every test
+ *
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+// project includes
+
+// C includes
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// F256 includes
+#include "f256_e.h"
+
+
+/*****************************************************************************/
+/*                            Macro Definitions                              */
+/*****************************************************************************/
+
+// hardware registers land in a scratch array instead of the F256 I/O page
+#undef R8
+#undef R16
+#undef R32
+#define R8(x)						(*(volatile uint8_t*)&host_registers[(uint32_t)(x) & HOST_REGISTER_MASK])
+#define R16(x)						(*(volatile uint16_t*)&host_registers[(uint32_t)(x) & HOST_REGISTER_MASK & ~1])
+#define R32(x)						(*(volatile uint32_t*)&host_registers[(uint32_t)(x) & HOST_REGISTER_MASK & ~3])
+
+#define HOST_REGISTER_MASK			0xFFFF
+
+// interrupts can't happen on the host
+#define __asm(x)
+
+// record a failed check and carry on, so one run reports every failure
+#define CHECK(cond)					do { if (!(cond)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); host_failures++; } } while (0)
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+extern uint8_t				host_registers[HOST_REGISTER_MASK + 1];
+extern uint16_t				host_ticks;			// what App_GetTicks() returns. tests move it along.
+extern uint16_t				host_ticks_per_call;	// App_GetTicks() adds this after each call, so timeout loops end
+extern uint16_t				host_failures;
+extern bool					host_verbose;		// print messages the module sends to the message area
+
+
+/*****************************************************************************/
+/*                       Public Function Prototypes                          */
+/*****************************************************************************/
+
+// print a one-line pass/fail summary for the_test_name and return the exit code for main()
+int Host_Finish(const char* the_test_name);
+
+
+#endif /* HOST_H_ */
@@ -0,0 +1,495 @@
+/*
+ * test_kermit.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ *
+ *  - host checks for kermit.c: the send-init timeout, and its sender and receiver talking to each other over a pair of
+ *    pipes, 8-bit and 7-bit, over a clean line and a noisy one
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+#include "host.h"
+
+#include "../src/kermit.c"
+
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define TEST_TIME_SCALE				10		// timeouts run this many times faster than on the F256, so a noisy run takes seconds
+#define TEST_LINK_BUFFER_SIZE		4096	// bytes sent are passed on in chunks this big
+#define TEST_NUM_FILES				4
+#define TEST_NEVER					0xFFFF	// test_cancel_after: ESC is never pressed
+#define TEST_CLEAN					0		// test_noise: no bytes are lost or damaged
+#define TEST_NOISE					5000		// test_noise: about 1 byte in this many is lost or has a bit flipped
+#define TEST_MAX_SECONDS			120		// a side that takes longer than this is stuck
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+typedef struct TestFile {
+	const char*	name_;
+	uint32_t	size_;
+} TestFile;
+
+// what the sender sends. the bytes of each are made by Test_FileByte().
+static const TestFile	test_files[TEST_NUM_FILES] =
+{
+	{"rand.bin", 20000},	// every byte value, in no order: prefixing, and long packets
+	{"empty.txt", 0},
+	{"small.txt", 16},		// the prefix characters themselves, and control characters
+	{"runs.bin", 8000},		// long runs: repeat counts
+};
+
+static int			test_link_in = -1;
+static int			test_link_out = -1;
+static uint8_t		test_link_buffer[TEST_LINK_BUFFER_SIZE];
+static uint16_t		test_link_buffer_len;
+static bool			test_seven_bit;					// the line strips the 8th bit
+static uint16_t		test_noise;						// TEST_CLEAN, or TEST_NOISE
+static unsigned		test_seed;
+static uint16_t		test_cancel_after;				// Transfer_CheckCancel() calls before ESC is "pressed"
+
+static uint8_t		test_file_num;					// the file being sent or received
+static uint32_t		test_file_pos;					// bytes of it read or written so far
+static bool			test_file_is_open;
+static uint8_t		test_num_whole;					// files received whole
+
+
+/*****************************************************************************/
+/*                       Stand-ins for what kermit.c calls                   */
+/*****************************************************************************/
+
+// pass on what this side has sent
+static void Test_FlushLink(void)
+{
+	uint16_t	the_pos = 0;
+	ssize_t		the_len;
+
+	while (the_pos < test_link_buffer_len)
+	{
+		if ( (the_len = write(test_link_out, test_link_buffer + the_pos, test_link_buffer_len - the_pos)) <= 0)
+		{
+			break;
+		}
+
+		the_pos += (uint16_t)the_len;
+	}
+
+	test_link_buffer_len = 0;
+}
+
+
+int16_t Serial_GetByte(uint32_t the_timeout_ms)
+{
+	struct pollfd	the_poll = {test_link_in, POLLIN, 0};
+	uint8_t			the_byte;
+
+	Test_FlushLink();
+
+	if (poll(&the_poll, 1, (int)(the_timeout_ms / TEST_TIME_SCALE)) <= 0 || read(test_link_in, &the_byte, 1) != 1)
+	{
+		return -1;
+	}
+
+	return the_byte;
+}
+
+uint16_t Serial_BytesAvailable(void)
+{
+	struct pollfd	the_poll = {test_link_in, POLLIN, 0};
+
+	Test_FlushLink();
+
+	return (poll(&the_poll, 1, 0) > 0) ? 1 : 0;
+}
+
+// the line strips the 8th bit if test_seven_bit, and on a noisy line, drops or damages about 1 byte in test_noise
+bool Serial_SendByte(uint8_t the_byte)
+{
+	if (test_noise != TEST_CLEAN && rand_r(&test_seed) % test_noise == 0)
+	{
+		if (rand_r(&test_seed) & 1)
+		{
+			return true;
+		}
+
+		the_byte ^= 1 << (rand_r(&test_seed) & 7);
+	}
+
+	if (test_seven_bit == true)
+	{
+		the_byte &= 0x7F;
+	}
+
+	test_link_buffer[test_link_buffer_len++] = the_byte;
+
+	if (test_link_buffer_len == TEST_LINK_BUFFER_SIZE)
+	{
+		Test_FlushLink();
+	}
+
+	return true;
+}
+
+bool Serial_WaitForTransmit(void)
+{
+	Test_FlushLink();
+	return true;
+}
+
+bool Serial_IsSevenBit(void)
+{
+	return test_seven_bit;
+}
+
+void Progress_AddError(void) {}
+void Progress_AddRetry(void) {}
+
+char* Strings_GetString(uint8_t the_string_id)
+{
+	return (the_string_id == ID_STR_MSG_KERMIT_REMOTE_ERROR) ? "Kermit: other side says %s" : "Kermit: %s";
+}
+
+bool Transfer_CheckCancel(void)
+{
+	if (test_cancel_after == TEST_NEVER || test_cancel_after-- > 0)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+// the byte the_index of test file the_file_num
+static uint8_t Test_FileByte(uint8_t the_file_num, uint32_t the_index)
+{
+	static const char	the_small[] = "hello ##&&~~\r\n\001\177";
+
+	switch (the_file_num)
+	{
+		case 0:
+			return (uint8_t)((the_index * 1103515245UL + 12345) >> 16);
+
+		case 2:
+			return (uint8_t)(the_small[the_index] | ((the_index & 1) ? 0x80 : 0));
+
+		default:
+			return (the_index < 5000) ? 0 : (the_index < 5300) ? 'A' : (uint8_t)the_index;
+	}
+}
+
+
+// receive callbacks: each byte is checked as it arrives
+static bool Test_Open(const char* the_filename, uint32_t the_filesize)
+{
+	for (test_file_num = 0; test_file_num < TEST_NUM_FILES; test_file_num++)
+	{
+		if (strcmp(the_filename, test_files[test_file_num].name_) == 0)
+		{
+			break;
+		}
+	}
+
+	CHECK(test_file_num < TEST_NUM_FILES);
+	CHECK(test_file_num >= TEST_NUM_FILES || the_filesize == test_files[test_file_num].size_);
+	CHECK(test_file_is_open == false);
+
+	test_file_pos = 0;
+	test_file_is_open = true;
+
+	return (test_file_num < TEST_NUM_FILES);
+}
+
+static bool Test_Write(const uint8_t* the_data, uint16_t the_len)
+{
+	uint16_t	i;
+
+	for (i = 0; i < the_len; i++)
+	{
+		if (test_file_pos >= test_files[test_file_num].size_ || the_data[i] != Test_FileByte(test_file_num, test_file_pos))
+		{
+			CHECK(false);
+			return false;
+		}
+
+		test_file_pos++;
+	}
+
+	return true;
+}
+
+static bool Test_ReceiveClose(void)
+{
+	CHECK(test_file_is_open == true);
+
+	if (test_file_pos == test_files[test_file_num].size_)
+	{
+		test_num_whole++;
+	}
+
+	test_file_is_open = false;
+	return true;
+}
+
+static const KermitCallbacks	test_rx_callbacks = {Test_Open, Test_Write, NULL, NULL, Test_ReceiveClose};
+
+
+// send callbacks: the files in test_files[], in order
+static bool Test_NextFile(char* the_filename, uint32_t* the_filesize)
+{
+	if (test_file_num >= TEST_NUM_FILES)
+	{
+		return false;
+	}
+
+	strcpy(the_filename, test_files[test_file_num].name_);
+	*the_filesize = test_files[test_file_num].size_;
+	test_file_pos = 0;
+	test_file_is_open = true;
+
+	return true;
+}
+
+static int16_t Test_Read(uint8_t* the_data, uint16_t the_len)
+{
+	uint16_t	i;
+
+	for (i = 0; i < the_len && test_file_pos < test_files[test_file_num].size_; i++)
+	{
+		the_data[i] = Test_FileByte(test_file_num, test_file_pos++);
+	}
+
+	return (int16_t)i;
+}
+
+static bool Test_SendClose(void)
+{
+	test_file_num++;
+	test_file_is_open = false;
+	return true;
+}
+
+static const KermitCallbacks	test_tx_callbacks = {NULL, NULL, Test_NextFile, Test_Read, Test_SendClose};
+
+
+/*****************************************************************************/
+/*                                 Helpers                                   */
+/*****************************************************************************/
+
+// total bytes in test_files[]
+static uint32_t Test_TotalSize(void)
+{
+	uint32_t	the_total = 0;
+	uint8_t		i;
+
+	for (i = 0; i < TEST_NUM_FILES; i++)
+	{
+		the_total += test_files[i].size_;
+	}
+
+	return the_total;
+}
+
+
+// run a whole session: the receiver in a child process, the sender here, a pipe each way between them.
+// ESC is "pressed" on the receiving side after rx_cancel_after checks, and on the sending side after tx_cancel_after.
+// returns what Kermit_Send() returned. the_rx_ok gets whether the receiver got everything, or was cancelled as it should be.
+static int32_t Test_Session(bool seven_bit, uint16_t the_noise, uint16_t rx_cancel_after, uint16_t tx_cancel_after, bool* the_rx_ok)
+{
+	int			to_rx[2];
+	int			to_tx[2];
+	pid_t		the_pid;
+	int			the_status;
+	int32_t		the_result;
+
+	if (pipe(to_rx) != 0 || pipe(to_tx) != 0)
+	{
+		CHECK(false);
+		return -1;
+	}
+
+	test_seven_bit = seven_bit;
+	test_noise = the_noise;
+	test_file_num = 0;
+	test_file_is_open = false;
+	test_num_whole = 0;
+	test_link_buffer_len = 0;
+	fflush(stdout);
+
+	if ( (the_pid = fork()) == 0)
+	{
+		alarm(TEST_MAX_SECONDS);
+		close(to_rx[1]);
+		close(to_tx[0]);
+		test_link_in = to_rx[0];
+		test_link_out = to_tx[1];
+		test_seed = 2;
+		test_cancel_after = rx_cancel_after;
+
+		the_result = Kermit_Receive(&test_rx_callbacks);
+		Test_FlushLink();
+
+		if (rx_cancel_after == TEST_NEVER && tx_cancel_after == TEST_NEVER)
+		{
+			CHECK(the_result == (int32_t)Test_TotalSize());
+			CHECK(test_num_whole == TEST_NUM_FILES);
+		}
+		else
+		{
+			CHECK(the_result < 0);
+		}
+
+		CHECK(test_file_is_open == false);
+
+		fflush(stdout);
+		_exit(host_failures > 0);
+	}
+
+	alarm(TEST_MAX_SECONDS);
+	close(to_rx[0]);
+	close(to_tx[1]);
+	test_link_in = to_tx[0];
+	test_link_out = to_rx[1];
+	test_seed = 1;
+	test_cancel_after = tx_cancel_after;
+
+	the_result = Kermit_Send(&test_tx_callbacks);
+	Test_FlushLink();
+
+	close(to_tx[0]);
+	close(to_rx[1]);
+	waitpid(the_pid, &the_status, 0);
+	alarm(0);
+
+	*the_rx_ok = (WIFEXITED(the_status) && WEXITSTATUS(the_status) == 0);
+
+	return the_result;
+}
+
+
+/*****************************************************************************/
+/*                                  Checks                                   */
+/*****************************************************************************/
+
+// the other side's TIME field, in seconds: short ones are stretched, and long ones cut to a minute, not wrapped around 16 bits
+static void Test_Timeout(void)
+{
+	uint8_t		the_init[2] = {KERMIT_TOCHAR(80), 0};
+	uint8_t		the_reply;
+
+	Kermit_Reset();
+	the_init[1] = KERMIT_TOCHAR(1);
+	Kermit_ParseInit(the_init, sizeof(the_init), &the_reply);
+	CHECK(kermit_timeout_ms == KERMIT_TIMEOUT_SECS * 1000);
+
+	Kermit_Reset();
+	the_init[1] = KERMIT_TOCHAR(10);
+	Kermit_ParseInit(the_init, sizeof(the_init), &the_reply);
+	CHECK(kermit_timeout_ms == 10000);
+
+	Kermit_Reset();
+	the_init[1] = KERMIT_TOCHAR(70);
+	Kermit_ParseInit(the_init, sizeof(the_init), &the_reply);
+	CHECK(kermit_timeout_ms == KERMIT_MAX_TIMEOUT_MS);
+
+	Kermit_Reset();
+	the_init[1] = KERMIT_TOCHAR(94);
+	Kermit_ParseInit(the_init, sizeof(the_init), &the_reply);
+	CHECK(kermit_timeout_ms == KERMIT_MAX_TIMEOUT_MS);
+}
+
+
+// every file arrives whole, 8-bit and 7-bit, over a clean line and a noisy one
+static void Test_Loopback(void)
+{
+	static const char*	the_modes[4] = {"8-bit clean", "7-bit clean", "8-bit noisy", "7-bit noisy"};
+	bool		the_rx_ok;
+	uint8_t		i;
+
+	for (i = 0; i < 4; i++)
+	{
+		CHECK(Test_Session((i & 1) != 0, (i & 2) ? TEST_NOISE : TEST_CLEAN, TEST_NEVER, TEST_NEVER, &the_rx_ok) == (int32_t)Test_TotalSize());
+		CHECK(the_rx_ok == true);
+
+		if (host_verbose == true)
+		{
+			printf("  %s: %s\n", the_modes[i], (the_rx_ok == true) ? "ok" : "FAILED");
+		}
+	}
+}
+
+
+// ESC on either side ends the session on both, and a receiver waiting on a silent line gives up when ESC is pressed
+static void Test_Cancel(void)
+{
+	bool		the_rx_ok;
+	int			the_silent[2];
+	int			the_answer[2];
+	uint8_t		the_sent[256];
+	ssize_t		the_len;
+
+	CHECK(Test_Session(false, TEST_CLEAN, 5, TEST_NEVER, &the_rx_ok) < 0);
+	CHECK(the_rx_ok == true);
+
+	CHECK(Test_Session(false, TEST_CLEAN, TEST_NEVER, 5, &the_rx_ok) < 0);
+	CHECK(the_rx_ok == true);
+
+	// nothing ever arrives: ESC is seen between polls, and the E packet says why
+	if (pipe(the_silent) != 0 || pipe(the_answer) != 0)
+	{
+		CHECK(false);
+		return;
+	}
+
+	test_seven_bit = false;
+	test_noise = TEST_CLEAN;
+	test_link_in = the_silent[0];
+	test_link_out = the_answer[1];
+	test_link_buffer_len = 0;
+	test_cancel_after = 2;
+
+	CHECK(Kermit_Receive(&test_rx_callbacks) < 0);
+	Test_FlushLink();
+
+	the_len = read(the_answer[0], the_sent, sizeof(the_sent) - 1);
+	CHECK(the_len > 0);
+	the_sent[(the_len > 0) ? the_len : 0] = 0;
+	CHECK(strstr((char*)the_sent, "ECancelled") != NULL);
+
+	close(the_silent[0]);
+	close(the_silent[1]);
+	close(the_answer[0]);
+	close(the_answer[1]);
+}
+
+
+int main(int argc, char* argv[])
+{
+	host_verbose = (argc > 1);
+
+	// a side that gives up closes its end of the link: the other finds out from what it was sent, not from a signal
+	signal(SIGPIPE, SIG_IGN);
+
+	Test_Timeout();
+	Test_Loopback();
+	Test_Cancel();
+
+	return Host_Finish("kermit");
+}
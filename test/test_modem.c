@@ -0,0 +1,231 @@
+/*
+ * test_modem.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ *
+ *  - host checks for modem.c: result code matching, and baud rate detection against a simulated modem and UART
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+#include "host.h"
+
+#include "../src/modem.c"
+
+#include <string.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define TEST_US_PER_TICK			62500	// RTC ticks are 1/16 second
+#define TEST_MODEM_LATENCY_US		300000	// a slow modem: time from the CR of AT to the first byte of its answer
+#define TEST_NUM_RATES				10
+#define TEST_NO_MODEM				0		// modem rate for "nothing is connected"
+#define TEST_MAX_ANSWER_LEN			16
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+// the order ALT-S tries rates in (app_autobaud_order[] in app.c): fastest first
+static const uint32_t	test_rates[TEST_NUM_RATES] = {115200, 57600, 38400, 19200, 9600, 4800, 3600, 2400, 1200, 300};
+
+
+/*****************************************************************************/
+/*                                 Helpers                                   */
+/*****************************************************************************/
+
+// feed a string through the matcher
+static void Test_Feed(const char* the_string)
+{
+	while (*the_string != 0)
+	{
+		Modem_ProcessByte((uint8_t)*the_string++);
+	}
+}
+
+
+// run one probe at the_probe_rate against a modem listening at the_modem_rate, tick by tick, the way the main loop does.
+// returns what Modem_CheckProbe() decided, and the tick it decided on in the_tick.
+static modem_probe_result Test_Probe(uint32_t the_probe_rate, uint32_t the_modem_rate, uint16_t* the_tick)
+{
+	static const char	the_good_answer[] = "AT\r\r\nOK\r\n";	// echo, then the result code
+	static const char	the_garbage[] = "\xF8\x80\xFE\x1E\xE0\xF8";	// what an answer sent at another rate looks like
+	const char*			the_answer;
+	uint8_t				the_answer_len;
+	uint8_t				the_next_byte = 0;
+	uint32_t			the_sent_us;
+	uint32_t			the_arrival_us;
+	uint32_t			the_char_us;
+	modem_probe_result	the_result;
+
+	// LOGIC:
+	//   time is kept in microseconds. the tick count can be up to a tick behind real time, so the probe is sent
+	//   at the very end of its tick: the worst case for the timeout. bytes are handed over as soon as they are
+	//   complete (the receive FIFO trigger is 1 byte), and checked once per tick, as the main loop would.
+	//   the modem answers AT at its own rate only. at any other rate, its echo of the garbled AT arrives as garbage.
+
+	Modem_StartProbe(the_probe_rate, *the_tick);
+	the_sent_us = (uint32_t)(*the_tick + 1) * TEST_US_PER_TICK - 1;
+	the_char_us = (the_modem_rate == TEST_NO_MODEM) ? 0 : 10000000UL / the_modem_rate;
+
+	if (the_modem_rate == TEST_NO_MODEM)
+	{
+		the_answer = "";
+		the_answer_len = 0;
+	}
+	else if (the_modem_rate == the_probe_rate)
+	{
+		the_answer = the_good_answer;
+		the_answer_len = sizeof(the_good_answer) - 1;
+	}
+	else
+	{
+		the_answer = the_garbage;
+		the_answer_len = sizeof(the_garbage) - 1;
+	}
+
+	for (;;)
+	{
+		(*the_tick)++;
+
+		while (the_next_byte < the_answer_len)
+		{
+			// the echo comes back a character behind the probe. the result code comes after the modem has thought about it.
+			the_arrival_us = the_sent_us + (the_next_byte + 1) * the_char_us;
+
+			if (the_next_byte >= 3)
+			{
+				the_arrival_us += 3 * the_char_us + TEST_MODEM_LATENCY_US;
+			}
+
+			if (the_arrival_us > (uint32_t)*the_tick * TEST_US_PER_TICK)
+			{
+				break;
+			}
+
+			Modem_ProcessByte((uint8_t)the_answer[the_next_byte++]);
+		}
+
+		the_result = Modem_CheckProbe(*the_tick);
+
+		if (the_result != MODEM_PROBE_WAITING)
+		{
+			return the_result;
+		}
+	}
+}
+
+
+// run ALT-S's whole sweep against a modem at the_modem_rate. returns the rate found, or 0. the_ticks gets how long it took.
+static uint32_t Test_Detect(uint32_t the_modem_rate, uint16_t* the_ticks)
+{
+	uint16_t	the_tick = 1000;	// anywhere: only differences matter
+	uint16_t	the_start = the_tick;
+	uint8_t		i;
+
+	for (i = 0; i < TEST_NUM_RATES; i++)
+	{
+		if (Test_Probe(test_rates[i], the_modem_rate, &the_tick) == MODEM_PROBE_ANSWERED)
+		{
+			*the_ticks = the_tick - the_start;
+			return test_rates[i];
+		}
+	}
+
+	*the_ticks = the_tick - the_start;
+	return 0;
+}
+
+
+/*****************************************************************************/
+/*                                  Checks                                   */
+/*****************************************************************************/
+
+// result codes on their own line are recognized. the same words inside other text are not.
+static void Test_ResultCodes(void)
+{
+	Modem_Reset();
+	Test_Feed("\r\nNO DIALTONE\r\n");
+	CHECK(Modem_GetLastResult() == MODEM_RESULT_NO_DIALTONE);
+
+	Test_Feed("\r\nCONNECT 2400/ARQ\r\n");
+	CHECK(Modem_IsOnline() == true);
+	CHECK(Modem_GetConnectRate() == 2400);
+
+	// once online, only NO CARRIER counts
+	Test_Feed("\r\nOK\r\nBUSY\r\n");
+	CHECK(Modem_GetLastResult() == MODEM_RESULT_CONNECT);
+	Test_Feed("Press RETURN. NO CARRIER\r\n");
+	CHECK(Modem_IsOnline() == true);
+	Test_Feed("\r\nNO CARRIER\r\n");
+	CHECK(Modem_IsOnline() == false);
+
+	Modem_Reset();
+	Test_Feed("OKAY\r\n");
+	CHECK(Modem_GetLastResult() == MODEM_RESULT_NONE);
+}
+
+
+// each probe waits long enough for a slow modem at that rate, and no longer than about a second
+static void Test_ProbeTimeout(void)
+{
+	uint8_t		i;
+	uint8_t		the_prev_timeout = 0;
+
+	for (i = 0; i < TEST_NUM_RATES; i++)
+	{
+		Modem_StartProbe(test_rates[i], 0);
+		CHECK(modem_probe_timeout >= MODEM_PROBE_BASE_TICKS && modem_probe_timeout <= MODEM_TICKS_PER_SECOND + 2);
+		CHECK(modem_probe_timeout >= the_prev_timeout);
+		CHECK(Modem_CheckProbe(modem_probe_timeout - 1) == MODEM_PROBE_WAITING);
+		CHECK(Modem_CheckProbe(modem_probe_timeout) == MODEM_PROBE_TIMED_OUT);
+		the_prev_timeout = modem_probe_timeout;
+	}
+
+	// the tick counter wraps
+	Modem_StartProbe(300, 0xFFF0);
+	CHECK(Modem_CheckProbe(0x0000) == MODEM_PROBE_WAITING);
+	CHECK(Modem_CheckProbe(0xFFF0 + modem_probe_timeout) == MODEM_PROBE_TIMED_OUT);
+}
+
+
+// a modem at any rate ALT-S offers is found at that rate, even a slow one at 300 baud
+static void Test_AutoBaud(void)
+{
+	uint16_t	the_ticks;
+	uint8_t		i;
+
+	for (i = 0; i < TEST_NUM_RATES; i++)
+	{
+		CHECK(Test_Detect(test_rates[i], &the_ticks) == test_rates[i]);
+
+		if (host_verbose == true)
+		{
+			printf("  %lu baud: found in %u ticks\n", (unsigned long)test_rates[i], the_ticks);
+		}
+	}
+
+	// nothing connected: every rate is tried, and the sweep gives up in well under 15 seconds
+	CHECK(Test_Detect(TEST_NO_MODEM, &the_ticks) == 0);
+	CHECK(the_ticks < 15 * MODEM_TICKS_PER_SECOND);
+}
+
+
+int main(int argc, char* argv[])
+{
+	host_verbose = (argc > 1);
+
+	Test_ResultCodes();
+	Test_ProbeTimeout();
+	Test_AutoBaud();
+
+	return Host_Finish("modem");
+}
@@ -0,0 +1,355 @@
+/*
+ * test_music.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ *
+ *  - host checks for music.c, and an ANSI music to WAV renderer for listening to what the note queue would play
+ *
+ *  "test_music" runs the checks
+ *  "test_music tune.mml tune.wav" parses the MML in tune.mml the way f/term would and writes the note queue as a WAV
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+#include "host.h"
+
+#include "../src/music.c"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define TEST_SAMPLE_RATE			22050
+#define TEST_SAMPLE_HIGH			0xA0	// 8-bit unsigned samples: square wave swings between these
+#define TEST_SAMPLE_LOW				0x60
+#define TEST_SAMPLE_SILENT			0x80
+#define TEST_WAV_HEADER_LEN			44
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+static FILE*		test_wav_file;
+static uint32_t		test_wav_samples;
+static uint32_t		test_wav_phase;		// position in the current square wave cycle, in 1/TEST_SAMPLE_RATE of a PSG tick (PSG_CLOCK / 32)
+
+
+/*****************************************************************************/
+/*                                 Helpers                                   */
+/*****************************************************************************/
+
+// start a fresh string, feed it through the parser, and end it. the queue is emptied first.
+static void Test_Play(const char* the_mml)
+{
+	Music_Stop();
+	Music_BeginString();
+
+	while (*the_mml != 0)
+	{
+		Music_ProcessByte((uint8_t)*the_mml++);
+	}
+
+	Music_EndString();
+}
+
+
+// number of entries waiting in the queue
+static uint8_t Test_QueueLen(void)
+{
+	return (music_write_idx - music_read_idx) & MUSIC_QUEUE_MASK;
+}
+
+
+// the_index'th entry waiting in the queue
+static MusicNote* Test_QueueEntry(uint8_t the_index)
+{
+	return &music_queue[(music_read_idx + the_index) & MUSIC_QUEUE_MASK];
+}
+
+
+// total ticks of everything waiting in the queue
+static uint16_t Test_QueueTicks(void)
+{
+	uint16_t	the_ticks = 0;
+	uint8_t		i;
+
+	for (i = 0; i < Test_QueueLen(); i++)
+	{
+		the_ticks += Test_QueueEntry(i)->ticks_;
+	}
+
+	return the_ticks;
+}
+
+
+// frequency, in Hz, the PSG plays for the_divider
+static double Test_Frequency(uint16_t the_divider)
+{
+	return (double)PSG_CLOCK / (32.0 * the_divider);
+}
+
+
+// write a little-endian value of the_len bytes to the WAV file
+static void Test_WriteLE(uint32_t the_value, uint8_t the_len)
+{
+	while (the_len-- > 0)
+	{
+		fputc(the_value & 0xFF, test_wav_file);
+		the_value >>= 8;
+	}
+}
+
+
+// write (or rewrite, once the length is known) the header of an 8-bit mono WAV
+static void Test_WriteWAVHeader(void)
+{
+	fseek(test_wav_file, 0, SEEK_SET);
+	fputs("RIFF", test_wav_file);
+	Test_WriteLE(TEST_WAV_HEADER_LEN - 8 + test_wav_samples, 4);
+	fputs("WAVEfmt ", test_wav_file);
+	Test_WriteLE(16, 4);					// fmt chunk length
+	Test_WriteLE(1, 2);						// PCM
+	Test_WriteLE(1, 2);						// mono
+	Test_WriteLE(TEST_SAMPLE_RATE, 4);
+	Test_WriteLE(TEST_SAMPLE_RATE, 4);		// bytes per second
+	Test_WriteLE(1, 2);						// bytes per sample
+	Test_WriteLE(8, 2);						// bits per sample
+	fputs("data", test_wav_file);
+	Test_WriteLE(test_wav_samples, 4);
+}
+
+
+// write everything in the queue to the WAV file as square waves (or silence), and empty the queue
+static void Test_DrainToWAV(void)
+{
+	MusicNote*	the_note;
+	uint32_t	the_samples;
+	uint32_t	the_half_cycle;
+
+	// LOGIC:
+	//   the PSG toggles its output every 16 * divider clocks. keep the phase in units of PSG_CLOCK / TEST_SAMPLE_RATE
+	//   so the wave carries on smoothly from one note to the next, as the chip's counter would.
+
+	while (music_read_idx != music_write_idx)
+	{
+		the_note = &music_queue[music_read_idx];
+		the_samples = (uint32_t)the_note->ticks_ * TEST_SAMPLE_RATE / MUSIC_TICKS_PER_SECOND;
+		the_half_cycle = (uint32_t)the_note->divider_ * 16 * TEST_SAMPLE_RATE;
+		test_wav_samples += the_samples;
+
+		while (the_samples-- > 0)
+		{
+			if (the_note->divider_ == 0)
+			{
+				fputc(TEST_SAMPLE_SILENT, test_wav_file);
+				continue;
+			}
+
+			test_wav_phase = (test_wav_phase + PSG_CLOCK) % (the_half_cycle * 2);
+			fputc((test_wav_phase < the_half_cycle) ? TEST_SAMPLE_HIGH : TEST_SAMPLE_LOW, test_wav_file);
+		}
+
+		music_read_idx = (music_read_idx + 1) & MUSIC_QUEUE_MASK;
+	}
+}
+
+
+/*****************************************************************************/
+/*                                  Checks                                   */
+/*****************************************************************************/
+
+// notes land on the right pitches, and low ones are moved up into the PSG's range
+static void Test_Pitch(void)
+{
+	double		the_freq;
+
+	// octave 3 starts at middle C, so O3 A is concert A
+	Test_Play("O3A");
+	CHECK(Test_QueueLen() == 2);
+	the_freq = Test_Frequency(Test_QueueEntry(0)->divider_);
+	CHECK(the_freq > 436.0 && the_freq < 444.0);
+
+	// N34 is the A an octave below. N0 is a rest.
+	Test_Play("N34N0");
+	the_freq = Test_Frequency(Test_QueueEntry(0)->divider_);
+	CHECK(the_freq > 218.0 && the_freq < 222.0);
+	CHECK(Test_QueueEntry(2)->divider_ == 0);
+
+	// sharps and flats: A- is G#
+	Test_Play("O3A-O3G#");
+	CHECK(Test_QueueEntry(0)->divider_ == Test_QueueEntry(2)->divider_);
+
+	// octave 0 is below a 10-bit divider: it still plays, just higher
+	Test_Play("O0C");
+	CHECK(Test_QueueEntry(0)->divider_ != 0 && Test_QueueEntry(0)->divider_ <= PSG_MAX_DIVIDER);
+
+	// < and > stay inside octaves 0 to 6
+	Test_Play("O6>C");
+	CHECK(Test_QueueEntry(0)->divider_ == Music_NoteDivider(MUSIC_MAX_OCTAVE * 12));
+	Test_Play("O0<<C");
+	CHECK(Test_QueueEntry(0)->divider_ == Music_NoteDivider(0));
+}
+
+
+// lengths, tempo, dots, and articulation
+static void Test_Timing(void)
+{
+	uint8_t		i;
+	char		the_mml[40];
+
+	// a quarter note at 120 is half a second: 8 ticks, all of them sounding when legato
+	Test_Play("MLT120L4C");
+	CHECK(Test_QueueLen() == 1 && Test_QueueEntry(0)->ticks_ == 8);
+
+	// normal is 7/8 sounding, staccato 3/4
+	Test_Play("MNT120C");
+	CHECK(Test_QueueLen() == 2 && Test_QueueEntry(0)->ticks_ == 7 && Test_QueueEntry(1)->ticks_ == 1);
+	CHECK(Test_QueueEntry(1)->divider_ == 0);
+	Test_Play("MST120C");
+	CHECK(Test_QueueLen() == 2 && Test_QueueEntry(0)->ticks_ == 6 && Test_QueueEntry(1)->ticks_ == 2);
+
+	// a dot adds half, and a length after the note applies to that note only
+	Test_Play("MLT120C.C2C");
+	CHECK(Test_QueueLen() == 3);
+	CHECK(Test_QueueEntry(0)->ticks_ == 12 && Test_QueueEntry(1)->ticks_ == 16 && Test_QueueEntry(2)->ticks_ == 8);
+
+	// rests are not shortened by articulation
+	Test_Play("MST120P4");
+	CHECK(Test_QueueLen() == 1 && Test_QueueEntry(0)->ticks_ == 8);
+
+	// 16 sixteenths at 150 are 1.6 seconds: 25.6 ticks. carrying the fractions keeps the total from drifting.
+	strcpy(the_mml, "MLT150L16");
+
+	for (i = 0; i < 16; i++)
+	{
+		strcat(the_mml, "C");
+	}
+
+	Test_Play(the_mml);
+	CHECK(Test_QueueTicks() == 25);
+
+	// tempos outside 32 to 255 are ignored
+	Test_Play("MLT10T999C");
+	CHECK(Test_QueueTicks() == 8);
+}
+
+
+// a full queue drops notes rather than overwriting the ones waiting to play
+static void Test_QueueFull(void)
+{
+	uint16_t	i;
+
+	Music_Stop();
+	Music_BeginString();
+	Music_ProcessByte('M');
+	Music_ProcessByte('L');
+
+	for (i = 0; i < MUSIC_QUEUE_SIZE * 2; i++)
+	{
+		Music_ProcessByte('C');
+	}
+
+	Music_ProcessByte('D');
+	Music_EndString();
+
+	CHECK(Test_QueueLen() == MUSIC_QUEUE_SIZE - 1);
+	CHECK(Test_QueueEntry(0)->divider_ == Test_QueueEntry(MUSIC_QUEUE_SIZE - 2)->divider_);
+}
+
+
+// the timer plays each entry for its ticks, then silences the PSG
+static void Test_Playback(void)
+{
+	uint8_t		i;
+
+	Test_Play("MLT120L4CDE");
+	CHECK(Test_QueueTicks() == 24);
+
+	for (i = 0; i < 24; i++)
+	{
+		Music_HandleTimerEvent();
+	}
+
+	CHECK(music_read_idx == music_write_idx);
+	CHECK(music_sounding == true);
+
+	Music_HandleTimerEvent();
+	CHECK(music_sounding == false);
+	CHECK(R8(PSG_BOTH) == (FLAG_PSG_LATCH | (MUSIC_CHANNEL << PSG_CHANNEL_SHIFT) | FLAG_PSG_VOLUME | PSG_ATTENUATION_OFF));
+}
+
+
+// only upper case MML letters start a music string after "ESC [ MF" or "ESC [ MB"
+static void Test_StringStart(void)
+{
+	CHECK(Music_IsStringStart('F') == true);
+	CHECK(Music_IsStringStart('B') == true);
+	CHECK(Music_IsStringStart('T') == true);
+	CHECK(Music_IsStringStart('<') == true);
+	CHECK(Music_IsStringStart('H') == false);
+	CHECK(Music_IsStringStart('c') == false);
+	CHECK(Music_IsStringStart(CH_ESC) == false);
+	CHECK(Music_IsStringStart(CH_ENTER) == false);
+}
+
+
+int main(int argc, char* argv[])
+{
+	FILE*		the_file;
+	int			the_byte;
+
+	if (argc == 3)
+	{
+		// render an MML file
+		if ( (the_file = fopen(argv[1], "rb")) == NULL)
+		{
+			printf("test_music: can't open %s\n", argv[1]);
+			return 1;
+		}
+
+		if ( (test_wav_file = fopen(argv[2], "wb")) == NULL)
+		{
+			printf("test_music: can't write %s\n", argv[2]);
+			return 1;
+		}
+
+		Test_WriteWAVHeader();
+		Music_Stop();
+		Music_BeginString();
+
+		// drain after every byte, so a long tune never fills the queue
+		while ( (the_byte = fgetc(the_file)) != EOF)
+		{
+			Music_ProcessByte((uint8_t)the_byte);
+			Test_DrainToWAV();
+		}
+
+		Music_EndString();
+		Test_DrainToWAV();
+		Test_WriteWAVHeader();
+
+		fclose(the_file);
+		fclose(test_wav_file);
+
+		CHECK(test_wav_samples > 0);
+
+		return Host_Finish("music");
+	}
+
+	Test_Pitch();
+	Test_Timing();
+	Test_QueueFull();
+	Test_Playback();
+	Test_StringStart();
+
+	return Host_Finish("music");
+}
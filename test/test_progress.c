@@ -0,0 +1,159 @@
+/*
+ * test_progress.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ *
+ *  - host checks for progress.c: byte counts in K and M, and a status line that fits the message area
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+#include "host.h"
+
+#include "../src/progress.c"
+#include "../src/strings.c"
+
+#include <string.h>
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+static uint8_t		test_bar;						// what the progress bar was last set to
+
+
+/*****************************************************************************/
+/*                      Stand-ins for what progress.c calls                  */
+/*****************************************************************************/
+
+void App_ShowProgressBar(void) {}
+void App_HideProgressBar(void) {}
+
+void App_UpdateProgressBar(uint8_t progress_bar_total)
+{
+	test_bar = progress_bar_total;
+}
+
+
+/*****************************************************************************/
+/*                                 Helpers                                   */
+/*****************************************************************************/
+
+// true if Progress_FormatSize() gives the_expected for the_bytes
+static bool Test_Size(uint32_t the_bytes, const char* the_expected)
+{
+	char	the_buffer[PROGRESS_SIZE_MAX_LEN];
+
+	Progress_FormatSize(the_buffer, the_bytes);
+
+	return (strcmp(the_buffer, the_expected) == 0);
+}
+
+
+// true if the last status line drawn was the_expected. "obj/test_progress -v" shows every line drawn.
+static bool Test_Line(const char* the_expected)
+{
+	return (strcmp(global_string_buff1, the_expected) == 0);
+}
+
+
+/*****************************************************************************/
+/*                                  Checks                                   */
+/*****************************************************************************/
+
+// bytes up to 1023, then K and M with one decimal place, cut rather than rounded so a file never shows done too soon
+static void Test_FormatSize(void)
+{
+	CHECK(Test_Size(0, "0"));
+	CHECK(Test_Size(1023, "1023"));
+	CHECK(Test_Size(1024, "1.0K"));
+	CHECK(Test_Size(12600, "12.3K"));
+	CHECK(Test_Size(0x000FFFFF, "1023.9K"));
+	CHECK(Test_Size(0x00100000, "1.0M"));
+	CHECK(Test_Size(47815680, "45.6M"));
+	CHECK(Test_Size(0xFFFFFFFF, "4095.9M"));
+}
+
+
+// a second of a transfer, then an error and a retry
+static void Test_StatusLine(void)
+{
+	host_ticks = 1000;
+	Progress_Start();
+	Progress_NewFile(46695, 0);
+	CHECK(Test_Line("0/45.6K 0% 0cps E0 R0"));
+
+	host_ticks += PROGRESS_TICKS_PER_SECOND;
+	Progress_AddBytes(1400);
+	CHECK(Test_Line("1.3K/45.6K 2% 1400cps 0:32 E0 R0"));
+	CHECK(test_bar == 2);
+
+	Progress_AddError();
+	Progress_AddRetry();
+	Progress_End();
+	CHECK(Test_Line("1.3K/45.6K 2% 1400cps 0:32 E1 R1"));
+
+	// no size from the protocol: no percentage or time left
+	host_ticks = 2000;
+	Progress_Start();
+	Progress_NewFile(0, 0);
+	host_ticks += PROGRESS_TICKS_PER_SECOND;
+	Progress_AddBytes(1000);
+	CHECK(Test_Line("1000 1000cps E0 R0"));
+}
+
+
+// every count at its largest still fits on one row of the message area
+static void Test_LongestLine(void)
+{
+	host_ticks = 0;
+	Progress_Start();
+	Progress_NewFile(0xFFFFFFFF, 0xFFFFFFF0);
+	host_ticks += PROGRESS_TICKS_PER_SECOND;
+	Progress_AddBytes(1);
+	progress_errors = 0xFFFF;
+	progress_retries = 0xFFFF;
+	Progress_Redraw();
+	CHECK(strlen(global_string_buff1) <= COMM_BUFFER_NUM_COLS);
+
+	// the slowest rate, with the most time left
+	host_ticks = 0;
+	Progress_Start();
+	Progress_NewFile(0xFFFFFFFF, 0);
+	host_ticks += PROGRESS_TICKS_PER_SECOND;
+	Progress_AddBytes(1);
+	progress_errors = 0xFFFF;
+	progress_retries = 0xFFFF;
+	Progress_Redraw();
+	CHECK(Test_Line("1/4095.9M 0% 1cps 71582788:14 E65535 R65535"));
+	CHECK(strlen(global_string_buff1) <= COMM_BUFFER_NUM_COLS);
+
+	// the fastest rate
+	host_ticks = 0;
+	Progress_Start();
+	Progress_NewFile(0xFFFFFFFF, 0);
+	host_ticks += PROGRESS_TICKS_PER_SECOND;
+	Progress_AddBytes(0xFFFF);
+	Progress_AddBytes(0xFFFF);
+	Progress_Redraw();
+	CHECK(strstr(global_string_buff1, " 65535cps ") != NULL);
+	CHECK(strlen(global_string_buff1) <= COMM_BUFFER_NUM_COLS);
+}
+
+
+int main(int argc, char* argv[])
+{
+	host_verbose = (argc > 1);
+	host_ticks_per_call = 0;
+
+	Test_FormatSize();
+	Test_StatusLine();
+	Test_LongestLine();
+
+	return Host_Finish("progress");
+}
@@ -0,0 +1,423 @@
+/*
+ * test_rip.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ *
+ *  - host checks for rip.c, and a RIPscrip to PPM renderer for looking at (or diffing) what it draws
+ *
+ *  "test_rip" runs the checks
+ *  "test_rip scene.rip scene.ppm" draws scene.rip the way f/term would and writes the bitmap, in the RIP palette, as a PPM
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+#include "host.h"
+
+#include "../src/rip.c"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+static Bitmap		test_bitmap;
+static uint8_t		test_pixels[RIP_BITMAP_HEIGHT][RIP_BITMAP_WIDTH];
+static uint32_t		test_out_of_bounds;		// pixels drawn outside the part of the bitmap under the terminal body
+static uint8_t		test_text[TERM_BODY_HEIGHT][TERM_BODY_WIDTH];
+
+
+/*****************************************************************************/
+/*                       Stand-ins for what rip.c calls                      */
+/*****************************************************************************/
+
+// every pixel goes through here. the real routines don't clip, so a pixel out here would be written to other memory.
+static void Test_Plot(int16_t x, int16_t y, uint8_t the_color)
+{
+	if (x < 0 || x >= RIP_BITMAP_WIDTH || y < 0 || y >= RIP_DRAW_HEIGHT)
+	{
+		test_out_of_bounds++;
+		return;
+	}
+
+	test_pixels[y][x] = the_color;
+}
+
+Bitmap* Bitmap_New(int16_t width, int16_t height, bool new_alloc, uint8_t* vram_loc)
+{
+	test_bitmap.width_ = width;
+	test_bitmap.height_ = height;
+	return &test_bitmap;
+}
+
+bool Bitmap_FillMemory(Bitmap* the_bitmap, uint8_t the_color)
+{
+	memset(test_pixels, the_color, sizeof(test_pixels));
+	return true;
+}
+
+bool Bitmap_SetPixelAtXY(Bitmap* the_bitmap, int16_t x, int16_t y, uint8_t the_color)
+{
+	Test_Plot(x, y, the_color);
+	return true;
+}
+
+bool Bitmap_DrawHLine(Bitmap* the_bitmap, int16_t x, int16_t y, int16_t the_line_len, uint8_t the_color)
+{
+	while (the_line_len-- > 0)
+	{
+		Test_Plot(x++, y, the_color);
+	}
+
+	return true;
+}
+
+bool Bitmap_DrawLine(Bitmap* the_bitmap, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t the_color)
+{
+	int16_t		dx = abs(x2 - x1);
+	int16_t		dy = -abs(y2 - y1);
+	int16_t		sx = (x1 < x2) ? 1 : -1;
+	int16_t		sy = (y1 < y2) ? 1 : -1;
+	int16_t		err = dx + dy;
+	int16_t		err2;
+
+	for (;;)
+	{
+		Test_Plot(x1, y1, the_color);
+
+		if (x1 == x2 && y1 == y2)
+		{
+			return true;
+		}
+
+		err2 = 2 * err;
+
+		if (err2 >= dy)
+		{
+			err += dy;
+			x1 += sx;
+		}
+
+		if (err2 <= dx)
+		{
+			err += dx;
+			y1 += sy;
+		}
+	}
+}
+
+bool Bitmap_DrawBoxCoords(Bitmap* the_bitmap, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t the_color)
+{
+	Bitmap_DrawLine(the_bitmap, x1, y1, x2, y1, the_color);
+	Bitmap_DrawLine(the_bitmap, x2, y1, x2, y2, the_color);
+	Bitmap_DrawLine(the_bitmap, x2, y2, x1, y2, the_color);
+	Bitmap_DrawLine(the_bitmap, x1, y2, x1, y1, the_color);
+	return true;
+}
+
+bool Bitmap_FillBox(Bitmap* the_bitmap, int16_t x, int16_t y, int16_t width, int16_t height, uint8_t the_color)
+{
+	int16_t		row;
+
+	for (row = 0; row < height; row++)
+	{
+		Bitmap_DrawHLine(the_bitmap, x, y + row, width, the_color);
+	}
+
+	return true;
+}
+
+bool Text_SetCharAndColorAtXY(uint8_t x, uint8_t y, uint8_t the_char, uint8_t fore_color, uint8_t back_color)
+{
+	CHECK(x < TERM_BODY_WIDTH && y < TERM_BODY_HEIGHT);
+
+	if (x < TERM_BODY_WIDTH && y < TERM_BODY_HEIGHT)
+	{
+		test_text[y][x] = the_char;
+	}
+
+	return true;
+}
+
+void Sys_SetGraphicMode(bool enable_sprites, bool enable_bitmaps, bool enable_tiles, bool enable_text_overlay, bool enable_text) {}
+void Sys_SetModeText(bool as_overlay) {}
+
+
+/*****************************************************************************/
+/*                                 Helpers                                   */
+/*****************************************************************************/
+
+// feed a RIPscrip stream the way serial.c does: "!|" at the start of a line hands the rest of the line to rip.c
+static void Test_Feed(const uint8_t* the_bytes, uint32_t the_len)
+{
+	bool		in_rip = false;
+	bool		line_start = true;
+	bool		got_bang = false;
+	uint8_t		the_byte;
+
+	while (the_len-- > 0)
+	{
+		the_byte = *the_bytes++;
+
+		if (in_rip == true)
+		{
+			in_rip = RIP_ProcessByte(the_byte);
+			line_start = !in_rip;
+			continue;
+		}
+
+		if (got_bang == true && the_byte == '|')
+		{
+			RIP_BeginLine();
+			in_rip = true;
+		}
+
+		got_bang = (line_start == true && the_byte == '!');
+		line_start = (the_byte == CH_ENTER || the_byte == CH_LF);
+	}
+}
+
+
+static void Test_FeedString(const char* the_string)
+{
+	Test_Feed((const uint8_t*)the_string, strlen(the_string));
+}
+
+
+// count pixels of the_color in the whole bitmap
+static uint32_t Test_CountPixels(uint8_t the_color)
+{
+	uint32_t	the_count = 0;
+	uint16_t	x;
+	uint16_t	y;
+
+	for (y = 0; y < RIP_BITMAP_HEIGHT; y++)
+	{
+		for (x = 0; x < RIP_BITMAP_WIDTH; x++)
+		{
+			the_count += (test_pixels[y][x] == the_color);
+		}
+	}
+
+	return the_count;
+}
+
+
+// write the bitmap to the_path as a PPM, using the palette rip.c set in CLUT 0
+static bool Test_WritePPM(const char* the_path)
+{
+	FILE*		the_file;
+	volatile uint8_t*	the_entry;
+	uint16_t	x;
+	uint16_t	y;
+
+	if ( (the_file = fopen(the_path, "wb")) == NULL)
+	{
+		return false;
+	}
+
+	fprintf(the_file, "P6\n%d %d\n255\n", RIP_BITMAP_WIDTH, RIP_BITMAP_HEIGHT);
+
+	for (y = 0; y < RIP_BITMAP_HEIGHT; y++)
+	{
+		for (x = 0; x < RIP_BITMAP_WIDTH; x++)
+		{
+			// CLUT entries are B, G, R, A
+			the_entry = &R8(VICKY_CLUT0 + ((uint32_t)test_pixels[y][x] << 2));
+			fputc(the_entry[2], the_file);
+			fputc(the_entry[1], the_file);
+			fputc(the_entry[0], the_file);
+		}
+	}
+
+	fclose(the_file);
+
+	return true;
+}
+
+
+/*****************************************************************************/
+/*                                  Checks                                   */
+/*****************************************************************************/
+
+// RIP's corners land on the corners of the terminal body
+static void Test_Scaling(void)
+{
+	RIP_Activate(true);
+
+	// bar over the whole RIP screen, 0,0 to 639,349, in color 1 (fill style 1, color 1)
+	Test_FeedString("!|S0101|B0000HR9P\r\n");
+	CHECK(test_pixels[0][0] == 1);
+	CHECK(test_pixels[RIP_DRAW_HEIGHT - 1][RIP_BITMAP_WIDTH - 1] == 1);
+	CHECK(Test_CountPixels(1) == (uint32_t)RIP_BITMAP_WIDTH * RIP_DRAW_HEIGHT);
+
+	// a line to the bottom right corner ends on the last pixel row of the terminal body
+	Test_FeedString("!|E|c02|L0000HR9P\r\n");
+	CHECK(test_pixels[0][0] == 2);
+	CHECK(test_pixels[RIP_DRAW_HEIGHT - 1][RIP_BITMAP_WIDTH - 1] == 2);
+
+	// text row 24 (y = 24 * 14) is the last text row
+	Test_FeedString("!|@009CX\r\n");
+	CHECK(test_text[TERM_BODY_Y2][0] == 'X');
+
+	CHECK(test_out_of_bounds == 0);
+}
+
+
+// coordinates past RIP's screen (MegaNums go to ZZ = 1295) and shapes that hang off its edges stay on the bitmap
+static void Test_Clipping(void)
+{
+	RIP_Activate(true);
+	test_out_of_bounds = 0;
+
+	Test_FeedString("!|L0000ZZZZ|LZZZZ0000|XZZZZ|RZZZZ0000|BZZZZZZZZ|B00000000\r\n");
+	Test_FeedString("!|CZZZZZZ|C0000ZZ|o0000ZZZZ|oZZZZZZZZ|OZZZZ00ZZZZZZ|OHR9P00A0ZZZZ\r\n");
+	Test_FeedString("!|P04ZZZZ0000ZZ0000ZZ|p03ZZ0000ZZZZZZ|l020000ZZZZ\r\n");
+	CHECK(test_out_of_bounds == 0);
+
+	// a bar past the bottom right is cut to the terminal body, not the bitmap
+	Bitmap_FillMemory(rip_bitmap, 0);
+	Test_FeedString("!|S0103|BHR9PZZZZ\r\n");
+	CHECK(Test_CountPixels(3) == 1);
+	CHECK(test_pixels[RIP_DRAW_HEIGHT - 1][RIP_BITMAP_WIDTH - 1] == 3);
+
+	CHECK(test_out_of_bounds == 0);
+}
+
+
+// an ellipse outline is a closed curve: every pixel on it touches at least two others
+static void Test_Ellipse(void)
+{
+	static const int16_t	the_radii[][2] = {{40, 10}, {10, 40}, {60, 3}, {3, 30}, {25, 25}, {100, 60}};
+	uint8_t		i;
+	int16_t		x;
+	int16_t		y;
+	int8_t		nx;
+	int8_t		ny;
+	uint8_t		the_neighbors;
+	uint16_t	the_lonely;
+
+	RIP_Activate(true);
+
+	for (i = 0; i < sizeof(the_radii) / sizeof(the_radii[0]); i++)
+	{
+		Bitmap_FillMemory(rip_bitmap, 0);
+		RIP_DrawEllipse(160, 100, the_radii[i][0], the_radii[i][1], 5, PARAM_DO_NOT_FILL);
+		the_lonely = 0;
+
+		for (y = 1; y < RIP_DRAW_HEIGHT - 1; y++)
+		{
+			for (x = 1; x < RIP_BITMAP_WIDTH - 1; x++)
+			{
+				if (test_pixels[y][x] != 5)
+				{
+					continue;
+				}
+
+				the_neighbors = 0;
+
+				for (ny = -1; ny <= 1; ny++)
+				{
+					for (nx = -1; nx <= 1; nx++)
+					{
+						the_neighbors += ((nx != 0 || ny != 0) && test_pixels[y + ny][x + nx] == 5);
+					}
+				}
+
+				the_lonely += (the_neighbors < 2);
+			}
+		}
+
+		CHECK(the_lonely == 0);
+	}
+}
+
+
+// random commands with random MegaNums: nothing may land outside the terminal body
+static void Test_Fuzz(void)
+{
+	static const char	the_commands[] = "wvgcQaWmTXLRBCOoAVIiZPplFS=s#E@Y";
+	static const char	the_digits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	uint8_t		the_line[80];
+	uint8_t		the_len;
+	uint16_t	i;
+
+	RIP_Activate(true);
+	test_out_of_bounds = 0;
+	srand(1);
+
+	for (i = 0; i < 20000; i++)
+	{
+		the_len = 0;
+		the_line[the_len++] = '!';
+		the_line[the_len++] = '|';
+		the_line[the_len++] = the_commands[rand() % (sizeof(the_commands) - 1)];
+
+		while (the_len < sizeof(the_line) - 2 && (rand() % 40) != 0)
+		{
+			the_line[the_len++] = the_digits[rand() % (sizeof(the_digits) - 1)];
+		}
+
+		the_line[the_len++] = CH_ENTER;
+		the_line[the_len++] = CH_LF;
+		Test_Feed(the_line, the_len);
+	}
+
+	CHECK(test_out_of_bounds == 0);
+}
+
+
+int main(int argc, char* argv[])
+{
+	FILE*		the_file;
+	uint8_t*	the_data;
+	long		the_size;
+
+	if (argc == 3)
+	{
+		// render a RIP file
+		if ( (the_file = fopen(argv[1], "rb")) == NULL)
+		{
+			printf("test_rip: can't open %s\n", argv[1]);
+			return 1;
+		}
+
+		fseek(the_file, 0, SEEK_END);
+		the_size = ftell(the_file);
+		fseek(the_file, 0, SEEK_SET);
+		the_data = malloc(the_size);
+
+		if (the_data == NULL || fread(the_data, 1, the_size, the_file) != (size_t)the_size)
+		{
+			printf("test_rip: can't read %s\n", argv[1]);
+			return 1;
+		}
+
+		fclose(the_file);
+
+		RIP_Activate(true);
+		Test_Feed(the_data, the_size);
+		CHECK(test_out_of_bounds == 0);
+
+		if (Test_WritePPM(argv[2]) == false)
+		{
+			printf("test_rip: can't write %s\n", argv[2]);
+			return 1;
+		}
+
+		return Host_Finish("rip");
+	}
+
+	Test_Scaling();
+	Test_Clipping();
+	Test_Ellipse();
+	Test_Fuzz();
+
+	return Host_Finish("rip");
+}
@@ -0,0 +1,321 @@
+/*
+ * test_serial.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ *
+ *  - host checks for serial.c: what gets printed for a given stream of received bytes
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+#include "host.h"
+
+#include "../src/serial.c"
+#include "../src/music.c"
+
+#include <string.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define TEST_MAX_PRINTED			256
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+static uint8_t		test_printed[TEST_MAX_PRINTED];	// glyphs Serial_PrintByte drew, in order
+static uint16_t		test_num_printed;
+static uint8_t		test_identity_lut[256];
+static uint8_t		test_num_scrolled_up;	// calls to Text_ScrollTextAndAttrRowsUp: one per deleted line
+
+
+/*****************************************************************************/
+/*                       Stand-ins for what serial.c calls                   */
+/*****************************************************************************/
+
+bool Text_SetCharAndColor(uint8_t the_char, uint8_t fore_color, uint8_t back_color)
+{
+	if (test_num_printed < TEST_MAX_PRINTED)
+	{
+		test_printed[test_num_printed++] = the_char;
+	}
+
+	return true;
+}
+
+bool Text_SetCharAndColorAtXY(uint8_t x, uint8_t y, uint8_t the_char, uint8_t fore_color, uint8_t back_color)
+{
+	return Text_SetCharAndColor(the_char, fore_color, back_color);
+}
+
+void Text_SetXY(uint8_t x, uint8_t y) {}
+bool Text_FillBox(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t the_char, uint8_t fore_color, uint8_t back_color) { return true; }
+bool Text_FillBoxAttrOnly(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t fore_color, uint8_t back_color) { return true; }
+bool Text_ScrollTextAndAttrRowsUp(uint8_t y1, uint8_t y2) { test_num_scrolled_up++; return true; }
+bool Text_ScrollTextAndAttrRowsDown(uint8_t y1, uint8_t y2) { return true; }
+bool Text_ShiftTextAndAttrLeft(uint8_t x, uint8_t y, uint8_t shift_count, uint8_t backfill_char, uint8_t backfill_fore_color, uint8_t backfill_back_color) { return true; }
+bool Text_ShiftTextAndAttrRight(uint8_t* working_buffer, uint8_t x, uint8_t y, uint8_t shift_count, uint8_t backfill_char, uint8_t backfill_fore_color, uint8_t backfill_back_color) { return true; }
+char* Screen_GetStringFromUser(char* dialog_title, char* dialog_body, char* starter_string, uint8_t max_len) { return NULL; }
+void General_CreateFilePathFromFolderAndFile(char* the_combined_path, char* the_folder_path, char* the_file_name, uint16_t max_path_len) {}
+FRESULT f_open(FIL* fp, const TCHAR* path, BYTE mode) { return FR_DISK_ERR; }
+FRESULT f_close(FIL* fp) { return FR_OK; }
+FRESULT f_write(FIL* fp, const void* buff, UINT btw, UINT* bw) { return FR_DISK_ERR; }
+
+void Modem_ProcessByte(uint8_t the_byte) {}
+void RIP_BeginLine(void) {}
+bool RIP_ProcessByte(uint8_t the_byte) { return false; }
+void Sixel_Begin(uint8_t the_col, uint8_t the_row) {}
+void Sixel_ProcessByte(uint8_t the_byte) {}
+uint8_t Sixel_End(void) { return 0; }
+void Sixel_Hide(void) {}
+void Telnet_Reset(void) {}
+bool Telnet_ProcessByte(uint8_t the_byte) { return true; }
+
+
+/*****************************************************************************/
+/*                                 Helpers                                   */
+/*****************************************************************************/
+
+// start a check from a clean terminal: ANSI, identity glyph table, nothing printed yet
+static void Test_Reset(bool utf8_on)
+{
+	Serial_SetGlyphLUT(test_identity_lut);
+	Serial_SetEmulation(EMULATION_ANSI);
+
+	if (Serial_ToggleUTF8Mode() != utf8_on)
+	{
+		Serial_ToggleUTF8Mode();
+	}
+
+	test_num_printed = 0;
+	test_num_scrolled_up = 0;
+	serial_x = TERM_BODY_X1;
+	serial_y = TERM_BODY_Y1;
+	Music_Stop();
+}
+
+
+// feed the_len bytes through the terminal, as if they had come from the UART
+static void Test_Feed(const char* the_bytes, uint16_t the_len)
+{
+	while (the_len-- > 0)
+	{
+		Serial_ProcessByte((uint8_t)*the_bytes++);
+	}
+}
+
+
+// true if exactly the_len glyphs were printed, and they were the_expected
+static bool Test_Printed(const uint8_t* the_expected, uint16_t the_len)
+{
+	return test_num_printed == the_len && memcmp(test_printed, the_expected, the_len) == 0;
+}
+
+
+// encode the_code_point as UTF-8 into the_buffer. returns the length.
+static uint8_t Test_EncodeUTF8(uint32_t the_code_point, char* the_buffer)
+{
+	if (the_code_point < 0x800)
+	{
+		the_buffer[0] = 0xC0 | (the_code_point >> 6);
+		the_buffer[1] = 0x80 | (the_code_point & 0x3F);
+		return 2;
+	}
+
+	the_buffer[0] = 0xE0 | (the_code_point >> 12);
+	the_buffer[1] = 0x80 | ((the_code_point >> 6) & 0x3F);
+	the_buffer[2] = 0x80 | (the_code_point & 0x3F);
+	return 3;
+}
+
+
+/*****************************************************************************/
+/*                                  Checks                                   */
+/*****************************************************************************/
+
+// the table is sorted with no duplicates (the binary search depends on it), and every entry decodes to its glyph
+static void Test_UnicodeTable(void)
+{
+	char		the_utf8[4];
+	uint8_t		the_len;
+	uint16_t	i;
+
+	for (i = 1; i < NUM_UNICODE_GLYPHS; i++)
+	{
+		CHECK(serial_unicode_glyphs[i - 1].code_point_ < serial_unicode_glyphs[i].code_point_);
+	}
+
+	for (i = 0; i < NUM_UNICODE_GLYPHS; i++)
+	{
+		Test_Reset(true);
+		the_len = Test_EncodeUTF8(serial_unicode_glyphs[i].code_point_, the_utf8);
+		Test_Feed(the_utf8, the_len);
+		CHECK(Test_Printed(&serial_unicode_glyphs[i].glyph_, 1));
+	}
+}
+
+
+// what the decoder does with good, unmapped, and broken sequences
+static void Test_UTF8Decoder(void)
+{
+	// ASCII, then U+2550 (double horizontal), U+00E9, U+2591 (light shade)
+	Test_Reset(true);
+	Test_Feed("A\xE2\x95\x90\xC3\xA9\xE2\x96\x91Z", 10);
+	CHECK(Test_Printed((const uint8_t*)"A\xCD\x82\xB0Z", 5));
+
+	// a code point with no CP437 glyph: U+4E00
+	Test_Reset(true);
+	Test_Feed("\xE4\xB8\x80", 3);
+	CHECK(Test_Printed((const uint8_t*)"?", 1));
+
+	// outside the BMP: U+1F600
+	Test_Reset(true);
+	Test_Feed("\xF0\x9F\x98\x80", 4);
+	CHECK(Test_Printed((const uint8_t*)"?", 1));
+
+	// sequence cut short by ASCII: one '?' for the lost character, then the ASCII byte
+	Test_Reset(true);
+	Test_Feed("\xE2\x95" "B", 3);
+	CHECK(Test_Printed((const uint8_t*)"?B", 2));
+
+	// sequence cut short by a new lead byte: '?' for the lost one, then the new one decodes
+	Test_Reset(true);
+	Test_Feed("\xE2\xC3\xA9", 3);
+	CHECK(Test_Printed((const uint8_t*)"?\x82", 2));
+
+	// stray continuation byte, and a byte that can't start a sequence
+	Test_Reset(true);
+	Test_Feed("\x80\xFF", 2);
+	CHECK(Test_Printed((const uint8_t*)"??", 2));
+
+	// UTF-8 off: high bytes are CP437 already
+	Test_Reset(false);
+	Test_Feed("\xC3\xA9", 2);
+	CHECK(Test_Printed((const uint8_t*)"\xC3\xA9", 2));
+}
+
+
+// CSI M is Delete Line, unless it has no parameters and F or B then an MML character follow it: then it is ANSI music
+static void Test_DeleteLineAndMusic(void)
+{
+	// BANSI forms: ESC [ MF, ESC [ MB, ESC [ N
+	Test_Reset(false);
+	Test_Feed("\x1B[MFT120CDE\x0E", 12);
+	CHECK(Test_Printed(NULL, 0));
+	CHECK(test_num_scrolled_up == 0);
+	CHECK(music_write_idx == 6);
+
+	Test_Reset(false);
+	Test_Feed("\x1B[NC\x0E", 5);
+	CHECK(Test_Printed(NULL, 0));
+	CHECK(music_write_idx == 2);
+
+	// bare CSI M before text: one line deleted, and the text is printed
+	Test_Reset(false);
+	Test_Feed("\x1B[Mhi", 5);
+	CHECK(test_num_scrolled_up == 1);
+	CHECK(Test_Printed((const uint8_t*)"hi", 2));
+	CHECK(music_write_idx == 0);
+
+	// bare CSI M before text that starts with an MML letter, or with F or B: the text is printed, not taken for music
+	Test_Reset(false);
+	Test_Feed("\x1B[MConnecting", 13);
+	CHECK(test_num_scrolled_up == 1);
+	CHECK(Test_Printed((const uint8_t*)"Connecting", 10));
+	CHECK(music_write_idx == 0);
+
+	Test_Reset(false);
+	Test_Feed("\x1B[MFred", 7);
+	CHECK(test_num_scrolled_up == 1);
+	CHECK(Test_Printed((const uint8_t*)"Fred", 4));
+	CHECK(music_write_idx == 0);
+
+	// a music string ends at the end of the line, even without Ctrl-N: what follows is printed
+	Test_Reset(false);
+	Test_Feed("\x1B[NCDE\r\nOK", 10);
+	CHECK(music_write_idx == 6);
+	CHECK(Test_Printed((const uint8_t*)"OK", 2));
+
+	// bare CSI M before another sequence, and before a line end
+	Test_Reset(false);
+	Test_Feed("\x1B[M\x1B[1mX", 8);
+	CHECK(test_num_scrolled_up == 1);
+	CHECK(Test_Printed((const uint8_t*)"X", 1));
+
+	Test_Reset(false);
+	Test_Feed("\x1B[M\r", 4);
+	CHECK(test_num_scrolled_up == 1);
+	CHECK(music_write_idx == 0);
+
+	// CSI n M deletes n lines, even if MML-looking text follows
+	Test_Reset(false);
+	Test_Feed("\x1B[3MC", 5);
+	CHECK(test_num_scrolled_up == 3);
+	CHECK(Test_Printed((const uint8_t*)"C", 1));
+	CHECK(music_write_idx == 0);
+
+	// never more lines than there are from the cursor down
+	Test_Reset(false);
+	serial_y = TERM_BODY_Y2 - 1;
+	Test_Feed("\x1B[9M", 4);
+	CHECK(test_num_scrolled_up == 2);
+}
+
+
+// a THRE interrupt that never arrives: sending falls back to polling LSR, or gives up, rather than hanging
+static void Test_TransmitStall(void)
+{
+	host_ticks_per_call = 1;
+
+	// full send buffer and no interrupt draining it, but the UART is idle: poll it out
+	global_uart_tx_read_idx = 0;
+	global_uart_tx_write_idx = UART_TX_BUFFER_SIZE - 1;
+	R8(UART_IER) = 0;
+	R8(UART_LSR) = UART_THR_IS_EMPTY;
+	CHECK(Serial_SendRawByte('Z') == true);
+	CHECK(global_uart_tx_read_idx == UART_TX_BUFFER_SIZE - 1);
+	CHECK(global_uart_tx_write_idx == 0);
+	CHECK((R8(UART_IER) & FLAG_UART_IER_TXA) != 0);
+	CHECK(Serial_WaitForTransmit() == true);
+	CHECK(R8(UART_THR) == 'Z');
+
+	// the UART takes nothing: drop what is queued and report it
+	R8(UART_LSR) = 0;
+	CHECK(Serial_SendRawByte('A') == true);
+	CHECK(Serial_WaitForTransmit() == false);
+	CHECK(global_uart_tx_read_idx == global_uart_tx_write_idx);
+
+	global_uart_tx_read_idx = 0;
+	global_uart_tx_write_idx = UART_TX_BUFFER_SIZE - 1;
+	CHECK(Serial_SendRawByte('B') == false);
+
+	host_ticks_per_call = 0;
+}
+
+
+int main(int argc, char* argv[])
+{
+	uint16_t	i;
+
+	host_verbose = (argc > 1);
+
+	for (i = 0; i < 256; i++)
+	{
+		test_identity_lut[i] = (uint8_t)i;
+	}
+
+	Test_UnicodeTable();
+	Test_UTF8Decoder();
+	Test_DeleteLineAndMusic();
+	Test_TransmitStall();
+
+	return Host_Finish("serial");
+}
@@ -0,0 +1,491 @@
+/*
+ * test_ymodem.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ *
+ *  - host checks for ymodem.c's receiver, against a scripted sender, and for its CRC
+ *
+ *  "test_ymodem -v" also times the CRC, table driven against bit at a time, per KB
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+#include "host.h"
+
+#include "../src/ymodem.c"
+
+#include <string.h>
+#include <time.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define TEST_MAX_STREAM				8192
+#define TEST_MAX_SENT				256
+#define TEST_MAX_FILE				4096
+#define TEST_FILE_SIZE				1500	// a 1K block and part of another
+#define TEST_NEVER					0xFFFF	// test_cancel_after: ESC is never pressed
+#define TEST_NO_PAUSE				0xFFFF	// test_pause_pos: the sender never stops to wait for an answer
+#define TEST_CRC_CHECK_VALUE		0x31C3	// CRC-16/XMODEM of "123456789"
+#define TEST_BENCH_KB				4096	// KB of data to time each CRC over
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+static uint8_t		test_stream[TEST_MAX_STREAM];	// everything the sender sends, in order. it doesn't wait for our answers.
+static uint16_t		test_stream_len;
+static uint16_t		test_stream_pos;
+static uint16_t		test_pause_pos;					// the sender goes quiet once when it gets here, waiting for our answer
+static uint8_t		test_sent[TEST_MAX_SENT];		// what the receiver sent back
+static uint16_t		test_sent_len;
+static uint8_t		test_file[TEST_MAX_FILE];		// what the receiver wrote
+static uint16_t		test_file_len;
+static char			test_file_name[FYMODEM_FILE_NAME_MAX_LENGTH + 1];
+static uint32_t		test_file_size;
+static uint8_t		test_num_closes;
+static uint16_t		test_cancel_after;				// Transfer_CheckCancel() calls before ESC is "pressed"
+static uint32_t		test_waited_ms;					// time spent in timeouts
+
+
+/*****************************************************************************/
+/*                       Stand-ins for what ymodem.c calls                   */
+/*****************************************************************************/
+
+int16_t Serial_GetByte(uint32_t the_timeout_ms)
+{
+	if (test_stream_pos == test_pause_pos)
+	{
+		test_pause_pos = TEST_NO_PAUSE;
+		test_waited_ms += the_timeout_ms;
+		return -1;
+	}
+
+	if (test_stream_pos < test_stream_len)
+	{
+		return test_stream[test_stream_pos++];
+	}
+
+	test_waited_ms += the_timeout_ms;
+	return -1;
+}
+
+uint16_t Serial_ReadPacket(uint8_t* the_buffer, uint16_t the_len, uint32_t the_timeout_ms)
+{
+	uint16_t	i = 0;
+
+	while (i < the_len && test_stream_pos < test_stream_len && test_stream_pos != test_pause_pos)
+	{
+		the_buffer[i++] = test_stream[test_stream_pos++];
+	}
+
+	if (i < the_len)
+	{
+		test_pause_pos = TEST_NO_PAUSE;
+		test_waited_ms += the_timeout_ms;
+	}
+
+	return i;
+}
+
+bool Serial_SendByte(uint8_t the_byte)
+{
+	if (test_sent_len < TEST_MAX_SENT)
+	{
+		test_sent[test_sent_len++] = the_byte;
+	}
+
+	return true;
+}
+
+bool Serial_WaitForTransmit(void) { return true; }
+void Serial_FlushInBuffer(void) {}
+void Progress_AddError(void) {}
+void Progress_AddRetry(void) {}
+
+bool Transfer_CheckCancel(void)
+{
+	if (test_cancel_after == TEST_NEVER || test_cancel_after-- > 0)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+// receive callbacks
+static bool Test_Open(const char* the_filename, uint32_t the_filesize)
+{
+	General_Strlcpy(test_file_name, the_filename, sizeof(test_file_name));
+	test_file_size = the_filesize;
+	test_file_len = 0;
+	return true;
+}
+
+static bool Test_Write(const uint8_t* the_data, uint16_t the_len)
+{
+	if (test_file_len + the_len > TEST_MAX_FILE)
+	{
+		return false;
+	}
+
+	memcpy(test_file + test_file_len, the_data, the_len);
+	test_file_len += the_len;
+	return true;
+}
+
+static bool Test_Close(void)
+{
+	test_num_closes++;
+	return true;
+}
+
+static const fymodem_rx_callbacks	test_callbacks = {Test_Open, Test_Write, Test_Close};
+
+
+/*****************************************************************************/
+/*                                 Helpers                                   */
+/*****************************************************************************/
+
+static void Test_Reset(void)
+{
+	test_stream_len = 0;
+	test_stream_pos = 0;
+	test_pause_pos = TEST_NO_PAUSE;
+	test_sent_len = 0;
+	test_file_len = 0;
+	test_file_name[0] = 0;
+	test_num_closes = 0;
+	test_cancel_after = TEST_NEVER;
+	test_waited_ms = 0;
+}
+
+
+// add a block to the sender's stream: SOH for 128 bytes, STX for 1K
+static void Test_AddBlock(uint8_t the_seq, const uint8_t* the_data, uint16_t the_len)
+{
+	uint16_t	the_crc = ym_crc16(the_data, the_len);
+
+	test_stream[test_stream_len++] = (the_len == YM_PACKET_SIZE) ? YM_SOH : YM_STX;
+	test_stream[test_stream_len++] = the_seq;
+	test_stream[test_stream_len++] = ~the_seq;
+	memcpy(test_stream + test_stream_len, the_data, the_len);
+	test_stream_len += the_len;
+	test_stream[test_stream_len++] = the_crc >> 8;
+	test_stream[test_stream_len++] = the_crc & 0xFF;
+}
+
+
+// the byte the_index of the test file
+static uint8_t Test_FileByte(uint16_t the_index)
+{
+	return (uint8_t)(the_index * 7 + (the_index >> 8));
+}
+
+
+// add a whole file to the stream: header block, data blocks, EOT. the_bad_block (if not 0) is sent damaged first, then again.
+static void Test_AddFile(uint8_t the_bad_block)
+{
+	uint8_t		the_block[YM_PACKET_1K_SIZE];
+	uint16_t	the_pos;
+	uint16_t	i;
+	uint8_t		the_seq = 1;
+
+	memset(the_block, 0, YM_PACKET_SIZE);
+	strcpy((char*)the_block, "files/test.bin");
+	strcpy((char*)the_block + 15, "1500 0");
+	Test_AddBlock(0, the_block, YM_PACKET_SIZE);
+
+	for (the_pos = 0; the_pos < TEST_FILE_SIZE; the_pos += YM_PACKET_1K_SIZE, the_seq++)
+	{
+		for (i = 0; i < YM_PACKET_1K_SIZE; i++)
+		{
+			the_block[i] = (the_pos + i < TEST_FILE_SIZE) ? Test_FileByte(the_pos + i) : YM_CPMEOF;
+		}
+
+		if (the_seq == the_bad_block)
+		{
+			Test_AddBlock(the_seq, the_block, YM_PACKET_1K_SIZE);
+			test_stream[test_stream_len - 100] ^= 0x10;
+		}
+
+		Test_AddBlock(the_seq, the_block, YM_PACKET_1K_SIZE);
+	}
+
+	test_stream[test_stream_len++] = YM_EOT;
+}
+
+
+// add the empty header block that ends a batch
+static void Test_AddEndOfBatch(void)
+{
+	uint8_t		the_block[YM_PACKET_SIZE];
+
+	memset(the_block, 0, sizeof(the_block));
+	Test_AddBlock(0, the_block, YM_PACKET_SIZE);
+}
+
+
+// true if the test file arrived whole, with the sender's name and size
+static bool Test_FileIsGood(void)
+{
+	uint16_t	i;
+
+	if (test_file_len != TEST_FILE_SIZE || test_file_size != TEST_FILE_SIZE || strcmp(test_file_name, "files/test.bin") != 0)
+	{
+		return false;
+	}
+
+	for (i = 0; i < TEST_FILE_SIZE; i++)
+	{
+		if (test_file[i] != Test_FileByte(i))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// how many times the receiver sent the_byte
+static uint16_t Test_CountSent(uint8_t the_byte)
+{
+	uint16_t	the_count = 0;
+	uint16_t	i;
+
+	for (i = 0; i < test_sent_len; i++)
+	{
+		the_count += (test_sent[i] == the_byte);
+	}
+
+	return the_count;
+}
+
+
+// the CRC ym_crc16() replaced: one bit at a time, no table
+static uint16_t Test_BitwiseCRC16(const uint8_t* the_data, uint16_t the_len)
+{
+	uint16_t	the_crc = 0;
+	uint8_t		i;
+
+	while (the_len-- > 0)
+	{
+		the_crc ^= (uint16_t)*the_data++ << 8;
+
+		for (i = 0; i < 8; i++)
+		{
+			the_crc = (the_crc & 0x8000) ? (the_crc << 1) ^ 0x1021 : the_crc << 1;
+		}
+	}
+
+	return the_crc;
+}
+
+
+// microseconds per KB the_crc_function takes on this computer
+static double Test_TimeCRC(uint16_t (*the_crc_function)(const uint8_t*, uint16_t), const uint8_t* the_block)
+{
+	volatile uint16_t	the_sink = 0;
+	clock_t				the_start = clock();
+	uint16_t			i;
+
+	for (i = 0; i < TEST_BENCH_KB; i++)
+	{
+		the_sink ^= the_crc_function(the_block, YM_PACKET_1K_SIZE);
+	}
+
+	return (double)(clock() - the_start) * 1000000.0 / CLOCKS_PER_SEC / TEST_BENCH_KB;
+}
+
+
+// true if the receiver's last words were CAN CAN
+static bool Test_SentCancel(void)
+{
+	return test_sent_len >= 2 && test_sent[test_sent_len - 2] == YM_CAN && test_sent[test_sent_len - 1] == YM_CAN;
+}
+
+
+/*****************************************************************************/
+/*                                  Checks                                   */
+/*****************************************************************************/
+
+// a normal batch of one file, with the padding on the last block dropped
+static void Test_Batch(void)
+{
+	Test_Reset();
+	Test_AddFile(0);
+	Test_AddEndOfBatch();
+
+	CHECK(fymodem_receive_cb(&test_callbacks, false) == TEST_FILE_SIZE);
+	CHECK(Test_FileIsGood());
+	CHECK(test_num_closes == 1);
+	CHECK(test_sent_len > 0 && test_sent[0] == YM_CRC);
+	CHECK(Test_SentCancel() == false);
+}
+
+
+// a damaged block is NAKed, and the copy sent after it is kept
+static void Test_BadBlock(void)
+{
+	Test_Reset();
+	Test_AddFile(2);
+	Test_AddEndOfBatch();
+
+	CHECK(fymodem_receive_cb(&test_callbacks, false) == TEST_FILE_SIZE);
+	CHECK(Test_FileIsGood());
+	CHECK(Test_CountSent(YM_NAK) == 1);
+}
+
+
+// line noise in place of a block's start byte: the rest of the block is let go by, then NAKed, and the copy sent after it
+// is kept. YMODEM-G can't get a block back, so it aborts instead.
+static void Test_BadStart(void)
+{
+	uint16_t	the_bad_pos = (YM_PACKET_SIZE + YM_PACKET_OVERHEAD) + (YM_PACKET_1K_SIZE + YM_PACKET_OVERHEAD);	// block 2
+
+	Test_Reset();
+	Test_AddFile(2);
+	Test_AddEndOfBatch();
+	test_stream[the_bad_pos] = 0x55;
+	test_pause_pos = the_bad_pos + YM_PACKET_1K_SIZE + YM_PACKET_OVERHEAD;
+
+	CHECK(fymodem_receive_cb(&test_callbacks, false) == TEST_FILE_SIZE);
+	CHECK(Test_FileIsGood());
+	CHECK(Test_CountSent(YM_NAK) == 1);
+	CHECK(Test_SentCancel() == false);
+
+	Test_Reset();
+	Test_AddFile(2);
+	Test_AddEndOfBatch();
+	test_stream[the_bad_pos] = 0x55;
+
+	CHECK(fymodem_receive_cb(&test_callbacks, true) == 0);
+	CHECK(Test_CountSent(YM_NAK) == 0);
+	CHECK(Test_SentCancel());
+}
+
+
+// nobody sending: the receiver asks for a while, then gives up, rather than sending 'C' forever
+static void Test_NoSender(void)
+{
+	Test_Reset();
+
+	CHECK(fymodem_receive_cb(&test_callbacks, false) == 0);
+	CHECK(Test_CountSent(YM_CRC) == YM_START_ERROR_MAX_NBR);
+	CHECK(Test_SentCancel());
+	CHECK(test_waited_ms <= (uint32_t)YM_START_ERROR_MAX_NBR * YM_PACKET_RX_TIMEOUT_MS);
+}
+
+
+// the sender stops after EOT, without the empty block that ends the batch: the file received is kept, and the transfer ends
+static void Test_NoEndOfBatch(void)
+{
+	Test_Reset();
+	Test_AddFile(0);
+
+	CHECK(fymodem_receive_cb(&test_callbacks, false) == TEST_FILE_SIZE);
+	CHECK(Test_FileIsGood());
+	CHECK(test_num_closes == 1);
+}
+
+
+// ESC stops the receiver, whether it is waiting for a sender or in the middle of a file
+static void Test_Cancel(void)
+{
+	Test_Reset();
+	test_cancel_after = 3;
+
+	CHECK(fymodem_receive_cb(&test_callbacks, false) == 0);
+	CHECK(Test_CountSent(YM_CRC) == 4);	// the first one, then one for each second waited before ESC
+	CHECK(Test_SentCancel());
+
+	// after the header block and the first data block
+	Test_Reset();
+	Test_AddFile(0);
+	Test_AddEndOfBatch();
+	test_cancel_after = 2;
+
+	CHECK(fymodem_receive_cb(&test_callbacks, false) == 0);
+	CHECK(test_file_len == YM_PACKET_1K_SIZE);
+	CHECK(test_num_closes == 1);
+	CHECK(Test_SentCancel());
+}
+
+
+// the sender cancels (CAN CAN) in the middle of a file: the file is closed, so what arrived is kept
+static void Test_SenderAbort(void)
+{
+	Test_Reset();
+	Test_AddFile(0);
+	test_stream_len -= YM_PACKET_1K_SIZE + YM_PACKET_OVERHEAD + 1;	// drop the last block and EOT
+	test_stream[test_stream_len++] = YM_CAN;
+	test_stream[test_stream_len++] = YM_CAN;
+
+	CHECK(fymodem_receive_cb(&test_callbacks, false) == 0);
+	CHECK(test_file_len == YM_PACKET_1K_SIZE);
+	CHECK(test_num_closes == 1);
+}
+
+
+// the table gives the same CRC as the bitwise version it replaced, and a block with its CRC appended checks out to 0
+static void Test_CRC(void)
+{
+	uint8_t		the_block[YM_PACKET_1K_SIZE + YM_PACKET_TRAILER];
+	uint16_t	the_crc;
+	uint16_t	the_len;
+	uint16_t	i;
+
+	CHECK(ym_crc16((const uint8_t*)"123456789", 9) == TEST_CRC_CHECK_VALUE);
+	CHECK(Test_BitwiseCRC16((const uint8_t*)"123456789", 9) == TEST_CRC_CHECK_VALUE);
+
+	for (i = 0; i < YM_PACKET_1K_SIZE; i++)
+	{
+		the_block[i] = Test_FileByte(i * 13 + 5);
+	}
+
+	for (the_len = 0; the_len <= YM_PACKET_1K_SIZE; the_len += (the_len < 4) ? 1 : 127)
+	{
+		CHECK(ym_crc16(the_block, the_len) == Test_BitwiseCRC16(the_block, the_len));
+	}
+
+	the_crc = ym_crc16(the_block, YM_PACKET_1K_SIZE);
+	the_block[YM_PACKET_1K_SIZE] = the_crc >> 8;
+	the_block[YM_PACKET_1K_SIZE + 1] = the_crc & 0xFF;
+	CHECK(ym_crc16(the_block, YM_PACKET_1K_SIZE + YM_PACKET_TRAILER) == 0);
+
+	// one flipped bit anywhere is caught
+	the_block[700] ^= 0x04;
+	CHECK(ym_crc16(the_block, YM_PACKET_1K_SIZE + YM_PACKET_TRAILER) != 0);
+	the_block[700] ^= 0x04;
+
+	if (host_verbose == true)
+	{
+		printf("  crc16 per KB: table %.1f us, bitwise %.1f us\n", Test_TimeCRC(ym_crc16, the_block), Test_TimeCRC(Test_BitwiseCRC16, the_block));
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	host_verbose = (argc > 1);
+
+	Test_CRC();
+	Test_Batch();
+	Test_BadBlock();
+	Test_BadStart();
+	Test_NoSender();
+	Test_NoEndOfBatch();
+	Test_Cancel();
+	Test_SenderAbort();
+
+	return Host_Finish("ymodem");
+}
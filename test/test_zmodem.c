@@ -0,0 +1,887 @@
+/*
+ * test_zmodem.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: micahbly
+ *
+ *  - host checks for zmodem.c's receiver, against a scripted sender
+ *
+ *  "test_zmodem" runs the checks
+ *  "test_zmodem -r folder" receives over stdin/stdout into folder, resuming files the way transfer.c does. zmodem_lsz.sh
+ *    runs it against lrzsz's sender; messages go to stderr.
+ */
+
+
+/*****************************************************************************/
+/*                                Includes                                   */
+/*****************************************************************************/
+
+#include "host.h"
+
+#include "../src/ymodem.c"
+#include "../src/zmodem.c"
+
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+
+/*****************************************************************************/
+/*                               Definitions                                 */
+/*****************************************************************************/
+
+#define TEST_MAX_STREAM				16384
+#define TEST_MAX_SENT				1024
+#define TEST_MAX_FILE				4096
+#define TEST_FILE_SIZE				3000	// two full subpackets and part of a third
+#define TEST_NEVER					0xFFFF	// test_cancel_after: ESC is never pressed
+#define TEST_NO_ERROR				0xFFFFFFFF	// Test_AddData(): no damaged subpacket
+#define TEST_NO_PAUSE				0xFFFF	// test_pause_pos: the sender never stops to think
+#define TEST_LINK_BUFFER_SIZE		4096	// -r: bytes sent are passed on in chunks this big
+
+
+/*****************************************************************************/
+/*                             Global Variables                              */
+/*****************************************************************************/
+
+static uint8_t		test_stream[TEST_MAX_STREAM];	// everything the sender sends, in order. it doesn't wait for our answers.
+static uint16_t		test_stream_len;
+static uint16_t		test_stream_pos;
+static uint16_t		test_pause_pos;					// the sender goes quiet for a receive timeout when it gets here
+static uint8_t		test_pause_polls;
+static bool			test_crc32;						// sender uses CRC-32 binary headers and subpackets
+static uint8_t		test_sent[TEST_MAX_SENT];		// what the receiver sent back
+static uint16_t		test_sent_len;
+static uint16_t		test_cancel_after;				// Transfer_CheckCancel() calls before ESC is "pressed"
+static uint32_t		test_waited_ms;					// time spent in timeouts
+
+static uint8_t		test_disk[TEST_MAX_FILE];		// the file as the callbacks have it: what was on disk, then what arrived
+static uint32_t		test_disk_len;
+static uint32_t		test_disk_read_pos;
+static uint32_t		test_offer;						// what open_ says may already be on disk
+static uint32_t		test_start_at;					// what start_ was told
+static uint32_t		test_file_size;
+static uint8_t		test_num_closes;
+
+static int			test_link_in = -1;				// -r: the sender's end of the link
+static int			test_link_out = -1;
+static uint8_t		test_link_buffer[TEST_LINK_BUFFER_SIZE];
+static uint16_t		test_link_buffer_len;
+static char			test_folder[256];
+static FILE*		test_folder_file;
+
+
+/*****************************************************************************/
+/*                       Stand-ins for what zmodem.c calls                   */
+/*****************************************************************************/
+
+// -r: pass on what the receiver has sent
+static void Test_FlushLink(void)
+{
+	uint16_t	the_pos = 0;
+	ssize_t		the_len;
+
+	while (the_pos < test_link_buffer_len)
+	{
+		if ( (the_len = write(test_link_out, test_link_buffer + the_pos, test_link_buffer_len - the_pos)) <= 0)
+		{
+			break;
+		}
+
+		the_pos += (uint16_t)the_len;
+	}
+
+	test_link_buffer_len = 0;
+}
+
+
+int16_t Serial_GetByte(uint32_t the_timeout_ms)
+{
+	struct pollfd	the_poll = {test_link_in, POLLIN, 0};
+	uint8_t			the_byte;
+
+	if (test_link_in >= 0)
+	{
+		Test_FlushLink();
+
+		if (poll(&the_poll, 1, (int)the_timeout_ms) <= 0 || read(test_link_in, &the_byte, 1) != 1)
+		{
+			return -1;
+		}
+
+		return the_byte;
+	}
+
+	if (test_stream_pos == test_pause_pos && test_pause_polls > 0)
+	{
+		test_pause_polls--;
+		test_waited_ms += the_timeout_ms;
+		return -1;
+	}
+
+	if (test_stream_pos < test_stream_len)
+	{
+		return test_stream[test_stream_pos++];
+	}
+
+	test_waited_ms += the_timeout_ms;
+	return -1;
+}
+
+uint16_t Serial_ReadPacket(uint8_t* the_buffer, uint16_t the_len, uint32_t the_timeout_ms)
+{
+	return 0;
+}
+
+bool Serial_SendByte(uint8_t the_byte)
+{
+	if (test_link_out >= 0)
+	{
+		test_link_buffer[test_link_buffer_len++] = the_byte;
+
+		if (test_link_buffer_len == TEST_LINK_BUFFER_SIZE)
+		{
+			Test_FlushLink();
+		}
+	}
+	else if (test_sent_len < TEST_MAX_SENT)
+	{
+		test_sent[test_sent_len++] = the_byte;
+	}
+
+	return true;
+}
+
+bool Serial_WaitForTransmit(void) { return true; }
+void Serial_FlushInBuffer(void) {}
+void Progress_AddError(void) {}
+void Progress_AddRetry(void) {}
+
+bool Transfer_CheckCancel(void)
+{
+	if (test_cancel_after == TEST_NEVER || test_cancel_after-- > 0)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+// receive callbacks: the file is kept in test_disk
+static bool Test_Open(const char* the_filename, uint32_t the_filesize, uint32_t* the_offset)
+{
+	CHECK(strcmp(the_filename, "files/test.bin") == 0);
+	test_file_size = the_filesize;
+	test_disk_read_pos = 0;
+	*the_offset = test_offer;
+	return true;
+}
+
+static bool Test_Read(uint8_t* the_data, uint16_t the_len)
+{
+	if (test_disk_read_pos + the_len > test_disk_len)
+	{
+		return false;
+	}
+
+	memcpy(the_data, test_disk + test_disk_read_pos, the_len);
+	test_disk_read_pos += the_len;
+	return true;
+}
+
+static bool Test_Start(uint32_t the_offset)
+{
+	test_start_at = the_offset;
+
+	if (the_offset < test_file_size)
+	{
+		test_disk_len = the_offset;
+	}
+
+	return true;
+}
+
+static bool Test_Write(const uint8_t* the_data, uint16_t the_len)
+{
+	if (test_disk_len + the_len > TEST_MAX_FILE)
+	{
+		return false;
+	}
+
+	memcpy(test_disk + test_disk_len, the_data, the_len);
+	test_disk_len += the_len;
+	return true;
+}
+
+static bool Test_Close(void)
+{
+	test_num_closes++;
+	return true;
+}
+
+static const ZModemCallbacks	test_callbacks = {Test_Open, Test_Read, Test_Start, Test_Write, Test_Close};
+
+
+// -r receive callbacks: the file is kept in test_folder, and resumed the way Transfer_ResumeFile() does it
+static bool Test_FolderOpen(const char* the_filename, uint32_t the_filesize, uint32_t* the_offset)
+{
+	char		the_path[512];
+	const char*	the_name = strrchr(the_filename, '/');
+	long		the_existing_size;
+
+	snprintf(the_path, sizeof(the_path), "%s/%s", test_folder, (the_name == NULL) ? the_filename : the_name + 1);
+
+	if ( (test_folder_file = fopen(the_path, "r+b")) == NULL && (test_folder_file = fopen(the_path, "w+b")) == NULL)
+	{
+		return false;
+	}
+
+	fseek(test_folder_file, 0, SEEK_END);
+	the_existing_size = ftell(test_folder_file);
+	fseek(test_folder_file, 0, SEEK_SET);
+
+	test_file_size = the_filesize;
+	*the_offset = 0;
+
+	if (the_filesize > 0 && (uint32_t)the_existing_size == the_filesize)
+	{
+		*the_offset = the_filesize;
+	}
+	else if (the_filesize > 0 && (uint32_t)the_existing_size < the_filesize)
+	{
+		*the_offset = (uint32_t)the_existing_size & ~((uint32_t)TRANSFER_SECTOR_SIZE - 1);
+	}
+
+	sprintf(global_string_buff1, "open %s: %lu bytes, %ld on disk", the_path, (unsigned long)the_filesize, the_existing_size);
+	Buffer_NewMessage(global_string_buff1);
+
+	return true;
+}
+
+static bool Test_FolderRead(uint8_t* the_data, uint16_t the_len)
+{
+	return fread(the_data, 1, the_len, test_folder_file) == the_len;
+}
+
+static bool Test_FolderStart(uint32_t the_offset)
+{
+	if (test_file_size > 0 && the_offset == test_file_size)
+	{
+		fclose(test_folder_file);
+		test_folder_file = NULL;
+		Buffer_NewMessage("skipping");
+		return true;
+	}
+
+	fflush(test_folder_file);
+
+	if (ftruncate(fileno(test_folder_file), the_offset) != 0 || fseek(test_folder_file, the_offset, SEEK_SET) != 0)
+	{
+		return false;
+	}
+
+	sprintf(global_string_buff1, "starting at %lu", (unsigned long)the_offset);
+	Buffer_NewMessage(global_string_buff1);
+
+	return true;
+}
+
+static bool Test_FolderWrite(const uint8_t* the_data, uint16_t the_len)
+{
+	return fwrite(the_data, 1, the_len, test_folder_file) == the_len;
+}
+
+static bool Test_FolderClose(void)
+{
+	if (test_folder_file != NULL)
+	{
+		fclose(test_folder_file);
+		test_folder_file = NULL;
+	}
+
+	return true;
+}
+
+static const ZModemCallbacks	test_folder_callbacks = {Test_FolderOpen, Test_FolderRead, Test_FolderStart, Test_FolderWrite, Test_FolderClose};
+
+
+/*****************************************************************************/
+/*                                 Helpers                                   */
+/*****************************************************************************/
+
+static void Test_Reset(void)
+{
+	test_stream_len = 0;
+	test_stream_pos = 0;
+	test_pause_pos = TEST_NO_PAUSE;
+	test_pause_polls = 0;
+	test_crc32 = true;
+	test_sent_len = 0;
+	test_cancel_after = TEST_NEVER;
+	test_waited_ms = 0;
+	test_disk_len = 0;
+	test_offer = 0;
+	test_start_at = TEST_NO_ERROR;
+	test_file_size = 0;
+	test_num_closes = 0;
+}
+
+
+// the byte the_index of the sender's file
+static uint8_t Test_FileByte(uint32_t the_index)
+{
+	return (uint8_t)(the_index * 7 + (the_index >> 8));
+}
+
+
+// CRC-32 of the first the_len bytes of the sender's file, as the sender reports it in ZCRC
+static uint32_t Test_FileCRC32(uint32_t the_len)
+{
+	uint32_t	crc32 = 0xFFFFFFFF;
+	uint32_t	i;
+
+	for (i = 0; i < the_len; i++)
+	{
+		crc32 = ZMODEM_CRC32_UPDATE(crc32, Test_FileByte(i));
+	}
+
+	return ~crc32;
+}
+
+
+static void Test_Put(uint8_t the_byte)
+{
+	test_stream[test_stream_len++] = the_byte;
+}
+
+
+// add a byte ZDLE escaped, as a sender would
+static void Test_PutEscaped(uint8_t the_byte)
+{
+	switch (the_byte)
+	{
+		case ZMODEM_ZDLE:
+		case ZMODEM_XON:
+		case ZMODEM_XOFF:
+		case ZMODEM_XON | 0x80:
+		case ZMODEM_XOFF | 0x80:
+		case 0x10:
+		case 0x90:
+			Test_Put(ZMODEM_ZDLE);
+			Test_Put(the_byte ^ 0x40);
+			break;
+
+		case 0x7F:
+			Test_Put(ZMODEM_ZDLE);
+			Test_Put(ZMODEM_ZRUB0);
+			break;
+
+		case 0xFF:
+			Test_Put(ZMODEM_ZDLE);
+			Test_Put(ZMODEM_ZRUB1);
+			break;
+
+		default:
+			Test_Put(the_byte);
+	}
+}
+
+
+// add the CRC of the_data, escaped: CRC-32 low byte first, or CRC-16 high byte first
+static void Test_PutCRC(const uint8_t* the_data, uint16_t the_len)
+{
+	uint32_t	crc32 = 0xFFFFFFFF;
+	uint16_t	crc16 = 0;
+	uint16_t	i;
+
+	for (i = 0; i < the_len; i++)
+	{
+		crc32 = ZMODEM_CRC32_UPDATE(crc32, the_data[i]);
+		crc16 = ZMODEM_CRC16_UPDATE(crc16, the_data[i]);
+	}
+
+	if (test_crc32 == false)
+	{
+		Test_PutEscaped(crc16 >> 8);
+		Test_PutEscaped(crc16 & 0xFF);
+		return;
+	}
+
+	crc32 = ~crc32;
+
+	for (i = 0; i < 4; i++)
+	{
+		Test_PutEscaped(crc32 & 0xFF);
+		crc32 >>= 8;
+	}
+}
+
+
+// add a hex header, the way a sender sends ZRQINIT and ZFIN
+static void Test_AddHexHeader(uint8_t the_type, uint32_t the_value)
+{
+	uint8_t		the_header[ZMODEM_HEADER_LEN] = {the_type, the_value, the_value >> 8, the_value >> 16, the_value >> 24};
+	uint16_t	crc16 = 0;
+	char		the_hex[3];
+	uint8_t		i;
+
+	Test_Put(ZMODEM_ZPAD);
+	Test_Put(ZMODEM_ZPAD);
+	Test_Put(ZMODEM_ZDLE);
+	Test_Put(ZMODEM_ZHEX);
+
+	for (i = 0; i < ZMODEM_HEADER_LEN; i++)
+	{
+		crc16 = ZMODEM_CRC16_UPDATE(crc16, the_header[i]);
+		sprintf(the_hex, "%02x", the_header[i]);
+		Test_Put(the_hex[0]);
+		Test_Put(the_hex[1]);
+	}
+
+	sprintf(the_hex, "%02x", crc16 >> 8);
+	Test_Put(the_hex[0]);
+	Test_Put(the_hex[1]);
+	sprintf(the_hex, "%02x", crc16 & 0xFF);
+	Test_Put(the_hex[0]);
+	Test_Put(the_hex[1]);
+	Test_Put(CH_ENTER);
+	Test_Put(CH_LF | 0x80);
+	Test_Put(ZMODEM_XON);
+}
+
+
+// add a binary header, CRC-16 or CRC-32 as test_crc32 says
+static void Test_AddBinHeader(uint8_t the_type, uint32_t the_value)
+{
+	uint8_t		the_header[ZMODEM_HEADER_LEN] = {the_type, the_value, the_value >> 8, the_value >> 16, the_value >> 24};
+	uint8_t		i;
+
+	Test_Put(ZMODEM_ZPAD);
+	Test_Put(ZMODEM_ZDLE);
+	Test_Put(test_crc32 ? ZMODEM_ZBIN32 : ZMODEM_ZBIN);
+
+	for (i = 0; i < ZMODEM_HEADER_LEN; i++)
+	{
+		Test_PutEscaped(the_header[i]);
+	}
+
+	Test_PutCRC(the_header, ZMODEM_HEADER_LEN);
+}
+
+
+// add a data subpacket ended by the_end. a damaged one has a bit flipped after its CRC was worked out.
+static void Test_AddSubpacket(const uint8_t* the_data, uint16_t the_len, uint8_t the_end, bool damaged)
+{
+	uint8_t		the_copy[ZMODEM_MAX_DATA + 1];
+	uint16_t	i;
+
+	memcpy(the_copy, the_data, the_len);
+	the_copy[the_len] = the_end;
+
+	for (i = 0; i < the_len; i++)
+	{
+		Test_PutEscaped((damaged && i == the_len / 2) ? the_copy[i] ^ 0x04 : the_copy[i]);
+	}
+
+	Test_Put(ZMODEM_ZDLE);
+	Test_Put(the_end);
+	Test_PutCRC(the_copy, the_len + 1);
+}
+
+
+// start a session and offer the test file. the_zf0 is the conversion option: ZMODEM_ZCRECOV for "sz -r".
+static void Test_AddOffer(uint8_t the_zf0)
+{
+	static const char	the_info[] = "files/test.bin\0" "3000 14567 0";
+
+	Test_AddHexHeader(ZMODEM_ZRQINIT, 0);
+	Test_AddBinHeader(ZMODEM_ZFILE, (uint32_t)the_zf0 << 24);
+	Test_AddSubpacket((const uint8_t*)the_info, sizeof(the_info), ZMODEM_ZCRCW, false);
+}
+
+
+// stream the test file from the_start, then ZEOF. the subpacket at the_bad_pos arrives damaged: the sender carries on
+// with the next one until our ZRPOS reaches it, then starts again from the damaged one.
+static void Test_AddData(uint32_t the_start, uint32_t the_bad_pos)
+{
+	uint8_t		the_data[ZMODEM_MAX_DATA];
+	uint32_t	the_pos = the_start;
+	uint16_t	the_len;
+	uint16_t	i;
+
+	Test_AddBinHeader(ZMODEM_ZDATA, the_pos);
+
+	while (the_pos < TEST_FILE_SIZE)
+	{
+		the_len = (TEST_FILE_SIZE - the_pos > ZMODEM_MAX_DATA) ? ZMODEM_MAX_DATA : (uint16_t)(TEST_FILE_SIZE - the_pos);
+
+		for (i = 0; i < the_len; i++)
+		{
+			the_data[i] = Test_FileByte(the_pos + i);
+		}
+
+		if (the_pos == the_bad_pos)
+		{
+			Test_AddSubpacket(the_data, the_len, ZMODEM_ZCRCG, true);
+			Test_AddSubpacket(the_data, the_len, ZMODEM_ZCRCG, false);
+			Test_AddBinHeader(ZMODEM_ZDATA, the_pos);
+			the_bad_pos = TEST_NO_ERROR;
+			continue;
+		}
+
+		Test_AddSubpacket(the_data, the_len, (the_pos + the_len >= TEST_FILE_SIZE) ? ZMODEM_ZCRCE : ZMODEM_ZCRCG, false);
+		the_pos += the_len;
+	}
+
+	Test_AddBinHeader(ZMODEM_ZEOF, TEST_FILE_SIZE);
+}
+
+
+// end the session, the way lsz does
+static void Test_AddFinish(void)
+{
+	Test_AddHexHeader(ZMODEM_ZFIN, 0);
+	Test_Put('O');
+	Test_Put('O');
+}
+
+
+// put the_len bytes of a file on the "disk" before the transfer: the start of the sender's file, or something else
+static void Test_SetDisk(uint32_t the_len, bool same_file)
+{
+	uint32_t	i;
+
+	for (i = 0; i < the_len; i++)
+	{
+		test_disk[i] = same_file ? Test_FileByte(i) : (uint8_t)(i ^ 0x5A);
+	}
+
+	test_disk_len = the_len;
+}
+
+
+// true if the "disk" ends up with the whole test file
+static bool Test_FileIsGood(void)
+{
+	uint32_t	i;
+
+	if (test_disk_len != TEST_FILE_SIZE || test_file_size != TEST_FILE_SIZE)
+	{
+		return false;
+	}
+
+	for (i = 0; i < TEST_FILE_SIZE; i++)
+	{
+		if (test_disk[i] != Test_FileByte(i))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// how many hex headers of the_type the receiver sent. the_value gets the value of the last one.
+static uint8_t Test_CountSent(uint8_t the_type, uint32_t* the_value)
+{
+	uint8_t		the_count = 0;
+	uint16_t	i;
+	uint8_t		j;
+	unsigned	the_bytes[ZMODEM_HEADER_LEN];
+
+	for (i = 0; i + 4 + ZMODEM_HEADER_LEN * 2 <= test_sent_len; i++)
+	{
+		if (test_sent[i] != ZMODEM_ZPAD || test_sent[i + 1] != ZMODEM_ZPAD || test_sent[i + 2] != ZMODEM_ZDLE || test_sent[i + 3] != ZMODEM_ZHEX)
+		{
+			continue;
+		}
+
+		for (j = 0; j < ZMODEM_HEADER_LEN; j++)
+		{
+			sscanf((char*)test_sent + i + 4 + j * 2, "%2x", &the_bytes[j]);
+		}
+
+		if (the_bytes[0] == the_type)
+		{
+			the_count++;
+			*the_value = the_bytes[1] | (the_bytes[2] << 8) | (the_bytes[3] << 16) | ((uint32_t)the_bytes[4] << 24);
+		}
+	}
+
+	return the_count;
+}
+
+
+// true if the receiver's last words were the cancel sequence
+static bool Test_SentCancel(void)
+{
+	return test_sent_len >= 20 && test_sent[test_sent_len - 20] == ZMODEM_ZDLE && test_sent[test_sent_len - 1] == ZMODEM_CH_BS;
+}
+
+
+/*****************************************************************************/
+/*                                  Checks                                   */
+/*****************************************************************************/
+
+// a whole file, with CRC-32 and with CRC-16
+static void Test_Receive(void)
+{
+	uint32_t	the_value;
+
+	Test_Reset();
+	Test_AddOffer(0);
+	Test_AddData(0, TEST_NO_ERROR);
+	Test_AddFinish();
+
+	CHECK(ZModem_Receive(&test_callbacks) == TEST_FILE_SIZE);
+	CHECK(Test_FileIsGood());
+	CHECK(test_num_closes == 1);
+	CHECK(test_start_at == 0);
+	CHECK(Test_CountSent(ZMODEM_ZRPOS, &the_value) == 1 && the_value == 0);
+	CHECK(Test_CountSent(ZMODEM_ZCRC, &the_value) == 0);
+	CHECK(Test_CountSent(ZMODEM_ZFIN, &the_value) == 1);
+
+	Test_Reset();
+	test_crc32 = false;
+	Test_AddOffer(0);
+	Test_AddData(0, TEST_NO_ERROR);
+	Test_AddFinish();
+
+	CHECK(ZModem_Receive(&test_callbacks) == TEST_FILE_SIZE);
+	CHECK(Test_FileIsGood());
+}
+
+
+// a damaged subpacket: ZRPOS back to the last good byte, and everything after it is skipped until the sender gets there
+static void Test_BadSubpacket(void)
+{
+	uint32_t	the_value;
+
+	Test_Reset();
+	Test_AddOffer(0);
+	Test_AddData(0, ZMODEM_MAX_DATA);
+	Test_AddFinish();
+
+	CHECK(ZModem_Receive(&test_callbacks) == TEST_FILE_SIZE);
+	CHECK(Test_FileIsGood());
+	CHECK(Test_CountSent(ZMODEM_ZRPOS, &the_value) == 2 && the_value == ZMODEM_MAX_DATA);
+}
+
+
+// part of the file is on disk, and the sender's ZCRC agrees it is the same file: only the rest is asked for
+static void Test_ResumeSameFile(void)
+{
+	uint32_t	the_value;
+
+	Test_Reset();
+	Test_SetDisk(1024, true);
+	test_offer = 1024;
+	Test_AddOffer(0);
+	Test_AddBinHeader(ZMODEM_ZCRC, Test_FileCRC32(1024));
+	Test_AddData(1024, TEST_NO_ERROR);
+	Test_AddFinish();
+
+	CHECK(ZModem_Receive(&test_callbacks) == TEST_FILE_SIZE - 1024);
+	CHECK(Test_CountSent(ZMODEM_ZCRC, &the_value) == 1 && the_value == 1024);
+	CHECK(Test_CountSent(ZMODEM_ZRPOS, &the_value) == 1 && the_value == 1024);
+	CHECK(test_start_at == 1024);
+	CHECK(Test_FileIsGood());
+}
+
+
+// a different file with the same name: the sender's ZCRC doesn't match, so it starts over instead of joining two files
+static void Test_ResumeOtherFile(void)
+{
+	uint32_t	the_value;
+
+	Test_Reset();
+	Test_SetDisk(1024, false);
+	test_offer = 1024;
+	Test_AddOffer(ZMODEM_ZCRECOV);
+	Test_AddBinHeader(ZMODEM_ZCRC, Test_FileCRC32(1024));
+	Test_AddData(0, TEST_NO_ERROR);
+	Test_AddFinish();
+
+	CHECK(ZModem_Receive(&test_callbacks) == TEST_FILE_SIZE);
+	CHECK(Test_CountSent(ZMODEM_ZRPOS, &the_value) == 1 && the_value == 0);
+	CHECK(test_start_at == 0);
+	CHECK(Test_FileIsGood());
+
+	// the whole file on disk, but a different one: received again rather than skipped
+	Test_Reset();
+	Test_SetDisk(TEST_FILE_SIZE, false);
+	test_offer = TEST_FILE_SIZE;
+	Test_AddOffer(0);
+	Test_AddBinHeader(ZMODEM_ZCRC, Test_FileCRC32(TEST_FILE_SIZE));
+	Test_AddData(0, TEST_NO_ERROR);
+	Test_AddFinish();
+
+	CHECK(ZModem_Receive(&test_callbacks) == TEST_FILE_SIZE);
+	CHECK(Test_CountSent(ZMODEM_ZSKIP, &the_value) == 0);
+	CHECK(Test_FileIsGood());
+}
+
+
+// the whole file on disk, and the sender's ZCRC agrees: skipped
+static void Test_Skip(void)
+{
+	uint32_t	the_value;
+
+	Test_Reset();
+	Test_SetDisk(TEST_FILE_SIZE, true);
+	test_offer = TEST_FILE_SIZE;
+	Test_AddOffer(0);
+	Test_AddBinHeader(ZMODEM_ZCRC, Test_FileCRC32(TEST_FILE_SIZE));
+	Test_AddFinish();
+
+	CHECK(ZModem_Receive(&test_callbacks) == 0);
+	CHECK(Test_CountSent(ZMODEM_ZSKIP, &the_value) == 1);
+	CHECK(Test_CountSent(ZMODEM_ZRPOS, &the_value) == 0);
+	CHECK(test_start_at == TEST_FILE_SIZE);
+	CHECK(test_num_closes == 0);
+}
+
+
+// a sender that ignores ZCRC: what is on disk is kept only if the sender asked to resume (ZCRECOV)
+static void Test_ResumeNoAnswer(void)
+{
+	uint32_t	the_value;
+
+	Test_Reset();
+	Test_SetDisk(1024, true);
+	test_offer = 1024;
+	Test_AddOffer(ZMODEM_ZCRECOV);
+	test_pause_pos = test_stream_len;
+	test_pause_polls = ZMODEM_RX_TIMEOUT_MS / ZMODEM_RX_POLL_MS;
+	Test_AddData(1024, TEST_NO_ERROR);
+	Test_AddFinish();
+
+	CHECK(ZModem_Receive(&test_callbacks) == TEST_FILE_SIZE - 1024);
+	CHECK(Test_CountSent(ZMODEM_ZRPOS, &the_value) == 1 && the_value == 1024);
+	CHECK(Test_FileIsGood());
+
+	Test_Reset();
+	Test_SetDisk(1024, true);
+	test_offer = 1024;
+	Test_AddOffer(0);
+	test_pause_pos = test_stream_len;
+	test_pause_polls = ZMODEM_RX_TIMEOUT_MS / ZMODEM_RX_POLL_MS;
+	Test_AddData(0, TEST_NO_ERROR);
+	Test_AddFinish();
+
+	CHECK(ZModem_Receive(&test_callbacks) == TEST_FILE_SIZE);
+	CHECK(Test_CountSent(ZMODEM_ZRPOS, &the_value) == 1 && the_value == 0);
+	CHECK(Test_FileIsGood());
+}
+
+
+// the sender ends the session with ZFIN, without a ZEOF for the file: the file is still closed, so what arrived is kept
+static void Test_NoEndOfFile(void)
+{
+	uint16_t	the_eof_len;
+
+	// the ZEOF Test_AddData() ends with is the same length as this one
+	Test_Reset();
+	Test_AddBinHeader(ZMODEM_ZEOF, TEST_FILE_SIZE);
+	the_eof_len = test_stream_len;
+
+	Test_Reset();
+	Test_AddOffer(0);
+	Test_AddData(0, TEST_NO_ERROR);
+	test_stream_len -= the_eof_len;
+	Test_AddFinish();
+
+	CHECK(ZModem_Receive(&test_callbacks) == TEST_FILE_SIZE);
+	CHECK(Test_FileIsGood());
+	CHECK(test_num_closes == 1);
+}
+
+
+// ESC stops the receiver, whether it is waiting for a sender or in the middle of a file. so does the sender cancelling.
+static void Test_Cancel(void)
+{
+	uint8_t		i;
+
+	Test_Reset();
+	test_cancel_after = 2;
+
+	CHECK(ZModem_Receive(&test_callbacks) == -1);
+	CHECK(test_waited_ms == 3 * ZMODEM_RX_POLL_MS);
+	CHECK(Test_SentCancel());
+
+	// after the first subpacket
+	Test_Reset();
+	Test_AddOffer(0);
+	Test_AddData(0, TEST_NO_ERROR);
+	Test_AddFinish();
+	test_cancel_after = 1;
+
+	CHECK(ZModem_Receive(&test_callbacks) == -1);
+	CHECK(test_disk_len == ZMODEM_MAX_DATA);
+	CHECK(test_num_closes == 1);
+	CHECK(Test_SentCancel());
+
+	// the sender gives up partway
+	Test_Reset();
+	Test_AddOffer(0);
+	Test_AddData(0, TEST_NO_ERROR);
+	test_stream_len -= 1500;
+
+	for (i = 0; i < 8; i++)
+	{
+		Test_Put(ZMODEM_ZDLE);
+	}
+
+	CHECK(ZModem_Receive(&test_callbacks) == -1);
+	CHECK(test_num_closes == 1);
+}
+
+
+// -r: receive over stdin/stdout into the_folder
+static int Test_ReceiveOverLink(const char* the_folder)
+{
+	int32_t		the_result;
+
+	// the link gets stdin and stdout. anything printed goes to stderr instead. a sender that quits early is a failed write, not a signal.
+	signal(SIGPIPE, SIG_IGN);
+	test_link_in = dup(STDIN_FILENO);
+	test_link_out = dup(STDOUT_FILENO);
+	dup2(STDERR_FILENO, STDOUT_FILENO);
+	setvbuf(stdout, NULL, _IONBF, 0);
+
+	General_Strlcpy(test_folder, the_folder, sizeof(test_folder));
+	test_cancel_after = TEST_NEVER;
+	host_verbose = true;
+
+	the_result = ZModem_Receive(&test_folder_callbacks);
+	Test_FlushLink();
+
+	printf("test_zmodem: received %ld bytes\n", (long)the_result);
+
+	return (the_result < 0) ? 1 : 0;
+}
+
+
+int main(int argc, char* argv[])
+{
+	if (argc == 3 && strcmp(argv[1], "-r") == 0)
+	{
+		return Test_ReceiveOverLink(argv[2]);
+	}
+
+	host_verbose = (argc > 1);
+
+	Test_Receive();
+	Test_BadSubpacket();
+	Test_ResumeSameFile();
+	Test_ResumeOtherFile();
+	Test_Skip();
+	Test_ResumeNoAnswer();
+	Test_NoEndOfFile();
+	Test_Cancel();
+
+	return Host_Finish("zmodem");
+}